@@ -0,0 +1,15 @@
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+
+int
+main(int   argc,
+     char *argv[])
+{
+  (void)IORING_OP_URING_CMD;
+  (void)IORING_SETUP_SQE128;
+  (void)IORING_ENTER_EXT_ARG;
+  (void)__NR_io_uring_setup;
+  (void)__NR_io_uring_enter;
+
+  return 0;
+}
@@ -0,0 +1,12 @@
+#define _GNU_SOURCE
+#include <fcntl.h>
+
+int
+main(int   argc,
+     char *argv[])
+{
+  (void)splice;
+  (void)vmsplice;
+
+  return 0;
+}
@@ -549,6 +549,37 @@ struct fuse_operations
   int (*removemapping)();
   int (*syncfs)();
   int (*tmpfile)(const char *, mode_t, fuse_file_info_t *);
+
+  /** Describe where to read data from rather than reading it
+   *
+   * Fill in the single fd buffer of bufv with the file descriptor
+   * and offset to read from. The data is then spliced directly to
+   * the kernel. Used in place of read() when set.
+   */
+  int (*read_buf)(const fuse_file_info_t *ffi,
+                  struct fuse_bufvec     *bufv,
+                  size_t                  size,
+                  off_t                   off);
+
+  /** Called after the reply to a read_buf has been sent
+   *
+   * err is 0 or the -errno of reading from the described fd or of
+   * sending the reply. Runs on the same thread as the read_buf call
+   * it follows. Optional.
+   */
+  void (*read_buf_done)(const fuse_file_info_t *ffi,
+                        int                     err);
+
+  /** Write data from a buffer vector rather than a memory buffer
+   *
+   * The source is a single fd buffer referring to a pipe holding the
+   * request's payload which can be spliced directly to its
+   * destination. When set the WRITE payload is no longer copied into
+   * the request buffer.
+   */
+  int (*write_buf)(const fuse_file_info_t *ffi,
+                   struct fuse_bufvec     *src,
+                   off_t                   off);
 };
 
 /** Extra context that may be needed by some filesystems
@@ -778,6 +809,10 @@ struct fuse_session *fuse_get_session(struct fuse *f);
 void fuse_gc1();
 void fuse_gc();
 void fuse_invalidate_all_nodes();
+void fuse_invalidate_path(const char *path);
+
+int  fuse_passthrough_open(const int fd);
+int  fuse_passthrough_close(const int backing_id);
 
 EXTERN_C_END
 
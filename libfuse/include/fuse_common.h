@@ -88,6 +88,15 @@ struct fuse_file_info_t
 
   uint32_t noflush:1;
 
+  /** Can be filled in by open/create along with backing_id to have
+      the kernel perform read/write/mmap directly against the
+      registered backing file. See fuse_passthrough_open(). */
+  uint32_t passthrough:1;
+
+  /** Backing file id returned by fuse_passthrough_open(). Only used
+      when passthrough is set. */
+  int32_t backing_id;
+
   /** File handle.  May be filled in by filesystem in open().
       Available in all other file operations */
   uint64_t fh;
@@ -107,6 +116,8 @@ struct fuse_file_info_t
  * FUSE_CAP_DONT_MASK: don't apply umask to file mode on create operations
  * FUSE_CAP_IOCTL_DIR: ioctl support on directories
  * FUSE_CAP_CACHE_SYMLINKS: cache READLINK responses
+ * FUSE_CAP_PASSTHROUGH: kernel supports passthrough of read/write to a backing fd
+ * FUSE_CAP_OVER_IO_URING: kernel supports receiving requests via io_uring
  */
 #define FUSE_CAP_ASYNC_READ           (1ULL << 0)
 #define FUSE_CAP_POSIX_LOCKS          (1ULL << 1)
@@ -127,6 +138,8 @@ struct fuse_file_info_t
 #define FUSE_CAP_SETXATTR_EXT         (1ULL << 22)
 #define FUSE_CAP_DIRECT_IO_ALLOW_MMAP (1ULL << 23)
 #define FUSE_CAP_CREATE_SUPP_GROUP    (1ULL << 24)
+#define FUSE_CAP_PASSTHROUGH          (1ULL << 25)
+#define FUSE_CAP_OVER_IO_URING        (1ULL << 26)
 
 
 /**
@@ -164,6 +177,7 @@ struct fuse_conn_info
   unsigned max_background;
   unsigned congestion_threshold;
   uint16_t max_pages;
+  uint32_t max_stack_depth;
 };
 
 struct fuse_session;
@@ -43,17 +43,32 @@ enum fuse_dirents_type_e
 };
 typedef enum fuse_dirents_type_e fuse_dirents_type_t;
 
+/*
+  `more` is set by a filesystem which returned only part of a
+  directory and expects to be called again, without a reset, to
+  append the rest. Once `data` grows past the spill size set with
+  fuse_dirents_spill_size() it is moved into an unlinked temp file
+  mapped in its place so the page cache rather than the heap holds
+  large listings. A zeroed fuse_dirents_t is valid but empty.
+*/
 typedef struct fuse_dirents_t fuse_dirents_t;
 struct fuse_dirents_t
 {
   kvec_t(char)        data;
   kvec_t(uint32_t)    offs;
   fuse_dirents_type_t type;
+  uint8_t             more;
+  uint8_t             spilled;
+  int                 spill_fd;
 };
 
+void fuse_dirents_spill_size(const uint64_t size);
+
 int  fuse_dirents_init(fuse_dirents_t *d);
 void fuse_dirents_free(fuse_dirents_t *d);
 void fuse_dirents_reset(fuse_dirents_t *d);
+int  fuse_dirents_copy(fuse_dirents_t       *dst,
+                       const fuse_dirents_t *src);
 
 int  fuse_dirents_add(fuse_dirents_t      *d,
                       const struct dirent *de,
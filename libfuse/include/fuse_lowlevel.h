@@ -1150,6 +1150,44 @@ int fuse_reply_data(fuse_req_t  req,
                     char       *buf,
                     size_t      bufsize);
 
+/**
+ * Reply with data described by a buffer vector
+ *
+ * If the buffer refers to a file descriptor the data is spliced
+ * through a per-thread pipe into the fuse device. Falls back to a
+ * copy if splicing is unavailable or the read comes up short.
+ *
+ * Possible requests:
+ *   read
+ *
+ * @param req request handle
+ * @param bufv buffer vector describing the data
+ * @return zero for success, -errno for failure to read the data (an
+ *         error reply was sent instead) or to send the reply
+ */
+int fuse_reply_data_bufvec(fuse_req_t          req,
+                           struct fuse_bufvec *bufv);
+
+/**
+ * Get the number of read replies which were spliced and the number
+ * which had to fall back to copying
+ */
+void fuse_read_splice_counts(uint64_t *spliced,
+                             uint64_t *fallback);
+
+/**
+ * Get the pipe holding the payload of a WRITE request
+ *
+ * When write splicing is enabled the data of a WRITE request is left
+ * in a pipe rather than copied into the request buffer. The caller
+ * should splice arg->size bytes out of it. Anything not consumed is
+ * discarded after the request is processed.
+ *
+ * @param req request handle
+ * @return the pipe's read end or -1 if the payload is in the buffer
+ */
+int fuse_write_splice_pipe(fuse_req_t req);
+
 /**
  * Reply with data vector
  *
@@ -1380,6 +1418,28 @@ int fuse_lowlevel_notify_store(struct fuse_chan *ch, uint64_t ino,
 int fuse_lowlevel_notify_retrieve(struct fuse_chan *ch, uint64_t ino,
                                   size_t size, off_t offset, void *cookie);
 
+/**
+ * Register a file descriptor as a passthrough backing file
+ *
+ * Requires FUSE_CAP_PASSTHROUGH to have been negotiated and
+ * CAP_SYS_ADMIN. The returned id is placed in fuse_file_info_t's
+ * backing_id when replying to open or create.
+ *
+ * @param ch the channel through which to register the fd
+ * @param fd the backing file descriptor
+ * @return backing id (> 0) for success, -errno for failure
+ */
+int fuse_lowlevel_passthrough_open(struct fuse_chan *ch, const int fd);
+
+/**
+ * Release a backing id obtained with fuse_lowlevel_passthrough_open()
+ *
+ * @param ch the channel through which the fd was registered
+ * @param backing_id the id to release
+ * @return zero for success, -errno for failure
+ */
+int fuse_lowlevel_passthrough_close(struct fuse_chan *ch, const int backing_id);
+
 
 /* ----------------------------------------------------------- *
  * Utility functions					       *
@@ -1454,6 +1514,7 @@ struct fuse_session *fuse_session_new(void *data,
                                       void *process_buf,
                                       void *destroy);
 void fuse_session_add_chan(struct fuse_session *se, struct fuse_chan *ch);
+void fuse_session_enable_write_splice(struct fuse_session *se);
 void fuse_session_remove_chan(struct fuse_chan *ch);
 void fuse_session_destroy(struct fuse_session *se);
 void fuse_session_exit(struct fuse_session *se);
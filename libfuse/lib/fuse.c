@@ -15,6 +15,7 @@
 #include "kvec.h"
 
 #include "node.h"
+#include "node_table.h"
 #include "config.h"
 #include "fuse_dirents.h"
 #include "fuse_i.h"
@@ -24,6 +25,7 @@
 #include "fuse_opt.h"
 #include "fuse_pollhandle.h"
 #include "fuse_msgbuf.hpp"
+#include "wyhash.h"
 
 #include <assert.h>
 #include <dlfcn.h>
@@ -56,6 +58,9 @@
 #define OFFSET_MAX 0x7fffffffffffffffLL
 
 #define NODE_TABLE_MIN_SIZE 8192
+#define NODE_TABLE_SHARD_BITS 6
+#define NODE_TABLE_SHARDS (1 << NODE_TABLE_SHARD_BITS)
+#define NODE_SHARD_MIN_SIZE (NODE_TABLE_MIN_SIZE / NODE_TABLE_SHARDS)
 
 #define PARAM(inarg) ((void*)(((char*)(inarg)) + sizeof(*(inarg))))
 
@@ -67,6 +72,9 @@ struct fuse_config
   unsigned int gid;
   unsigned int umask;
   int remember;
+  unsigned int remember_max;
+  unsigned int path_cache_max;
+  unsigned int msgbuf_max_idle;
   int debug;
   int nogc;
   int set_mode;
@@ -80,29 +88,25 @@ struct fuse_fs
   struct fuse_operations op;
 };
 
-struct lock_queue_element
-{
-  struct lock_queue_element *next;
-  pthread_cond_t cond;
-  uint64_t   nodeid1;
-  const char *name1;
-  char **path1;
-  node_t **wnode1;
-  uint64_t   nodeid2;
-  const char *name2;
-  char **path2;
-  node_t **wnode2;
-  int err;
-  bool done : 1;
-};
-
-struct node_table
+/*
+  The id and name tables are split into NODE_TABLE_SHARDS
+  independently locked hash tables so lookups of unrelated
+  nodes don't serialize on a single lock. A node's id shard lock
+  guards its mutable state (nlookup, treelock, open_count, locks,
+  stat cache) while name and parent are only changed with both its
+  name shard and id shard locks held. refctr is atomic.
+
+  Lock order: name shard -> id shard -> remembered_lock. No more
+  than one shard of each kind is held at a time.
+*/
+typedef struct node_shard_t node_shard_t;
+struct node_shard_t
 {
-  node_t **array;
-  size_t   use;
-  size_t   size;
-  size_t   split;
-};
+  pthread_mutex_t   lock;
+  node_table_t      table;
+  uint64_t          acquisitions;
+  uint64_t          contentions;
+} __attribute__((aligned(64)));
 
 #define container_of(ptr,type,member) ({                        \
       const typeof( ((type *)0)->member ) *__mptr = (ptr);      \
@@ -117,13 +121,6 @@ struct list_head
   struct list_head *prev;
 };
 
-typedef struct remembered_node_t remembered_node_t;
-struct remembered_node_t
-{
-  node_t *node;
-  time_t  time;
-};
-
 typedef struct nodeid_gen_t nodeid_gen_t;
 struct nodeid_gen_t
 {
@@ -134,17 +131,33 @@ struct nodeid_gen_t
 struct fuse
 {
   struct fuse_session *se;
-  struct node_table name_table;
-  struct node_table id_table;
+  node_shard_t name_shards[NODE_TABLE_SHARDS];
+  node_shard_t id_shards[NODE_TABLE_SHARDS];
   nodeid_gen_t nodeid_gen;
   unsigned int hidectr;
-  pthread_mutex_t lock;
   struct fuse_config conf;
   struct fuse_fs *fs;
-  struct lock_queue_element *lockq;
+
+  /* waiters for a contended treelock */
+  pthread_mutex_t lock;
+  pthread_cond_t  treelock_cond;
+  uint64_t        treelock_gen;
+  uint64_t        treelock_waits;
+  uint32_t        treelock_waiters;
+
+  /* cached node paths and path grace periods, see try_get_path */
+  uint64_t path_gen;
+  pthread_mutex_t path_grace_lock;
+  uint64_t path_cache_size;
+  uint64_t path_cache_hits;
+  uint64_t path_cache_misses;
 
   pthread_t maintenance_thread;
-  kvec_t(remembered_node_t) remembered_nodes;
+  pthread_mutex_t remembered_lock;
+  node_t   *remembered_head;
+  node_t   *remembered_tail;
+  uint64_t  remembered_count;
+  uint64_t  remembered_evictions;
 };
 
 struct lock
@@ -158,6 +171,7 @@ struct lock
 };
 
 #define TREELOCK_WRITE -1
+#define TREELOCK_WRITE_WAITED -2
 #define TREELOCK_WAIT_OFFSET INT_MIN
 
 struct fuse_dh
@@ -167,15 +181,24 @@ struct fuse_dh
   fuse_dirents_t  d;
 };
 
+/*
+  path_gen is 0 while the thread holds no path, otherwise one more
+  than the path_gen it entered with. See path_enter.
+*/
 struct fuse_context_i
 {
   struct fuse_context ctx;
   fuse_req_t req;
+  uint64_t path_gen;
+  uint32_t path_depth;
+  struct fuse_context_i *prev;
+  struct fuse_context_i *next;
 };
 
 static pthread_key_t fuse_context_key;
 static pthread_mutex_t fuse_context_lock = PTHREAD_MUTEX_INITIALIZER;
 static int fuse_context_ref;
+static struct fuse_context_i *fuse_contexts;
 
 /*
   Why was the nodeid:generation logic simplified?
@@ -188,9 +211,7 @@ static
 uint64_t
 generate_nodeid(nodeid_gen_t *ng_)
 {
-  ng_->nodeid++;
-
-  return ng_->nodeid;
+  return __atomic_add_fetch(&ng_->nodeid,1,__ATOMIC_RELAXED);
 }
 
 static
@@ -259,28 +280,78 @@ list_del(struct list_head *entry)
 }
 
 static
-size_t
-id_hash(struct fuse *f,
-        uint64_t     ino)
+inline
+void
+node_shard_lock(node_shard_t *s_)
 {
-  uint64_t hash = ((uint32_t)ino * 2654435761U) % f->id_table.size;
-  uint64_t oldhash = hash % (f->id_table.size / 2);
+  if(pthread_mutex_trylock(&s_->lock) != 0)
+    {
+      pthread_mutex_lock(&s_->lock);
+      s_->contentions++;
+    }
 
-  if(oldhash >= f->id_table.split)
-    return oldhash;
-  else
-    return hash;
+  s_->acquisitions++;
+}
+
+static
+inline
+void
+node_shard_unlock(node_shard_t *s_)
+{
+  pthread_mutex_unlock(&s_->lock);
 }
 
+/*
+  The top bits of a hash select the shard and the low bits the slot
+  within the shard's table.
+*/
+static
+inline
+uint64_t
+id_hash(const uint64_t ino_)
+{
+  return (ino_ * 0x9E3779B97F4A7C15ULL);
+}
+
+static
+uint64_t
+name_hash(const uint64_t  parent_,
+          const char     *name_)
+{
+  return wyhash(name_,strlen(name_),parent_,_wyp);
+}
+
+static
+inline
+node_shard_t*
+id_shard(struct fuse    *f_,
+         const uint64_t  hash_)
+{
+  return &f_->id_shards[hash_ >> (64 - NODE_TABLE_SHARD_BITS)];
+}
+
+static
+inline
+node_shard_t*
+name_shard(struct fuse    *f_,
+           const uint64_t  hash_)
+{
+  return &f_->name_shards[hash_ >> (64 - NODE_TABLE_SHARD_BITS)];
+}
+
+/* Caller must hold the id shard lock of nodeid */
 static
 node_t*
 get_node_nocheck(struct fuse *f,
                  uint64_t     nodeid)
 {
-  size_t hash = id_hash(f,nodeid);
+  uint64_t hash = id_hash(nodeid);
+  node_table_t *t = &id_shard(f,hash)->table;
+  node_table_probe_t p;
   node_t *node;
 
-  for(node = f->id_table.array[hash]; node != NULL; node = node->id_next)
+  node_table_probe_begin(t,hash,&p);
+  while((node = node_table_probe_next(t,&p)) != NULL)
     if(node->nodeid == nodeid)
       return node;
 
@@ -304,21 +375,212 @@ get_node(struct fuse      *f,
   return node;
 }
 
+static
+inline
+void
+node_lock(struct fuse  *f_,
+          const node_t *node_)
+{
+  node_shard_lock(id_shard(f_,id_hash(node_->nodeid)));
+}
+
+static
+inline
+void
+node_unlock(struct fuse  *f_,
+            const node_t *node_)
+{
+  node_shard_unlock(id_shard(f_,id_hash(node_->nodeid)));
+}
+
+/* Returns the node with its id shard locked. Release with node_unlock() */
+static
+node_t*
+get_node_locked(struct fuse    *f_,
+                const uint64_t  nodeid_)
+{
+  node_shard_lock(id_shard(f_,id_hash(nodeid_)));
+
+  return get_node(f_,nodeid_);
+}
+
+static
+inline
+void
+node_ref(node_t *node_)
+{
+  __atomic_add_fetch(&node_->refctr,1,__ATOMIC_RELAXED);
+}
+
+/*
+  A node whose refctr has dropped to zero is being deleted and must
+  not be revived by a concurrent lookup.
+*/
+static
+int
+node_ref_unless_zero(node_t *node_)
+{
+  uint32_t refctr;
+
+  refctr = __atomic_load_n(&node_->refctr,__ATOMIC_RELAXED);
+  do
+    {
+      if(refctr == 0)
+        return 0;
+    }
+  while(!__atomic_compare_exchange_n(&node_->refctr,&refctr,refctr + 1,
+                                     true,__ATOMIC_ACQUIRE,__ATOMIC_RELAXED));
+
+  return 1;
+}
+
+/*
+  Remembered nodes, those the kernel has forgotten but which are kept
+  for `remember` seconds, are kept on an intrusive list ordered by the
+  time they were forgotten. Since that time comes from a monotonic
+  clock appending keeps the list sorted so the oldest are always at
+  the head and insert, removal and expiry are O(1). A node looked up
+  again is removed and is appended anew when next forgotten making the
+  list LRU ordered which is what remember_max evicts by.
+
+  All of the below require remembered_lock.
+*/
+static
+inline
+int
+remembered_contains(struct fuse  *f_,
+                    const node_t *node_)
+{
+  return ((node_->remembered_prev != NULL) || (f_->remembered_head == node_));
+}
+
+static
+void
+remembered_append(struct fuse *f_,
+                  node_t      *node_)
+{
+  node_->remembered_prev = f_->remembered_tail;
+  node_->remembered_next = NULL;
+  if(f_->remembered_tail)
+    f_->remembered_tail->remembered_next = node_;
+  else
+    f_->remembered_head = node_;
+  f_->remembered_tail = node_;
+  f_->remembered_count++;
+}
+
+static
+void
+remembered_unlink(struct fuse *f_,
+                  node_t      *node_)
+{
+  if(node_->remembered_prev)
+    node_->remembered_prev->remembered_next = node_->remembered_next;
+  else
+    f_->remembered_head = node_->remembered_next;
+  if(node_->remembered_next)
+    node_->remembered_next->remembered_prev = node_->remembered_prev;
+  else
+    f_->remembered_tail = node_->remembered_prev;
+  node_->remembered_prev = NULL;
+  node_->remembered_next = NULL;
+  f_->remembered_count--;
+}
+
 static
 void
 remove_remembered_node(struct fuse *f_,
                        node_t *node_)
 {
-  for(size_t i = 0; i < kv_size(f_->remembered_nodes); i++)
+  pthread_mutex_lock(&f_->remembered_lock);
+  if(remembered_contains(f_,node_))
+    remembered_unlink(f_,node_);
+  pthread_mutex_unlock(&f_->remembered_lock);
+}
+
+/*
+  remembered_lock is taken after a node's shard lock elsewhere so here
+  the shard lock is only tried and -EBUSY returned if busy. Active
+  directories are not forgotten, they are moved to the tail as if just
+  forgotten and -EAGAIN returned. *dead_ is set if the node dropped to
+  zero refs and needs deleting once remembered_lock is released.
+*/
+static
+int
+remembered_forget(struct fuse *f_,
+                  node_t      *node_,
+                  time_t       now_,
+                  node_t     **dead_)
+{
+  node_shard_t *s;
+
+  s = id_shard(f_,id_hash(node_->nodeid));
+  if(pthread_mutex_trylock(&s->lock) != 0)
+    return -EBUSY;
+
+  assert(node_->nlookup == 1);
+
+  remembered_unlink(f_,node_);
+  if(__atomic_load_n(&node_->refctr,__ATOMIC_RELAXED) > 1)
     {
-      if(kv_A(f_->remembered_nodes,i).node != node_)
-        continue;
+      node_->remembered_time = now_;
+      remembered_append(f_,node_);
+      pthread_mutex_unlock(&s->lock);
+      return -EAGAIN;
+    }
 
-      kv_delete(f_->remembered_nodes,i);
-      break;
+  *dead_ = NULL;
+  node_->nlookup = 0;
+  if(__atomic_sub_fetch(&node_->refctr,1,__ATOMIC_ACQ_REL) == 0)
+    *dead_ = node_;
+  pthread_mutex_unlock(&s->lock);
+
+  return 0;
+}
+
+#define MAX_EVICT_CHECK 8
+
+/*
+  Forgets least recently used nodes while over remember_max. Returns
+  the number of nodes put in dead_ to be deleted by the caller.
+*/
+static
+int
+remembered_evict(struct fuse *f_,
+                 time_t       now_,
+                 node_t     **dead_,
+                 const int    max_dead_)
+{
+  int rv;
+  int deadcnt;
+  node_t *node;
+  node_t *next;
+
+  deadcnt = 0;
+  node = f_->remembered_head;
+  for(int i = 0; (i < MAX_EVICT_CHECK) && (node != NULL); i++)
+    {
+      if(f_->remembered_count <= f_->conf.remember_max)
+        break;
+      if(deadcnt >= max_dead_)
+        break;
+
+      next = node->remembered_next;
+      rv = remembered_forget(f_,node,now_,&dead_[deadcnt]);
+      if(rv == 0)
+        {
+          f_->remembered_evictions++;
+          if(dead_[deadcnt])
+            deadcnt++;
+        }
+      node = next;
     }
+
+  return deadcnt;
 }
 
+#undef MAX_EVICT_CHECK
+
 static
 uint32_t
 stat_crc32b(const struct stat *st_)
@@ -359,65 +621,36 @@ current_time()
   return now.tv_sec;
 }
 
+/*
+  Nodes cache their full path once built. Rather than walking the
+  subtree on rename or unlink of a directory path_gen is bumped which
+  invalidates every cached path at once. Every cached string, live or
+  stale, counts against path_cache_max until freed.
+*/
 static
 void
-free_node(struct fuse *f_,
-          node_t      *node_)
-{
-  filename_free(f_,node_->name);
-
-  if(node_->hidden_fh)
-    f_->fs->op.free_hide(node_->hidden_fh);
-
-  node_free(node_);
-}
-
-static
-void
-node_table_reduce(struct node_table *t)
+path_cache_free(struct fuse *f_,
+                char        *path_)
 {
-  size_t newsize = t->size / 2;
-  void *newarray;
-
-  if(newsize < NODE_TABLE_MIN_SIZE)
+  if(path_ == NULL)
     return;
 
-  newarray = realloc(t->array,sizeof(node_t*) * newsize);
-  if(newarray != NULL)
-    t->array = newarray;
-
-  t->size = newsize;
-  t->split = t->size / 2;
+  __atomic_sub_fetch(&f_->path_cache_size,strlen(path_) + 1,__ATOMIC_RELAXED);
+  free(path_);
 }
 
 static
 void
-remerge_id(struct fuse *f)
+free_node(struct fuse *f_,
+          node_t      *node_)
 {
-  struct node_table *t = &f->id_table;
-  int iter;
-
-  if(t->split == 0)
-    node_table_reduce(t);
-
-  for(iter = 8; t->split > 0 && iter; iter--)
-    {
-      node_t **upper;
-
-      t->split--;
-      upper = &t->array[t->split + t->size / 2];
-      if(*upper)
-        {
-          node_t **nodep;
+  filename_free(f_,node_->name);
+  path_cache_free(f_,node_->path);
 
-          for(nodep = &t->array[t->split]; *nodep;
-              nodep = &(*nodep)->id_next);
+  if(node_->hidden_fh)
+    f_->fs->op.free_hide(node_->hidden_fh);
 
-          *nodep = *upper;
-          *upper = NULL;
-          break;
-        }
-    }
+  node_free(node_);
 }
 
 static
@@ -425,73 +658,12 @@ void
 unhash_id(struct fuse *f,
           node_t      *node)
 {
-  node_t **nodep = &f->id_table.array[id_hash(f,node->nodeid)];
-
-  for(; *nodep != NULL; nodep = &(*nodep)->id_next)
-    if(*nodep == node)
-      {
-        *nodep = node->id_next;
-        f->id_table.use--;
-
-        if(f->id_table.use < f->id_table.size / 4)
-          remerge_id(f);
-        return;
-      }
-}
+  uint64_t hash = id_hash(node->nodeid);
+  node_shard_t *s = id_shard(f,hash);
 
-static
-int
-node_table_resize(struct node_table *t)
-{
-  size_t newsize = t->size * 2;
-  void *newarray;
-
-  newarray = realloc(t->array,sizeof(node_t*) * newsize);
-  if(newarray == NULL)
-    return -1;
-
-  t->array = newarray;
-  memset(t->array + t->size,0,t->size * sizeof(node_t*));
-  t->size = newsize;
-  t->split = 0;
-
-  return 0;
-}
-
-static
-void
-rehash_id(struct fuse *f)
-{
-  struct node_table *t = &f->id_table;
-  node_t **nodep;
-  node_t **next;
-  size_t hash;
-
-  if(t->split == t->size / 2)
-    return;
-
-  hash = t->split;
-  t->split++;
-  for(nodep = &t->array[hash]; *nodep != NULL; nodep = next)
-    {
-      node_t *node = *nodep;
-      size_t newhash = id_hash(f,node->nodeid);
-
-      if(newhash != hash)
-        {
-          next = nodep;
-          *nodep = node->id_next;
-          node->id_next = t->array[newhash];
-          t->array[newhash] = node;
-        }
-      else
-        {
-          next = &node->id_next;
-        }
-    }
-
-  if(t->split == t->size / 2)
-    node_table_resize(t);
+  node_shard_lock(s);
+  node_table_remove(&s->table,hash,node);
+  node_shard_unlock(s);
 }
 
 static
@@ -499,35 +671,12 @@ void
 hash_id(struct fuse *f,
         node_t      *node)
 {
-  size_t hash;
-
-  hash = id_hash(f,node->nodeid);
-  node->id_next = f->id_table.array[hash];
-  f->id_table.array[hash] = node;
-  f->id_table.use++;
+  uint64_t hash = id_hash(node->nodeid);
+  node_shard_t *s = id_shard(f,hash);
 
-  if(f->id_table.use >= f->id_table.size / 2)
-    rehash_id(f);
-}
-
-static
-size_t
-name_hash(struct fuse *f,
-          uint64_t     parent,
-          const char  *name)
-{
-  uint64_t hash = parent;
-  uint64_t oldhash;
-
-  for(; *name; name++)
-    hash = hash * 31 + (unsigned char)*name;
-
-  hash %= f->name_table.size;
-  oldhash = hash % (f->name_table.size / 2);
-  if(oldhash >= f->name_table.split)
-    return oldhash;
-  else
-    return hash;
+  node_shard_lock(s);
+  node_table_insert(&s->table,hash,node);
+  node_shard_unlock(s);
 }
 
 static
@@ -535,35 +684,52 @@ void
 unref_node(struct fuse *f,
            node_t      *node);
 
+/* Caller must be between path_enter and path_leave */
 static
 void
-remerge_name(struct fuse *f)
+path_cache_store(struct fuse *f_,
+                 uint64_t     nodeid_,
+                 uint64_t     gen_,
+                 const char  *path_,
+                 size_t       len_)
 {
-  int iter;
-  struct node_table *t = &f->name_table;
-
-  if(t->split == 0)
-    node_table_reduce(t);
+  char *old;
+  char *path;
+  node_t *node;
+  uint64_t max;
+  uint64_t size;
 
-  for(iter = 8; t->split > 0 && iter; iter--)
-    {
-      node_t **upper;
+  max = ((uint64_t)f_->conf.path_cache_max << 20);
+  if(max == 0)
+    return;
 
-      t->split--;
-      upper = &t->array[t->split + t->size / 2];
-      if(*upper)
-        {
-          node_t **nodep;
+  path = malloc(len_ + 1);
+  if(path == NULL)
+    return;
+  memcpy(path,path_,len_);
+  path[len_] = '\0';
 
-          for(nodep = &t->array[t->split]; *nodep; nodep = &(*nodep)->name_next);
+  size = __atomic_add_fetch(&f_->path_cache_size,len_ + 1,__ATOMIC_RELAXED);
 
-          *nodep = *upper;
-          *upper = NULL;
-          break;
-        }
+  node = get_node_locked(f_,nodeid_);
+  old = node->path;
+  if(old)
+    size -= (strlen(old) + 1);
+  if((node->name != NULL) && (size <= max))
+    {
+      node->path     = path;
+      node->path_gen = gen_;
+      path = old;
     }
+  node_unlock(f_,node);
+
+  path_cache_free(f_,path);
 }
 
+/*
+  The caller must own the node's name: either by holding its
+  treelock for writing or by being the one deleting it.
+*/
 static
 void
 unhash_name(struct fuse *f,
@@ -571,67 +737,71 @@ unhash_name(struct fuse *f,
 {
   if(node->name)
     {
-      size_t hash = name_hash(f,node->parent->nodeid,node->name);
-      node_t **nodep = &f->name_table.array[hash];
-
-      for(; *nodep != NULL; nodep = &(*nodep)->name_next)
-        if(*nodep == node)
-          {
-            *nodep = node->name_next;
-            node->name_next = NULL;
-            unref_node(f,node->parent);
-            filename_free(f,node->name);
-            node->name = NULL;
-            node->parent = NULL;
-            f->name_table.use--;
-
-            if(f->name_table.use < f->name_table.size / 4)
-              remerge_name(f);
-            return;
-          }
+      char *name;
+      char *path;
+      node_t *parent;
+      uint64_t hash = name_hash(node->parent->nodeid,node->name);
+      node_shard_t *s = name_shard(f,hash);
+
+      node_shard_lock(s);
+      if(node_table_remove(&s->table,hash,node) == -1)
+        {
+          fprintf(stderr,
+                  "fuse internal error: unable to unhash node: %llu\n",
+                  (unsigned long long)node->nodeid);
 
-      fprintf(stderr,
-              "fuse internal error: unable to unhash node: %llu\n",
-              (unsigned long long)node->nodeid);
+          abort();
+        }
 
-      abort();
+      node_lock(f,node);
+      name   = node->name;
+      parent = node->parent;
+      path   = node->path;
+      node->name = NULL;
+      node->parent = NULL;
+      node->path = NULL;
+      node_unlock(f,node);
+      node_shard_unlock(s);
+
+      /* only nodes with children have refs beyond their own */
+      if(__atomic_load_n(&node->refctr,__ATOMIC_ACQUIRE) > 1)
+        __atomic_add_fetch(&f->path_gen,1,__ATOMIC_RELEASE);
+
+      unref_node(f,parent);
+      filename_free(f,name);
+      path_cache_free(f,path);
     }
 }
 
+/* Caller must hold the name shard lock for hash */
 static
-void
-rehash_name(struct fuse *f)
-{
-  struct node_table *t = &f->name_table;
-  node_t **nodep;
-  node_t **next;
-  size_t hash;
+int
+hash_name_locked(struct fuse  *f,
+                 node_shard_t *s,
+                 uint64_t      hash,
+                 node_t       *node,
+                 uint64_t      parentid,
+                 const char   *name)
+{
+  char *newname;
+  node_t *parent;
+
+  newname = filename_strdup(f,name);
+  if(newname == NULL)
+    return -1;
 
-  if(t->split == t->size / 2)
-    return;
+  parent = get_node_locked(f,parentid);
+  node_ref(parent);
+  node_unlock(f,parent);
 
-  hash = t->split;
-  t->split++;
-  for(nodep = &t->array[hash]; *nodep != NULL; nodep = next)
-    {
-      node_t *node = *nodep;
-      size_t newhash = name_hash(f,node->parent->nodeid,node->name);
+  node_lock(f,node);
+  node->name   = newname;
+  node->parent = parent;
+  node_unlock(f,node);
 
-      if(newhash != hash)
-        {
-          next = nodep;
-          *nodep = node->name_next;
-          node->name_next = t->array[newhash];
-          t->array[newhash] = node;
-        }
-      else
-        {
-          next = &node->name_next;
-        }
-    }
+  node_table_insert(&s->table,hash,node);
 
-  if(t->split == t->size / 2)
-    node_table_resize(t);
+  return 0;
 }
 
 static
@@ -641,22 +811,15 @@ hash_name(struct fuse *f,
           uint64_t     parentid,
           const char  *name)
 {
-  size_t hash = name_hash(f,parentid,name);
-  node_t *parent = get_node(f,parentid);
-  node->name = filename_strdup(f,name);
-  if(node->name == NULL)
-    return -1;
-
-  parent->refctr++;
-  node->parent = parent;
-  node->name_next = f->name_table.array[hash];
-  f->name_table.array[hash] = node;
-  f->name_table.use++;
+  int rv;
+  uint64_t hash = name_hash(parentid,name);
+  node_shard_t *s = name_shard(f,hash);
 
-  if(f->name_table.use >= f->name_table.size / 2)
-    rehash_name(f);
+  node_shard_lock(s);
+  rv = hash_name_locked(f,s,hash,node,parentid,name);
+  node_shard_unlock(s);
 
-  return 0;
+  return rv;
 }
 
 static
@@ -685,9 +848,11 @@ void
 unref_node(struct fuse *f,
            node_t *node)
 {
-  assert(node->refctr > 0);
-  node->refctr--;
-  if(!node->refctr)
+  uint32_t refctr;
+
+  refctr = __atomic_sub_fetch(&node->refctr,1,__ATOMIC_ACQ_REL);
+  assert(refctr != UINT32_MAX);
+  if(!refctr)
     delete_node(f,node);
 }
 
@@ -704,30 +869,62 @@ rand64(void)
   return rv;
 }
 
+/* Caller must hold the name shard lock for hash */
+static
+node_t*
+lookup_node_locked(node_shard_t *s,
+                   uint64_t      hash,
+                   uint64_t      parent,
+                   const char   *name)
+{
+  node_t *node;
+  node_table_probe_t p;
+
+  node_table_probe_begin(&s->table,hash,&p);
+  while((node = node_table_probe_next(&s->table,&p)) != NULL)
+    {
+      if(__atomic_load_n(&node->refctr,__ATOMIC_RELAXED) == 0)
+        continue;
+      if(node->parent->nodeid == parent && strcmp(node->name,name) == 0)
+        return node;
+    }
+
+  return NULL;
+}
+
 static
 node_t*
 lookup_node(struct fuse *f,
             uint64_t     parent,
             const char  *name)
 {
-  size_t hash;
+  uint64_t hash;
   node_t *node;
+  node_shard_t *s;
 
-  hash =  name_hash(f,parent,name);
-  for(node = f->name_table.array[hash]; node != NULL; node = node->name_next)
-    if(node->parent->nodeid == parent && strcmp(node->name,name) == 0)
-      return node;
+  hash = name_hash(parent,name);
+  s    = name_shard(f,hash);
 
-  return NULL;
+  node_shard_lock(s);
+  node = lookup_node_locked(s,hash,parent,name);
+  node_shard_unlock(s);
+
+  return node;
 }
 
+/* Caller must hold the node's id shard lock */
 static
-void
+int
 inc_nlookup(node_t *node)
 {
   if(!node->nlookup)
-    node->refctr++;
+    {
+      if(!node_ref_unless_zero(node))
+        return -1;
+    }
   node->nlookup++;
+
+  return 0;
 }
 
 static
@@ -736,39 +933,56 @@ find_node(struct fuse *f,
           uint64_t     parent,
           const char  *name)
 {
+  int rv;
+  uint64_t hash;
   node_t *node;
+  node_shard_t *s;
 
-  pthread_mutex_lock(&f->lock);
   if(!name)
-    node = get_node(f,parent);
-  else
-    node = lookup_node(f,parent,name);
-
-  if(node == NULL)
     {
-      node = node_alloc();
-      if(node == NULL)
-        goto out_err;
+      node = get_node_locked(f,parent);
+      if((node->nlookup == 1) && remember_nodes(f))
+        remove_remembered_node(f,node);
+      inc_nlookup(node);
+      node_unlock(f,node);
+
+      return node;
+    }
 
-      node->nodeid = generate_nodeid(&f->nodeid_gen);
-      if(f->conf.remember)
-        inc_nlookup(node);
+  hash = name_hash(parent,name);
+  s    = name_shard(f,hash);
 
-      if(hash_name(f,node,parent,name) == -1)
-        {
-          free_node(f,node);
-          node = NULL;
-          goto out_err;
-        }
-      hash_id(f,node);
+  node_shard_lock(s);
+  node = lookup_node_locked(s,hash,parent,name);
+  if(node != NULL)
+    {
+      node_lock(f,node);
+      if((node->nlookup == 1) && remember_nodes(f))
+        remove_remembered_node(f,node);
+      rv = inc_nlookup(node);
+      node_unlock(f,node);
+      if(rv == 0)
+        goto out;
     }
-  else if((node->nlookup == 1) && remember_nodes(f))
+
+  node = node_alloc();
+  if(node == NULL)
+    goto out;
+
+  node->nodeid  = generate_nodeid(&f->nodeid_gen);
+  node->refctr  = 1;
+  node->nlookup = (remember_nodes(f) ? 2 : 1);
+
+  if(hash_name_locked(f,s,hash,node,parent,name) == -1)
     {
-      remove_remembered_node(f,node);
+      free_node(f,node);
+      node = NULL;
+      goto out;
     }
-  inc_nlookup(node);
- out_err:
-  pthread_mutex_unlock(&f->lock);
+  hash_id(f,node);
+
+ out:
+  node_shard_unlock(s);
   return node;
 }
 
@@ -812,30 +1026,197 @@ add_name(char       **buf,
   return s;
 }
 
+/*
+  Treelocks are only ever tried, never blocked on, while holding shard
+  locks. A thread which gets EAGAIN drops what it holds and waits for
+  treelock_gen to change. Anyone needing a node's readers to drain
+  marks it with TREELOCK_WAIT_OFFSET and anyone blocked by a write lock
+  marks it TREELOCK_WRITE_WAITED so only clearing one of those marks
+  needs to bump the generation.
+*/
 static
 void
+treelock_wait_begin(struct fuse *f_,
+                    uint64_t    *gen_)
+{
+  pthread_mutex_lock(&f_->lock);
+  f_->treelock_waits++;
+  __atomic_add_fetch(&f_->treelock_waiters,1,__ATOMIC_SEQ_CST);
+  *gen_ = f_->treelock_gen;
+  pthread_mutex_unlock(&f_->lock);
+}
+
+static
+void
+treelock_wait(struct fuse *f_,
+              uint64_t    *gen_)
+{
+  pthread_mutex_lock(&f_->lock);
+  while(f_->treelock_gen == *gen_)
+    pthread_cond_wait(&f_->treelock_cond,&f_->lock);
+  *gen_ = f_->treelock_gen;
+  pthread_mutex_unlock(&f_->lock);
+}
+
+static
+void
+treelock_wait_end(struct fuse *f_)
+{
+  __atomic_sub_fetch(&f_->treelock_waiters,1,__ATOMIC_SEQ_CST);
+}
+
+static
+void
+treelock_wake(struct fuse *f_)
+{
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  if(__atomic_load_n(&f_->treelock_waiters,__ATOMIC_SEQ_CST) == 0)
+    return;
+
+  pthread_mutex_lock(&f_->lock);
+  f_->treelock_gen++;
+  pthread_cond_broadcast(&f_->treelock_cond);
+  pthread_mutex_unlock(&f_->lock);
+}
+
+/* Caller must hold the node's id shard lock */
+static
+inline
+void
+treelock_mark_waited(node_t *node_)
+{
+  if(node_->treelock == TREELOCK_WRITE)
+    node_->treelock = TREELOCK_WRITE_WAITED;
+}
+
+static struct fuse_context_i *fuse_get_context_internal(void);
+
+/*
+  Requests only read lock the node they resolve, not its ancestors,
+  so a hit in the path cache touches nothing but that node. What
+  keeps an ancestor from being renamed while a request is using a
+  path through it is a grace period instead: each thread publishes
+  the path_gen it resolved paths under and whoever write locks a
+  node with children bumps path_gen and waits for every other thread
+  which entered before the bump to leave. New requests see the write
+  lock on their way up or miss the cache because of the bump.
+
+  The bump and wait are done by one thread at a time. Anyone else
+  needing one backs off with EAGAIN rather than wait while holding
+  paths the first may be waiting on.
+*/
+static
+uint64_t
+path_enter(struct fuse *f_)
+{
+  uint64_t gen;
+  struct fuse_context_i *c = fuse_get_context_internal();
+
+  if(c->path_depth++)
+    {
+      __atomic_thread_fence(__ATOMIC_SEQ_CST);
+      return __atomic_load_n(&f_->path_gen,__ATOMIC_SEQ_CST);
+    }
+
+  do
+    {
+      gen = __atomic_load_n(&f_->path_gen,__ATOMIC_SEQ_CST);
+      __atomic_store_n(&c->path_gen,gen + 1,__ATOMIC_SEQ_CST);
+      __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    }
+  while(__atomic_load_n(&f_->path_gen,__ATOMIC_SEQ_CST) != gen);
+
+  return gen;
+}
+
+static
+void
+path_leave(void)
+{
+  struct fuse_context_i *c = fuse_get_context_internal();
+
+  if(--c->path_depth == 0)
+    __atomic_store_n(&c->path_gen,0,__ATOMIC_RELEASE);
+}
+
+/* Caller must hold path_grace_lock */
+static
+void
+path_grace(struct fuse *f_)
+{
+  int busy;
+  uint64_t gen;
+  uint64_t other;
+  struct fuse_context_i *c;
+  struct fuse_context_i *self = fuse_get_context_internal();
+
+  gen = __atomic_add_fetch(&f_->path_gen,1,__ATOMIC_SEQ_CST);
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+  do
+    {
+      busy = 0;
+      pthread_mutex_lock(&fuse_context_lock);
+      for(c = fuse_contexts; c != NULL; c = c->next)
+        {
+          if(c == self)
+            continue;
+
+          other = __atomic_load_n(&c->path_gen,__ATOMIC_SEQ_CST);
+          if(other && (other <= gen))
+            {
+              busy = 1;
+              break;
+            }
+        }
+      pthread_mutex_unlock(&fuse_context_lock);
+
+      if(busy)
+        usleep(50);
+    }
+  while(busy);
+}
+
+/* Returns non-zero if waiters need waking */
+static
+int
 unlock_path(struct fuse *f,
             uint64_t     nodeid,
-            node_t *wnode,
-            node_t *end)
+            node_t *wnode)
 {
+  int wake;
   node_t *node;
 
+  wake = 0;
   if(wnode)
     {
-      assert(wnode->treelock == TREELOCK_WRITE);
+      node_lock(f,wnode);
+      assert((wnode->treelock == TREELOCK_WRITE) ||
+             (wnode->treelock == TREELOCK_WRITE_WAITED));
+      wake = (wnode->treelock == TREELOCK_WRITE_WAITED);
       wnode->treelock = 0;
+      node_unlock(f,wnode);
     }
 
-  for(node = get_node(f,nodeid); node != end && node->nodeid != FUSE_ROOT_ID; node = node->parent)
+  if(nodeid != FUSE_ROOT_ID)
     {
+      node = get_node_locked(f,nodeid);
       assert(node->treelock != 0);
       assert(node->treelock != TREELOCK_WAIT_OFFSET);
       assert(node->treelock != TREELOCK_WRITE);
+      assert(node->treelock != TREELOCK_WRITE_WAITED);
       node->treelock--;
       if(node->treelock == TREELOCK_WAIT_OFFSET)
-        node->treelock = 0;
+        {
+          node->treelock = 0;
+          wake = 1;
+        }
+      node_unlock(f,node);
     }
+
+  path_leave();
+
+  return wake;
 }
 
 static
@@ -848,10 +1229,15 @@ try_get_path(struct fuse  *f,
              bool          need_lock)
 {
   unsigned bufsize = 256;
+  unsigned namelen;
   char *buf;
   char *s;
   node_t *node;
+  node_t *leaf;
+  node_t *parent;
   node_t *wnode = NULL;
+  uint64_t gen;
+  int cached;
   int err;
 
   *path = NULL;
@@ -871,26 +1257,65 @@ try_get_path(struct fuse  *f,
       if(s == NULL)
         goto out_free;
     }
+  namelen = (buf + bufsize - 1 - s);
 
-  if(wnodep)
+  gen  = path_enter(f);
+  leaf = get_node_locked(f,nodeid);
+  if(leaf->nodeid != FUSE_ROOT_ID)
     {
-      assert(need_lock);
-      wnode = lookup_node(f,nodeid,name);
-      if(wnode)
+      /*
+        A node being renamed is briefly nameless but is write locked
+        so check the treelock first.
+      */
+      err = -EAGAIN;
+      if(need_lock && (leaf->treelock < 0))
         {
-          if(wnode->treelock != 0)
-            {
-              if(wnode->treelock > 0)
-                wnode->treelock += TREELOCK_WAIT_OFFSET;
-              err = -EAGAIN;
-              goto out_free;
-            }
-          wnode->treelock = TREELOCK_WRITE;
+          treelock_mark_waited(leaf);
+          node_unlock(f,leaf);
+          goto out_leave;
+        }
+
+      err = -ESTALE;
+      if(leaf->name == NULL || leaf->parent == NULL)
+        {
+          node_unlock(f,leaf);
+          goto out_leave;
         }
+
+      if(need_lock)
+        leaf->treelock++;
     }
 
-  for(node = get_node(f,nodeid); node->nodeid != FUSE_ROOT_ID; node = node->parent)
+  cached = 0;
+  if(leaf->path && (leaf->path_gen == gen))
     {
+      s = add_name(&buf,&bufsize,s,&leaf->path[1]);
+      err = -ENOMEM;
+      if(s == NULL)
+        {
+          node_unlock(f,leaf);
+          goto out_unlock_path;
+        }
+      cached = 1;
+    }
+
+  /*
+    Without a cached path walk up building it. Ancestors aren't
+    locked but one being write locked means it is about to change.
+  */
+  node = leaf;
+  while(!cached && (node->nodeid != FUSE_ROOT_ID))
+    {
+      if(need_lock && (node != leaf))
+        {
+          err = -EAGAIN;
+          if(node->treelock < 0)
+            {
+              treelock_mark_waited(node);
+              goto out_unlock;
+            }
+        }
+
       err = -ESTALE;
       if(node->name == NULL || node->parent == NULL)
         goto out_unlock;
@@ -900,13 +1325,67 @@ try_get_path(struct fuse  *f,
       if(s == NULL)
         goto out_unlock;
 
-      if(need_lock)
+      parent = node->parent;
+      node_unlock(f,node);
+      node = parent;
+      node_lock(f,node);
+    }
+  node_unlock(f,node);
+
+  if(need_lock && !cached && (nodeid != FUSE_ROOT_ID))
+    path_cache_store(f,nodeid,gen,s,(buf + bufsize - 1 - s) - namelen);
+
+  if(nodeid != FUSE_ROOT_ID)
+    __atomic_add_fetch((cached ? &f->path_cache_hits : &f->path_cache_misses),
+                       1,__ATOMIC_RELAXED);
+
+  /*
+    The write lock is taken last so a failed attempt only has read
+    locks to undo and doesn't wake waiters for nothing.
+  */
+  if(wnodep)
+    {
+      uint64_t hash = name_hash(nodeid,name);
+      node_shard_t *ns = name_shard(f,hash);
+
+      assert(need_lock);
+      node_shard_lock(ns);
+      wnode = lookup_node_locked(ns,hash,nodeid,name);
+      if(wnode)
+        {
+          node_lock(f,wnode);
+          if(wnode->treelock != 0)
+            {
+              if(wnode->treelock > 0)
+                wnode->treelock += TREELOCK_WAIT_OFFSET;
+              else
+                treelock_mark_waited(wnode);
+              node_unlock(f,wnode);
+              node_shard_unlock(ns);
+              err = -EAGAIN;
+              if(unlock_path(f,nodeid,NULL))
+                treelock_wake(f);
+              goto out_free;
+            }
+          wnode->treelock = TREELOCK_WRITE;
+          node_unlock(f,wnode);
+        }
+      node_shard_unlock(ns);
+
+      /* only nodes with children have refs beyond their own */
+      if(wnode && (__atomic_load_n(&wnode->refctr,__ATOMIC_ACQUIRE) > 1))
         {
           err = -EAGAIN;
-          if(node->treelock < 0)
-            goto out_unlock;
+          if(pthread_mutex_trylock(&f->path_grace_lock) != 0)
+            {
+              unlock_path(f,nodeid,wnode);
+              treelock_wake(f);
+              goto out_free;
+            }
 
-          node->treelock++;
+          path_grace(f);
+          pthread_mutex_unlock(&f->path_grace_lock);
+          treelock_wake(f);
         }
     }
 
@@ -922,8 +1401,14 @@ try_get_path(struct fuse  *f,
   return 0;
 
  out_unlock:
-  if(need_lock)
-    unlock_path(f,nodeid,wnode,node);
+  node_unlock(f,node);
+ out_unlock_path:
+  if(unlock_path(f,nodeid,NULL))
+    treelock_wake(f);
+  goto out_free;
+
+ out_leave:
+  path_leave();
  out_free:
   free(buf);
 
@@ -950,117 +1435,16 @@ try_get_path2(struct fuse  *f,
     {
       err = try_get_path(f,nodeid2,name2,path2,wnode2,true);
       if(err)
-        {
-          node_t *wn1 = wnode1 ? *wnode1 : NULL;
-
-          unlock_path(f,nodeid1,wn1,NULL);
-          free(*path1);
-        }
-    }
-
-  return err;
-}
-
-static
-void
-queue_element_wakeup(struct fuse               *f,
-                     struct lock_queue_element *qe)
-{
-  int err;
-
-  if(!qe->path1)
-    {
-      /* Just waiting for it to be unlocked */
-      if(get_node(f,qe->nodeid1)->treelock == 0)
-        pthread_cond_signal(&qe->cond);
-
-      return;
-    }
-
-  if(qe->done)
-    return;
-
-  if(!qe->path2)
-    {
-      err = try_get_path(f,
-                         qe->nodeid1,
-                         qe->name1,
-                         qe->path1,
-                         qe->wnode1,
-                         true);
-    }
-  else
-    {
-      err = try_get_path2(f,
-                          qe->nodeid1,
-                          qe->name1,
-                          qe->nodeid2,
-                          qe->name2,
-                          qe->path1,
-                          qe->path2,
-                          qe->wnode1,
-                          qe->wnode2);
-    }
-
-  if(err == -EAGAIN)
-    return;
-
-  qe->err = err;
-  qe->done = true;
-  pthread_cond_signal(&qe->cond);
-}
-
-static
-void
-wake_up_queued(struct fuse *f)
-{
-  struct lock_queue_element *qe;
-
-  for(qe = f->lockq; qe != NULL; qe = qe->next)
-    queue_element_wakeup(f,qe);
-}
-
-static
-void
-queue_path(struct fuse               *f,
-           struct lock_queue_element *qe)
-{
-  struct lock_queue_element **qp;
-
-  qe->done = false;
-  pthread_cond_init(&qe->cond,NULL);
-  qe->next = NULL;
-  for(qp = &f->lockq; *qp != NULL; qp = &(*qp)->next);
-  *qp = qe;
-}
-
-static
-void
-dequeue_path(struct fuse               *f,
-             struct lock_queue_element *qe)
-{
-  struct lock_queue_element **qp;
-
-  pthread_cond_destroy(&qe->cond);
-  for(qp = &f->lockq; *qp != qe; qp = &(*qp)->next);
-  *qp = qe->next;
-}
-
-static
-int
-wait_path(struct fuse               *f,
-          struct lock_queue_element *qe)
-{
-  queue_path(f,qe);
-
-  do
-    {
-      pthread_cond_wait(&qe->cond,&f->lock);
-    } while(!qe->done);
+        {
+          node_t *wn1 = wnode1 ? *wnode1 : NULL;
 
-  dequeue_path(f,qe);
+          if(unlock_path(f,nodeid1,wn1))
+            treelock_wake(f);
+          free(*path1);
+        }
+    }
 
-  return qe->err;
+  return err;
 }
 
 static
@@ -1073,20 +1457,16 @@ get_path_common(struct fuse  *f,
 {
   int err;
 
-  pthread_mutex_lock(&f->lock);
   err = try_get_path(f,nodeid,name,path,wnode,true);
   if(err == -EAGAIN)
     {
-      struct lock_queue_element qe = {0};
+      uint64_t gen;
 
-      qe.nodeid1 = nodeid;
-      qe.name1   = name;
-      qe.path1   = path;
-      qe.wnode1  = wnode;
-
-      err = wait_path(f,&qe);
+      treelock_wait_begin(f,&gen);
+      while((err = try_get_path(f,nodeid,name,path,wnode,true)) == -EAGAIN)
+        treelock_wait(f,&gen);
+      treelock_wait_end(f);
     }
-  pthread_mutex_unlock(&f->lock);
 
   return err;
 }
@@ -1135,25 +1515,18 @@ get_path2(struct fuse  *f,
 {
   int err;
 
-  pthread_mutex_lock(&f->lock);
   err = try_get_path2(f,nodeid1,name1,nodeid2,name2,
                       path1,path2,wnode1,wnode2);
   if(err == -EAGAIN)
     {
-      struct lock_queue_element qe = {0};
-
-      qe.nodeid1 = nodeid1;
-      qe.name1   = name1;
-      qe.path1   = path1;
-      qe.wnode1  = wnode1;
-      qe.nodeid2 = nodeid2;
-      qe.name2   = name2;
-      qe.path2   = path2;
-      qe.wnode2  = wnode2;
-
-      err = wait_path(f,&qe);
+      uint64_t gen;
+
+      treelock_wait_begin(f,&gen);
+      while((err = try_get_path2(f,nodeid1,name1,nodeid2,name2,
+                                 path1,path2,wnode1,wnode2)) == -EAGAIN)
+        treelock_wait(f,&gen);
+      treelock_wait_end(f);
     }
-  pthread_mutex_unlock(&f->lock);
 
   return err;
 }
@@ -1165,11 +1538,8 @@ free_path_wrlock(struct fuse *f,
                  node_t *wnode,
                  char        *path)
 {
-  pthread_mutex_lock(&f->lock);
-  unlock_path(f,nodeid,wnode,NULL);
-  if(f->lockq)
-    wake_up_queued(f);
-  pthread_mutex_unlock(&f->lock);
+  if(unlock_path(f,nodeid,wnode))
+    treelock_wake(f);
   free(path);
 }
 
@@ -1193,11 +1563,12 @@ free_path2(struct fuse *f,
            char        *path1,
            char        *path2)
 {
-  pthread_mutex_lock(&f->lock);
-  unlock_path(f,nodeid1,wnode1,NULL);
-  unlock_path(f,nodeid2,wnode2,NULL);
-  wake_up_queued(f);
-  pthread_mutex_unlock(&f->lock);
+  int wake;
+
+  wake  = unlock_path(f,nodeid1,wnode1);
+  wake |= unlock_path(f,nodeid2,wnode2);
+  if(wake)
+    treelock_wake(f);
   free(path1);
   free(path2);
 }
@@ -1208,33 +1579,38 @@ forget_node(struct fuse      *f,
             const uint64_t    nodeid,
             const uint64_t    nlookup)
 {
+  int deadcnt;
   node_t *node;
+  node_t *dead[2];
 
   if(nodeid == FUSE_ROOT_ID)
     return;
 
-  pthread_mutex_lock(&f->lock);
-  node = get_node(f,nodeid);
+  node = get_node_locked(f,nodeid);
 
   /*
    * Node may still be locked due to interrupt idiocy in open,
    * create and opendir
    */
-  while(node->nlookup == nlookup && node->treelock)
+  if((node->nlookup == nlookup) && node->treelock)
     {
-      struct lock_queue_element qe = {0};
-
-      qe.nodeid1 = nodeid;
+      uint64_t gen;
 
-      queue_path(f,&qe);
-
-      do
+      node_unlock(f,node);
+      treelock_wait_begin(f,&gen);
+      for(;;)
         {
-          pthread_cond_wait(&qe.cond,&f->lock);
+          node_lock(f,node);
+          if(!((node->nlookup == nlookup) && node->treelock))
+            break;
+          if(node->treelock > 0)
+            node->treelock += TREELOCK_WAIT_OFFSET;
+          else
+            treelock_mark_waited(node);
+          node_unlock(f,node);
+          treelock_wait(f,&gen);
         }
-      while((node->nlookup == nlookup) && node->treelock);
-
-      dequeue_path(f,&qe);
+      treelock_wait_end(f);
     }
 
   assert(node->nlookup >= nlookup);
@@ -1242,19 +1618,29 @@ forget_node(struct fuse      *f,
 
   if(node->nlookup == 0)
     {
+      node_unlock(f,node);
       unref_node(f,node);
+      return;
     }
-  else if((node->nlookup == 1) && remember_nodes(f))
-    {
-      remembered_node_t fn;
 
-      fn.node = node;
-      fn.time = current_time();
-
-      kv_push(remembered_node_t,f->remembered_nodes,fn);
+  deadcnt = 0;
+  if((node->nlookup == 1) && remember_nodes(f))
+    {
+      time_t now = current_time();
+
+      pthread_mutex_lock(&f->remembered_lock);
+      node->remembered_time = now;
+      remembered_append(f,node);
+      if(f->conf.remember_max &&
+         (f->remembered_count > f->conf.remember_max))
+        deadcnt = remembered_evict(f,now,dead,2);
+      pthread_mutex_unlock(&f->remembered_lock);
     }
 
-  pthread_mutex_unlock(&f->lock);
+  node_unlock(f,node);
+
+  for(int i = 0; i < deadcnt; i++)
+    delete_node(f,dead[i]);
 }
 
 static
@@ -1264,8 +1650,10 @@ unlink_node(struct fuse *f,
 {
   if(remember_nodes(f))
     {
+      node_lock(f,node);
       assert(node->nlookup > 1);
       node->nlookup--;
+      node_unlock(f,node);
     }
   unhash_name(f,node);
 }
@@ -1278,11 +1666,9 @@ remove_node(struct fuse *f,
 {
   node_t *node;
 
-  pthread_mutex_lock(&f->lock);
   node = lookup_node(f,dir,name);
   if(node != NULL)
     unlink_node(f,node);
-  pthread_mutex_unlock(&f->lock);
 }
 
 static
@@ -1295,27 +1681,20 @@ rename_node(struct fuse *f,
 {
   node_t *node;
   node_t *newnode;
-  int err = 0;
 
-  pthread_mutex_lock(&f->lock);
   node = lookup_node(f,olddir,oldname);
   newnode = lookup_node(f,newdir,newname);
   if(node == NULL)
-    goto out;
+    return 0;
 
   if(newnode != NULL)
     unlink_node(f,newnode);
 
   unhash_name(f,node);
   if(hash_name(f,node,newdir,newname) == -1)
-    {
-      err = -ENOMEM;
-      goto out;
-    }
+    return -ENOMEM;
 
- out:
-  pthread_mutex_unlock(&f->lock);
-  return err;
+  return 0;
 }
 
 static
@@ -1377,9 +1756,9 @@ set_path_info(struct fuse             *f,
   e->ino        = node->nodeid;
   e->generation = ((e->ino == FUSE_ROOT_ID) ? 0 : f->nodeid_gen.generation);
 
-  pthread_mutex_lock(&f->lock);
+  node_lock(f,node);
   update_stat(node,&e->attr);
-  pthread_mutex_unlock(&f->lock);
+  node_unlock(f,node);
 
   set_stat(f,e->ino,&e->attr);
 
@@ -1438,14 +1817,38 @@ fuse_get_context_internal(void)
           abort();
         }
       pthread_setspecific(fuse_context_key,c);
+
+      pthread_mutex_lock(&fuse_context_lock);
+      c->next = fuse_contexts;
+      if(fuse_contexts)
+        fuse_contexts->prev = c;
+      fuse_contexts = c;
+      pthread_mutex_unlock(&fuse_context_lock);
     }
   return c;
 }
 
+/* Caller must hold fuse_context_lock */
+static
+void
+fuse_context_unlink(struct fuse_context_i *c_)
+{
+  if(c_->prev)
+    c_->prev->next = c_->next;
+  else
+    fuse_contexts = c_->next;
+  if(c_->next)
+    c_->next->prev = c_->prev;
+}
+
 static
 void
 fuse_freecontext(void *data)
 {
+  pthread_mutex_lock(&fuse_context_lock);
+  fuse_context_unlink(data);
+  pthread_mutex_unlock(&fuse_context_lock);
+
   free(data);
 }
 
@@ -1479,7 +1882,11 @@ fuse_delete_context_key(void)
   fuse_context_ref--;
   if(!fuse_context_ref)
     {
-      free(pthread_getspecific(fuse_context_key));
+      struct fuse_context_i *c = pthread_getspecific(fuse_context_key);
+
+      if(c)
+        fuse_context_unlink(c);
+      free(c);
       pthread_key_delete(fuse_context_key);
     }
   pthread_mutex_unlock(&fuse_context_lock);
@@ -1570,17 +1977,19 @@ fuse_lib_lookup(fuse_req_t             req,
     {
       if(name[1] == '\0')
         {
+          node_shard_t *s = id_shard(f,id_hash(nodeid));
+
           name = NULL;
-          pthread_mutex_lock(&f->lock);
+          node_shard_lock(s);
           dot = get_node_nocheck(f,nodeid);
           if(dot == NULL)
             {
-              pthread_mutex_unlock(&f->lock);
+              node_shard_unlock(s);
               reply_entry(req,&e,-ESTALE);
               return;
             }
-          dot->refctr++;
-          pthread_mutex_unlock(&f->lock);
+          node_ref(dot);
+          node_shard_unlock(s);
         }
       else if((name[1] == '.') && (name[2] == '\0'))
         {
@@ -1590,10 +1999,12 @@ fuse_lib_lookup(fuse_req_t             req,
               return;
             }
 
+          node_t *node;
+
           name = NULL;
-          pthread_mutex_lock(&f->lock);
-          nodeid = get_node(f,nodeid)->parent->nodeid;
-          pthread_mutex_unlock(&f->lock);
+          node = get_node_locked(f,nodeid);
+          nodeid = node->parent->nodeid;
+          node_unlock(f,node);
         }
     }
 
@@ -1610,11 +2021,7 @@ fuse_lib_lookup(fuse_req_t             req,
     }
 
   if(dot)
-    {
-      pthread_mutex_lock(&f->lock);
-      unref_node(f,dot);
-      pthread_mutex_unlock(&f->lock);
-    }
+    unref_node(f,dot);
 
   reply_entry(req,&e,err);
 }
@@ -1682,11 +2089,10 @@ fuse_lib_getattr(fuse_req_t             req,
     }
   else
     {
-      pthread_mutex_lock(&f->lock);
-      node = get_node(f,hdr_->nodeid);
+      node = get_node_locked(f,hdr_->nodeid);
       if(node->hidden_fh)
         ffi.fh = node->hidden_fh;
-      pthread_mutex_unlock(&f->lock);
+      node_unlock(f,node);
     }
 
   memset(&buf,0,sizeof(buf));
@@ -1707,10 +2113,9 @@ fuse_lib_getattr(fuse_req_t             req,
 
   if(!err)
     {
-      pthread_mutex_lock(&f->lock);
-      node = get_node(f,hdr_->nodeid);
+      node = get_node_locked(f,hdr_->nodeid);
       update_stat(node,&buf);
-      pthread_mutex_unlock(&f->lock);
+      node_unlock(f,node);
       set_stat(f,hdr_->nodeid,&buf);
       fuse_reply_attr(req,&buf,timeout.attr);
     }
@@ -1745,14 +2150,13 @@ fuse_lib_setattr(fuse_req_t             req,
     }
   else
     {
-      pthread_mutex_lock(&f->lock);
-      node = get_node(f,hdr_->nodeid);
+      node = get_node_locked(f,hdr_->nodeid);
       if(node->hidden_fh)
         {
           fi = &ffi;
           fi->fh = node->hidden_fh;
         }
-      pthread_mutex_unlock(&f->lock);
+      node_unlock(f,node);
     }
 
   err = 0;
@@ -1831,9 +2235,9 @@ fuse_lib_setattr(fuse_req_t             req,
 
   if(!err)
     {
-      pthread_mutex_lock(&f->lock);
-      update_stat(get_node(f,hdr_->nodeid),&stbuf);
-      pthread_mutex_unlock(&f->lock);
+      node = get_node_locked(f,hdr_->nodeid);
+      update_stat(node,&stbuf);
+      node_unlock(f,node);
       set_stat(f,hdr_->nodeid,&stbuf);
       fuse_reply_attr(req,&stbuf,timeout.attr);
     }
@@ -1998,10 +2402,13 @@ fuse_lib_unlink(fuse_req_t             req,
 
   if(!err)
     {
-      pthread_mutex_lock(&f->lock);
-      if(node_open(wnode))
-        err = f->fs->op.prepare_hide(path,&wnode->hidden_fh);
-      pthread_mutex_unlock(&f->lock);
+      if(wnode)
+        {
+          node_lock(f,wnode);
+          if(node_open(wnode))
+            err = f->fs->op.prepare_hide(path,&wnode->hidden_fh);
+          node_unlock(f,wnode);
+        }
 
       err = f->fs->op.unlink(path);
       if(!err)
@@ -2089,15 +2496,37 @@ fuse_lib_rename(fuse_req_t             req,
   newname = (oldname + strlen(oldname) + 1);
 
   f = req_fuse_prepare(req);
+
+  /*
+    The kernel normally completes a rename onto the same name itself
+    but can forward one if its dentries changed in between. Write
+    locking both would then wait on itself forever.
+  */
+  if((hdr_->nodeid == arg->newdir) && (strcmp(oldname,newname) == 0))
+    {
+      err = get_path_wrlock(f,hdr_->nodeid,oldname,&oldpath,&wnode1);
+      if(!err)
+        {
+          err = f->fs->op.rename(oldpath,oldpath);
+          free_path_wrlock(f,hdr_->nodeid,wnode1,oldpath);
+        }
+
+      fuse_reply_err(req,err);
+      return;
+    }
+
   err = get_path2(f,hdr_->nodeid,oldname,arg->newdir,newname,
                   &oldpath,&newpath,&wnode1,&wnode2);
 
   if(!err)
     {
-      pthread_mutex_lock(&f->lock);
-      if(node_open(wnode2))
-        err = f->fs->op.prepare_hide(newpath,&wnode2->hidden_fh);
-      pthread_mutex_unlock(&f->lock);
+      if(wnode2)
+        {
+          node_lock(f,wnode2);
+          if(node_open(wnode2))
+            err = f->fs->op.prepare_hide(newpath,&wnode2->hidden_fh);
+          node_unlock(f,wnode2);
+        }
 
       err = f->fs->op.rename(oldpath,newpath);
       if(!err)
@@ -2155,9 +2584,8 @@ fuse_do_release(struct fuse      *f,
 
   f->fs->op.release(fi);
 
-  pthread_mutex_lock(&f->lock);
+  node = get_node_locked(f,ino);
   {
-    node = get_node(f,ino);
     assert(node->open_count > 0);
     node->open_count--;
 
@@ -2167,7 +2595,7 @@ fuse_do_release(struct fuse      *f,
         node->hidden_fh = 0;
       }
   }
-  pthread_mutex_unlock(&f->lock);
+  node_unlock(f,node);
 
   if(fh)
     f->fs->op.free_hide(fh);
@@ -2220,9 +2648,11 @@ fuse_lib_create(fuse_req_t             req,
 
   if(!err)
     {
-      pthread_mutex_lock(&f->lock);
-      get_node(f,e.ino)->open_count++;
-      pthread_mutex_unlock(&f->lock);
+      node_t *node;
+
+      node = get_node_locked(f,e.ino);
+      node->open_count++;
+      node_unlock(f,node);
 
       if(fuse_reply_create(req,&e,&ffi) == -ENOENT)
         {
@@ -2250,17 +2680,15 @@ open_auto_cache(struct fuse      *f,
   node_t *node;
   fuse_timeouts_t timeout;
 
-  pthread_mutex_lock(&f->lock);
-
-  node = get_node(f,ino);
+  node = get_node_locked(f,ino);
   if(node->is_stat_cache_valid)
     {
       int err;
       struct stat stbuf;
 
-      pthread_mutex_unlock(&f->lock);
+      node_unlock(f,node);
       err = f->fs->op.fgetattr(fi,&stbuf,&timeout);
-      pthread_mutex_lock(&f->lock);
+      node_lock(f,node);
 
       if(!err)
         update_stat(node,&stbuf);
@@ -2273,7 +2701,7 @@ open_auto_cache(struct fuse      *f,
 
   node->is_stat_cache_valid = 1;
 
-  pthread_mutex_unlock(&f->lock);
+  node_unlock(f,node);
 }
 
 static
@@ -2306,9 +2734,11 @@ fuse_lib_open(fuse_req_t             req,
 
   if(!err)
     {
-      pthread_mutex_lock(&f->lock);
-      get_node(f,hdr_->nodeid)->open_count++;
-      pthread_mutex_unlock(&f->lock);
+      node_t *node;
+
+      node = get_node_locked(f,hdr_->nodeid);
+      node->open_count++;
+      node_unlock(f,node);
       /* The open syscall was interrupted,so it must be cancelled */
       if(fuse_reply_open(req,&ffi) == -ENOENT)
         fuse_do_release(f,hdr_->nodeid,&ffi);
@@ -2321,6 +2751,27 @@ fuse_lib_open(fuse_req_t             req,
   free_path(f,hdr_->nodeid,path);
 }
 
+static
+void
+fuse_lib_read_buf(fuse_req_t           req_,
+                  struct fuse          *f_,
+                  fuse_file_info_t     *ffi_,
+                  struct fuse_read_in  *arg_)
+{
+  int res;
+  struct fuse_bufvec bufv = FUSE_BUFVEC_INIT(arg_->size);
+
+  res = f_->fs->op.read_buf(ffi_,&bufv,arg_->size,arg_->offset);
+
+  if(res >= 0)
+    res = fuse_reply_data_bufvec(req_,&bufv);
+  else
+    fuse_reply_err(req_,res);
+
+  if(f_->fs->op.read_buf_done)
+    f_->fs->op.read_buf_done(ffi_,((res < 0) ? res : 0));
+}
+
 static
 void
 fuse_lib_read(fuse_req_t             req,
@@ -2342,6 +2793,9 @@ fuse_lib_read(fuse_req_t             req,
 
   f = req_fuse_prepare(req);
 
+  if(f->fs->op.read_buf)
+    return fuse_lib_read_buf(req,f,&ffi,arg);
+
   msgbuf = msgbuf_alloc_page_aligned();
 
   res = f->fs->op.read(&ffi,msgbuf->mem,arg->size,arg->offset);
@@ -2354,12 +2808,28 @@ fuse_lib_read(fuse_req_t             req,
   msgbuf_free(msgbuf);
 }
 
+static
+int
+fuse_lib_write_buf(struct fuse            *f_,
+                   const fuse_file_info_t *ffi_,
+                   struct fuse_write_in   *arg_,
+                   const int               pipefd_)
+{
+  struct fuse_bufvec src = FUSE_BUFVEC_INIT(arg_->size);
+
+  src.buf[0].flags = FUSE_BUF_IS_FD;
+  src.buf[0].fd    = pipefd_;
+
+  return f_->fs->op.write_buf(ffi_,&src,arg_->offset);
+}
+
 static
 void
 fuse_lib_write(fuse_req_t             req,
                struct fuse_in_header *hdr_)
 {
   int res;
+  int pipefd;
   char *data;
   struct fuse *f;
   fuse_file_info_t ffi = {0};
@@ -2381,7 +2851,11 @@ fuse_lib_write(fuse_req_t             req,
 
   f = req_fuse_prepare(req);
 
-  res = f->fs->op.write(&ffi,data,arg->size,arg->offset);
+  pipefd = fuse_write_splice_pipe(req);
+  if(pipefd >= 0)
+    res = fuse_lib_write_buf(f,&ffi,arg,pipefd);
+  else
+    res = f->fs->op.write(&ffi,data,arg->size,arg->offset);
   free_path(f,hdr_->nodeid,NULL);
 
   if(res >= 0)
@@ -2496,6 +2970,22 @@ readdir_buf_size(fuse_dirents_t *d_,
   return size_;
 }
 
+/*
+  Whether a request for `size_` bytes at entry `off_` can be answered
+  from what's already been read.
+*/
+static
+int
+readdir_buf_full(fuse_dirents_t *d_,
+                 size_t          size_,
+                 off_t           off_)
+{
+  if(off_ >= kv_size(d_->offs))
+    return 0;
+
+  return ((kv_size(d_->data) - kv_A(d_->offs,off_)) >= size_);
+}
+
 static
 char*
 readdir_buf(fuse_dirents_t *d_,
@@ -2534,6 +3024,13 @@ fuse_lib_readdir(fuse_req_t             req_,
 
   rv = 0;
   if((arg->offset == 0) || (kv_size(d->data) == 0))
+    {
+      fuse_dirents_reset(d);
+      rv = f->fs->op.readdir(&ffi,d);
+    }
+
+  /* Streamed listings are continued until the request is covered */
+  while((rv == 0) && d->more && !readdir_buf_full(d,size,arg->offset))
     rv = f->fs->op.readdir(&ffi,d);
 
   if(rv)
@@ -2552,6 +3049,97 @@ fuse_lib_readdir(fuse_req_t             req_,
   pthread_mutex_unlock(&dh->lock);
 }
 
+/*
+  To the kernel a READDIRPLUS entry with a nodeid is a lookup of that
+  entry and it will later forget it as such. So entries are given
+  nodes only as they are sent, with their lookup count incremented as
+  LOOKUP would. A trailing partial entry isn't parsed by the kernel
+  and so isn't linked. Entries the filesystem has no attributes for,
+  mode 0, are sent as plain dirents which the kernel doesn't link.
+*/
+static
+void
+readdir_plus_link(struct fuse    *f_,
+                  uint64_t        parent_,
+                  fuse_dirents_t *d_,
+                  off_t           off_,
+                  size_t          size_)
+{
+  size_t i;
+  size_t end;
+  node_t *node;
+  struct stat st;
+  fuse_direntplus_t *d;
+  char name[NAME_MAX + 1];
+
+  if(size_ == 0)
+    return;
+
+  end = kv_A(d_->offs,off_) + size_;
+  for(i = off_; ((i + 1) < kv_size(d_->offs)) && (kv_A(d_->offs,i + 1) <= end); i++)
+    {
+      d = (fuse_direntplus_t*)&kv_A(d_->data,kv_A(d_->offs,i));
+
+      d->entry.nodeid     = 0;
+      d->entry.generation = 0;
+      if(d->attr.mode == 0)
+        continue;
+      if(d->dirent.namelen > NAME_MAX)
+        continue;
+
+      memcpy(name,d->dirent.name,d->dirent.namelen);
+      name[d->dirent.namelen] = '\0';
+
+      node = find_node(f_,parent_,name);
+      if(node == NULL)
+        continue;
+
+      d->entry.nodeid     = node->nodeid;
+      d->entry.generation = f_->nodeid_gen.generation;
+
+      memset(&st,0,sizeof(st));
+      st.st_ino          = d->attr.ino;
+      st.st_size         = d->attr.size;
+      st.st_mtim.tv_sec  = d->attr.mtime;
+      st.st_mtim.tv_nsec = d->attr.mtimensec;
+
+      node_lock(f_,node);
+      update_stat(node,&st);
+      node_unlock(f_,node);
+
+      if(f_->conf.set_mode)
+        d->attr.mode = ((d->attr.mode & S_IFMT) | (0777 & ~f_->conf.umask));
+      if(f_->conf.set_uid)
+        d->attr.uid = f_->conf.uid;
+      if(f_->conf.set_gid)
+        d->attr.gid = f_->conf.gid;
+    }
+}
+
+// Undoes readdir_plus_link when the reply never made it.
+static
+void
+readdir_plus_unlink(struct fuse    *f_,
+                    fuse_dirents_t *d_,
+                    off_t           off_,
+                    size_t          size_)
+{
+  size_t i;
+  size_t end;
+  fuse_direntplus_t *d;
+
+  if(size_ == 0)
+    return;
+
+  end = kv_A(d_->offs,off_) + size_;
+  for(i = off_; ((i + 1) < kv_size(d_->offs)) && (kv_A(d_->offs,i + 1) <= end); i++)
+    {
+      d = (fuse_direntplus_t*)&kv_A(d_->data,kv_A(d_->offs,i));
+      if(d->entry.nodeid != 0)
+        forget_node(f_,d->entry.nodeid,1);
+    }
+}
+
 static
 void
 fuse_lib_readdir_plus(fuse_req_t             req_,
@@ -2578,7 +3166,10 @@ fuse_lib_readdir_plus(fuse_req_t             req_,
 
   rv = 0;
   if((arg->offset == 0) || (kv_size(d->data) == 0))
-    rv = f->fs->op.readdir_plus(&ffi,d);
+    {
+      fuse_dirents_reset(d);
+      rv = f->fs->op.readdir_plus(&ffi,d);
+    }
 
   if(rv)
     {
@@ -2587,10 +3178,14 @@ fuse_lib_readdir_plus(fuse_req_t             req_,
     }
 
   size = readdir_buf_size(d,size,arg->offset);
+  if(d->type == PLUS)
+    readdir_plus_link(f,hdr_->nodeid,d,arg->offset,size);
 
-  fuse_reply_buf(req_,
-                 readdir_buf(d,arg->offset),
-                 size);
+  rv = fuse_reply_buf(req_,
+                      readdir_buf(d,arg->offset),
+                      size);
+  if((rv == -ENOENT) && (d->type == PLUS))
+    readdir_plus_unlink(f,d,arg->offset,size);
 
  out:
   pthread_mutex_unlock(&dh->lock);
@@ -2961,9 +3556,11 @@ fuse_lib_tmpfile(fuse_req_t                   req_,
 
   if(!err)
     {
-      pthread_mutex_lock(&f->lock);
-      get_node(f,e.ino)->open_count++;
-      pthread_mutex_unlock(&f->lock);
+      node_t *node;
+
+      node = get_node_locked(f,e.ino);
+      node->open_count++;
+      node_unlock(f,node);
 
       if(fuse_reply_create(req_,&e,&ffi) == -ENOENT)
         {
@@ -3134,6 +3731,7 @@ fuse_flush_common(struct fuse      *f,
   lock_t l;
   int err;
   int errlock;
+  node_t *node;
 
   memset(&lock,0,sizeof(lock));
   lock.l_type = F_UNLCK;
@@ -3145,9 +3743,9 @@ fuse_flush_common(struct fuse      *f,
     {
       flock_to_lock(&lock,&l);
       l.owner = fi->lock_owner;
-      pthread_mutex_lock(&f->lock);
-      locks_insert(get_node(f,ino),&l);
-      pthread_mutex_unlock(&f->lock);
+      node = get_node_locked(f,ino);
+      locks_insert(node,&l);
+      node_unlock(f,node);
 
       /* if op.lock() is defined FLUSH is needed regardless
          of op.flush() */
@@ -3262,6 +3860,7 @@ fuse_lib_getlk(fuse_req_t                   req,
   lock_t lk;
   struct flock flk;
   lock_t *conflict;
+  node_t *node;
   fuse_file_info_t ffi = {0};
   const struct fuse_lk_in *arg;
 
@@ -3275,11 +3874,11 @@ fuse_lib_getlk(fuse_req_t                   req,
 
   flock_to_lock(&flk,&lk);
   lk.owner = ffi.lock_owner;
-  pthread_mutex_lock(&f->lock);
-  conflict = locks_conflict(get_node(f,hdr_->nodeid),&lk);
+  node = get_node_locked(f,hdr_->nodeid);
+  conflict = locks_conflict(node,&lk);
   if(conflict)
     lock_to_flock(conflict,&flk);
-  pthread_mutex_unlock(&f->lock);
+  node_unlock(f,node);
   if(!conflict)
     err = fuse_lock_common(req,hdr_->nodeid,&ffi,&flk,F_GETLK);
   else
@@ -3305,11 +3904,12 @@ fuse_lib_setlk(fuse_req_t        req,
     {
       struct fuse *f = req_fuse(req);
       lock_t l;
+      node_t *node;
       flock_to_lock(lock,&l);
       l.owner = fi->lock_owner;
-      pthread_mutex_lock(&f->lock);
-      locks_insert(get_node(f,ino),&l);
-      pthread_mutex_unlock(&f->lock);
+      node = get_node_locked(f,ino);
+      locks_insert(node,&l);
+      node_unlock(f,node);
     }
 
   fuse_reply_err(req,err);
@@ -3489,49 +4089,38 @@ fuse_lib_fallocate(fuse_req_t                   req,
   fuse_reply_err(req,err);
 }
 
-static
-int
-remembered_node_cmp(const void *a_,
-                    const void *b_)
-{
-  const remembered_node_t *a = a_;
-  const remembered_node_t *b = b_;
-
-  return (a->time - b->time);
-}
-
-static
-void
-remembered_nodes_sort(struct fuse *f_)
-{
-  pthread_mutex_lock(&f_->lock);
-  qsort(&kv_first(f_->remembered_nodes),
-        kv_size(f_->remembered_nodes),
-        sizeof(remembered_node_t),
-        remembered_node_cmp);
-  pthread_mutex_unlock(&f_->lock);
-}
-
 #define MAX_PRUNE 100
 #define MAX_CHECK 1000
 
+/*
+  Forgets nodes from the head of the remembered list which have
+  expired or are over remember_max. Sets *done_ once there is nothing
+  left to do. Busy nodes are skipped and left for the next pass.
+*/
+static
 int
 fuse_prune_some_remembered_nodes(struct fuse *f_,
-                                 int         *offset_)
+                                 int         *done_)
 {
+  int rv;
   time_t now;
   int pruned;
   int checked;
+  int deadcnt;
+  node_t *node;
+  node_t *next;
+  node_t *dead[MAX_PRUNE];
 
-  pthread_mutex_lock(&f_->lock);
+  pthread_mutex_lock(&f_->remembered_lock);
 
   pruned = 0;
   checked = 0;
+  deadcnt = 0;
   now = current_time();
-  while(*offset_ < kv_size(f_->remembered_nodes))
+  node = f_->remembered_head;
+  while(node != NULL)
     {
-      time_t age;
-      remembered_node_t *fn = &kv_A(f_->remembered_nodes,*offset_);
+      int over_max;
 
       if(pruned >= MAX_PRUNE)
         break;
@@ -3539,29 +4128,33 @@ fuse_prune_some_remembered_nodes(struct fuse *f_,
         break;
 
       checked++;
-      age = (now - fn->time);
-      if(f_->conf.remember > age)
-        break;
-
-      assert(fn->node->nlookup == 1);
-
-      /* Don't forget active directories */
-      if(fn->node->refctr > 1)
+      over_max = (f_->conf.remember_max &&
+                  (f_->remembered_count > f_->conf.remember_max));
+      if(!over_max && (f_->conf.remember > (now - node->remembered_time)))
         {
-          (*offset_)++;
-          continue;
+          node = NULL;
+          break;
         }
 
-      fn->node->nlookup = 0;
-      unref_node(f_,fn->node);
-      kv_delete(f_->remembered_nodes,*offset_);
-      pruned++;
+      next = node->remembered_next;
+      rv = remembered_forget(f_,node,now,&dead[deadcnt]);
+      if(rv == 0)
+        {
+          if(over_max)
+            f_->remembered_evictions++;
+          if(dead[deadcnt])
+            deadcnt++;
+          pruned++;
+        }
+      node = next;
     }
 
-  pthread_mutex_unlock(&f_->lock);
+  pthread_mutex_unlock(&f_->remembered_lock);
 
-  if((pruned < MAX_PRUNE) && (checked < MAX_CHECK))
-    *offset_ = -1;
+  for(int i = 0; i < deadcnt; i++)
+    delete_node(f_,dead[i]);
+
+  *done_ = ((node == NULL) || (pruned == 0));
 
   return pruned;
 }
@@ -3581,25 +4174,16 @@ sleep_100ms(void)
 void
 fuse_prune_remembered_nodes(struct fuse *f_)
 {
-  int offset;
-  int pruned;
+  int done;
 
-  offset = 0;
-  pruned = 0;
   for(;;)
     {
-      pruned += fuse_prune_some_remembered_nodes(f_,&offset);
-      if(offset >= 0)
-        {
-          sleep_100ms();
-          continue;
-        }
+      fuse_prune_some_remembered_nodes(f_,&done);
+      if(done)
+        break;
 
-      break;
+      sleep_100ms();
     }
-
-  if(pruned > 0)
-    remembered_nodes_sort(f_);
 }
 
 static struct fuse_lowlevel_ops fuse_path_ops =
@@ -3705,6 +4289,9 @@ static const struct fuse_opt fuse_lib_opts[] =
    FUSE_LIB_OPT("gid=%d",	      gid,0),
    FUSE_LIB_OPT("noforget",           remember,-1),
    FUSE_LIB_OPT("remember=%u",        remember,0),
+   FUSE_LIB_OPT("remember_max=%u",    remember_max,0),
+   FUSE_LIB_OPT("path_cache_max=%u",  path_cache_max,0),
+   FUSE_LIB_OPT("msgbuf_max_idle=%u", msgbuf_max_idle,0),
    FUSE_OPT_END
   };
 
@@ -3716,6 +4303,9 @@ static void fuse_lib_help(void)
           "    -o gid=N               set file group\n"
           "    -o noforget            never forget cached inodes\n"
           "    -o remember=T          remember cached inodes for T seconds (0s)\n"
+          "    -o remember_max=N      max remembered inodes, LRU evicted (0 = no max)\n"
+          "    -o path_cache_max=N    max MiB of cached node paths, 0 disables (32)\n"
+          "    -o msgbuf_max_idle=N   max idle message buffers kept (0 = no max)\n"
           "    -o threads=NUM         number of worker threads. 0 = autodetect.\n"
           "                           Negative values autodetect then divide by\n"
           "                           absolute value. default = 0\n"
@@ -3774,21 +4364,68 @@ fuse_fs_new(const struct fuse_operations *op,
 
 static
 int
-node_table_init(struct node_table *t)
+node_shards_init(node_shard_t *shards_)
 {
-  t->size = NODE_TABLE_MIN_SIZE;
-  t->array = (node_t **)calloc(1,sizeof(node_t *) * t->size);
-  if(t->array == NULL)
+  for(int i = 0; i < NODE_TABLE_SHARDS; i++)
     {
-      fprintf(stderr,"fuse: memory allocation failed\n");
-      return -1;
+      if(node_table_init(&shards_[i].table,NODE_SHARD_MIN_SIZE) == -1)
+        {
+          fprintf(stderr,"fuse: memory allocation failed\n");
+          while(i--)
+            node_table_destroy(&shards_[i].table);
+          return -1;
+        }
+    }
+
+  for(int i = 0; i < NODE_TABLE_SHARDS; i++)
+    {
+      fuse_mutex_init(&shards_[i].lock);
+      shards_[i].acquisitions = 0;
+      shards_[i].contentions  = 0;
     }
-  t->use = 0;
-  t->split = 0;
 
   return 0;
 }
 
+static
+void
+node_shards_destroy(node_shard_t *shards_)
+{
+  for(int i = 0; i < NODE_TABLE_SHARDS; i++)
+    {
+      node_table_destroy(&shards_[i].table);
+      pthread_mutex_destroy(&shards_[i].lock);
+    }
+}
+
+typedef struct node_shards_stats_t node_shards_stats_t;
+struct node_shards_stats_t
+{
+  uint64_t size;
+  uint64_t use;
+  uint64_t acquisitions;
+  uint64_t contentions;
+};
+
+static
+void
+node_shards_stats(node_shard_t        *shards_,
+                  node_shards_stats_t *stats_)
+{
+  memset(stats_,0,sizeof(*stats_));
+  for(int i = 0; i < NODE_TABLE_SHARDS; i++)
+    {
+      node_shard_t *s = &shards_[i];
+
+      pthread_mutex_lock(&s->lock);
+      stats_->size         += node_table_size(&s->table);
+      stats_->use          += node_table_use(&s->table);
+      stats_->acquisitions += s->acquisitions;
+      stats_->contentions  += s->contentions;
+      pthread_mutex_unlock(&s->lock);
+    }
+}
+
 static
 struct fuse*
 fuse_get_fuse_obj()
@@ -3803,11 +4440,19 @@ void
 metrics_log_nodes_info(struct fuse *f_,
                        FILE        *file_)
 {
-  char buf[1024];
+  char buf[2048];
   char time_str[64];
   struct tm tm;
   struct timeval tv;
   uint64_t sizeof_node;
+  uint64_t treelock_waits;
+  uint64_t path_cache_size;
+  uint64_t path_cache_hits;
+  uint64_t path_cache_misses;
+  uint64_t remembered_count;
+  uint64_t remembered_evictions;
+  node_shards_stats_t id_stats;
+  node_shards_stats_t name_stats;
   float node_usage_ratio;
   uint64_t node_slab_count;
   uint64_t node_avail_objs;
@@ -3828,15 +4473,41 @@ metrics_log_nodes_info(struct fuse *f_,
   node_total_alloc_mem = fmp_total_allocated_memory(&lfmp->fmp);
   lfmp_unlock(lfmp);
 
+  node_shards_stats(f_->id_shards,&id_stats);
+  node_shards_stats(f_->name_shards,&name_stats);
+  pthread_mutex_lock(&f_->lock);
+  treelock_waits = f_->treelock_waits;
+  pthread_mutex_unlock(&f_->lock);
+  path_cache_size   = __atomic_load_n(&f_->path_cache_size,__ATOMIC_RELAXED);
+  path_cache_hits   = __atomic_load_n(&f_->path_cache_hits,__ATOMIC_RELAXED);
+  path_cache_misses = __atomic_load_n(&f_->path_cache_misses,__ATOMIC_RELAXED);
+  pthread_mutex_lock(&f_->remembered_lock);
+  remembered_count     = f_->remembered_count;
+  remembered_evictions = f_->remembered_evictions;
+  pthread_mutex_unlock(&f_->remembered_lock);
+
   snprintf(buf,sizeof(buf),
            "time: %s\n"
            "sizeof(node): %"PRIu64"\n"
+           "node table shards: %d\n"
            "node id_table size: %"PRIu64"\n"
            "node id_table usage: %"PRIu64"\n"
            "node id_table total allocated memory: %"PRIu64"\n"
+           "node id_table lock acquisitions: %"PRIu64"\n"
+           "node id_table lock contentions: %"PRIu64"\n"
            "node name_table size: %"PRIu64"\n"
            "node name_table usage: %"PRIu64"\n"
            "node name_table total allocated memory: %"PRIu64"\n"
+           "node name_table lock acquisitions: %"PRIu64"\n"
+           "node name_table lock contentions: %"PRIu64"\n"
+           "node treelock waits: %"PRIu64"\n"
+           "node path cache size: %"PRIu64"\n"
+           "node path cache max: %"PRIu64"\n"
+           "node path cache hits: %"PRIu64"\n"
+           "node path cache misses: %"PRIu64"\n"
+           "node remembered count: %"PRIu64"\n"
+           "node remembered max: %u\n"
+           "node remembered evictions: %"PRIu64"\n"
            "node memory pool slab count: %"PRIu64"\n"
            "node memory pool usage ratio: %f\n"
            "node memory pool avail objs: %"PRIu64"\n"
@@ -3844,17 +4515,32 @@ metrics_log_nodes_info(struct fuse *f_,
            "msgbuf bufsize: %"PRIu64"\n"
            "msgbuf allocation count: %"PRIu64"\n"
            "msgbuf available count: %"PRIu64"\n"
+           "msgbuf high water count: %"PRIu64"\n"
+           "msgbuf max idle: %"PRIu64"\n"
            "msgbuf total allocated memory: %"PRIu64"\n"
            "\n"
            ,
            time_str,
            sizeof_node,
-           (uint64_t)f_->id_table.size,
-           (uint64_t)f_->id_table.use,
-           (uint64_t)(f_->id_table.size * sizeof(node_t*)),
-           (uint64_t)f_->name_table.size,
-           (uint64_t)f_->name_table.use,
-           (uint64_t)(f_->name_table.size * sizeof(node_t*)),
+           NODE_TABLE_SHARDS,
+           id_stats.size,
+           id_stats.use,
+           (uint64_t)(id_stats.size * sizeof(node_table_slot_t)),
+           id_stats.acquisitions,
+           id_stats.contentions,
+           name_stats.size,
+           name_stats.use,
+           (uint64_t)(name_stats.size * sizeof(node_table_slot_t)),
+           name_stats.acquisitions,
+           name_stats.contentions,
+           treelock_waits,
+           path_cache_size,
+           ((uint64_t)f_->conf.path_cache_max << 20),
+           path_cache_hits,
+           path_cache_misses,
+           remembered_count,
+           f_->conf.remember_max,
+           remembered_evictions,
            node_slab_count,
            node_usage_ratio,
            node_avail_objs,
@@ -3862,6 +4548,8 @@ metrics_log_nodes_info(struct fuse *f_,
            msgbuf_get_bufsize(),
            msgbuf_alloc_count(),
            msgbuf_avail_count(),
+           msgbuf_high_water_count(),
+           msgbuf_get_max_idle(),
            msgbuf_alloc_count() * msgbuf_get_bufsize()
            );
 
@@ -3910,15 +4598,19 @@ fuse_invalidate_all_nodes()
 
   syslog(LOG_INFO,"invalidating file entries");
 
-  pthread_mutex_lock(&f->lock);
-  for(int i = 0; i < f->id_table.size; i++)
+  for(int i = 0; i < NODE_TABLE_SHARDS; i++)
     {
       node_t *node;
+      uint64_t iter = 0;
+      node_shard_t *s = &f->id_shards[i];
 
-      for(node = f->id_table.array[i]; node != NULL; node = node->id_next)
+      node_shard_lock(s);
+      while((node = node_table_next(&s->table,&iter)) != NULL)
         {
           if(node->nodeid == FUSE_ROOT_ID)
             continue;
+          if(node->parent == NULL)
+            continue;
           if(node->parent->nodeid != FUSE_ROOT_ID)
             continue;
 
@@ -3927,8 +4619,90 @@ fuse_invalidate_all_nodes()
                                            node->name,
                                            strlen(node->name));
         }
+      node_shard_unlock(s);
+    }
+}
+
+/*
+  Walks `path` through the node table and asks the kernel to drop the
+  final component's dentry and the parent's attributes along with the
+  node's attributes if it is known. Nothing is sent if a parent
+  directory was never looked up as the kernel can't have cached
+  anything below it.
+*/
+void
+fuse_invalidate_path(const char *path_)
+{
+  uint64_t hash;
+  uint64_t parent;
+  uint64_t nodeid;
+  node_t *node;
+  node_shard_t *s;
+  const char *name;
+  const char *next;
+  char buf[NAME_MAX + 1];
+  struct fuse *f = fuse_get_fuse_obj();
+
+  if(f->se == NULL)
+    return;
+
+  parent = 0;
+  nodeid = FUSE_ROOT_ID;
+  name   = path_;
+  while(*name == '/')
+    name++;
+
+  while(*name != '\0')
+    {
+      size_t len;
+
+      if(nodeid == 0)
+        return;
+
+      next = strchr(name,'/');
+      len  = ((next == NULL) ? strlen(name) : (size_t)(next - name));
+      if(len > NAME_MAX)
+        return;
+
+      memcpy(buf,name,len);
+      buf[len] = '\0';
+
+      parent = nodeid;
+      hash   = name_hash(parent,buf);
+      s      = name_shard(f,hash);
+
+      node_shard_lock(s);
+      node   = lookup_node_locked(s,hash,parent,buf);
+      nodeid = ((node == NULL) ? 0 : node->nodeid);
+      node_shard_unlock(s);
+
+      name += len;
+      while(*name == '/')
+        name++;
     }
-  pthread_mutex_unlock(&f->lock);
+
+  if(parent == 0)
+    return;
+
+  fuse_lowlevel_notify_inval_entry(f->se->ch,parent,buf,strlen(buf));
+  if(nodeid != 0)
+    fuse_lowlevel_notify_inval_inode(f->se->ch,nodeid,-1,0);
+}
+
+int
+fuse_passthrough_open(const int fd_)
+{
+  struct fuse *f = fuse_get_fuse_obj();
+
+  return fuse_lowlevel_passthrough_open(f->se->ch,fd_);
+}
+
+int
+fuse_passthrough_close(const int backing_id_)
+{
+  struct fuse *f = fuse_get_fuse_obj();
+
+  return fuse_lowlevel_passthrough_close(f->se->ch,backing_id_);
 }
 
 void
@@ -4028,10 +4802,12 @@ fuse_new_common(struct fuse_chan             *ch,
       llop.setlk = NULL;
     }
 
+  f->conf.path_cache_max = 32;
   if(fuse_opt_parse(args,&f->conf,fuse_lib_opts,fuse_lib_opt_proc) == -1)
     goto out_free_fs;
 
   g_LOG_METRICS = f->conf.debug;
+  msgbuf_set_max_idle(f->conf.msgbuf_max_idle);
 
   f->se = fuse_lowlevel_new_common(args,&llop,sizeof(llop),f);
   if(f->se == NULL)
@@ -4039,19 +4815,23 @@ fuse_new_common(struct fuse_chan             *ch,
 
   fuse_session_add_chan(f->se,ch);
 
+  if(f->fs->op.write_buf)
+    fuse_session_enable_write_splice(f->se);
+
   /* Trace topmost layer by default */
   srand(time(NULL));
   f->nodeid_gen.nodeid = FUSE_ROOT_ID;
   f->nodeid_gen.generation = rand64();
-  if(node_table_init(&f->name_table) == -1)
+  if(node_shards_init(f->name_shards) == -1)
     goto out_free_session;
 
-  if(node_table_init(&f->id_table) == -1)
+  if(node_shards_init(f->id_shards) == -1)
     goto out_free_name_table;
 
   fuse_mutex_init(&f->lock);
-
-  kv_init(f->remembered_nodes);
+  fuse_mutex_init(&f->path_grace_lock);
+  pthread_cond_init(&f->treelock_cond,NULL);
+  fuse_mutex_init(&f->remembered_lock);
 
   root = node_alloc();
   if(root == NULL)
@@ -4062,17 +4842,18 @@ fuse_new_common(struct fuse_chan             *ch,
 
   root->name = filename_strdup(f,"/");
 
-  root->parent = NULL;
-  root->nodeid = FUSE_ROOT_ID;
-  inc_nlookup(root);
+  root->parent  = NULL;
+  root->nodeid  = FUSE_ROOT_ID;
+  root->refctr  = 1;
+  root->nlookup = 1;
   hash_id(f,root);
 
   return f;
 
  out_free_id_table:
-  free(f->id_table.array);
+  node_shards_destroy(f->id_shards);
  out_free_name_table:
-  free(f->name_table.array);
+  node_shards_destroy(f->name_shards);
  out_free_session:
   fuse_session_destroy(f->se);
  out_free_fs:
@@ -4100,8 +4881,6 @@ fuse_new(struct fuse_chan             *ch,
 void
 fuse_destroy(struct fuse *f)
 {
-  size_t i;
-
   if(f->fs)
     {
       struct fuse_context_i *c = fuse_get_context_internal();
@@ -4109,11 +4888,12 @@ fuse_destroy(struct fuse *f)
       memset(c,0,sizeof(*c));
       c->ctx.fuse = f;
 
-      for(i = 0; i < f->id_table.size; i++)
+      for(int s = 0; s < NODE_TABLE_SHARDS; s++)
         {
           node_t *node;
+          uint64_t iter = 0;
 
-          for(node = f->id_table.array[i]; node != NULL; node = node->id_next)
+          while((node = node_table_next(&f->id_shards[s].table,&iter)) != NULL)
             {
               if(!node->hidden_fh)
                 continue;
@@ -4124,24 +4904,21 @@ fuse_destroy(struct fuse *f)
         }
     }
 
-  for(i = 0; i < f->id_table.size; i++)
+  for(int s = 0; s < NODE_TABLE_SHARDS; s++)
     {
       node_t *node;
-      node_t *next;
+      uint64_t iter = 0;
 
-      for(node = f->id_table.array[i]; node != NULL; node = next)
-        {
-          next = node->id_next;
-          free_node(f,node);
-          f->id_table.use--;
-        }
+      while((node = node_table_next(&f->id_shards[s].table,&iter)) != NULL)
+        free_node(f,node);
     }
 
-  free(f->id_table.array);
-  free(f->name_table.array);
+  node_shards_destroy(f->id_shards);
+  node_shards_destroy(f->name_shards);
+  pthread_cond_destroy(&f->treelock_cond);
   pthread_mutex_destroy(&f->lock);
+  pthread_mutex_destroy(&f->remembered_lock);
   fuse_session_destroy(f->se);
-  kv_destroy(f->remembered_nodes);
   fuse_delete_context_key();
 }
 
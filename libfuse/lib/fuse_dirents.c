@@ -1,3 +1,4 @@
+#define _GNU_SOURCE
 #define _FILE_OFFSET_BITS 64
 
 #include "fuse_attr.h"
@@ -10,15 +11,27 @@
 
 #include <dirent.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
 
 /* 32KB - same as glibc getdents buffer size */
 #define DEFAULT_SIZE (1024 * 32)
 
+static uint64_t g_SPILL_SIZE = 0;
+
+void
+fuse_dirents_spill_size(const uint64_t size_)
+{
+  __atomic_store_n(&g_SPILL_SIZE,size_,__ATOMIC_RELAXED);
+}
+
 static
 uint64_t
 round_up(const uint64_t number_,
@@ -60,21 +73,127 @@ fuse_direntplus_size(const uint64_t namelen_)
   return rv;
 }
 
+static
+int
+spill_open(void)
+{
+  int fd;
+  const char *tmpdir;
+  char path[PATH_MAX];
+
+  tmpdir = getenv("TMPDIR");
+  if((tmpdir == NULL) || (tmpdir[0] == '\0'))
+    tmpdir = "/tmp";
+
+  fd = open(tmpdir,O_TMPFILE|O_RDWR|O_CLOEXEC,0600);
+  if(fd >= 0)
+    return fd;
+
+  snprintf(path,sizeof(path),"%s/mergerfs.dirents.XXXXXX",tmpdir);
+  fd = mkostemp(path,O_CLOEXEC);
+  if(fd == -1)
+    return -1;
+
+  unlink(path);
+
+  return fd;
+}
+
+/*
+  Moves the heap buffer into a temp file of `size_` bytes. On failure
+  the heap buffer is left alone.
+*/
+static
+int
+spill_data(fuse_dirents_t *d_,
+           uint64_t        size_)
+{
+  int fd;
+  void *p;
+
+  fd = spill_open();
+  if(fd == -1)
+    return -1;
+
+  if(ftruncate(fd,size_) == -1)
+    goto err;
+
+  p = mmap(NULL,size_,PROT_READ|PROT_WRITE,MAP_SHARED,fd,0);
+  if(p == MAP_FAILED)
+    goto err;
+
+  memcpy(p,d_->data.a,kv_size(d_->data));
+  kv_destroy(d_->data);
+
+  d_->data.a   = (char*)p;
+  d_->data.m   = size_;
+  d_->spilled  = 1;
+  d_->spill_fd = fd;
+
+  return 0;
+
+ err:
+  close(fd);
+  return -1;
+}
+
+static
+int
+spill_grow(fuse_dirents_t *d_,
+           uint64_t        size_)
+{
+  void *p;
+
+  /* Double to keep the number of remaps logarithmic */
+  if(size_ < (kv_max(d_->data) * 2))
+    size_ = (kv_max(d_->data) * 2);
+
+  if(ftruncate(d_->spill_fd,size_) == -1)
+    return -ENOMEM;
+
+  p = mremap(d_->data.a,kv_max(d_->data),size_,MREMAP_MAYMOVE);
+  if(p == MAP_FAILED)
+    return -ENOMEM;
+
+  d_->data.a = (char*)p;
+  d_->data.m = size_;
+
+  return 0;
+}
+
+/* Ensures `data` can hold at least `size_` bytes in total */
+static
+int
+fuse_dirents_data_reserve(fuse_dirents_t *d_,
+                          uint64_t        size_)
+{
+  uint64_t spill_size;
+
+  if(size_ <= kv_max(d_->data))
+    return 0;
+
+  size_ = round_up(size_,DEFAULT_SIZE);
+  if(d_->spilled)
+    return spill_grow(d_,size_);
+
+  spill_size = __atomic_load_n(&g_SPILL_SIZE,__ATOMIC_RELAXED);
+  if(spill_size && (size_ > spill_size) && (spill_data(d_,size_) == 0))
+    return 0;
+
+  kv_resize(char,d_->data,size_);
+  if(d_->data.a == NULL)
+    return -ENOMEM;
+
+  return 0;
+}
+
 static
 int
 fuse_dirents_buf_resize(fuse_dirents_t *d_,
                         uint64_t        size_)
 {
   if((kv_size(d_->data) + size_) >= kv_max(d_->data))
-    {
-      uint64_t new_size;
-
-      new_size = round_up((kv_size(d_->data) + size_),DEFAULT_SIZE);
-
-      kv_resize(char,d_->data,new_size);
-      if(d_->data.a == NULL)
-        return -ENOMEM;
-    }
+    return fuse_dirents_data_reserve(d_,(kv_size(d_->data) + size_ + 1));
 
   return 0;
 }
@@ -377,6 +496,7 @@ void
 fuse_dirents_reset(fuse_dirents_t *d_)
 {
   d_->type          = UNSET;
+  d_->more          = 0;
   kv_size(d_->data) = 0;
   kv_size(d_->offs) = 1;
 }
@@ -384,7 +504,10 @@ fuse_dirents_reset(fuse_dirents_t *d_)
 int
 fuse_dirents_init(fuse_dirents_t *d_)
 {
-  d_->type = UNSET;
+  d_->type     = UNSET;
+  d_->more     = 0;
+  d_->spilled  = 0;
+  d_->spill_fd = -1;
 
   kv_init(d_->data);
   kv_resize(char,d_->data,DEFAULT_SIZE);
@@ -398,9 +521,45 @@ fuse_dirents_init(fuse_dirents_t *d_)
   return 0;
 }
 
+/*
+  Replaces the content of `dst_` with that of `src_`. `dst_` may be
+  zeroed rather than initialized in which case it is sized to fit.
+*/
+int
+fuse_dirents_copy(fuse_dirents_t       *dst_,
+                  const fuse_dirents_t *src_)
+{
+  if(fuse_dirents_data_reserve(dst_,kv_size(src_->data)) != 0)
+    return -ENOMEM;
+
+  if(kv_max(dst_->offs) < kv_size(src_->offs))
+    {
+      kv_resize(uint32_t,dst_->offs,kv_size(src_->offs));
+      if(dst_->offs.a == NULL)
+        return -ENOMEM;
+    }
+
+  dst_->type = src_->type;
+  dst_->more = src_->more;
+  kv_size(dst_->data) = kv_size(src_->data);
+  kv_size(dst_->offs) = kv_size(src_->offs);
+  memcpy(dst_->data.a,src_->data.a,kv_size(src_->data));
+  memcpy(dst_->offs.a,src_->offs.a,(kv_size(src_->offs) * sizeof(uint32_t)));
+
+  return 0;
+}
+
 void
 fuse_dirents_free(fuse_dirents_t *d_)
 {
-  kv_destroy(d_->data);
+  if(d_->spilled)
+    {
+      munmap(d_->data.a,kv_max(d_->data));
+      close(d_->spill_fd);
+    }
+  else
+    {
+      kv_destroy(d_->data);
+    }
   kv_destroy(d_->offs);
 }
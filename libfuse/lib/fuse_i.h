@@ -39,6 +39,8 @@ struct fuse_req
   struct fuse_ctx ctx;
   struct fuse_chan *ch;
   unsigned int ioctl_64bit : 1;
+  unsigned int write_splice : 1;
+  int write_pipefd;
 };
 
 struct fuse_notify_req
@@ -67,6 +69,7 @@ struct fuse_ll
   int got_destroy;
   pthread_key_t pipe_key;
   int broken_splice_nonblock;
+  int write_splice;
   uint64_t notify_ctr;
   struct fuse_notify_req notify_list;
 };
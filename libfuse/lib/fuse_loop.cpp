@@ -16,6 +16,7 @@
 #include "fuse_config.hpp"
 #include "fuse_msgbuf.hpp"
 #include "fuse_ll.hpp"
+#include "fuse_uring.hpp"
 
 #include <errno.h>
 #include <pthread.h>
@@ -528,6 +529,8 @@ fuse_session_loop_mt(struct fuse_session *se_,
 
   ::wait(se_,&finished);
 
+  fuse_uring_stop();
+
   sem_destroy(&finished);
 
   return 0;
@@ -18,6 +18,7 @@
 #include "fuse_misc.h"
 #include "fuse_pollhandle.h"
 #include "fuse_msgbuf.hpp"
+#include "fuse_uring.hpp"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -26,8 +27,12 @@
 #include <unistd.h>
 #include <limits.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <assert.h>
 #include <sys/file.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
 
 #ifndef F_LINUX_SPECIFIC_BASE
 #define F_LINUX_SPECIFIC_BASE       1024
@@ -139,6 +144,10 @@ fuse_send_msg(struct fuse_ll   *f,
 
   out->len = iov_length(iov, count);
 
+  rv = fuse_uring_send_msg(iov,count);
+  if(rv != -ENOENT)
+    return rv;
+
   rv = writev(fuse_chan_fd(ch),iov,count);
   if(rv == -1)
     return -errno;
@@ -277,6 +286,11 @@ fill_open(struct fuse_open_out   *arg_,
     arg_->open_flags |= FOPEN_PARALLEL_DIRECT_WRITES;
   if(ffi_->noflush)
     arg_->open_flags |= FOPEN_NOFLUSH;
+  if(ffi_->passthrough)
+    {
+      arg_->open_flags |= FOPEN_PASSTHROUGH;
+      arg_->backing_id  = ffi_->backing_id;
+    }
 }
 
 int
@@ -407,7 +421,7 @@ fuse_send_data_iov_fallback(struct fuse_ll     *f,
   fuse_msgbuf_t *msgbuf;
   msgbuf = msgbuf_alloc();
   if(msgbuf == NULL)
-    return -ENOMEM;
+    return ENOMEM;
 
   mem_buf.buf[0].mem = msgbuf->mem;
   res = fuse_buf_copy(&mem_buf, buf, 0);
@@ -443,6 +457,270 @@ fuse_ll_pipe_free(struct fuse_ll_pipe *llp)
   free(llp);
 }
 
+static uint64_t g_SPLICE_READ_COUNT;
+static uint64_t g_SPLICE_READ_FALLBACK_COUNT;
+
+void
+fuse_read_splice_counts(uint64_t *spliced_,
+                        uint64_t *fallback_)
+{
+  *spliced_  = __atomic_load_n(&g_SPLICE_READ_COUNT,__ATOMIC_RELAXED);
+  *fallback_ = __atomic_load_n(&g_SPLICE_READ_FALLBACK_COUNT,__ATOMIC_RELAXED);
+}
+
+#ifdef HAVE_SPLICE
+static
+size_t
+fuse_ll_pipe_max_size(void)
+{
+  FILE *f;
+  unsigned long max;
+
+  max = (1024 * 1024);
+  f = fopen("/proc/sys/fs/pipe-max-size","r");
+  if(f == NULL)
+    return max;
+  if(fscanf(f,"%lu",&max) != 1)
+    max = (1024 * 1024);
+  fclose(f);
+
+  return max;
+}
+
+/*
+  Each thread gets its own pipe sized to hold the largest possible
+  reply, limited to pipe-max-size. Data spliced into a pipe isn't
+  necessarily page aligned so an extra page is needed beyond the
+  msgbuf size. Replies which don't fit fall back to a copy.
+*/
+static
+struct fuse_ll_pipe*
+fuse_ll_get_pipe(struct fuse_ll *f_)
+{
+  int rv;
+  size_t size;
+  struct fuse_ll_pipe *llp;
+  static size_t max_size = 0;
+
+  llp = pthread_getspecific(f_->pipe_key);
+  if(llp != NULL)
+    return llp;
+
+  llp = malloc(sizeof(struct fuse_ll_pipe));
+  if(llp == NULL)
+    return NULL;
+
+  rv = pipe2(llp->pipe,O_CLOEXEC|O_NONBLOCK);
+  if(rv == -1)
+    {
+      free(llp);
+      return NULL;
+    }
+
+  if(max_size == 0)
+    max_size = fuse_ll_pipe_max_size();
+
+  size = (msgbuf_get_bufsize() + pagesize);
+  if(size > max_size)
+    size = max_size;
+
+  msgbuf_pipe_set_size(llp->pipe[0],size);
+  rv = fcntl(llp->pipe[0],F_GETPIPE_SZ);
+  llp->size     = ((rv == -1) ? 0 : rv);
+  llp->can_grow = 0;
+
+  pthread_setspecific(f_->pipe_key,llp);
+
+  return llp;
+}
+
+/*
+  After a failure the pipe may hold a partial message. Rather than
+  try to drain it throw it away and let the next request create a
+  fresh one.
+*/
+static
+void
+fuse_ll_clear_pipe(struct fuse_ll *f_)
+{
+  struct fuse_ll_pipe *llp;
+
+  llp = pthread_getspecific(f_->pipe_key);
+  if(llp == NULL)
+    return;
+
+  pthread_setspecific(f_->pipe_key,NULL);
+  fuse_ll_pipe_free(llp);
+}
+
+/*
+  A short splice from the source (the file shrinking underneath the
+  read) leaves a header in the pipe with the wrong length. Pull
+  everything back out, fix the length, and write it normally.
+
+  As with fuse_send_data_iov_fallback a positive errno means nothing
+  was sent and the request still needs a reply.
+*/
+static
+int
+fuse_send_data_drain_pipe(struct fuse_ll      *f_,
+                          struct fuse_chan    *ch_,
+                          struct fuse_ll_pipe *llp_,
+                          const size_t         len_)
+{
+  int rv;
+  size_t total;
+  fuse_msgbuf_t *msgbuf;
+  struct fuse_out_header *out;
+
+  msgbuf = msgbuf_alloc();
+  if(msgbuf == NULL)
+    {
+      fuse_ll_clear_pipe(f_);
+      return ENOMEM;
+    }
+
+  total = 0;
+  while(total < len_)
+    {
+      rv = read(llp_->pipe[0],&msgbuf->mem[total],(len_ - total));
+      if(rv <= 0)
+        {
+          fuse_ll_clear_pipe(f_);
+          msgbuf_free(msgbuf);
+          return ((rv == -1) ? errno : EIO);
+        }
+
+      total += rv;
+    }
+
+  out = (struct fuse_out_header*)msgbuf->mem;
+  out->len = len_;
+
+  rv = write(fuse_chan_fd(ch_),msgbuf->mem,len_);
+  rv = ((rv == -1) ? -errno : 0);
+
+  msgbuf_free(msgbuf);
+
+  return rv;
+}
+
+/*
+  A read reaching past EOF would come up short after its header was
+  already in the pipe. Those are read normally instead.
+*/
+static
+int
+fuse_ll_read_past_eof(const struct fuse_bufvec *buf_,
+                      const size_t              len_)
+{
+  int rv;
+  struct stat st;
+  const struct fuse_buf *buf = &buf_->buf[buf_->idx];
+
+  if(!(buf->flags & FUSE_BUF_FD_SEEK))
+    return 0;
+
+  rv = fstat(buf->fd,&st);
+  if(rv == -1)
+    return 0;
+  if(!S_ISREG(st.st_mode))
+    return 0;
+
+  return ((buf->pos + (off_t)len_) > st.st_size);
+}
+
+static
+int
+fuse_send_data_iov_splice(struct fuse_ll     *f_,
+                          struct fuse_chan   *ch_,
+                          struct iovec       *iov_,
+                          int                 iov_count_,
+                          struct fuse_bufvec *buf_,
+                          size_t              len_)
+{
+  ssize_t rv;
+  size_t headerlen;
+  struct fuse_ll_pipe *llp;
+  struct fuse_out_header *out = iov_[0].iov_base;
+  struct fuse_bufvec pipe_buf = FUSE_BUFVEC_INIT(len_);
+
+  headerlen = iov_length(iov_,iov_count_);
+  out->len  = headerlen + len_;
+
+  if(fuse_ll_read_past_eof(buf_,len_))
+    goto fallback;
+
+  llp = fuse_ll_get_pipe(f_);
+  if(llp == NULL)
+    goto fallback;
+  if(llp->size < (out->len + pagesize))
+    goto fallback;
+
+  rv = vmsplice(llp->pipe[1],iov_,iov_count_,SPLICE_F_NONBLOCK);
+  if(rv != (ssize_t)headerlen)
+    {
+      fuse_ll_clear_pipe(f_);
+      goto fallback;
+    }
+
+  pipe_buf.buf[0].flags = FUSE_BUF_IS_FD;
+  pipe_buf.buf[0].fd    = llp->pipe[1];
+
+  rv = fuse_buf_copy(&pipe_buf,buf_,FUSE_BUF_FORCE_SPLICE|FUSE_BUF_SPLICE_NONBLOCK);
+  if(rv < 0)
+    {
+      fuse_ll_clear_pipe(f_);
+      goto fallback;
+    }
+
+  if(rv < (ssize_t)len_)
+    {
+      __atomic_add_fetch(&g_SPLICE_READ_FALLBACK_COUNT,1,__ATOMIC_RELAXED);
+      return fuse_send_data_drain_pipe(f_,ch_,llp,headerlen + rv);
+    }
+
+  /*
+    The kernel takes a reply whole or not at all so on failure nothing
+    was delivered and an error reply is sent instead.
+  */
+  rv = splice(llp->pipe[0],NULL,fuse_chan_fd(ch_),NULL,out->len,SPLICE_F_MOVE);
+  if(rv == -1)
+    {
+      rv = errno;
+      fuse_ll_clear_pipe(f_);
+      return rv;
+    }
+
+  if(rv != (ssize_t)out->len)
+    {
+      fuse_ll_clear_pipe(f_);
+      return EIO;
+    }
+
+  __atomic_add_fetch(&g_SPLICE_READ_COUNT,1,__ATOMIC_RELAXED);
+
+  return 0;
+
+ fallback:
+  __atomic_add_fetch(&g_SPLICE_READ_FALLBACK_COUNT,1,__ATOMIC_RELAXED);
+  return fuse_send_data_iov_fallback(f_,ch_,iov_,iov_count_,buf_,len_);
+}
+#else
+static
+int
+fuse_send_data_iov_splice(struct fuse_ll     *f_,
+                          struct fuse_chan   *ch_,
+                          struct iovec       *iov_,
+                          int                 iov_count_,
+                          struct fuse_bufvec *buf_,
+                          size_t              len_)
+{
+  __atomic_add_fetch(&g_SPLICE_READ_FALLBACK_COUNT,1,__ATOMIC_RELAXED);
+  return fuse_send_data_iov_fallback(f_,ch_,iov_,iov_count_,buf_,len_);
+}
+#endif
+
 static
 int
 fuse_send_data_iov(struct fuse_ll     *f,
@@ -487,6 +765,37 @@ fuse_reply_data(fuse_req_t    req,
     }
 }
 
+int
+fuse_reply_data_bufvec(fuse_req_t          req_,
+                       struct fuse_bufvec *bufv_)
+{
+  int rv;
+  int res;
+  struct iovec iov[2];
+  struct fuse_out_header out;
+
+  iov[0].iov_base = &out;
+  iov[0].iov_len  = sizeof(struct fuse_out_header);
+
+  out.unique = req_->unique;
+  out.error  = 0;
+
+  /* replies to requests received via io_uring can't be spliced */
+  if(fuse_uring_current(req_->unique))
+    res = fuse_send_data_iov_fallback(req_->f,req_->ch,iov,1,bufv_,fuse_buf_size(bufv_));
+  else
+    res = fuse_send_data_iov_splice(req_->f,req_->ch,iov,1,bufv_,fuse_buf_size(bufv_));
+  if(res <= 0)
+    {
+      destroy_req(req_);
+      return res;
+    }
+
+  rv = fuse_reply_err(req_,res);
+
+  return ((rv < 0) ? rv : -res);
+}
+
 int
 fuse_reply_statfs(fuse_req_t            req,
                   const struct statvfs *stbuf)
@@ -1175,6 +1484,10 @@ do_init(fuse_req_t             req,
         f->conn.capable |= FUSE_CAP_DIRECT_IO_ALLOW_MMAP;
       if(inargflags & FUSE_CREATE_SUPP_GROUP)
         f->conn.capable |= FUSE_CAP_CREATE_SUPP_GROUP;
+      if(inargflags & FUSE_PASSTHROUGH)
+        f->conn.capable |= FUSE_CAP_PASSTHROUGH;
+      if(inargflags & FUSE_OVER_IO_URING)
+        f->conn.capable |= FUSE_CAP_OVER_IO_URING;
     }
   else
     {
@@ -1212,6 +1525,9 @@ do_init(fuse_req_t             req,
       outarg.max_pages  = f->conn.max_pages;
 
       msgbuf_set_bufsize(outarg.max_pages + 1);
+
+      if(f->conn.max_write > (outarg.max_pages * pagesize))
+        f->conn.max_write = (outarg.max_pages * pagesize);
     }
 
   if(f->conn.want & FUSE_CAP_ASYNC_READ)
@@ -1248,6 +1564,13 @@ do_init(fuse_req_t             req,
     outargflags |= FUSE_CREATE_SUPP_GROUP;
   if(f->conn.want & FUSE_CAP_DIRECT_IO_ALLOW_MMAP)
     outargflags |= FUSE_DIRECT_IO_ALLOW_MMAP;
+  if(f->conn.want & FUSE_CAP_PASSTHROUGH)
+    {
+      outargflags |= FUSE_PASSTHROUGH;
+      outarg.max_stack_depth = f->conn.max_stack_depth;
+    }
+  if(f->conn.want & FUSE_CAP_OVER_IO_URING)
+    outargflags |= FUSE_OVER_IO_URING;
 
   if(inargflags & FUSE_INIT_EXT)
     {
@@ -1655,6 +1978,42 @@ fuse_lowlevel_notify_retrieve(struct fuse_chan *ch,
   return err;
 }
 
+int
+fuse_lowlevel_passthrough_open(struct fuse_chan *ch_,
+                               const int         fd_)
+{
+  int rv;
+  struct fuse_backing_map map = {0};
+
+  if(!ch_)
+    return -EINVAL;
+
+  map.fd = fd_;
+
+  rv = ioctl(fuse_chan_fd(ch_),FUSE_DEV_IOC_BACKING_OPEN,&map);
+  if(rv == -1)
+    return -errno;
+
+  return rv;
+}
+
+int
+fuse_lowlevel_passthrough_close(struct fuse_chan *ch_,
+                                const int         backing_id_)
+{
+  int rv;
+  uint32_t backing_id = backing_id_;
+
+  if(!ch_)
+    return -EINVAL;
+
+  rv = ioctl(fuse_chan_fd(ch_),FUSE_DEV_IOC_BACKING_CLOSE,&backing_id);
+  if(rv == -1)
+    return -errno;
+
+  return 0;
+}
+
 void *
 fuse_req_userdata(fuse_req_t req)
 {
@@ -1881,6 +2240,164 @@ fuse_ll_buf_receive_read(struct fuse_session *se_,
   return rv;
 }
 
+#ifdef HAVE_SPLICE
+static
+int
+fuse_ll_read_pipe(const int  fd_,
+                  void      *buf_,
+                  size_t     count_)
+{
+  ssize_t rv;
+
+  rv = read(fd_,buf_,count_);
+  if(rv == -1)
+    return -errno;
+  if(rv != count_)
+    return -EIO;
+
+  return 0;
+}
+
+/*
+ * Splice the request into the msgbuf's pipe and read back only what
+ * is needed. For WRITE the payload is left in the pipe so the
+ * filesystem can splice it directly to its destination.
+ */
+static
+int
+fuse_ll_buf_receive_splice(struct fuse_session *se_,
+                           fuse_msgbuf_t       *msgbuf_)
+{
+  int rv;
+  size_t len;
+  size_t hdrlen;
+  struct fuse_in_header *in;
+
+  msgbuf_->pipe_payload = 0;
+  if(msgbuf_->pipefd[0] == -1)
+    {
+      rv = msgbuf_pipe_open(msgbuf_);
+      if(rv < 0)
+        return fuse_ll_buf_receive_read(se_,msgbuf_);
+    }
+
+  rv = splice(fuse_chan_fd(se_->ch),NULL,
+              msgbuf_->pipefd[1],NULL,
+              msgbuf_->size,
+              SPLICE_F_MOVE);
+  if(rv == -1)
+    return -errno;
+
+  len = rv;
+  in  = (struct fuse_in_header*)msgbuf_->mem;
+  if(len < sizeof(struct fuse_in_header))
+    goto short_read;
+
+  rv = fuse_ll_read_pipe(msgbuf_->pipefd[0],in,sizeof(struct fuse_in_header));
+  if(rv < 0)
+    goto short_read;
+
+  hdrlen = sizeof(struct fuse_in_header);
+  if((in->opcode == FUSE_WRITE) &&
+     (se_->f->conn.proto_minor >= 9) &&
+     (len > (hdrlen + sizeof(struct fuse_write_in))))
+    hdrlen += sizeof(struct fuse_write_in);
+  else
+    hdrlen = len;
+
+  rv = fuse_ll_read_pipe(msgbuf_->pipefd[0],
+                         &msgbuf_->mem[sizeof(struct fuse_in_header)],
+                         hdrlen - sizeof(struct fuse_in_header));
+  if(rv < 0)
+    goto short_read;
+
+  msgbuf_->pipe_payload = (len - hdrlen);
+
+  return len;
+
+ short_read:
+  fprintf(stderr, "short read from fuse device\n");
+  msgbuf_pipe_close(msgbuf_);
+  return -EIO;
+}
+
+/*
+ * Whatever the filesystem did not consume must be removed so the
+ * pipe can be reused for the next request.
+ */
+static
+void
+fuse_ll_drain_payload(const fuse_msgbuf_t *msgbuf_)
+{
+  ssize_t rv;
+
+  do
+    {
+      rv = read(msgbuf_->pipefd[0],msgbuf_->mem,msgbuf_->size);
+    }
+  while(rv > 0);
+}
+
+/*
+ * Called once INIT has set the message size. The kernel fails any
+ * request which does not fit in the pipe so only switch over if a
+ * large enough pipe can be created.
+ */
+static
+void
+fuse_ll_start_write_splice(struct fuse_session *se_)
+{
+  int rv;
+  fuse_msgbuf_t msgbuf = {0};
+
+  msgbuf.pipefd[0] = -1;
+  msgbuf.pipefd[1] = -1;
+
+  rv = msgbuf_pipe_open(&msgbuf);
+  if(rv < 0)
+    {
+      fprintf(stderr,
+              "fuse: unable to create pipe for write splicing, "
+              "falling back to read: %s\n",
+              strerror(-rv));
+      return;
+    }
+
+  msgbuf_pipe_close(&msgbuf);
+
+  se_->receive_buf = fuse_ll_buf_receive_splice;
+}
+#else
+static
+void
+fuse_ll_drain_payload(const fuse_msgbuf_t *msgbuf_)
+{
+  (void)msgbuf_;
+}
+
+static
+void
+fuse_ll_start_write_splice(struct fuse_session *se_)
+{
+  (void)se_;
+}
+#endif
+
+void
+fuse_session_enable_write_splice(struct fuse_session *se_)
+{
+  se_->f->write_splice = 1;
+}
+
+int
+fuse_write_splice_pipe(fuse_req_t req_)
+{
+  if(req_->write_splice)
+    return req_->write_pipefd;
+
+  return -1;
+}
+
 static
 void
 fuse_ll_buf_process_read(struct fuse_session *se_,
@@ -1904,6 +2421,12 @@ fuse_ll_buf_process_read(struct fuse_session *se_,
   req->ctx.pid = in->pid;
   req->ch      = se_->ch;
 
+  if(msgbuf_->pipe_payload)
+    {
+      req->write_splice = 1;
+      req->write_pipefd = msgbuf_->pipefd[0];
+    }
+
   err = ENOSYS;
   if(in->opcode >= FUSE_MAXOP)
     goto reply_err;
@@ -1912,6 +2435,9 @@ fuse_ll_buf_process_read(struct fuse_session *se_,
 
   fuse_ll_ops[in->opcode].func(req, in);
 
+  if(msgbuf_->pipe_payload)
+    fuse_ll_drain_payload(msgbuf_);
+
   return;
 
  reply_err:
@@ -1919,6 +2445,19 @@ fuse_ll_buf_process_read(struct fuse_session *se_,
   return;
 }
 
+static
+void
+fuse_ll_start_uring(struct fuse_session *se_)
+{
+  int rv;
+
+  rv = fuse_uring_start(se_);
+  if(rv < 0)
+    fprintf(stderr,
+            "fuse: unable to start io_uring queues: %s\n",
+            strerror(-rv));
+}
+
 static
 void
 fuse_ll_buf_process_read_init(struct fuse_session *se_,
@@ -1950,6 +2489,12 @@ fuse_ll_buf_process_read_init(struct fuse_session *se_,
 
   fuse_ll_ops[in->opcode].func(req, in);
 
+  if(se_->f->write_splice)
+    fuse_ll_start_write_splice(se_);
+
+  if(se_->f->conn.want & FUSE_CAP_OVER_IO_URING)
+    fuse_ll_start_uring(se_);
+
   return;
 
  reply_err:
@@ -1987,6 +2532,7 @@ fuse_lowlevel_new_common(struct fuse_args               *args,
 
   f->conn.max_write = UINT_MAX;
   f->conn.max_readahead = UINT_MAX;
+  f->conn.max_stack_depth = 1;
   list_init_nreq(&f->notify_list);
   f->notify_ctr = 1;
   fuse_mutex_init(&f->lock);
@@ -19,22 +19,62 @@
 #include "fuse.h"
 #include "fuse_kernel.h"
 
+#include "moodycamel/concurrentqueue.h"
+
+#include <fcntl.h>
+#include <sys/syscall.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <atomic>
 #include <cstdint>
+#include <cstdio>
 #include <cstdlib>
-#include <mutex>
-#include <vector>
+#include <cstring>
+
+
+/*
+  Free buffers are cached per thread in a small magazine. When a
+  magazine runs dry or overflows half of it is exchanged with a
+  global lock free depot. The common alloc/free pair on a worker
+  thread therefore touches no shared state besides the counters.
+
+  Buffers are allocated by the thread which first needs them and the
+  kernel places their pages on that thread's NUMA node when they are
+  first touched. Since the magazine hands a thread back the buffers
+  it freed most recently those buffers tend to stay local to it.
+*/
+#define MSGBUF_MAGAZINE_SIZE 8
 
+#if defined SYS_setreuid32
+#define MSGBUF_SETREUID(R,E) (syscall(SYS_setreuid32,(R),(E)))
+#else
+#define MSGBUF_SETREUID(R,E) (syscall(SYS_setreuid,(R),(E)))
+#endif
 
 static std::uint32_t g_PAGESIZE = 0;
 static std::uint32_t g_BUFSIZE  = 0;
 
 static std::atomic<std::uint_fast64_t> g_MSGBUF_ALLOC_COUNT;
+static std::atomic<std::uint_fast64_t> g_MSGBUF_AVAIL_COUNT;
+static std::atomic<std::uint_fast64_t> g_MSGBUF_HIGH_WATER_COUNT;
+static std::atomic<std::uint_fast64_t> g_MSGBUF_MAX_IDLE;
+static std::atomic<bool>               g_MSGBUF_PIPE_UNSIZABLE;
+
+static moodycamel::ConcurrentQueue<fuse_msgbuf_t*> g_MSGBUF_DEPOT;
 
-static std::mutex g_MUTEX;
-static std::vector<fuse_msgbuf_t*> g_MSGBUF_STACK;
+struct msgbuf_magazine_t
+{
+  ~msgbuf_magazine_t()
+  {
+    g_MSGBUF_DEPOT.enqueue_bulk(bufs,count);
+  }
+
+  std::size_t    count = 0;
+  fuse_msgbuf_t *bufs[MSGBUF_MAGAZINE_SIZE];
+};
+
+static thread_local msgbuf_magazine_t t_MAGAZINE;
 
 uint64_t
 msgbuf_get_bufsize()
@@ -98,6 +138,22 @@ page_aligned_malloc(const uint64_t size_)
   return buf;
 }
 
+static
+void
+msgbuf_update_high_water(const uint64_t count_)
+{
+  std::uint_fast64_t high;
+
+  high = g_MSGBUF_HIGH_WATER_COUNT.load(std::memory_order_relaxed);
+  while(count_ > high)
+    {
+      if(g_MSGBUF_HIGH_WATER_COUNT.compare_exchange_weak(high,
+                                                         count_,
+                                                         std::memory_order_relaxed))
+        break;
+    }
+}
+
 typedef void (*msgbuf_setup_func_t)(fuse_msgbuf_t*);
 
 static
@@ -105,23 +161,31 @@ fuse_msgbuf_t*
 _msgbuf_alloc(msgbuf_setup_func_t setup_func_)
 {
   fuse_msgbuf_t *msgbuf;
+  msgbuf_magazine_t &mag = t_MAGAZINE;
+
+  if(mag.count == 0)
+    mag.count = g_MSGBUF_DEPOT.try_dequeue_bulk(mag.bufs,
+                                                MSGBUF_MAGAZINE_SIZE / 2);
 
-  g_MUTEX.lock();
-  if(g_MSGBUF_STACK.empty())
+  if(mag.count)
+    {
+      msgbuf = mag.bufs[--mag.count];
+      g_MSGBUF_AVAIL_COUNT.fetch_sub(1,std::memory_order_relaxed);
+    }
+  else
     {
-      g_MUTEX.unlock();
+      uint64_t count;
 
       msgbuf = (fuse_msgbuf_t*)page_aligned_malloc(g_BUFSIZE);
       if(msgbuf == NULL)
         return NULL;
 
-      g_MSGBUF_ALLOC_COUNT.fetch_add(1,std::memory_order_relaxed);
-    }
-  else
-    {
-      msgbuf = g_MSGBUF_STACK.back();
-      g_MSGBUF_STACK.pop_back();
-      g_MUTEX.unlock();
+      msgbuf->pipefd[0]    = -1;
+      msgbuf->pipefd[1]    = -1;
+      msgbuf->pipe_payload = 0;
+
+      count = g_MSGBUF_ALLOC_COUNT.fetch_add(1,std::memory_order_relaxed);
+      msgbuf_update_high_water(count + 1);
     }
 
   setup_func_(msgbuf);
@@ -149,23 +213,122 @@ void
 msgbuf_destroy(fuse_msgbuf_t *msgbuf_)
 {
   //  free(msgbuf_->mem);
+  msgbuf_pipe_close(msgbuf_);
   free(msgbuf_);
+  g_MSGBUF_ALLOC_COUNT.fetch_sub(1,std::memory_order_relaxed);
+}
+
+/*
+  Requests run with the caller's euid and without CAP_SYS_RESOURCE
+  growing a pipe is limited by pipe-max-size and the user's pipe page
+  quota. Only this thread's euid is switched, the same way mergerfs'
+  ugid does, so a pipe is sized the same no matter whose request
+  created it. The first failure is logged.
+*/
+int
+msgbuf_pipe_set_size(const int      fd_,
+                     const uint64_t size_)
+{
+  int rv;
+  int err;
+  uid_t euid;
+  static std::atomic<bool> logged(false);
+
+  euid = geteuid();
+  if(euid != 0)
+    MSGBUF_SETREUID(-1,0);
+
+  rv  = fcntl(fd_,F_SETPIPE_SZ,size_);
+  err = errno;
+
+  if(euid != 0)
+    MSGBUF_SETREUID(-1,euid);
+
+  if((rv == -1) && !logged.exchange(true,std::memory_order_relaxed))
+    fprintf(stderr,
+            "fuse: unable to set splice pipe size to %lu: %s\n",
+            (unsigned long)size_,
+            strerror(err));
+
+  errno = err;
+
+  return rv;
+}
+
+// A pipe used to splice requests out of /dev/fuse. It must be able
+// to hold a full request or the kernel will fail the request. Data
+// may not be page aligned so one more page than the message is
+// needed which happens to be the size of the buffer. If a pipe can't
+// be made that large even as root it never will be so later calls
+// fail straight away and requests are read instead.
+int
+msgbuf_pipe_open(fuse_msgbuf_t *msgbuf_)
+{
+  int rv;
+
+  if(g_MSGBUF_PIPE_UNSIZABLE.load(std::memory_order_relaxed))
+    return -ENOSPC;
+
+  rv = pipe2(msgbuf_->pipefd,O_CLOEXEC|O_NONBLOCK);
+  if(rv == -1)
+    return -errno;
+
+  rv = msgbuf_pipe_set_size(msgbuf_->pipefd[0],g_BUFSIZE);
+  if(rv < (int)g_BUFSIZE)
+    {
+      msgbuf_pipe_close(msgbuf_);
+      g_MSGBUF_PIPE_UNSIZABLE.store(true,std::memory_order_relaxed);
+      return -ENOSPC;
+    }
+
+  return 0;
+}
+
+void
+msgbuf_pipe_close(fuse_msgbuf_t *msgbuf_)
+{
+  if(msgbuf_->pipefd[0] != -1)
+    close(msgbuf_->pipefd[0]);
+  if(msgbuf_->pipefd[1] != -1)
+    close(msgbuf_->pipefd[1]);
+  msgbuf_->pipefd[0]    = -1;
+  msgbuf_->pipefd[1]    = -1;
+  msgbuf_->pipe_payload = 0;
 }
 
+/*
+  The idle cap is checked without synchronization so it can be
+  overshot briefly by concurrent frees. Good enough for trimming.
+*/
 void
 msgbuf_free(fuse_msgbuf_t *msgbuf_)
 {
-  std::lock_guard<std::mutex> lck(g_MUTEX);
+  uint64_t max_idle;
+  msgbuf_magazine_t &mag = t_MAGAZINE;
 
   if(msgbuf_->size != (g_BUFSIZE - g_PAGESIZE))
     {
       msgbuf_destroy(msgbuf_);
-      g_MSGBUF_ALLOC_COUNT.fetch_sub(1,std::memory_order_relaxed);
       return;
     }
 
-  g_MSGBUF_STACK.emplace_back(msgbuf_);
+  max_idle = g_MSGBUF_MAX_IDLE.load(std::memory_order_relaxed);
+  if(max_idle &&
+     (g_MSGBUF_AVAIL_COUNT.load(std::memory_order_relaxed) >= max_idle))
+    {
+      msgbuf_destroy(msgbuf_);
+      return;
+    }
+
+  if(mag.count == MSGBUF_MAGAZINE_SIZE)
+    {
+      mag.count -= (MSGBUF_MAGAZINE_SIZE / 2);
+      g_MSGBUF_DEPOT.enqueue_bulk(&mag.bufs[mag.count],
+                                  MSGBUF_MAGAZINE_SIZE / 2);
+    }
 
+  mag.bufs[mag.count++] = msgbuf_;
+  g_MSGBUF_AVAIL_COUNT.fetch_add(1,std::memory_order_relaxed);
 }
 
 uint64_t
@@ -177,52 +340,61 @@ msgbuf_alloc_count()
 uint64_t
 msgbuf_avail_count()
 {
-  std::lock_guard<std::mutex> lck(g_MUTEX);
-
-  return g_MSGBUF_STACK.size();
+  return g_MSGBUF_AVAIL_COUNT;
 }
 
-void
-msgbuf_gc_10percent()
+uint64_t
+msgbuf_high_water_count()
 {
-  std::vector<fuse_msgbuf_t*> togc;
-
-  {
-    std::size_t size;
-    std::size_t ten_percent;
+  return g_MSGBUF_HIGH_WATER_COUNT;
+}
 
-    std::lock_guard<std::mutex> lck(g_MUTEX);
+uint64_t
+msgbuf_get_max_idle()
+{
+  return g_MSGBUF_MAX_IDLE;
+}
 
-    size        = g_MSGBUF_STACK.size();
-    ten_percent = (size / 10);
+void
+msgbuf_set_max_idle(const uint64_t max_idle_)
+{
+  g_MSGBUF_MAX_IDLE = max_idle_;
+}
 
-    for(std::size_t i = 0; i < ten_percent; i++)
-      {
-        togc.push_back(g_MSGBUF_STACK.back());
-        g_MSGBUF_STACK.pop_back();
-      }
-  }
+/*
+  Only buffers in the depot are collected. Those sitting in thread
+  magazines are bounded by MSGBUF_MAGAZINE_SIZE per thread and are
+  the ones most likely to be needed again soon.
+*/
+static
+void
+msgbuf_gc_count(std::size_t count_)
+{
+  std::size_t n;
+  fuse_msgbuf_t *bufs[64];
+  const std::size_t max = (sizeof(bufs) / sizeof(bufs[0]));
 
-  for(auto msgbuf : togc)
+  while(count_)
     {
-      msgbuf_destroy(msgbuf);
-      g_MSGBUF_ALLOC_COUNT.fetch_sub(1,std::memory_order_relaxed);
+      n = g_MSGBUF_DEPOT.try_dequeue_bulk(bufs,std::min(count_,max));
+      if(n == 0)
+        break;
+
+      g_MSGBUF_AVAIL_COUNT.fetch_sub(n,std::memory_order_relaxed);
+      for(std::size_t i = 0; i < n; i++)
+        msgbuf_destroy(bufs[i]);
+      count_ -= n;
     }
 }
 
 void
-msgbuf_gc()
+msgbuf_gc_10percent()
 {
-  std::vector<fuse_msgbuf_t*> oldstack;
-
-  {
-    std::lock_guard<std::mutex> lck(g_MUTEX);
-    oldstack.swap(g_MSGBUF_STACK);
-  }
+  msgbuf_gc_count(g_MSGBUF_DEPOT.size_approx() / 10);
+}
 
-  for(auto msgbuf: oldstack)
-    {
-      msgbuf_destroy(msgbuf);
-      g_MSGBUF_ALLOC_COUNT.fetch_sub(1,std::memory_order_relaxed);
-    }
+void
+msgbuf_gc()
+{
+  msgbuf_gc_count(SIZE_MAX);
 }
@@ -35,8 +35,16 @@ void           msgbuf_gc_10percent();
 
 uint64_t       msgbuf_alloc_count();
 uint64_t       msgbuf_avail_count();
+uint64_t       msgbuf_high_water_count();
+
+void           msgbuf_set_max_idle(const uint64_t max_idle);
+uint64_t       msgbuf_get_max_idle();
 
 void           msgbuf_page_align(fuse_msgbuf_t *msgbuf);
 void           msgbuf_write_align(fuse_msgbuf_t *msgbuf);
 
+int            msgbuf_pipe_set_size(const int fd, const uint64_t size);
+int            msgbuf_pipe_open(fuse_msgbuf_t *msgbuf);
+void           msgbuf_pipe_close(fuse_msgbuf_t *msgbuf);
+
 EXTERN_C_END
@@ -0,0 +1,709 @@
+/*
+  ISC License
+
+  Copyright (c) 2024, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+/*
+  FUSE over io_uring (Linux 6.14+)
+
+  The kernel keeps one queue per possible CPU and hands requests to
+  the queue of the CPU the requesting task is running on. Each queue
+  is served by its own thread and ring which runs the handlers
+  inline so a slow request holds up others from the same CPU. Entries are registered with
+  a header and payload buffer which the kernel fills with a request.
+  The reply is written back into the same buffers and committed with
+  a command which also fetches the next request. Commits are only
+  submitted when the thread next waits for completions so replies
+  are batched along with the wait in a single io_uring_enter.
+
+  FORGET and INTERRUPT as well as anything sent before all queues
+  are registered still arrive via /dev/fuse so the regular loop
+  continues to run alongside.
+*/
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "config.h"
+
+#include "fuse_uring.hpp"
+
+#include "fuse_i.h"
+#include "fuse_kernel.h"
+#include "fuse_lowlevel.h"
+#include "fuse_msgbuf.hpp"
+
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <syslog.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <vector>
+
+#ifdef HAVE_IO_URING
+#include <linux/io_uring.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#define URING_QUEUE_DEPTH 4
+#define URING_SQE_SIZE    128
+
+struct uring_queue;
+
+struct uring_ent
+{
+  uring_queue                  *queue;
+  struct fuse_uring_req_header *header;
+  char                         *buf;
+  char                         *payload;
+  uint32_t                      payload_size;
+  uint64_t                      unique;
+  uint64_t                      commit_id;
+  bool                          replied;
+  struct iovec                  iov[2];
+};
+
+struct uring_queue
+{
+  int       qid;
+  unsigned  depth;
+  int       ring_fd;
+  pthread_t thread;
+  bool      started;
+
+  void     *sq_ptr;
+  size_t    sq_size;
+  void     *cq_ptr;
+  size_t    cq_size;
+  char     *sqes;
+  size_t    sqes_size;
+
+  unsigned *sq_head;
+  unsigned *sq_tail;
+  unsigned *sq_array;
+  unsigned  sq_mask;
+  unsigned  sq_entries;
+
+  unsigned *cq_head;
+  unsigned *cq_tail;
+  unsigned  cq_mask;
+  struct io_uring_cqe *cqes;
+
+  unsigned  to_submit;
+  unsigned  active;
+
+  std::vector<uring_ent> ents;
+};
+
+static struct fuse_session       *g_SE = NULL;
+static int                        g_FD = -1;
+static std::atomic<bool>          g_EXIT(false);
+static std::vector<uring_queue*>  g_QUEUES;
+
+static thread_local uring_ent *t_ENT = NULL;
+
+static
+int
+uring_read_cpulist(const char        *path_,
+                   std::vector<bool> &cpus_)
+{
+  int rv;
+  int lo;
+  int hi;
+  FILE *f;
+
+  f = fopen(path_,"r");
+  if(f == NULL)
+    return -errno;
+
+  while(true)
+    {
+      rv = fscanf(f,"%d",&lo);
+      if(rv != 1)
+        break;
+      hi = lo;
+      rv = fscanf(f,"-%d",&hi);
+      if(hi >= (int)cpus_.size())
+        cpus_.resize(hi + 1,false);
+      for(int cpu = lo; cpu <= hi; cpu++)
+        cpus_[cpu] = true;
+      if(fgetc(f) != ',')
+        break;
+    }
+  fclose(f);
+
+  return (cpus_.empty() ? -ENOENT : 0);
+}
+
+/*
+  The kernel only marks the ring ready once every possible CPU has a
+  registered queue so one is created for each. Requests are only ever
+  routed to the queue of an online CPU so offline ones get a single
+  entry to satisfy registration rather than a full set of buffers.
+*/
+static
+void
+uring_queue_depths(std::vector<unsigned> &depths_)
+{
+  int rv;
+  std::vector<bool> possible;
+  std::vector<bool> online;
+
+  rv = uring_read_cpulist("/sys/devices/system/cpu/possible",possible);
+  if(rv < 0)
+    possible.assign(sysconf(_SC_NPROCESSORS_CONF),true);
+
+  rv = uring_read_cpulist("/sys/devices/system/cpu/online",online);
+  if(rv < 0)
+    online = possible;
+  online.resize(possible.size(),false);
+
+  depths_.resize(possible.size());
+  for(size_t cpu = 0; cpu < possible.size(); cpu++)
+    depths_[cpu] = (online[cpu] ? URING_QUEUE_DEPTH : 1);
+}
+
+static
+void
+uring_teardown(uring_queue *q_)
+{
+  if(q_->sqes != NULL)
+    munmap(q_->sqes,q_->sqes_size);
+  if((q_->cq_ptr != NULL) && (q_->cq_ptr != q_->sq_ptr))
+    munmap(q_->cq_ptr,q_->cq_size);
+  if(q_->sq_ptr != NULL)
+    munmap(q_->sq_ptr,q_->sq_size);
+  if(q_->ring_fd >= 0)
+    close(q_->ring_fd);
+
+  q_->sqes    = NULL;
+  q_->cq_ptr  = NULL;
+  q_->sq_ptr  = NULL;
+  q_->ring_fd = -1;
+
+  for(auto &ent : q_->ents)
+    {
+      free(ent.header);
+      free(ent.buf);
+    }
+  q_->ents.clear();
+}
+
+static
+int
+uring_setup(uring_queue    *q_,
+            const unsigned  entries_)
+{
+  int fd;
+  char *sq;
+  char *cq;
+  struct io_uring_params p;
+
+  memset(&p,0,sizeof(p));
+  p.flags = (IORING_SETUP_SQE128 | IORING_SETUP_SINGLE_ISSUER);
+
+  fd = syscall(__NR_io_uring_setup,entries_,&p);
+  if(fd < 0)
+    return -errno;
+
+  q_->ring_fd   = fd;
+  q_->sq_size   = (p.sq_off.array + (p.sq_entries * sizeof(unsigned)));
+  q_->cq_size   = (p.cq_off.cqes + (p.cq_entries * sizeof(struct io_uring_cqe)));
+  q_->sqes_size = (p.sq_entries * URING_SQE_SIZE);
+
+  if(p.features & IORING_FEAT_SINGLE_MMAP)
+    {
+      if(q_->cq_size > q_->sq_size)
+        q_->sq_size = q_->cq_size;
+      q_->cq_size = q_->sq_size;
+    }
+
+  q_->sq_ptr = mmap(NULL,q_->sq_size,
+                    PROT_READ|PROT_WRITE,MAP_SHARED|MAP_POPULATE,
+                    fd,IORING_OFF_SQ_RING);
+  if(q_->sq_ptr == MAP_FAILED)
+    {
+      q_->sq_ptr = NULL;
+      return -errno;
+    }
+
+  if(p.features & IORING_FEAT_SINGLE_MMAP)
+    {
+      q_->cq_ptr = q_->sq_ptr;
+    }
+  else
+    {
+      q_->cq_ptr = mmap(NULL,q_->cq_size,
+                        PROT_READ|PROT_WRITE,MAP_SHARED|MAP_POPULATE,
+                        fd,IORING_OFF_CQ_RING);
+      if(q_->cq_ptr == MAP_FAILED)
+        {
+          q_->cq_ptr = NULL;
+          return -errno;
+        }
+    }
+
+  q_->sqes = (char*)mmap(NULL,q_->sqes_size,
+                         PROT_READ|PROT_WRITE,MAP_SHARED|MAP_POPULATE,
+                         fd,IORING_OFF_SQES);
+  if(q_->sqes == MAP_FAILED)
+    {
+      q_->sqes = NULL;
+      return -errno;
+    }
+
+  sq = (char*)q_->sq_ptr;
+  cq = (char*)q_->cq_ptr;
+
+  q_->sq_head    = (unsigned*)(sq + p.sq_off.head);
+  q_->sq_tail    = (unsigned*)(sq + p.sq_off.tail);
+  q_->sq_array   = (unsigned*)(sq + p.sq_off.array);
+  q_->sq_mask    = *(unsigned*)(sq + p.sq_off.ring_mask);
+  q_->sq_entries = *(unsigned*)(sq + p.sq_off.ring_entries);
+  q_->cq_head    = (unsigned*)(cq + p.cq_off.head);
+  q_->cq_tail    = (unsigned*)(cq + p.cq_off.tail);
+  q_->cq_mask    = *(unsigned*)(cq + p.cq_off.ring_mask);
+  q_->cqes       = (struct io_uring_cqe*)(cq + p.cq_off.cqes);
+
+  return 0;
+}
+
+static
+int
+uring_enter(uring_queue    *q_,
+            const unsigned  min_complete_)
+{
+  int rv;
+  struct __kernel_timespec ts;
+  struct io_uring_getevents_arg arg;
+
+  // Wake up periodically to check if the loop has been asked to exit.
+  ts.tv_sec  = 1;
+  ts.tv_nsec = 0;
+
+  memset(&arg,0,sizeof(arg));
+  arg.sigmask_sz = (_NSIG / 8);
+  arg.ts         = (uint64_t)(uintptr_t)&ts;
+
+  rv = syscall(__NR_io_uring_enter,
+               q_->ring_fd,
+               q_->to_submit,
+               min_complete_,
+               (IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG),
+               &arg,
+               sizeof(arg));
+  if(rv < 0)
+    return -errno;
+
+  q_->to_submit -= rv;
+
+  return rv;
+}
+
+static
+struct io_uring_sqe*
+uring_get_sqe(uring_queue *q_)
+{
+  unsigned idx;
+  unsigned head;
+  unsigned tail;
+  struct io_uring_sqe *sqe;
+
+  head = __atomic_load_n(q_->sq_head,__ATOMIC_ACQUIRE);
+  tail = *q_->sq_tail;
+  if((tail - head) >= q_->sq_entries)
+    return NULL;
+
+  idx = (tail & q_->sq_mask);
+  sqe = (struct io_uring_sqe*)&q_->sqes[idx * URING_SQE_SIZE];
+  memset(sqe,0,URING_SQE_SIZE);
+  q_->sq_array[idx] = idx;
+
+  __atomic_store_n(q_->sq_tail,tail + 1,__ATOMIC_RELEASE);
+  q_->to_submit++;
+
+  return sqe;
+}
+
+// Each entry has at most one command outstanding and the SQ is
+// sized to the number of entries so there is always room.
+static
+void
+uring_prep_cmd(uring_ent      *ent_,
+               const uint32_t  cmd_op_)
+{
+  struct io_uring_sqe *sqe;
+  struct fuse_uring_cmd_req *req;
+
+  sqe = uring_get_sqe(ent_->queue);
+
+  sqe->opcode    = IORING_OP_URING_CMD;
+  sqe->fd        = g_FD;
+  sqe->cmd_op    = cmd_op_;
+  sqe->user_data = (uint64_t)(uintptr_t)ent_;
+
+  req = (struct fuse_uring_cmd_req*)sqe->cmd;
+  req->qid       = ent_->queue->qid;
+  req->commit_id = ent_->commit_id;
+
+  if(cmd_op_ == FUSE_IO_URING_CMD_REGISTER)
+    {
+      sqe->addr = (uint64_t)(uintptr_t)ent_->iov;
+      sqe->len  = 2;
+    }
+}
+
+static
+void
+uring_commit_err(uring_ent *ent_,
+                 const int  err_)
+{
+  struct fuse_out_header *out;
+
+  out = (struct fuse_out_header*)ent_->header->in_out;
+  out->len    = sizeof(struct fuse_out_header);
+  out->error  = -err_;
+  out->unique = ent_->unique;
+
+  ent_->header->ring_ent_in_out.payload_sz = 0;
+  ent_->replied = true;
+
+  uring_prep_cmd(ent_,FUSE_IO_URING_CMD_COMMIT_AND_FETCH);
+}
+
+/*
+  The kernel splits the request into the fuse_in_header, the opcode
+  specific argument, and everything else in the payload. The first
+  two are copied in front of the payload (which has a page of space
+  reserved before it) so the rest of the library sees the same
+  contiguous message as a read from /dev/fuse.
+*/
+static
+void
+uring_process(uring_ent *ent_)
+{
+  size_t oplen;
+  size_t hdrlen;
+  fuse_msgbuf_t msgbuf;
+  struct fuse_in_header *in;
+  struct fuse_uring_ent_in_out *ent_in_out;
+
+  in         = (struct fuse_in_header*)ent_->header->in_out;
+  ent_in_out = &ent_->header->ring_ent_in_out;
+
+  ent_->unique    = in->unique;
+  ent_->commit_id = ent_in_out->commit_id;
+  ent_->replied   = false;
+
+  hdrlen = sizeof(struct fuse_in_header);
+  if((in->len < (hdrlen + ent_in_out->payload_sz)) ||
+     ((in->len - hdrlen - ent_in_out->payload_sz) > FUSE_URING_OP_IN_OUT_SZ))
+    return uring_commit_err(ent_,EIO);
+
+  oplen = (in->len - hdrlen - ent_in_out->payload_sz);
+
+  msgbuf.mem          = (ent_->payload - oplen - hdrlen);
+  msgbuf.size         = (hdrlen + oplen + ent_->payload_size);
+  msgbuf.pipefd[0]    = -1;
+  msgbuf.pipefd[1]    = -1;
+  msgbuf.pipe_payload = 0;
+
+  memcpy(msgbuf.mem,in,hdrlen);
+  memcpy(msgbuf.mem + hdrlen,ent_->header->op_in,oplen);
+
+  t_ENT = ent_;
+  g_SE->process_buf(g_SE,&msgbuf);
+  t_ENT = NULL;
+
+  if(!ent_->replied)
+    uring_commit_err(ent_,EIO);
+}
+
+static
+void
+uring_reap(uring_queue *q_)
+{
+  unsigned head;
+  unsigned tail;
+  uring_ent *ent;
+  struct io_uring_cqe *cqe;
+
+  head = *q_->cq_head;
+  tail = __atomic_load_n(q_->cq_tail,__ATOMIC_ACQUIRE);
+  while(head != tail)
+    {
+      cqe = &q_->cqes[head & q_->cq_mask];
+      ent = (uring_ent*)(uintptr_t)cqe->user_data;
+
+      if(cqe->res < 0)
+        {
+          if((cqe->res != -ENOTCONN) && (cqe->res != -ECANCELED))
+            syslog(LOG_ERR,
+                   "fuse-loop=io_uring: queue %d command failed - %s",
+                   q_->qid,
+                   strerror(-cqe->res));
+          q_->active--;
+        }
+      else
+        {
+          uring_process(ent);
+        }
+
+      head++;
+      __atomic_store_n(q_->cq_head,head,__ATOMIC_RELEASE);
+    }
+}
+
+static
+int
+uring_alloc_ents(uring_queue *q_)
+{
+  int rv;
+  long pagesize;
+  uint32_t payload_size;
+
+  pagesize     = sysconf(_SC_PAGESIZE);
+  payload_size = msgbuf_get_bufsize();
+
+  q_->ents.resize(q_->depth);
+  for(auto &ent : q_->ents)
+    {
+      memset(&ent,0,sizeof(ent));
+
+      ent.queue        = q_;
+      ent.payload_size = payload_size;
+
+      rv = posix_memalign((void**)&ent.header,
+                          pagesize,
+                          sizeof(struct fuse_uring_req_header));
+      if(rv != 0)
+        return -rv;
+
+      rv = posix_memalign((void**)&ent.buf,
+                          pagesize,
+                          pagesize + payload_size);
+      if(rv != 0)
+        return -rv;
+
+      ent.payload = (ent.buf + pagesize);
+
+      ent.iov[0].iov_base = ent.header;
+      ent.iov[0].iov_len  = sizeof(struct fuse_uring_req_header);
+      ent.iov[1].iov_base = ent.payload;
+      ent.iov[1].iov_len  = ent.payload_size;
+    }
+
+  return 0;
+}
+
+static
+void
+uring_pin(uring_queue *q_)
+{
+  cpu_set_t cpuset;
+
+  if(q_->qid >= CPU_SETSIZE)
+    return;
+
+  CPU_ZERO(&cpuset);
+  CPU_SET(q_->qid,&cpuset);
+
+  pthread_setaffinity_np(pthread_self(),sizeof(cpuset),&cpuset);
+}
+
+static
+void*
+uring_thread(void *arg_)
+{
+  int rv;
+  uring_queue *q = (uring_queue*)arg_;
+
+  uring_pin(q);
+
+  rv = uring_setup(q,q->depth);
+  if(rv == 0)
+    rv = uring_alloc_ents(q);
+  if(rv < 0)
+    {
+      syslog(LOG_ERR,
+             "fuse-loop=io_uring: unable to setup queue %d - %s",
+             q->qid,
+             strerror(-rv));
+      uring_teardown(q);
+      return NULL;
+    }
+
+  for(auto &ent : q->ents)
+    uring_prep_cmd(&ent,FUSE_IO_URING_CMD_REGISTER);
+  q->active = q->ents.size();
+
+  while(q->active && !g_EXIT && !fuse_session_exited(g_SE))
+    {
+      rv = uring_enter(q,1);
+      if((rv < 0) &&
+         (rv != -EINTR) &&
+         (rv != -ETIME) &&
+         (rv != -EAGAIN) &&
+         (rv != -EBUSY))
+        {
+          syslog(LOG_ERR,
+                 "fuse-loop=io_uring: queue %d enter failed - %s",
+                 q->qid,
+                 strerror(-rv));
+          break;
+        }
+
+      uring_reap(q);
+    }
+
+  uring_teardown(q);
+
+  return NULL;
+}
+
+int
+fuse_uring_start(struct fuse_session *se_)
+{
+  int rv;
+  int nr_online;
+  uring_queue *q;
+  std::vector<unsigned> depths;
+
+  g_SE = se_;
+  g_FD = fuse_chan_fd(se_->ch);
+  g_EXIT = false;
+
+  nr_online = 0;
+  uring_queue_depths(depths);
+  for(int qid = 0; qid < (int)depths.size(); qid++)
+    {
+      q = new uring_queue();
+      q->qid     = qid;
+      q->depth   = depths[qid];
+      q->ring_fd = -1;
+      if(q->depth == URING_QUEUE_DEPTH)
+        nr_online++;
+
+      rv = fuse_start_thread(&q->thread,uring_thread,q);
+      if(rv == -1)
+        {
+          delete q;
+          return -EAGAIN;
+        }
+
+      q->started = true;
+      g_QUEUES.push_back(q);
+    }
+
+  syslog(LOG_INFO,"fuse-loop=io_uring; queues=%d; online=%d; queue-depth=%d;",
+         (int)depths.size(),
+         nr_online,
+         URING_QUEUE_DEPTH);
+
+  return 0;
+}
+
+void
+fuse_uring_stop(void)
+{
+  g_EXIT = true;
+
+  for(auto q : g_QUEUES)
+    {
+      if(q->started)
+        pthread_join(q->thread,NULL);
+      delete q;
+    }
+
+  g_QUEUES.clear();
+}
+
+int
+fuse_uring_current(const uint64_t unique_)
+{
+  return ((t_ENT != NULL) && (t_ENT->unique == unique_));
+}
+
+int
+fuse_uring_send_msg(struct iovec *iov_,
+                    const int     count_)
+{
+  size_t len;
+  uring_ent *ent;
+  struct fuse_out_header *out;
+
+  out = (struct fuse_out_header*)iov_[0].iov_base;
+  ent = t_ENT;
+  if((ent == NULL) || (ent->unique != out->unique) || ent->replied)
+    return -ENOENT;
+
+  len = 0;
+  for(int i = 1; i < count_; i++)
+    {
+      if((len + iov_[i].iov_len) > ent->payload_size)
+        return -ERANGE;
+
+      memmove(&ent->payload[len],iov_[i].iov_base,iov_[i].iov_len);
+      len += iov_[i].iov_len;
+    }
+
+  memcpy(ent->header->in_out,out,sizeof(struct fuse_out_header));
+  ent->header->ring_ent_in_out.payload_sz = len;
+  ent->replied = true;
+
+  uring_prep_cmd(ent,FUSE_IO_URING_CMD_COMMIT_AND_FETCH);
+
+  return 0;
+}
+#else
+int
+fuse_uring_start(struct fuse_session *se_)
+{
+  (void)se_;
+
+  return -ENOSYS;
+}
+
+void
+fuse_uring_stop(void)
+{
+}
+
+int
+fuse_uring_current(const uint64_t unique_)
+{
+  (void)unique_;
+
+  return 0;
+}
+
+int
+fuse_uring_send_msg(struct iovec *iov_,
+                    const int     count_)
+{
+  (void)iov_;
+  (void)count_;
+
+  return -ENOENT;
+}
+#endif
@@ -1,22 +1,27 @@
+#pragma once
+
 #include "lock.h"
 #include "lfmp.h"
 
 typedef struct node_s node_t;
 struct node_s
 {
-  node_t *name_next;
-  node_t *id_next;
-
   uint64_t nodeid;
   char *name;
   node_t *parent;
 
+  char *path;
+  uint64_t path_gen;
+
   uint64_t nlookup;
   uint32_t refctr;
   uint32_t open_count;
   uint64_t hidden_fh;
 
   int32_t treelock;
+  uint32_t remembered_time;
+  node_t *remembered_prev;
+  node_t *remembered_next;
   lock_t *locks;
 
   uint32_t stat_crc32b;
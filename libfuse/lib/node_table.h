@@ -0,0 +1,477 @@
+/*
+  ISC License
+
+  Copyright (c) 2024, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#pragma once
+
+#include "node.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+  Open addressing, Robin Hood hashed table of nodes. Each slot keeps
+  the full 64bit hash next to the node pointer so probing only touches
+  the node itself when the hashes match. The table is keyed by hash
+  alone and allows duplicates. Callers walk the candidates for a hash
+  with node_table_probe_next() and compare keys themselves.
+
+  Growing or shrinking allocates the new slot array and leaves the old
+  one in place. Every insert and remove then migrates a few old slots
+  so the cost of a resize is spread across many calls rather than
+  stalling one. Lookups check both arrays until migration is done.
+  Removals from the old array leave tombstones since backward shifting
+  could move entries behind the migration cursor.
+
+  Not thread safe.
+*/
+
+#define NODE_TABLE_TOMBSTONE    ((node_t*)1)
+#define NODE_TABLE_MIGRATE_STEP 8
+
+typedef struct node_table_slot_t node_table_slot_t;
+struct node_table_slot_t
+{
+  uint64_t  hash;
+  node_t   *node;
+};
+
+typedef struct node_table_t node_table_t;
+struct node_table_t
+{
+  node_table_slot_t *slots;
+  uint64_t           mask;
+  uint64_t           use;
+  uint64_t           min_size;
+
+  node_table_slot_t *old_slots;
+  uint64_t           old_mask;
+  uint64_t           old_use;
+  uint64_t           migrate_pos;
+};
+
+typedef struct node_table_probe_t node_table_probe_t;
+struct node_table_probe_t
+{
+  uint64_t hash;
+  uint64_t pos;
+  uint64_t dist;
+  int      old;
+};
+
+static
+inline
+uint64_t
+node_table_dist(const uint64_t mask_,
+                const uint64_t pos_,
+                const uint64_t hash_)
+{
+  return ((pos_ - (hash_ & mask_)) & mask_);
+}
+
+/* min_size_ must be a power of 2 */
+static
+inline
+int
+node_table_init(node_table_t   *t_,
+                const uint64_t  min_size_)
+{
+  memset(t_,0,sizeof(*t_));
+
+  t_->slots = (node_table_slot_t*)calloc(min_size_,sizeof(node_table_slot_t));
+  if(t_->slots == NULL)
+    return -1;
+
+  t_->mask     = (min_size_ - 1);
+  t_->min_size = min_size_;
+
+  return 0;
+}
+
+static
+inline
+void
+node_table_destroy(node_table_t *t_)
+{
+  free(t_->slots);
+  free(t_->old_slots);
+  t_->slots     = NULL;
+  t_->old_slots = NULL;
+}
+
+static
+inline
+uint64_t
+node_table_size(const node_table_t *t_)
+{
+  uint64_t size;
+
+  size = (t_->mask + 1);
+  if(t_->old_slots)
+    size += (t_->old_mask + 1);
+
+  return size;
+}
+
+static
+inline
+uint64_t
+node_table_use(const node_table_t *t_)
+{
+  return (t_->use + t_->old_use);
+}
+
+static
+inline
+void
+node_table_slots_insert(node_table_slot_t *slots_,
+                        const uint64_t     mask_,
+                        uint64_t           hash_,
+                        node_t            *node_)
+{
+  uint64_t pos;
+  uint64_t dist;
+
+  pos  = (hash_ & mask_);
+  dist = 0;
+  while(slots_[pos].node != NULL)
+    {
+      uint64_t d;
+
+      d = node_table_dist(mask_,pos,slots_[pos].hash);
+      if(d < dist)
+        {
+          node_table_slot_t tmp = slots_[pos];
+
+          slots_[pos].hash = hash_;
+          slots_[pos].node = node_;
+          hash_ = tmp.hash;
+          node_ = tmp.node;
+          dist  = d;
+        }
+
+      pos = ((pos + 1) & mask_);
+      dist++;
+    }
+
+  slots_[pos].hash = hash_;
+  slots_[pos].node = node_;
+}
+
+static
+inline
+void
+node_table_migrate(node_table_t   *t_,
+                   const uint64_t  count_)
+{
+  uint64_t end;
+
+  if(t_->old_slots == NULL)
+    return;
+
+  end = t_->migrate_pos + count_;
+  if(end > (t_->old_mask + 1))
+    end = (t_->old_mask + 1);
+
+  for(; t_->migrate_pos < end; t_->migrate_pos++)
+    {
+      node_table_slot_t *slot = &t_->old_slots[t_->migrate_pos];
+
+      if((slot->node == NULL) || (slot->node == NODE_TABLE_TOMBSTONE))
+        continue;
+
+      node_table_slots_insert(t_->slots,t_->mask,slot->hash,slot->node);
+      slot->node = NODE_TABLE_TOMBSTONE;
+      t_->old_use--;
+      t_->use++;
+    }
+
+  if(t_->migrate_pos > t_->old_mask)
+    {
+      free(t_->old_slots);
+      t_->old_slots   = NULL;
+      t_->old_mask    = 0;
+      t_->old_use     = 0;
+      t_->migrate_pos = 0;
+    }
+}
+
+/* On allocation failure the table stays as is. */
+static
+inline
+void
+node_table_resize(node_table_t   *t_,
+                  const uint64_t  size_)
+{
+  node_table_slot_t *slots;
+
+  if(t_->old_slots)
+    node_table_migrate(t_,t_->old_mask + 1);
+
+  slots = (node_table_slot_t*)calloc(size_,sizeof(node_table_slot_t));
+  if(slots == NULL)
+    return;
+
+  t_->old_slots   = t_->slots;
+  t_->old_mask    = t_->mask;
+  t_->old_use     = t_->use;
+  t_->migrate_pos = 0;
+  t_->slots       = slots;
+  t_->mask        = (size_ - 1);
+  t_->use         = 0;
+}
+
+static
+inline
+void
+node_table_insert(node_table_t   *t_,
+                  const uint64_t  hash_,
+                  node_t         *node_)
+{
+  node_table_migrate(t_,NODE_TABLE_MIGRATE_STEP);
+
+  if(((t_->use + t_->old_use + 1) * 8) > ((t_->mask + 1) * 7))
+    node_table_resize(t_,(t_->mask + 1) * 2);
+
+  node_table_slots_insert(t_->slots,t_->mask,hash_,node_);
+  t_->use++;
+}
+
+static
+inline
+int
+node_table_remove_new(node_table_t   *t_,
+                      const uint64_t  hash_,
+                      const node_t   *node_)
+{
+  uint64_t pos;
+  uint64_t dist;
+  uint64_t next;
+  node_table_slot_t *slots = t_->slots;
+  const uint64_t mask = t_->mask;
+
+  pos  = (hash_ & mask);
+  dist = 0;
+  for(;;)
+    {
+      if(slots[pos].node == NULL)
+        return -1;
+      if(node_table_dist(mask,pos,slots[pos].hash) < dist)
+        return -1;
+      if(slots[pos].node == node_)
+        break;
+
+      pos = ((pos + 1) & mask);
+      dist++;
+    }
+
+  for(;;)
+    {
+      next = ((pos + 1) & mask);
+      if((slots[next].node == NULL) ||
+         (node_table_dist(mask,next,slots[next].hash) == 0))
+        break;
+
+      slots[pos] = slots[next];
+      pos = next;
+    }
+
+  slots[pos].node = NULL;
+  t_->use--;
+
+  return 0;
+}
+
+static
+inline
+int
+node_table_remove_old(node_table_t   *t_,
+                      const uint64_t  hash_,
+                      const node_t   *node_)
+{
+  uint64_t pos;
+  uint64_t dist;
+  node_table_slot_t *slots = t_->old_slots;
+  const uint64_t mask = t_->old_mask;
+
+  if(slots == NULL)
+    return -1;
+
+  pos  = (hash_ & mask);
+  dist = 0;
+  for(;;)
+    {
+      if(slots[pos].node == NULL)
+        return -1;
+      if(node_table_dist(mask,pos,slots[pos].hash) < dist)
+        return -1;
+      if(slots[pos].node == node_)
+        break;
+
+      pos = ((pos + 1) & mask);
+      dist++;
+    }
+
+  slots[pos].node = NODE_TABLE_TOMBSTONE;
+  t_->old_use--;
+
+  return 0;
+}
+
+/* Returns -1 if the node wasn't found */
+static
+inline
+int
+node_table_remove(node_table_t   *t_,
+                  const uint64_t  hash_,
+                  const node_t   *node_)
+{
+  int rv;
+
+  rv = node_table_remove_new(t_,hash_,node_);
+  if(rv == -1)
+    rv = node_table_remove_old(t_,hash_,node_);
+  if(rv == -1)
+    return -1;
+
+  node_table_migrate(t_,NODE_TABLE_MIGRATE_STEP);
+
+  if((t_->old_slots == NULL) &&
+     ((t_->mask + 1) > t_->min_size) &&
+     ((t_->use * 8) < (t_->mask + 1)))
+    node_table_resize(t_,(t_->mask + 1) / 2);
+
+  return 0;
+}
+
+/*
+  Lookups also advance a pending migration so a table which stops
+  changing doesn't keep paying for probing two arrays.
+*/
+static
+inline
+void
+node_table_probe_begin(node_table_t       *t_,
+                       const uint64_t      hash_,
+                       node_table_probe_t *p_)
+{
+  node_table_migrate(t_,NODE_TABLE_MIGRATE_STEP);
+
+  p_->hash = hash_;
+  p_->pos  = (hash_ & t_->mask);
+  p_->dist = 0;
+  p_->old  = 0;
+}
+
+static
+inline
+node_t*
+node_table_probe_slots(const node_table_slot_t *slots_,
+                       const uint64_t           mask_,
+                       node_table_probe_t      *p_)
+{
+  for(;;)
+    {
+      const node_table_slot_t *slot = &slots_[p_->pos];
+
+      if(slot->node == NULL)
+        return NULL;
+      if((slot->hash == p_->hash) && (slot->node != NODE_TABLE_TOMBSTONE))
+        {
+          p_->pos = ((p_->pos + 1) & mask_);
+          p_->dist++;
+          return slot->node;
+        }
+      if(node_table_dist(mask_,p_->pos,slot->hash) < p_->dist)
+        return NULL;
+
+      p_->pos = ((p_->pos + 1) & mask_);
+      p_->dist++;
+    }
+}
+
+/*
+  Returns the next node whose hash matches or NULL once there are no
+  more candidates. The table must not be modified while probing.
+*/
+static
+inline
+node_t*
+node_table_probe_next(const node_table_t *t_,
+                      node_table_probe_t *p_)
+{
+  node_t *node;
+
+  if(p_->old == 0)
+    {
+      node = node_table_probe_slots(t_->slots,t_->mask,p_);
+      if(node)
+        return node;
+      if(t_->old_slots == NULL)
+        {
+          p_->old = 2;
+          return NULL;
+        }
+
+      p_->old  = 1;
+      p_->pos  = (p_->hash & t_->old_mask);
+      p_->dist = 0;
+    }
+
+  if(p_->old == 1)
+    {
+      node = node_table_probe_slots(t_->old_slots,t_->old_mask,p_);
+      if(node)
+        return node;
+
+      p_->old = 2;
+    }
+
+  return NULL;
+}
+
+/*
+  Iterates over every node. *iter_ should start at 0. The table must
+  not be modified while iterating.
+*/
+static
+inline
+node_t*
+node_table_next(const node_table_t *t_,
+                uint64_t           *iter_)
+{
+  uint64_t size;
+  uint64_t old_size;
+  node_t *node;
+
+  size     = (t_->mask + 1);
+  old_size = (t_->old_slots ? (t_->old_mask + 1) : 0);
+  while(*iter_ < (size + old_size))
+    {
+      if(*iter_ < size)
+        node = t_->slots[*iter_].node;
+      else
+        node = t_->old_slots[*iter_ - size].node;
+      (*iter_)++;
+
+      if((node != NULL) && (node != NODE_TABLE_TOMBSTONE))
+        return node;
+    }
+
+  return NULL;
+}
@@ -0,0 +1,598 @@
+/*
+  ISC License
+
+  Copyright (c) 2024, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+/*
+  Compares the open addressing node table against the chained linear
+  hashing table it replaced. Both are driven the way fuse.c uses them:
+  an id table keyed by nodeid and a name table keyed by parent nodeid
+  and name with nodes spread over directories of 1000 entries.
+
+  usage: node-table-bench [count...]   (default: 1M 10M 50M)
+
+  Each node is ~100 bytes so 50M needs roughly 10GiB of memory.
+*/
+
+#include "node_table.h"
+#include "wyhash.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define DIR_SIZE 1000
+#define MIN_SIZE 8192
+
+/* The previous implementation, chained via pointers in the node */
+
+typedef struct old_node_t old_node_t;
+struct old_node_t
+{
+  old_node_t *name_next;
+  old_node_t *id_next;
+  node_t      node;
+};
+
+typedef struct old_table_t old_table_t;
+struct old_table_t
+{
+  old_node_t **array;
+  size_t       use;
+  size_t       size;
+  size_t       split;
+  int          is_name;
+};
+
+static
+uint64_t
+old_id_hash(const uint64_t ino_)
+{
+  return (ino_ * 0x9E3779B97F4A7C15ULL);
+}
+
+static
+uint64_t
+old_name_hash(const uint64_t  parent_,
+              const char     *name_)
+{
+  uint64_t hash = parent_;
+
+  for(; *name_; name_++)
+    hash = hash * 31 + (unsigned char)*name_;
+
+  return (hash * 0x9E3779B97F4A7C15ULL);
+}
+
+static
+old_node_t**
+old_next(old_table_t *t_,
+         old_node_t  *n_)
+{
+  return (t_->is_name ? &n_->name_next : &n_->id_next);
+}
+
+static
+uint64_t
+old_hash(old_table_t *t_,
+         old_node_t  *n_)
+{
+  if(t_->is_name)
+    return old_name_hash(n_->node.parent->nodeid,n_->node.name);
+  return old_id_hash(n_->node.nodeid);
+}
+
+static
+size_t
+old_bucket(const old_table_t *t_,
+           const uint64_t     hash_)
+{
+  uint64_t bucket = (hash_ % t_->size);
+  uint64_t oldbucket = (bucket % (t_->size / 2));
+
+  if(oldbucket >= t_->split)
+    return oldbucket;
+  return bucket;
+}
+
+static
+void
+old_init(old_table_t *t_,
+         int          is_name_)
+{
+  t_->size    = MIN_SIZE;
+  t_->array   = calloc(t_->size,sizeof(old_node_t*));
+  t_->use     = 0;
+  t_->split   = 0;
+  t_->is_name = is_name_;
+}
+
+static
+void
+old_resize(old_table_t *t_)
+{
+  size_t newsize = t_->size * 2;
+  void *newarray;
+
+  newarray = realloc(t_->array,sizeof(old_node_t*) * newsize);
+  if(newarray == NULL)
+    return;
+
+  t_->array = newarray;
+  memset(t_->array + t_->size,0,t_->size * sizeof(old_node_t*));
+  t_->size  = newsize;
+  t_->split = 0;
+}
+
+static
+void
+old_rehash(old_table_t *t_)
+{
+  old_node_t **nodep;
+  old_node_t **next;
+  size_t hash;
+
+  if(t_->split == t_->size / 2)
+    return;
+
+  hash = t_->split;
+  t_->split++;
+  for(nodep = &t_->array[hash]; *nodep != NULL; nodep = next)
+    {
+      old_node_t *node = *nodep;
+      size_t newhash = old_bucket(t_,old_hash(t_,node));
+
+      if(newhash != hash)
+        {
+          next = nodep;
+          *nodep = *old_next(t_,node);
+          *old_next(t_,node) = t_->array[newhash];
+          t_->array[newhash] = node;
+        }
+      else
+        {
+          next = old_next(t_,node);
+        }
+    }
+
+  if(t_->split == t_->size / 2)
+    old_resize(t_);
+}
+
+static
+void
+old_reduce(old_table_t *t_)
+{
+  size_t newsize = t_->size / 2;
+  void *newarray;
+
+  if(newsize < MIN_SIZE)
+    return;
+
+  newarray = realloc(t_->array,sizeof(old_node_t*) * newsize);
+  if(newarray != NULL)
+    t_->array = newarray;
+
+  t_->size  = newsize;
+  t_->split = t_->size / 2;
+}
+
+static
+void
+old_remerge(old_table_t *t_)
+{
+  int iter;
+
+  if(t_->split == 0)
+    old_reduce(t_);
+
+  for(iter = 8; t_->split > 0 && iter; iter--)
+    {
+      old_node_t **upper;
+
+      t_->split--;
+      upper = &t_->array[t_->split + t_->size / 2];
+      if(*upper)
+        {
+          old_node_t **nodep;
+
+          for(nodep = &t_->array[t_->split]; *nodep; nodep = old_next(t_,*nodep));
+
+          *nodep = *upper;
+          *upper = NULL;
+          break;
+        }
+    }
+}
+
+static
+void
+old_insert(old_table_t *t_,
+           old_node_t  *n_)
+{
+  size_t bucket;
+
+  bucket = old_bucket(t_,old_hash(t_,n_));
+  *old_next(t_,n_) = t_->array[bucket];
+  t_->array[bucket] = n_;
+  t_->use++;
+
+  if(t_->use >= t_->size / 2)
+    old_rehash(t_);
+}
+
+static
+void
+old_remove(old_table_t *t_,
+           old_node_t  *n_)
+{
+  old_node_t **nodep;
+
+  nodep = &t_->array[old_bucket(t_,old_hash(t_,n_))];
+  for(; *nodep != NULL; nodep = old_next(t_,*nodep))
+    if(*nodep == n_)
+      {
+        *nodep = *old_next(t_,n_);
+        t_->use--;
+
+        if(t_->use < t_->size / 4)
+          old_remerge(t_);
+        return;
+      }
+}
+
+static
+old_node_t*
+old_get_id(old_table_t    *t_,
+           const uint64_t  nodeid_)
+{
+  old_node_t *node;
+
+  node = t_->array[old_bucket(t_,old_id_hash(nodeid_))];
+  for(; node != NULL; node = node->id_next)
+    if(node->node.nodeid == nodeid_)
+      return node;
+
+  return NULL;
+}
+
+static
+old_node_t*
+old_get_name(old_table_t    *t_,
+             const uint64_t  parent_,
+             const char     *name_)
+{
+  old_node_t *node;
+
+  node = t_->array[old_bucket(t_,old_name_hash(parent_,name_))];
+  for(; node != NULL; node = node->name_next)
+    if((node->node.parent->nodeid == parent_) &&
+       (strcmp(node->node.name,name_) == 0))
+      return node;
+
+  return NULL;
+}
+
+/* The current implementation */
+
+static
+uint64_t
+new_name_hash(const uint64_t  parent_,
+              const char     *name_)
+{
+  return wyhash(name_,strlen(name_),parent_,_wyp);
+}
+
+static
+node_t*
+new_get_id(node_table_t   *t_,
+           const uint64_t  nodeid_)
+{
+  node_t *node;
+  node_table_probe_t p;
+
+  node_table_probe_begin(t_,old_id_hash(nodeid_),&p);
+  while((node = node_table_probe_next(t_,&p)) != NULL)
+    if(node->nodeid == nodeid_)
+      return node;
+
+  return NULL;
+}
+
+static
+node_t*
+new_get_name(node_table_t   *t_,
+             const uint64_t  parent_,
+             const char     *name_)
+{
+  node_t *node;
+  node_table_probe_t p;
+
+  node_table_probe_begin(t_,new_name_hash(parent_,name_),&p);
+  while((node = node_table_probe_next(t_,&p)) != NULL)
+    if((node->parent->nodeid == parent_) &&
+       (strcmp(node->name,name_) == 0))
+      return node;
+
+  return NULL;
+}
+
+/* Driver */
+
+static
+double
+now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+
+  return (ts.tv_sec + (ts.tv_nsec / 1000000000.0));
+}
+
+/* Visits 0..count_-1 in a scattered order */
+static
+uint64_t
+scatter(const uint64_t i_,
+        const uint64_t count_)
+{
+  return ((i_ * 2654435761ULL) % count_);
+}
+
+static
+void
+report(const char     *impl_,
+       const char     *phase_,
+       const uint64_t  count_,
+       const double    secs_)
+{
+  printf("%-4s %-12s %10"PRIu64" nodes: %8.1f ns/op\n",
+         impl_,
+         phase_,
+         count_,
+         (secs_ * 1000000000.0) / count_);
+}
+
+static
+void
+report_max(const char     *impl_,
+           const char     *phase_,
+           const uint64_t  count_,
+           const double    secs_)
+{
+  printf("%-4s %-12s %10"PRIu64" nodes: %8.1f us worst\n",
+         impl_,
+         phase_,
+         count_,
+         (secs_ * 1000000.0));
+}
+
+static
+void
+setup_parents(node_t         *parents_,
+              const uint64_t  count_)
+{
+  for(uint64_t i = 0; i < (count_ / DIR_SIZE) + 1; i++)
+    parents_[i].nodeid = (count_ + 2 + i);
+}
+
+static
+void
+setup_node(node_t         *node_,
+           node_t         *parents_,
+           char           *names_,
+           const uint64_t  i_)
+{
+  char *name = &names_[i_ * 16];
+
+  snprintf(name,16,"file%"PRIu64,(i_ % DIR_SIZE));
+  node_->nodeid = (i_ + 2);
+  node_->name   = name;
+  node_->parent = &parents_[i_ / DIR_SIZE];
+}
+
+static
+int
+bench_old(const uint64_t count_)
+{
+  double t;
+  double t1;
+  double worst;
+  char *names;
+  node_t *parents;
+  old_node_t *nodes;
+  old_table_t id;
+  old_table_t name;
+  uint64_t found;
+
+  names   = malloc(count_ * 16);
+  parents = calloc((count_ / DIR_SIZE) + 1,sizeof(node_t));
+  nodes   = calloc(count_,sizeof(old_node_t));
+  if(!names || !parents || !nodes)
+    return -1;
+
+  setup_parents(parents,count_);
+  for(uint64_t i = 0; i < count_; i++)
+    setup_node(&nodes[i].node,parents,names,i);
+
+  old_init(&id,0);
+  old_init(&name,1);
+
+  worst = 0;
+  t = now();
+  for(uint64_t i = 0; i < count_; i++)
+    {
+      t1 = now();
+      old_insert(&id,&nodes[i]);
+      old_insert(&name,&nodes[i]);
+      t1 = (now() - t1);
+      if(t1 > worst)
+        worst = t1;
+    }
+  report("old","insert",count_,now() - t);
+  report_max("old","insert",count_,worst);
+
+  found = 0;
+  t = now();
+  for(uint64_t i = 0; i < count_; i++)
+    found += !!old_get_id(&id,nodes[scatter(i,count_)].node.nodeid);
+  report("old","lookup id",count_,now() - t);
+
+  t = now();
+  for(uint64_t i = 0; i < count_; i++)
+    {
+      node_t *n = &nodes[scatter(i,count_)].node;
+      found += !!old_get_name(&name,n->parent->nodeid,n->name);
+    }
+  report("old","lookup name",count_,now() - t);
+
+  t = now();
+  for(uint64_t i = 0; i < count_; i++)
+    found += !!old_get_id(&id,count_ * 4 + i);
+  report("old","miss id",count_,now() - t);
+
+  t = now();
+  for(uint64_t i = 0; i < count_; i++)
+    {
+      old_remove(&id,&nodes[i]);
+      old_remove(&name,&nodes[i]);
+    }
+  report("old","remove",count_,now() - t);
+
+  if(found != (count_ * 2))
+    fprintf(stderr,"old: found %"PRIu64" of %"PRIu64"\n",found,count_ * 2);
+
+  free(id.array);
+  free(name.array);
+  free(nodes);
+  free(parents);
+  free(names);
+
+  return 0;
+}
+
+static
+int
+bench_new(const uint64_t count_)
+{
+  double t;
+  double t1;
+  double worst;
+  char *names;
+  node_t *parents;
+  node_t *nodes;
+  node_table_t id;
+  node_table_t name;
+  uint64_t found;
+
+  names   = malloc(count_ * 16);
+  parents = calloc((count_ / DIR_SIZE) + 1,sizeof(node_t));
+  nodes   = calloc(count_,sizeof(node_t));
+  if(!names || !parents || !nodes)
+    return -1;
+
+  setup_parents(parents,count_);
+  for(uint64_t i = 0; i < count_; i++)
+    setup_node(&nodes[i],parents,names,i);
+
+  node_table_init(&id,MIN_SIZE);
+  node_table_init(&name,MIN_SIZE);
+
+  worst = 0;
+  t = now();
+  for(uint64_t i = 0; i < count_; i++)
+    {
+      node_t *n = &nodes[i];
+
+      t1 = now();
+      node_table_insert(&id,old_id_hash(n->nodeid),n);
+      node_table_insert(&name,new_name_hash(n->parent->nodeid,n->name),n);
+      t1 = (now() - t1);
+      if(t1 > worst)
+        worst = t1;
+    }
+  report("new","insert",count_,now() - t);
+  report_max("new","insert",count_,worst);
+
+  found = 0;
+  t = now();
+  for(uint64_t i = 0; i < count_; i++)
+    found += !!new_get_id(&id,nodes[scatter(i,count_)].nodeid);
+  report("new","lookup id",count_,now() - t);
+
+  t = now();
+  for(uint64_t i = 0; i < count_; i++)
+    {
+      node_t *n = &nodes[scatter(i,count_)];
+      found += !!new_get_name(&name,n->parent->nodeid,n->name);
+    }
+  report("new","lookup name",count_,now() - t);
+
+  t = now();
+  for(uint64_t i = 0; i < count_; i++)
+    found += !!new_get_id(&id,count_ * 4 + i);
+  report("new","miss id",count_,now() - t);
+
+  t = now();
+  for(uint64_t i = 0; i < count_; i++)
+    {
+      node_t *n = &nodes[i];
+
+      node_table_remove(&id,old_id_hash(n->nodeid),n);
+      node_table_remove(&name,new_name_hash(n->parent->nodeid,n->name),n);
+    }
+  report("new","remove",count_,now() - t);
+
+  if(found != (count_ * 2))
+    fprintf(stderr,"new: found %"PRIu64" of %"PRIu64"\n",found,count_ * 2);
+
+  node_table_destroy(&id);
+  node_table_destroy(&name);
+  free(nodes);
+  free(parents);
+  free(names);
+
+  return 0;
+}
+
+int
+main(int    argc_,
+     char **argv_)
+{
+  uint64_t counts[] = {1000000,10000000,50000000};
+  int n = (sizeof(counts) / sizeof(counts[0]));
+
+  if(argc_ > 1)
+    {
+      n = 0;
+      for(int i = 1; (i < argc_) && (n < 3); i++)
+        counts[n++] = strtoull(argv_[i],NULL,10);
+    }
+
+  for(int i = 0; i < n; i++)
+    {
+      if(bench_old(counts[i]) || bench_new(counts[i]))
+        {
+          fprintf(stderr,"unable to allocate %"PRIu64" nodes\n",counts[i]);
+          return 1;
+        }
+      printf("\n");
+    }
+
+  return 0;
+}
@@ -0,0 +1,272 @@
+/*
+  ISC License
+
+  Copyright (c) 2024, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include "attr_cache.hpp"
+
+#include "fuse.h"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <string.h>
+
+using std::string;
+
+static const uint64_t DEFAULT_TIMEOUT   = 0;
+static const uint64_t DEFAULT_MAX       = 65536;
+static const size_t   MAX_INVALIDATIONS = 4096;
+
+AttrCache g_ATTR_CACHE;
+
+namespace l
+{
+  static
+  string
+  parent(const char *fusepath_)
+  {
+    const char *slash;
+
+    slash = strrchr(fusepath_,'/');
+    if((slash == NULL) || (slash == fusepath_))
+      return "/";
+
+    return string(fusepath_,slash);
+  }
+
+  /*
+    Kernel invalidations can't be sent from the request which caused
+    them. The kernel may be holding the parent directory's lock while
+    waiting on the reply and the notification needs the same lock. A
+    single thread sends them instead. If it falls too far behind
+    everything is invalidated rather than growing without bound.
+  */
+  namespace inval
+  {
+    static std::mutex              mutex;
+    static std::condition_variable cv;
+    static std::deque<string>      queue;
+    static bool                    overflow = false;
+
+    static
+    void
+    run(void)
+    {
+      string fusepath;
+      std::unique_lock<std::mutex> lk(mutex);
+
+      while(true)
+        {
+          cv.wait(lk,[]{ return (overflow || !queue.empty()); });
+
+          if(overflow)
+            {
+              queue.clear();
+              overflow = false;
+              lk.unlock();
+              fuse_invalidate_all_nodes();
+              lk.lock();
+              continue;
+            }
+
+          fusepath = std::move(queue.front());
+          queue.pop_front();
+
+          lk.unlock();
+          fuse_invalidate_path(fusepath.c_str());
+          lk.lock();
+        }
+    }
+
+    static
+    void
+    push(const char *fusepath_)
+    {
+      static std::once_flag once;
+
+      std::call_once(once,
+                     []()
+                     {
+                       std::thread thread(l::inval::run);
+
+                       pthread_setname_np(thread.native_handle(),"fuse.inval");
+                       thread.detach();
+                     });
+
+      {
+        std::lock_guard<std::mutex> lk(mutex);
+
+        if(queue.size() >= MAX_INVALIDATIONS)
+          overflow = true;
+        else
+          queue.emplace_back(fusepath_);
+      }
+
+      cv.notify_one();
+    }
+  }
+}
+
+
+AttrCache::AttrCache(void)
+  : timeout(DEFAULT_TIMEOUT),
+    max(DEFAULT_MAX)
+{
+
+}
+
+bool
+AttrCache::enabled(void) const
+{
+  return (timeout != 0);
+}
+
+void
+AttrCache::erase(const char *fusepath_)
+{
+  if(timeout == 0)
+    return;
+
+  _lru.erase(fusepath_);
+}
+
+/*
+  For creation and removal which change the parent's mtime and link
+  count as well.
+*/
+void
+AttrCache::erase_entry(const char *fusepath_)
+{
+  if(timeout == 0)
+    return;
+
+  _lru.erase(fusepath_);
+  _lru.erase(l::parent(fusepath_));
+}
+
+/*
+  Erases the path, its parent and everything under it. Used when a
+  directory may have moved so walks every entry.
+*/
+void
+AttrCache::erase_tree(const char *fusepath_)
+{
+  if(timeout == 0)
+    return;
+
+  erase_entry(fusepath_);
+  _lru.erase_children(fusepath_);
+}
+
+void
+AttrCache::notify(const char *fusepath_)
+{
+  if(timeout == 0)
+    return;
+
+  l::inval::push(fusepath_);
+}
+
+void
+AttrCache::clear(void)
+{
+  _lru.clear();
+}
+
+uint64_t
+AttrCache::hits(void) const
+{
+  return _lru.hits();
+}
+
+uint64_t
+AttrCache::misses(void) const
+{
+  return _lru.misses();
+}
+
+uint64_t
+AttrCache::evictions(void) const
+{
+  return _lru.evictions();
+}
+
+/*
+  On a hit fills in `st` and `error` and returns true. On a miss
+  returns false with `gen` set to what must be passed to `insert` so
+  a result raced by an erase isn't stored.
+*/
+bool
+AttrCache::lookup(const char     *fusepath_,
+                  const uint64_t  branches_id_,
+                  const uid_t     uid_,
+                  const gid_t     gid_,
+                  struct stat    *st_,
+                  int            *error_,
+                  uint64_t       *gen_)
+{
+  auto hit = [&](const Value &v_)
+  {
+    if(v_.branches_id != branches_id_)
+      return false;
+    if((v_.uid != uid_) || (v_.gid != gid_))
+      return false;
+
+    *error_ = v_.error;
+    if(*error_ == 0)
+      *st_ = v_.st;
+
+    return true;
+  };
+
+  return _lru.lookup(fusepath_,
+                     ShardedLRU<Value,ATTR_CACHE_SHARDS>::now(),
+                     timeout,
+                     gen_,
+                     hit);
+}
+
+void
+AttrCache::insert(const char        *fusepath_,
+                  const uint64_t     gen_,
+                  const uint64_t     branches_id_,
+                  const uid_t        uid_,
+                  const gid_t        gid_,
+                  const int          error_,
+                  const struct stat *st_)
+{
+  Value value;
+
+  if((error_ == 0) && !S_ISDIR(st_->st_mode) && (st_->st_nlink > 1))
+    return;
+
+  value.branches_id = branches_id_;
+  value.uid         = uid_;
+  value.gid         = gid_;
+  value.error       = error_;
+  if(error_ == 0)
+    value.st = *st_;
+
+  _lru.insert(fusepath_,
+              gen_,
+              ShardedLRU<Value,ATTR_CACHE_SHARDS>::now(),
+              value,
+              max);
+}
@@ -0,0 +1,107 @@
+/*
+  ISC License
+
+  Copyright (c) 2024, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#pragma once
+
+#include "sharded_lru.hpp"
+
+#include <atomic>
+#include <cstdint>
+
+#include <sys/stat.h>
+
+#define ATTR_CACHE_SHARDS 16
+
+
+/*
+  Caches the result of path based getattr, which libfuse also uses
+  for lookup, keyed by fuse path. Entries hold the final stat after
+  symlinkify and inode calculation and are tied to the Branches
+  instance which produced them. ENOENT is cached as well. Files with
+  more than one link aren't cached since changing one name changes
+  the attributes of the others. Whether a path can be stat'ed depends
+  on who is asking so an entry is only a hit for the uid and gid it
+  was fetched as.
+
+  Entries expire after `timeout` milliseconds and are evicted least
+  recently used first once a shard is past its share of `max`.
+  Callers changing a path's attributes must `erase` it. Callers
+  changing the namespace must use `erase_entry` or `erase_tree` which
+  also drop the parent. The kernel updates its own caches from the
+  replies to requests it sends but not from changes mergerfs makes on
+  its own, such as moving a file on ENOSPC or a rename which failed
+  part way, so `notify` queues an invalidation of the path for the
+  kernel in those cases. Writes through passthrough or mmap never
+  reach mergerfs so writable handles erase their path on open and on
+  release.
+*/
+class AttrCache
+{
+public:
+  struct Value
+  {
+    uint64_t    branches_id;
+    uid_t       uid;
+    gid_t       gid;
+    int         error;
+    struct stat st;
+  };
+
+public:
+  AttrCache(void);
+
+public:
+  bool enabled(void) const;
+
+public:
+  void erase(const char *fusepath);
+  void erase_entry(const char *fusepath);
+  void erase_tree(const char *fusepath);
+  void clear(void);
+  void notify(const char *fusepath);
+
+public:
+  bool lookup(const char     *fusepath,
+              const uint64_t  branches_id,
+              const uid_t     uid,
+              const gid_t     gid,
+              struct stat    *st,
+              int            *error,
+              uint64_t       *gen);
+  void insert(const char        *fusepath,
+              const uint64_t     gen,
+              const uint64_t     branches_id,
+              const uid_t        uid,
+              const gid_t        gid,
+              const int          error,
+              const struct stat *st);
+
+public:
+  uint64_t hits(void) const;
+  uint64_t misses(void) const;
+  uint64_t evictions(void) const;
+
+public:
+  std::atomic<uint64_t> timeout;
+  std::atomic<uint64_t> max;
+
+private:
+  ShardedLRU<Value,ATTR_CACHE_SHARDS> _lru;
+};
+
+extern AttrCache g_ATTR_CACHE;
@@ -23,7 +23,10 @@
 
 
 Branch::Branch(const uint64_t &default_minfreespace_)
-  : _default_minfreespace(&default_minfreespace_)
+  : space(std::make_shared<BranchSpace>()),
+    stats(std::make_shared<BranchStats>()),
+    dirfd(std::make_shared<BranchFD>()),
+    _default_minfreespace(&default_minfreespace_)
 {
 }
 
@@ -95,3 +98,9 @@ Branch::ro_or_nc(void) const
   return ((mode == Branch::Mode::RO) ||
           (mode == Branch::Mode::NC));
 }
+
+int
+Branch::fd(void) const
+{
+  return dirfd->get(path);
+}
@@ -18,7 +18,11 @@
 
 #pragma once
 
+#include "branch_fd.hpp"
+#include "branch_space.hpp"
+#include "branch_stats.hpp"
 #include "nonstd/optional.hpp"
+#include "small_vec.hpp"
 #include "strvec.hpp"
 #include "tofrom_string.hpp"
 
@@ -31,6 +35,7 @@ class Branch final : public ToFromString
 {
 public:
   typedef std::vector<Branch> Vector;
+  typedef SmallVec<const Branch*,8> CPtrVec;
 
 public:
   Branch(const uint64_t &default_minfreespace_);
@@ -48,6 +53,7 @@ public:
   bool ro(void) const;
   bool nc(void) const;
   bool ro_or_nc(void) const;
+  int  fd(void) const;
 
 public:
   int from_string(const std::string &str) final;
@@ -60,6 +66,9 @@ public:
 public:
   Mode mode;
   std::string path;
+  BranchSpace::Ptr space;
+  BranchStats::Ptr stats;
+  BranchFD::Ptr    dirfd;
 
 private:
   nonstd::optional<uint64_t>  _minfreespace;
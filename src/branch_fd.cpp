@@ -0,0 +1,167 @@
+/*
+  ISC License
+
+  Copyright (c) 2024, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include "branch_fd.hpp"
+
+#include "epoch.hpp"
+#include "fs_close.hpp"
+#include "fs_fstat.hpp"
+#include "fs_open.hpp"
+#include "fs_stat.hpp"
+
+#include <fcntl.h>
+
+#ifndef O_PATH
+# define O_PATH 0
+#endif
+
+
+namespace l
+{
+  /*
+    Other threads may still be using a replaced descriptor so it is
+    closed once they have all left the epoch::Guard they got it in.
+  */
+  struct RetiredFD
+  {
+    RetiredFD(const int fd_)
+      : fd(fd_)
+    {
+    }
+
+    ~RetiredFD()
+    {
+      fs::close(fd);
+    }
+
+    const int fd;
+  };
+}
+
+BranchFD::BranchFD()
+  : _fd(-1),
+    _used(false),
+    _failed(false)
+{
+}
+
+BranchFD::~BranchFD()
+{
+  int fd;
+
+  fd = _fd.load(std::memory_order_relaxed);
+  if(fd >= 0)
+    fs::close(fd);
+}
+
+int
+BranchFD::open(const std::string &path_)
+{
+  int fd;
+  int expected;
+
+  std::lock_guard<std::mutex> lg(_mutex);
+
+  expected = _fd.load(std::memory_order_relaxed);
+  if(expected >= 0)
+    return expected;
+  if(_failed.load(std::memory_order_relaxed))
+    return -1;
+
+  fd = fs::open(path_,O_PATH|O_DIRECTORY|O_CLOEXEC);
+  if(fd == -1)
+    {
+      _failed.store(true,std::memory_order_relaxed);
+      return -1;
+    }
+
+  _used.store(true,std::memory_order_relaxed);
+  _fd.store(fd,std::memory_order_release);
+
+  return fd;
+}
+
+int
+BranchFD::get(const std::string &path_)
+{
+  int fd;
+
+  fd = _fd.load(std::memory_order_acquire);
+  if(fd >= 0)
+    {
+      if(!_used.load(std::memory_order_relaxed))
+        _used.store(true,std::memory_order_relaxed);
+      return fd;
+    }
+
+  if(_failed.load(std::memory_order_relaxed))
+    return -1;
+
+  return open(path_);
+}
+
+void
+BranchFD::drop(void)
+{
+  int fd;
+
+  {
+    std::lock_guard<std::mutex> lg(_mutex);
+
+    fd = _fd.exchange(-1,std::memory_order_acq_rel);
+  }
+
+  if(fd >= 0)
+    epoch::retire(std::make_shared<l::RetiredFD>(fd));
+}
+
+/*
+  Called by the branch refresher each pass. A failed open may be
+  retried again. The descriptor is dropped, to be reopened on next
+  use, if it wasn't used since the last pass so an idle branch can
+  be unmounted, if the branch path is gone, or if something was
+  mounted over (or unmounted from) the path so it no longer refers
+  to what the descriptor does.
+*/
+void
+BranchFD::revalidate(const std::string &path_)
+{
+  int rv;
+  int fd;
+  struct stat fd_st;
+  struct stat path_st;
+
+  _failed.store(false,std::memory_order_relaxed);
+
+  fd = _fd.load(std::memory_order_acquire);
+  if(fd < 0)
+    return;
+
+  if(_used.exchange(false,std::memory_order_relaxed))
+    {
+      rv = fs::stat(path_,&path_st);
+      if(rv == 0)
+        rv = fs::fstat(fd,&fd_st);
+      if((rv == 0) &&
+         (fd_st.st_dev == path_st.st_dev) &&
+         (fd_st.st_ino == path_st.st_ino))
+        return;
+    }
+
+  drop();
+}
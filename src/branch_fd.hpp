@@ -0,0 +1,61 @@
+/*
+  ISC License
+
+  Copyright (c) 2024, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+
+
+/*
+  O_PATH descriptor of a branch's root so calls can be made relative
+  to it rather than having the kernel walk the branch's path each
+  time. Opened on first use rather than when the branch is configured
+  so branches mounted late, such as with branches-mount-timeout, are
+  picked up. Shared by every copy of a Branch like BranchSpace.
+
+  get() returns -1 if the branch can't be opened and callers fall
+  back to full paths. A failed open isn't retried until the next
+  revalidate(). Callers must be in an epoch::Guard, as requests are
+  through Config::Read, for as long as they use the descriptor.
+*/
+class BranchFD
+{
+public:
+  typedef std::shared_ptr<BranchFD> Ptr;
+
+public:
+  BranchFD();
+  ~BranchFD();
+
+public:
+  int  get(const std::string &path);
+  void revalidate(const std::string &path);
+
+private:
+  int  open(const std::string &path);
+  void drop(void);
+
+private:
+  std::atomic<int>  _fd;
+  std::atomic<bool> _used;
+  std::atomic<bool> _failed;
+  std::mutex        _mutex;
+};
@@ -0,0 +1,189 @@
+/*
+  ISC License
+
+  Copyright (c) 2024, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include "branch_space.hpp"
+
+#include "config.hpp"
+#include "epoch.hpp"
+#include "errno.hpp"
+#include "fs_statvfs.hpp"
+#include "statvfs_util.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+#include <pthread.h>
+
+
+BranchSpace::BranchSpace()
+  : _valid(false),
+    _refreshing(false),
+    _error(0),
+    _readonly(false),
+    _spaceavail(0),
+    _spaceused(0)
+{
+}
+
+int
+BranchSpace::refresh(const std::string &path_)
+{
+  int rv;
+  struct statvfs st;
+
+  rv = fs::statvfs(path_,&st);
+  if(rv == -1)
+    {
+      _error.store(errno,std::memory_order_relaxed);
+      _valid.store(true,std::memory_order_release);
+      return -1;
+    }
+
+  _readonly.store(StatVFS::readonly(st),std::memory_order_relaxed);
+  _spaceavail.store(StatVFS::spaceavail(st),std::memory_order_relaxed);
+  _spaceused.store(StatVFS::spaceused(st),std::memory_order_relaxed);
+  _error.store(0,std::memory_order_relaxed);
+  _valid.store(true,std::memory_order_release);
+
+  return 0;
+}
+
+/*
+  Branches which haven't been seen by the refresher yet, such as
+  those just added at runtime, are queried directly.
+*/
+int
+BranchSpace::get(const std::string &path_,
+                 fs::info_t        *info_)
+{
+  int error;
+
+  if(!_valid.load(std::memory_order_acquire))
+    {
+      if(refresh(path_) == -1)
+        return -1;
+    }
+
+  error = _error.load(std::memory_order_relaxed);
+  if(error)
+    return (errno=error,-1);
+
+  info_->readonly   = _readonly.load(std::memory_order_relaxed);
+  info_->spaceavail = _spaceavail.load(std::memory_order_relaxed);
+  info_->spaceused  = _spaceused.load(std::memory_order_relaxed);
+
+  return 0;
+}
+
+/*
+  Account for data written through mergerfs between refreshes so a
+  burst of creates spreads out rather than all landing on whichever
+  branch looked emptiest at the last refresh. Overwrites are counted
+  too which is fine as the next refresh replaces the estimate.
+*/
+void
+BranchSpace::consume(const uint64_t bytes_)
+{
+  uint64_t avail;
+
+  avail = _spaceavail.load(std::memory_order_relaxed);
+  while(!_spaceavail.compare_exchange_weak(avail,
+                                           avail - std::min(avail,bytes_),
+                                           std::memory_order_relaxed))
+    ;
+
+  _spaceused.fetch_add(bytes_,std::memory_order_relaxed);
+}
+
+bool
+BranchSpace::claim_refresh(void)
+{
+  return !_refreshing.exchange(true,std::memory_order_acquire);
+}
+
+void
+BranchSpace::release_refresh(void)
+{
+  _refreshing.store(false,std::memory_order_release);
+}
+
+namespace l
+{
+  static
+  void
+  refresh(const std::string      &path_,
+          const BranchSpace::Ptr &space_,
+          const BranchStats::Ptr &stats_,
+          const BranchFD::Ptr    &dirfd_)
+  {
+    int rv;
+    uint64_t start;
+
+    start = BranchStats::now();
+    rv = space_->refresh(path_);
+    stats_->record(start,(rv == -1));
+    dirfd_->revalidate(path_);
+
+    space_->release_refresh();
+  }
+
+  static
+  void
+  refresher()
+  {
+    uint64_t interval;
+
+    while(true)
+      {
+        {
+          Config::Read cfg;
+          Branches::CPtr branches = cfg->branches;
+
+          interval = cfg->cache_statfs;
+          for(auto const &branch : *branches)
+            {
+              if(!branch.space->claim_refresh())
+                continue;
+
+              std::thread(l::refresh,
+                          branch.path,
+                          branch.space,
+                          branch.stats,
+                          branch.dirfd).detach();
+            }
+        }
+
+        // Release branch lists replaced since the last pass which
+        // no request is still using.
+        epoch::reclaim();
+
+        std::this_thread::sleep_for(std::chrono::seconds(std::max(interval,
+                                                                  (uint64_t)1)));
+      }
+  }
+}
+
+void
+BranchSpace::spawn_refresher()
+{
+  std::thread thread(l::refresher);
+
+  pthread_setname_np(thread.native_handle(),"fs.branchspace");
+  thread.detach();
+}
@@ -0,0 +1,67 @@
+/*
+  ISC License
+
+  Copyright (c) 2024, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#pragma once
+
+#include "fs_info_t.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+
+/*
+  Space and readonly state of a branch. Kept up to date by a
+  background thread so create policies can read it without issuing
+  statvfs calls or taking locks. Shared by every copy of a Branch so
+  it survives changes to unrelated branches.
+
+  Each branch is refreshed on its own thread, outside of any
+  epoch::Guard, so a slow or hung branch holds up neither the others
+  nor the release of retired branch lists and descriptors. A branch
+  whose last refresh hasn't returned is skipped until it does.
+*/
+class BranchSpace
+{
+public:
+  typedef std::shared_ptr<BranchSpace> Ptr;
+
+public:
+  BranchSpace();
+
+public:
+  int  get(const std::string &path, fs::info_t *info);
+  int  refresh(const std::string &path);
+  void consume(const uint64_t bytes);
+
+public:
+  bool claim_refresh(void);
+  void release_refresh(void);
+
+public:
+  static void spawn_refresher();
+
+private:
+  std::atomic<bool>     _valid;
+  std::atomic<bool>     _refreshing;
+  std::atomic<int>      _error;
+  std::atomic<bool>     _readonly;
+  std::atomic<uint64_t> _spaceavail;
+  std::atomic<uint64_t> _spaceused;
+};
@@ -0,0 +1,228 @@
+/*
+  ISC License
+
+  Copyright (c) 2024, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include "branch_stats.hpp"
+
+#include <errno.h>
+#include <time.h>
+
+// Weight of a new sample is 1/(1 << EWMA_SHIFT)
+#define EWMA_SHIFT 3
+// Error rate is kept in parts per million
+#define ERROR_RATE_MAX 1000000ULL
+// An error rate of 100% multiplies the score by 1 + this
+#define ERROR_PENALTY 10ULL
+// Write rate is sampled over windows of this many nanoseconds
+#define WRITE_WINDOW 1000000000ULL
+// Write rate in bytes per second which counts as one more writer
+#define WRITE_RATE_PER_WRITER (64ULL * 1024ULL * 1024ULL)
+
+
+BranchStats::BranchStats()
+  : _latency(0),
+    _error_rate(0),
+    _writers(0),
+    _write_rate(0),
+    _window_start(BranchStats::now()),
+    _window_bytes(0),
+    _probes(0)
+{
+}
+
+uint64_t
+BranchStats::now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+
+  return ((ts.tv_sec * 1000000000ULL) + ts.tv_nsec);
+}
+
+/*
+  Errors which say something about the branch rather than the
+  request. A missing file or lack of permission isn't the branch's
+  fault.
+*/
+bool
+BranchStats::fault(const int err_)
+{
+  switch(err_)
+    {
+    case EIO:
+    case ENXIO:
+    case ENODEV:
+    case ENOTCONN:
+    case ESTALE:
+    case ETIMEDOUT:
+    case EROFS:
+    case ENOSPC:
+      return true;
+    default:
+      return false;
+    }
+}
+
+void
+BranchStats::record(const uint64_t start_,
+                    const bool     error_)
+{
+  uint64_t lat;
+  uint64_t err;
+  uint64_t sample;
+
+  sample = (BranchStats::now() - start_);
+
+  lat = _latency.load(std::memory_order_relaxed);
+  if(lat == 0)
+    lat = sample;
+  else
+    lat = (lat - (lat >> EWMA_SHIFT) + (sample >> EWMA_SHIFT));
+  _latency.store(lat,std::memory_order_relaxed);
+
+  err = _error_rate.load(std::memory_order_relaxed);
+  err = (err - (err >> EWMA_SHIFT));
+  if(error_)
+    err += (ERROR_RATE_MAX >> EWMA_SHIFT);
+  _error_rate.store(err,std::memory_order_relaxed);
+}
+
+// nanoseconds
+uint64_t
+BranchStats::latency(void) const
+{
+  return _latency.load(std::memory_order_relaxed);
+}
+
+// parts per million
+uint64_t
+BranchStats::error_rate(void) const
+{
+  return _error_rate.load(std::memory_order_relaxed);
+}
+
+/*
+  Lower is better. Branches which haven't been sampled yet score 0 so
+  they get tried.
+*/
+uint64_t
+BranchStats::score(void) const
+{
+  uint64_t lat;
+  uint64_t err;
+
+  lat = latency();
+  err = error_rate();
+
+  return (lat + ((lat * err * ERROR_PENALTY) / ERROR_RATE_MAX));
+}
+
+void
+BranchStats::writer_opened(void)
+{
+  _writers.fetch_add(1,std::memory_order_relaxed);
+}
+
+void
+BranchStats::writer_closed(void)
+{
+  _writers.fetch_sub(1,std::memory_order_relaxed);
+}
+
+/*
+  Bytes are accumulated into a window. Whoever writes after the
+  window has expired folds it into the write rate and starts a new
+  one.
+*/
+void
+BranchStats::written(const uint64_t bytes_)
+{
+  uint64_t t;
+  uint64_t rate;
+  uint64_t bytes;
+  uint64_t start;
+  uint64_t elapsed;
+
+  _window_bytes.fetch_add(bytes_,std::memory_order_relaxed);
+
+  t       = BranchStats::now();
+  start   = _window_start.load(std::memory_order_relaxed);
+  elapsed = (t - start);
+  if(elapsed < WRITE_WINDOW)
+    return;
+  if(!_window_start.compare_exchange_strong(start,t,std::memory_order_relaxed))
+    return;
+
+  bytes = _window_bytes.exchange(0,std::memory_order_relaxed);
+  bytes = ((bytes * 1000000ULL) / (elapsed / 1000ULL));
+  rate  = _write_rate.load(std::memory_order_relaxed);
+  if(elapsed >= (WRITE_WINDOW * 2))
+    rate = bytes;
+  else
+    rate = (rate - (rate >> EWMA_SHIFT) + (bytes >> EWMA_SHIFT));
+  _write_rate.store(rate,std::memory_order_relaxed);
+}
+
+uint64_t
+BranchStats::writers(void) const
+{
+  return _writers.load(std::memory_order_relaxed);
+}
+
+/*
+  bytes per second. If nothing has been written for a while the
+  window hasn't been folded in yet so the last rate is stale.
+*/
+uint64_t
+BranchStats::write_rate(void) const
+{
+  uint64_t elapsed;
+
+  elapsed = (BranchStats::now() - _window_start.load(std::memory_order_relaxed));
+  if(elapsed >= (WRITE_WINDOW * 2))
+    return 0;
+
+  return _write_rate.load(std::memory_order_relaxed);
+}
+
+/*
+  Number of writers plus the write rate expressed as writers. Lower
+  is less loaded.
+*/
+uint64_t
+BranchStats::load(void) const
+{
+  return (writers() + (write_rate() / WRITE_RATE_PER_WRITER));
+}
+
+bool
+BranchStats::probe_begin(const uint64_t max_)
+{
+  if(_probes.fetch_add(1,std::memory_order_relaxed) < max_)
+    return true;
+
+  _probes.fetch_sub(1,std::memory_order_relaxed);
+
+  return false;
+}
+
+void
+BranchStats::probe_end(void)
+{
+  _probes.fetch_sub(1,std::memory_order_relaxed);
+}
@@ -0,0 +1,76 @@
+/*
+  ISC License
+
+  Copyright (c) 2024, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+
+/*
+  Observed performance of a branch. Latency and error rate are
+  exponentially weighted moving averages of calls mergerfs already
+  makes: the background statvfs refresh, concurrent search probes,
+  the latency policies' own checks and the getattr, open, create,
+  read and write calls made on the branch, spliced reads included.
+  Load is the number of files open for writing on the branch and the
+  rate they are being written to. Updates are racy by design, a lost sample now and then doesn't
+  matter. Probes counts the concurrent search probes queued or running
+  against the branch. Shared between copies of a Branch like
+  BranchSpace.
+*/
+class BranchStats
+{
+public:
+  typedef std::shared_ptr<BranchStats> Ptr;
+
+public:
+  BranchStats();
+
+public:
+  static uint64_t now(void);
+  static bool     fault(const int err);
+
+public:
+  void     record(const uint64_t start, const bool error);
+  uint64_t latency(void) const;
+  uint64_t error_rate(void) const;
+  uint64_t score(void) const;
+
+public:
+  void     writer_opened(void);
+  void     writer_closed(void);
+  void     written(const uint64_t bytes);
+  uint64_t writers(void) const;
+  uint64_t write_rate(void) const;
+  uint64_t load(void) const;
+
+public:
+  bool probe_begin(const uint64_t max);
+  void probe_end(void);
+
+private:
+  std::atomic<uint64_t> _latency;
+  std::atomic<uint64_t> _error_rate;
+  std::atomic<uint64_t> _writers;
+  std::atomic<uint64_t> _write_rate;
+  std::atomic<uint64_t> _window_start;
+  std::atomic<uint64_t> _window_bytes;
+  std::atomic<uint64_t> _probes;
+};
@@ -18,7 +18,9 @@
 
 #include "branches.hpp"
 #include "ef.hpp"
+#include "epoch.hpp"
 #include "errno.hpp"
+#include "fmt/core.h"
 #include "from_string.hpp"
 #include "fs_glob.hpp"
 #include "fs_is_rofs.hpp"
@@ -28,6 +30,7 @@
 #include "str.hpp"
 #include "syslog.hpp"
 
+#include <atomic>
 #include <string>
 
 #include <fnmatch.h>
@@ -37,8 +40,12 @@ using std::vector;
 using nonstd::optional;
 
 
+// Unique per instance so caches can tell when the branches changed
+static std::atomic<uint64_t> g_IMPL_ID(0);
+
 Branches::Impl::Impl(const uint64_t &default_minfreespace_)
-  : _default_minfreespace(default_minfreespace_)
+  : _default_minfreespace(default_minfreespace_),
+    _id(++g_IMPL_ID)
 {
 }
 
@@ -64,6 +71,12 @@ Branches::Impl::operator=(Branches::Impl &&rval_)
   return *this;
 }
 
+uint64_t
+Branches::Impl::id(void) const
+{
+  return _id;
+}
+
 const
 uint64_t&
 Branches::Impl::minfreespace(void) const
@@ -196,7 +209,10 @@ namespace l
     fs::realpathize(&paths);
     for(auto &path : paths)
       {
-        branch.path = path;
+        branch.path  = path;
+        branch.space = std::make_shared<BranchSpace>();
+        branch.stats = std::make_shared<BranchStats>();
+        branch.dirfd = std::make_shared<BranchFD>();
         branches_->push_back(branch);
       }
 
@@ -382,33 +398,54 @@ Branches::Impl::to_paths() const
   return vp;
 }
 
+const
+Branch*
+Branches::Impl::find(const std::string &path_) const
+{
+  for(const auto &branch : *this)
+    {
+      if(branch.path == path_)
+        return &branch;
+    }
+
+  return NULL;
+}
+
 int
 Branches::from_string(const std::string &str_)
 {
   int rv;
-  Branches::Ptr impl;
   Branches::Ptr new_impl;
+  std::lock_guard<std::mutex> lock_guard(_mutex);
 
-  {
-    std::lock_guard<std::mutex> lock_guard(_mutex);
-    impl = _impl;
-  }
-
-  new_impl = std::make_shared<Branches::Impl>(impl->minfreespace());
-  *new_impl = *impl;
+  new_impl = std::make_shared<Branches::Impl>(_impl->minfreespace());
+  *new_impl = *_impl;
 
   rv = new_impl->from_string(str_);
   if(rv < 0)
     return rv;
 
-  {
-    std::lock_guard<std::mutex> lock_guard(_mutex);
-    _impl = new_impl;
-  }
+  publish(new_impl);
 
   return 0;
 }
 
+/*
+  Must be called with _mutex held. Readers which loaded the old list
+  keep using it until they leave their epoch guard.
+*/
+void
+Branches::publish(const Branches::Ptr &impl_)
+{
+  Branches::Ptr old_impl;
+
+  old_impl = _impl;
+  _impl    = impl_;
+  _cur.store(_impl.get(),std::memory_order_release);
+
+  epoch::retire(old_impl);
+}
+
 string
 Branches::to_string(void) const
 {
@@ -420,7 +457,15 @@ Branches::to_string(void) const
 void
 Branches::find_and_set_mode_ro()
 {
-  for(auto &branch : *_impl)
+  bool changed;
+  Branches::Ptr new_impl;
+  std::lock_guard<std::mutex> lock_guard(_mutex);
+
+  new_impl = std::make_shared<Branches::Impl>(_impl->minfreespace());
+  *new_impl = *_impl;
+
+  changed = false;
+  for(auto &branch : *new_impl)
     {
       if(branch.mode != Branch::Mode::RW)
         continue;
@@ -432,7 +477,11 @@ Branches::find_and_set_mode_ro()
                      branch.path.c_str());
 
       branch.mode = Branch::Mode::RO;
+      changed     = true;
     }
+
+  if(changed)
+    publish(new_impl);
 }
 
 SrcMounts::SrcMounts(Branches &b_)
@@ -467,3 +516,77 @@ SrcMounts::to_string(void) const
 
   return rv;
 }
+
+BranchesLatency::BranchesLatency(Branches &b_)
+  : _branches(b_)
+{
+
+}
+
+int
+BranchesLatency::from_string(const std::string &s_)
+{
+  return -EROFS;
+}
+
+/*
+  PATH=LATENCYus/ERRORRATE%:...
+*/
+std::string
+BranchesLatency::to_string(void) const
+{
+  std::string rv;
+  Branches::CPtr branches = _branches;
+
+  if(branches->empty())
+    return rv;
+
+  for(const auto &branch : *branches)
+    {
+      rv += fmt::format("{}={}us/{:.2f}%:",
+                        branch.path,
+                        (branch.stats->latency() / 1000),
+                        (branch.stats->error_rate() / 10000.0));
+    }
+
+  rv.pop_back();
+
+  return rv;
+}
+
+BranchesLoad::BranchesLoad(Branches &b_)
+  : _branches(b_)
+{
+
+}
+
+int
+BranchesLoad::from_string(const std::string &s_)
+{
+  return -EROFS;
+}
+
+/*
+  PATH=WRITERS/BYTESPERSEC:...
+*/
+std::string
+BranchesLoad::to_string(void) const
+{
+  std::string rv;
+  Branches::CPtr branches = _branches;
+
+  if(branches->empty())
+    return rv;
+
+  for(const auto &branch : *branches)
+    {
+      rv += fmt::format("{}={}/{}:",
+                        branch.path,
+                        branch.stats->writers(),
+                        branch.stats->write_rate());
+    }
+
+  rv.pop_back();
+
+  return rv;
+}
@@ -23,6 +23,7 @@
 #include "strvec.hpp"
 #include "tofrom_string.hpp"
 
+#include <atomic>
 #include <cstdint>
 #include <memory>
 #include <mutex>
@@ -33,7 +34,9 @@
 class Branches final : public ToFromString
 {
 public:
-  class Impl final : public ToFromString, public Branch::Vector
+  class Impl final : public ToFromString,
+                     public Branch::Vector,
+                     public std::enable_shared_from_this<Impl>
   {
   public:
     typedef std::shared_ptr<Impl> Ptr;
@@ -50,6 +53,8 @@ public:
     const uint64_t& minfreespace(void) const;
     void to_paths(StrVec &strvec) const;
     fs::PathVector to_paths() const;
+    const Branch* find(const std::string &path) const;
+    uint64_t id(void) const;
 
   public:
     Impl& operator=(Impl &impl_);
@@ -57,15 +62,25 @@ public:
 
   private:
     const uint64_t &_default_minfreespace;
+    const uint64_t  _id;
   };
 
+  /*
+    The branch list is never modified once published. Changes build a
+    new Impl and swap it in. Readers get the current one with a single
+    load and it stays valid while they hold a Config::Read (or any
+    epoch::Guard). Anything which needs it longer, such as work left
+    running after a request returns, should take a reference with
+    shared_from_this().
+  */
 public:
   typedef Branches::Impl::Ptr  Ptr;
-  typedef Branches::Impl::CPtr CPtr;
+  typedef const Branches::Impl *CPtr;
 
 public:
   Branches(const uint64_t &default_minfreespace_)
-    : _impl(std::make_shared<Impl>(default_minfreespace_))
+    : _impl(std::make_shared<Impl>(default_minfreespace_)),
+      _cur(_impl.get())
   {}
 
 public:
@@ -73,15 +88,45 @@ public:
   std::string to_string(void) const final;
 
 public:
-  operator CPtr()   const { std::lock_guard<std::mutex> lg(_mutex); return _impl; }
-  CPtr operator->() const { std::lock_guard<std::mutex> lg(_mutex); return _impl; }
+  operator CPtr()   const { return _cur.load(std::memory_order_acquire); }
+  CPtr operator->() const { return _cur.load(std::memory_order_acquire); }
 
 public:
   void find_and_set_mode_ro();
 
+private:
+  void publish(const Ptr &impl);
+
 private:
   mutable std::mutex _mutex;
   Ptr                _impl;
+  std::atomic<CPtr>  _cur;
+};
+
+class BranchesLatency : public ToFromString
+{
+public:
+  BranchesLatency(Branches &b_);
+
+public:
+  int from_string(const std::string &str) final;
+  std::string to_string(void) const final;
+
+private:
+  Branches &_branches;
+};
+
+class BranchesLoad : public ToFromString
+{
+public:
+  BranchesLoad(Branches &b_);
+
+public:
+  int from_string(const std::string &str) final;
+  std::string to_string(void) const final;
+
+private:
+  Branches &_branches;
 };
 
 class SrcMounts : public ToFromString
@@ -55,42 +55,60 @@ namespace l
   readonly(const std::string &s_)
   {
     IFERT("async_read");
+    IFERT("branches-latency");
+    IFERT("branches-load");
     IFERT("branches-mount-timeout");
+    IFERT("cache.dirents-stats");
+    IFERT("cache.getattr-stats");
+    IFERT("cache.search-policy-stats");
     IFERT("cache.symlinks");
     IFERT("cache.writeback");
     IFERT("direct-io-allow-mmap");
     IFERT("export-support");
     IFERT("fsname");
+    IFERT("fuse-loop");
     IFERT("fuse_msg_size");
     IFERT("mount");
     IFERT("nullrw");
+    IFERT("passthrough");
     IFERT("pid");
     IFERT("pin-threads");
     IFERT("process-thread-count");
     IFERT("process-thread-queue-depth");
     IFERT("read-thread-count");
+    IFERT("read-splice");
     IFERT("readdirplus");
     IFERT("scheduling-priority");
     IFERT("srcmounts");
     IFERT("threads");
     IFERT("version");
+    IFERT("write-splice");
 
     return false;
   }
 }
 
 Config::Config()
-  : async_read(true),
+  : action_concurrency(0),
+    async_read(true),
     auto_cache(false),
     minfreespace(MINFREESPACE_DEFAULT),
     branches(minfreespace),
+    branches_latency(branches),
+    branches_load(branches),
     branches_mount_timeout(0),
     cache_attr(1),
+    cache_dir_presence(0),
+    cache_dirents(0),
     cache_entry(1),
     cache_files(CacheFiles::ENUM::LIBFUSE),
     cache_files_process_names(CACHE_FILES_PROCESS_NAMES_DEFAULT),
+    cache_getattr(0),
+    cache_getattr_max(65536),
     cache_negative_entry(0),
     cache_readdir(false),
+    cache_search_policy(0),
+    cache_search_policy_max(65536),
     cache_statfs(0),
     cache_symlinks(false),
     category(func),
@@ -102,9 +120,11 @@ Config::Config()
     follow_symlinks(FollowSymlinks::ENUM::NEVER),
     fsname(),
     func(),
+    fuse_loop(FuseLoop::ENUM::THREADS),
     fuse_msg_size(FUSE_MAX_MAX_PAGES),
     ignorepponrename(false),
     inodecalc("hybrid-hash"),
+    lat_hysteresis(20),
     lazy_umount_mountpoint(false),
     link_cow(false),
     link_exdev(LinkEXDEV::ENUM::PASSTHROUGH),
@@ -114,10 +134,15 @@ Config::Config()
     nfsopenhack(NFSOpenHack::ENUM::OFF),
     nullrw(false),
     parallel_direct_writes(false),
+    passthrough(Passthrough::ENUM::OFF),
     posix_acl(false),
     readahead(0),
     readdir("seq"),
+    read_splice(false),
+    read_splice_fallback(ConfigReadSpliceCount::Type::FALLBACK),
+    read_splice_spliced(ConfigReadSpliceCount::Type::SPLICED),
     readdirplus(false),
+    readdir_spill(0),
     rename_exdev(RenameEXDEV::ENUM::PASSTHROUGH),
     scheduling_priority(-10),
     security_capability(true),
@@ -131,20 +156,33 @@ Config::Config()
     fuse_process_thread_queue_depth(0),
     fuse_pin_threads("false"),
     version(MERGERFS_VERSION),
+    write_splice(false),
     writeback_cache(false),
     xattr(XAttr::ENUM::PASSTHROUGH),
     _initialized(false)
 {
+  _map["action-concurrency"]     = &action_concurrency;
   _map["async_read"]             = &async_read;
   _map["auto_cache"]             = &auto_cache;
   _map["branches"]               = &branches;
+  _map["branches-latency"]       = &branches_latency;
+  _map["branches-load"]          = &branches_load;
   _map["branches-mount-timeout"] = &branches_mount_timeout;
   _map["cache.attr"]             = &cache_attr;
+  _map["cache.dir-presence"]     = &cache_dir_presence;
+  _map["cache.dirents"]          = &cache_dirents;
+  _map["cache.dirents-stats"]    = &cache_dirents_stats;
   _map["cache.entry"]            = &cache_entry;
   _map["cache.files"]            = &cache_files;
   _map["cache.files.process-names"] = &cache_files_process_names;
+  _map["cache.getattr"]          = &cache_getattr;
+  _map["cache.getattr-max"]      = &cache_getattr_max;
+  _map["cache.getattr-stats"]    = &cache_getattr_stats;
   _map["cache.negative_entry"]   = &cache_negative_entry;
   _map["cache.readdir"]          = &cache_readdir;
+  _map["cache.search-policy"]    = &cache_search_policy;
+  _map["cache.search-policy-max"] = &cache_search_policy_max;
+  _map["cache.search-policy-stats"] = &cache_search_policy_stats;
   _map["cache.statfs"]           = &cache_statfs;
   _map["cache.symlinks"]         = &cache_symlinks;
   _map["cache.writeback"]        = &writeback_cache;
@@ -179,10 +217,12 @@ Config::Config()
   _map["func.truncate"]          = &func.truncate;
   _map["func.unlink"]            = &func.unlink;
   _map["func.utimens"]           = &func.utimens;
+  _map["fuse-loop"]              = &fuse_loop;
   _map["fuse_msg_size"]          = &fuse_msg_size;
   _map["ignorepponrename"]       = &ignorepponrename;
   _map["inodecalc"]              = &inodecalc;
   _map["kernel_cache"]           = &kernel_cache;
+  _map["lat.hysteresis"]         = &lat_hysteresis;
   _map["lazy-umount-mountpoint"] = &lazy_umount_mountpoint;
   _map["link_cow"]               = &link_cow;
   _map["link-exdev"]             = &link_exdev;
@@ -194,10 +234,15 @@ Config::Config()
   _map["nullrw"]                 = &nullrw;
   _map["pid"]                    = &pid;
   _map["parallel-direct-writes"] = &parallel_direct_writes;
+  _map["passthrough"]            = &passthrough;
   _map["pin-threads"]            = &fuse_pin_threads;
   _map["posix_acl"]              = &posix_acl;
   _map["readahead"]              = &readahead;
   _map["readdirplus"]            = &readdirplus;
+  _map["readdir-spill"]          = &readdir_spill;
+  _map["read-splice"]            = &read_splice;
+  _map["read-splice.fallback"]   = &read_splice_fallback;
+  _map["read-splice.spliced"]    = &read_splice_spliced;
   _map["rename-exdev"]           = &rename_exdev;
   _map["scheduling-priority"]    = &scheduling_priority;
   _map["security_capability"]    = &security_capability;
@@ -211,6 +256,7 @@ Config::Config()
   _map["process-thread-count"]   = &fuse_process_thread_count;
   _map["process-thread-queue-depth"] = &fuse_process_thread_queue_depth;
   _map["version"]                = &version;
+  _map["write-splice"]           = &write_splice;
   _map["xattr"]                  = &xattr;
 }
 
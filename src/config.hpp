@@ -18,21 +18,28 @@
 
 #include "branches.hpp"
 #include "category.hpp"
+#include "config_attr_cache.hpp"
 #include "config_cachefiles.hpp"
+#include "config_dir_cache.hpp"
 #include "config_flushonclose.hpp"
 #include "config_follow_symlinks.hpp"
+#include "config_fuse_loop.hpp"
 #include "config_pid.hpp"
 #include "config_inodecalc.hpp"
 #include "config_link_exdev.hpp"
 #include "config_log_metrics.hpp"
 #include "config_moveonenospc.hpp"
 #include "config_nfsopenhack.hpp"
+#include "config_passthrough.hpp"
+#include "config_policy_cache.hpp"
+#include "config_read_splice.hpp"
 #include "config_rename_exdev.hpp"
 #include "config_set.hpp"
 #include "config_statfs.hpp"
 #include "config_statfsignore.hpp"
 #include "config_xattr.hpp"
 #include "enum.hpp"
+#include "epoch.hpp"
 #include "errno.hpp"
 #include "funcs.hpp"
 #include "fuse_readdir.hpp"
@@ -74,11 +81,13 @@ public:
   {
   public:
     Read();
+    Read(const Read&) = delete;
 
   public:
     inline const Config* operator->() const;
 
   private:
+    epoch::Guard  _guard;
     const Config &_cfg;
   };
 
@@ -87,12 +96,14 @@ public:
   {
   public:
     Write();
+    Write(const Write&) = delete;
 
   public:
     Config* operator->();
 
   private:
-    Config &_cfg;
+    epoch::Guard  _guard;
+    Config       &_cfg;
   };
 
 public:
@@ -102,17 +113,29 @@ public:
   Config& operator=(const Config&);
 
 public:
+  ConfigUINT64   action_concurrency;
   ConfigBOOL     async_read;
   ConfigBOOL     auto_cache;
   ConfigUINT64   minfreespace;
   Branches       branches;
+  BranchesLatency branches_latency;
+  BranchesLoad   branches_load;
   ConfigUINT64   branches_mount_timeout;
   ConfigUINT64   cache_attr;
+  ConfigUINT64   cache_dir_presence;
+  ConfigUINT64   cache_dirents;
+  ConfigDirCacheStats cache_dirents_stats;
   ConfigUINT64   cache_entry;
   CacheFiles     cache_files;
   ConfigSet      cache_files_process_names;
+  ConfigUINT64   cache_getattr;
+  ConfigUINT64   cache_getattr_max;
+  ConfigAttrCacheStats cache_getattr_stats;
   ConfigUINT64   cache_negative_entry;
   ConfigBOOL     cache_readdir;
+  ConfigUINT64   cache_search_policy;
+  ConfigUINT64   cache_search_policy_max;
+  ConfigPolicyCacheStats cache_search_policy_stats;
   ConfigUINT64   cache_statfs;
   ConfigBOOL     cache_symlinks;
   Categories     category;
@@ -124,10 +147,12 @@ public:
   FollowSymlinks follow_symlinks;
   ConfigSTR      fsname;
   Funcs          func;
+  FuseLoop       fuse_loop;
   ConfigUINT64   fuse_msg_size;
   ConfigBOOL     ignorepponrename;
   InodeCalc      inodecalc;
   ConfigBOOL     kernel_cache;
+  ConfigUINT64   lat_hysteresis;
   ConfigBOOL     lazy_umount_mountpoint;
   ConfigBOOL     link_cow;
   LinkEXDEV      link_exdev;
@@ -137,11 +162,16 @@ public:
   NFSOpenHack    nfsopenhack;
   ConfigBOOL     nullrw;
   ConfigBOOL     parallel_direct_writes;
+  Passthrough    passthrough;
   ConfigGetPid   pid;
   ConfigBOOL     posix_acl;
   ConfigUINT64   readahead;
   FUSE::ReadDir  readdir;
+  ConfigBOOL     read_splice;
+  ConfigReadSpliceCount read_splice_fallback;
+  ConfigReadSpliceCount read_splice_spliced;
   ConfigBOOL     readdirplus;
+  ConfigUINT64   readdir_spill;
   RenameEXDEV    rename_exdev;
   ConfigINT      scheduling_priority;
   ConfigBOOL     security_capability;
@@ -155,6 +185,7 @@ public:
   ConfigINT      fuse_process_thread_queue_depth;
   ConfigSTR      fuse_pin_threads;
   ConfigSTR      version;
+  ConfigBOOL     write_splice;
   ConfigBOOL     writeback_cache;
   XAttr          xattr;
 
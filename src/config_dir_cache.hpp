@@ -0,0 +1,45 @@
+/*
+  ISC License
+
+  Copyright (c) 2024, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#pragma once
+
+#include "dir_cache.hpp"
+#include "tofrom_string.hpp"
+
+#include "fmt/core.h"
+
+
+class ConfigDirCacheStats : public ToFromString
+{
+public:
+  std::string
+  to_string() const final
+  {
+    return fmt::format("hits={},misses={},evictions={},bytes={}",
+                       g_DIR_CACHE.hits(),
+                       g_DIR_CACHE.misses(),
+                       g_DIR_CACHE.evictions(),
+                       g_DIR_CACHE.size());
+  }
+
+  int
+  from_string(const std::string &) final
+  {
+    return -EROFS;
+  }
+};
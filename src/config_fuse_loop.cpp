@@ -0,0 +1,51 @@
+/*
+  ISC License
+
+  Copyright (c) 2024, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include "config_fuse_loop.hpp"
+#include "ef.hpp"
+#include "errno.hpp"
+
+
+template<>
+int
+FuseLoop::from_string(const std::string &s_)
+{
+  if(s_ == "threads")
+    _data = FuseLoop::ENUM::THREADS;
+  ef(s_ == "io_uring")
+    _data = FuseLoop::ENUM::IO_URING;
+  else
+    return -EINVAL;
+
+  return 0;
+}
+
+template<>
+std::string
+FuseLoop::to_string(void) const
+{
+  switch(_data)
+    {
+    case FuseLoop::ENUM::THREADS:
+      return "threads";
+    case FuseLoop::ENUM::IO_URING:
+      return "io_uring";
+    }
+
+  return std::string();
+}
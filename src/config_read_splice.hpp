@@ -0,0 +1,65 @@
+/*
+  ISC License
+
+  Copyright (c) 2024, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#pragma once
+
+#include "tofrom_string.hpp"
+#include "fmt/core.h"
+
+#include "fuse_lowlevel.h"
+
+#include <cstdint>
+
+
+class ConfigReadSpliceCount : public ToFromString
+{
+public:
+  enum class Type
+    {
+      SPLICED,
+      FALLBACK
+    };
+
+public:
+  ConfigReadSpliceCount(const Type type_)
+    : _type(type_)
+  {
+  }
+
+public:
+  std::string
+  to_string() const final
+  {
+    uint64_t spliced;
+    uint64_t fallback;
+
+    fuse_read_splice_counts(&spliced,&fallback);
+
+    return fmt::format("{}",
+                       ((_type == Type::SPLICED) ? spliced : fallback));
+  }
+
+  int
+  from_string(const std::string &) final
+  {
+    return -EROFS;
+  }
+
+private:
+  const Type _type;
+};
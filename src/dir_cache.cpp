@@ -0,0 +1,257 @@
+/*
+  ISC License
+
+  Copyright (c) 2024, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include "dir_cache.hpp"
+
+#include <cstring>
+
+using std::string;
+
+static const uint64_t DEFAULT_MAX = 0;
+
+DirCache g_DIR_CACHE;
+
+namespace l
+{
+  /*
+    Paths can't contain NUL so the credentials are appended after
+    one.
+  */
+  static
+  string
+  key(const char  *fusepath_,
+      const uid_t  uid_,
+      const gid_t  gid_)
+  {
+    string key;
+
+    key  = fusepath_;
+    key += '\0';
+    key.append(reinterpret_cast<const char*>(&uid_),sizeof(uid_));
+    key.append(reinterpret_cast<const char*>(&gid_),sizeof(gid_));
+
+    return key;
+  }
+
+  static
+  bool
+  equal(const struct timespec &a_,
+        const struct timespec &b_)
+  {
+    return ((a_.tv_sec == b_.tv_sec) &&
+            (a_.tv_nsec == b_.tv_nsec));
+  }
+
+  static
+  bool
+  equal(const DirCache::Stamp &a_,
+        const DirCache::Stamp &b_)
+  {
+    if(a_.present != b_.present)
+      return false;
+    if(!a_.present)
+      return true;
+
+    return ((a_.dev == b_.dev) &&
+            (a_.ino == b_.ino) &&
+            l::equal(a_.mtime,b_.mtime) &&
+            l::equal(a_.ctime,b_.ctime));
+  }
+
+  static
+  bool
+  equal(const DirCache::Stamps &a_,
+        const DirCache::Stamps &b_)
+  {
+    if(a_.size() != b_.size())
+      return false;
+
+    for(size_t i = 0; i < a_.size(); i++)
+      {
+        if(!l::equal(a_[i],b_[i]))
+          return false;
+      }
+
+    return true;
+  }
+}
+
+
+DirCache::Entry::Entry()
+  : branches_id(0),
+    size(0)
+{
+  memset(&dirents,0,sizeof(dirents));
+}
+
+DirCache::Entry::~Entry()
+{
+  fuse_dirents_free(&dirents);
+}
+
+DirCache::DirCache(void)
+  : max(DEFAULT_MAX),
+    _size(0),
+    _hits(0),
+    _misses(0),
+    _evictions(0)
+{
+
+}
+
+bool
+DirCache::enabled(void) const
+{
+  return (max != 0);
+}
+
+void
+DirCache::_erase(std::unordered_map<std::string,Value>::iterator i_)
+{
+  _size -= i_->second.entry->size;
+  _lru.erase(i_->second.lru);
+  _cache.erase(i_);
+}
+
+void
+DirCache::clear(void)
+{
+  std::lock_guard<std::mutex> lk(_mutex);
+
+  _cache.clear();
+  _lru.clear();
+  _size = 0;
+}
+
+/*
+  On a hit replaces `dirents_` with the cached listing. The copy is
+  made outside the lock. A stale entry is dropped.
+*/
+bool
+DirCache::get(const char     *fusepath_,
+              const uid_t     uid_,
+              const gid_t     gid_,
+              const uint64_t  branches_id_,
+              const Stamps   &stamps_,
+              fuse_dirents_t *dirents_)
+{
+  string key;
+  EntryPtr entry;
+
+  key = l::key(fusepath_,uid_,gid_);
+
+  {
+    std::lock_guard<std::mutex> lk(_mutex);
+
+    auto i = _cache.find(key);
+    if(i != _cache.end())
+      {
+        if((i->second.entry->branches_id == branches_id_) &&
+           l::equal(i->second.entry->stamps,stamps_))
+          {
+            _lru.splice(_lru.begin(),_lru,i->second.lru);
+            entry = i->second.entry;
+          }
+        else
+          {
+            _erase(i);
+          }
+      }
+  }
+
+  if(!entry || (fuse_dirents_copy(dirents_,&entry->dirents) != 0))
+    {
+      _misses++;
+      return false;
+    }
+
+  _hits++;
+
+  return true;
+}
+
+void
+DirCache::insert(const char           *fusepath_,
+                 const uid_t           uid_,
+                 const gid_t           gid_,
+                 const uint64_t        branches_id_,
+                 const Stamps         &stamps_,
+                 const fuse_dirents_t *dirents_)
+{
+  uint64_t max;
+  string key;
+  std::shared_ptr<Entry> entry;
+
+  max = this->max;
+  key = l::key(fusepath_,uid_,gid_);
+
+  entry = std::make_shared<Entry>();
+  entry->branches_id = branches_id_;
+  entry->stamps      = stamps_;
+  if(fuse_dirents_copy(&entry->dirents,dirents_) != 0)
+    return;
+  entry->size = (sizeof(Entry) +
+                 key.size() +
+                 (stamps_.size() * sizeof(Stamp)) +
+                 kv_max(entry->dirents.data) +
+                 (kv_max(entry->dirents.offs) * sizeof(uint32_t)));
+  if(entry->size > max)
+    return;
+
+  std::lock_guard<std::mutex> lk(_mutex);
+
+  auto i = _cache.find(key);
+  if(i != _cache.end())
+    _erase(i);
+
+  auto rv = _cache.emplace(std::move(key),Value());
+  _lru.push_front(&rv.first->first);
+  rv.first->second.entry = entry;
+  rv.first->second.lru   = _lru.begin();
+  _size += entry->size;
+
+  while(_size > max)
+    {
+      _erase(_cache.find(*_lru.back()));
+      _evictions++;
+    }
+}
+
+uint64_t
+DirCache::hits(void) const
+{
+  return _hits;
+}
+
+uint64_t
+DirCache::misses(void) const
+{
+  return _misses;
+}
+
+uint64_t
+DirCache::evictions(void) const
+{
+  return _evictions;
+}
+
+uint64_t
+DirCache::size(void) const
+{
+  return _size;
+}
@@ -0,0 +1,126 @@
+/*
+  ISC License
+
+  Copyright (c) 2024, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#pragma once
+
+#include "fuse_dirents.h"
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <sys/stat.h>
+
+
+/*
+  Caches merged directory listings keyed by fuse path so unchanged
+  directories don't need every branch re-read, deduplicated and have
+  their inodes recalculated. Each entry is stamped with the device,
+  inode, mtime and ctime of the directory on every branch, or that
+  it wasn't there, and the Branches instance used. A lookup whose
+  stamps differ is a miss and drops the entry. Changes made through
+  mergerfs or directly on the branches update the directories'
+  times so no explicit invalidation is needed. Listings are read with
+  the caller's credentials and branches it can't read are left out
+  so entries are also keyed by uid and gid.
+
+  `max` is the memory budget in bytes for all entries. Least recently
+  used entries are evicted to stay under it.
+*/
+class DirCache
+{
+public:
+  struct Stamp
+  {
+    bool            present;
+    dev_t           dev;
+    ino_t           ino;
+    struct timespec mtime;
+    struct timespec ctime;
+  };
+
+  typedef std::vector<Stamp> Stamps;
+
+  struct Entry
+  {
+    Entry();
+    ~Entry();
+
+    uint64_t       branches_id;
+    Stamps         stamps;
+    fuse_dirents_t dirents;
+    uint64_t       size;
+  };
+
+  typedef std::shared_ptr<const Entry> EntryPtr;
+
+  struct Value
+  {
+    EntryPtr entry;
+    std::list<const std::string*>::iterator lru;
+  };
+
+public:
+  DirCache(void);
+
+public:
+  bool enabled(void) const;
+  void clear(void);
+
+public:
+  bool get(const char     *fusepath,
+           const uid_t     uid,
+           const gid_t     gid,
+           const uint64_t  branches_id,
+           const Stamps   &stamps,
+           fuse_dirents_t *dirents);
+  void insert(const char           *fusepath,
+              const uid_t           uid,
+              const gid_t           gid,
+              const uint64_t        branches_id,
+              const Stamps         &stamps,
+              const fuse_dirents_t *dirents);
+
+public:
+  uint64_t hits(void) const;
+  uint64_t misses(void) const;
+  uint64_t evictions(void) const;
+  uint64_t size(void) const;
+
+public:
+  std::atomic<uint64_t> max;
+
+private:
+  void _erase(std::unordered_map<std::string,Value>::iterator i);
+
+private:
+  std::mutex                             _mutex;
+  std::unordered_map<std::string,Value>  _cache;
+  std::list<const std::string*>          _lru;
+  std::atomic<uint64_t>                  _size;
+  std::atomic<uint64_t>                  _hits;
+  std::atomic<uint64_t>                  _misses;
+  std::atomic<uint64_t>                  _evictions;
+};
+
+extern DirCache g_DIR_CACHE;
@@ -18,8 +18,11 @@
 
 #include "fh.hpp"
 
+#include <memory>
 #include <string>
 
+namespace FUSE { struct ReadDirStreamState; }
+
 
 class DirInfo : public FH
 {
@@ -28,4 +31,7 @@ public:
     : FH(fusepath_)
   {
   }
+
+public:
+  std::shared_ptr<FUSE::ReadDirStreamState> stream;
 };
@@ -0,0 +1,210 @@
+/*
+  ISC License
+
+  Copyright (c) 2024, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include "epoch.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <mutex>
+#include <vector>
+
+
+namespace l
+{
+  /*
+    Each thread publishes the epoch it entered its outermost Guard at
+    or 0 when outside of one. Padded so threads don't share a cache
+    line.
+  */
+  struct Slot
+  {
+    std::atomic<uint64_t> active;
+    char                  pad[64 - sizeof(std::atomic<uint64_t>)];
+  };
+
+  struct Retired
+  {
+    uint64_t                    epoch;
+    std::shared_ptr<const void> ptr;
+  };
+
+  /*
+    Never destroyed so detached threads still running at exit can't
+    touch a destroyed registry.
+  */
+  struct Registry
+  {
+    std::atomic<uint64_t> epoch;
+    std::mutex            mutex;
+    std::vector<Slot*>    slots;
+    std::vector<Retired>  retired;
+  };
+
+  static
+  Registry&
+  registry(void)
+  {
+    static Registry *reg = new Registry{{1},{},{},{}};
+
+    return *reg;
+  }
+
+  struct ThreadSlot
+  {
+    ThreadSlot()
+      : slot(new Slot{{0},{}}),
+        depth(0)
+    {
+      Registry &reg = l::registry();
+      std::lock_guard<std::mutex> lg(reg.mutex);
+
+      reg.slots.push_back(slot);
+    }
+
+    ~ThreadSlot()
+    {
+      Registry &reg = l::registry();
+      std::lock_guard<std::mutex> lg(reg.mutex);
+
+      reg.slots.erase(std::find(reg.slots.begin(),reg.slots.end(),slot));
+      delete slot;
+    }
+
+    Slot     *slot;
+    unsigned  depth;
+  };
+
+  static
+  ThreadSlot&
+  thread_slot(void)
+  {
+    static thread_local ThreadSlot ts;
+
+    return ts;
+  }
+
+  static
+  uint64_t
+  oldest_active(const Registry &reg_)
+  {
+    uint64_t e;
+    uint64_t oldest;
+
+    oldest = std::numeric_limits<uint64_t>::max();
+    for(const Slot *slot : reg_.slots)
+      {
+        e = slot->active.load(std::memory_order_seq_cst);
+        if(e != 0)
+          oldest = std::min(oldest,e);
+      }
+
+    return oldest;
+  }
+
+  static
+  void
+  reclaim(Registry             &reg_,
+          std::vector<Retired> *freed_)
+  {
+    uint64_t oldest;
+
+    oldest = l::oldest_active(reg_);
+
+    auto pending = [oldest](const Retired &r_) { return (r_.epoch > oldest); };
+    auto iter    = std::partition(reg_.retired.begin(),
+                                  reg_.retired.end(),
+                                  pending);
+
+    std::move(iter,reg_.retired.end(),std::back_inserter(*freed_));
+    reg_.retired.erase(iter,reg_.retired.end());
+  }
+}
+
+namespace epoch
+{
+  /*
+    The fence orders publishing the slot before any loads of
+    protected pointers. Pairs with the seq_cst epoch increment and
+    slot scan in retire().
+  */
+  void
+  enter(void)
+  {
+    l::ThreadSlot &ts = l::thread_slot();
+
+    if(ts.depth++ != 0)
+      return;
+
+    ts.slot->active.store(l::registry().epoch.load(std::memory_order_acquire),
+                          std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+  }
+
+  void
+  leave(void)
+  {
+    l::ThreadSlot &ts = l::thread_slot();
+
+    if(--ts.depth != 0)
+      return;
+
+    ts.slot->active.store(0,std::memory_order_release);
+  }
+
+  /*
+    Must be called after the replacement has been published. Any
+    thread which could still hold ptr entered before the increment.
+    Values are freed outside the lock since destructors may close
+    files and such.
+  */
+  void
+  retire(std::shared_ptr<const void> ptr_)
+  {
+    uint64_t e;
+    l::Registry &reg = l::registry();
+    std::vector<l::Retired> freed;
+
+    e = (reg.epoch.fetch_add(1,std::memory_order_seq_cst) + 1);
+
+    {
+      std::lock_guard<std::mutex> lg(reg.mutex);
+
+      reg.retired.push_back({e,std::move(ptr_)});
+      l::reclaim(reg,&freed);
+    }
+  }
+
+  void
+  reclaim(void)
+  {
+    l::Registry &reg = l::registry();
+    std::vector<l::Retired> freed;
+
+    {
+      std::lock_guard<std::mutex> lg(reg.mutex);
+
+      if(reg.retired.empty())
+        return;
+
+      l::reclaim(reg,&freed);
+    }
+  }
+}
@@ -0,0 +1,54 @@
+/*
+  ISC License
+
+  Copyright (c) 2024, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#pragma once
+
+#include <memory>
+
+
+/*
+  Epoch based reclamation for data which is replaced rather than
+  modified in place, such as the branch list. Readers wrap their use
+  in a Guard, which only writes to a slot owned by the calling
+  thread, and can then load the current pointer with a single
+  acquire load. Writers publish the replacement and retire() the old
+  value which is released once every thread which was in a Guard at
+  the time has left it.
+
+  Guards nest. Config::Read and Config::Write hold one so anything
+  reached through the config is protected for the life of the
+  request.
+*/
+namespace epoch
+{
+  void enter(void);
+  void leave(void);
+
+  void retire(std::shared_ptr<const void> ptr);
+  void reclaim(void);
+
+  class Guard
+  {
+  public:
+    Guard()  { epoch::enter(); }
+    ~Guard() { epoch::leave(); }
+
+    Guard(const Guard&) = delete;
+    Guard& operator=(const Guard&) = delete;
+  };
+}
@@ -0,0 +1,130 @@
+/*
+  ISC License
+
+  Copyright (c) 2024, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include "fanout.hpp"
+
+#include "ugid.hpp"
+
+#include "thread_pool.hpp"
+
+#include <atomic>
+#include <future>
+#include <mutex>
+
+#include <unistd.h>
+
+// Below this the hand off to the pool costs more than it saves
+#define FANOUT_MIN_COUNT 3
+
+
+static std::atomic<unsigned> g_max(0);
+static std::mutex            g_pool_mutex;
+static ThreadPool           *g_pool = NULL;
+
+namespace l
+{
+  static
+  ThreadPool&
+  pool(const unsigned max_)
+  {
+    std::lock_guard<std::mutex> lg(g_pool_mutex);
+
+    if(g_pool == NULL)
+      g_pool = new ThreadPool(max_,max_ * 64,"fs.fanout");
+
+    return *g_pool;
+  }
+}
+
+namespace fanout
+{
+  unsigned
+  max(void)
+  {
+    return g_max;
+  }
+
+  void
+  max(const unsigned max_)
+  {
+    g_max = max_;
+
+    std::lock_guard<std::mutex> lg(g_pool_mutex);
+    if((g_pool != NULL) && (max_ > 0))
+      g_pool->set_threads(max_);
+  }
+
+  void
+  for_each(const Branch::CPtrVec &branches_,
+           const Func            &func_,
+           std::vector<int>      *errs_)
+  {
+    uid_t uid;
+    gid_t gid;
+    unsigned max;
+    std::vector<std::future<int>> futures;
+
+    errs_->resize(branches_.size());
+
+    max = g_max;
+    if((max < 2) || (branches_.size() < FANOUT_MIN_COUNT))
+      {
+        for(size_t i = 0, ei = branches_.size(); i != ei; i++)
+          (*errs_)[i] = func_(*branches_[i]);
+        return;
+      }
+
+    uid = ::geteuid();
+    gid = ::getegid();
+
+    ThreadPool &tp = l::pool(max);
+
+    futures.reserve(branches_.size() - 1);
+    for(size_t i = 1, ei = branches_.size(); i != ei; i++)
+      {
+        auto func = [&,i,uid,gid]()
+        {
+          const ugid::Set ugid(uid,gid);
+
+          (*errs_)[i] = func_(*branches_[i]);
+
+          return 0;
+        };
+
+        futures.emplace_back(tp.enqueue_task(func));
+      }
+
+    (*errs_)[0] = func_(*branches_[0]);
+
+    for(auto &future : futures)
+      future.wait();
+  }
+
+  void
+  for_each(const Branch::CPtrVec &branches_,
+           const Func            &func_,
+           PolicyRV              *prv_)
+  {
+    std::vector<int> errs;
+
+    fanout::for_each(branches_,func_,&errs);
+
+    for(size_t i = 0, ei = branches_.size(); i != ei; i++)
+      prv_->insert(errs[i],branches_[i]);
+  }
+}
@@ -0,0 +1,52 @@
+/*
+  ISC License
+
+  Copyright (c) 2024, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#pragma once
+
+#include "branch.hpp"
+#include "policy_rv.hpp"
+
+#include <functional>
+#include <vector>
+
+
+/*
+  Runs a function against each of a list of branches. With a max
+  concurrency above 1 and enough branches the calls are spread over
+  a shared thread pool, the calling thread taking the first, and run
+  with the caller's credentials. Otherwise they run serially. Either
+  way results are returned in branch order so callers aggregate
+  errors exactly as the serial loops did.
+
+  The function returns 0 or an errno.
+*/
+namespace fanout
+{
+  typedef std::function<int(const Branch&)> Func;
+
+  unsigned max(void);
+  void     max(const unsigned max);
+
+  void for_each(const Branch::CPtrVec &branches,
+                const Func            &func,
+                std::vector<int>      *errs);
+
+  void for_each(const Branch::CPtrVec &branches,
+                const Func            &func,
+                PolicyRV              *prv);
+}
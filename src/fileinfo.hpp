@@ -16,9 +16,12 @@
 
 #pragma once
 
+#include "branch_space.hpp"
+#include "branch_stats.hpp"
 #include "fh.hpp"
 
 #include <cstdint>
+#include <memory>
 #include <string>
 #include <mutex>
 
@@ -31,12 +34,61 @@ public:
            bool const  direct_io_)
     : FH(fusepath_),
       fd(fd_),
-      direct_io(direct_io_)
+      backing_id(0),
+      backing_dev(0),
+      backing_ino(0),
+      direct_io(direct_io_),
+      writer(0),
+      cached_io(0)
   {
   }
 
+  ~FileInfo()
+  {
+    if(writer)
+      stats->writer_closed();
+  }
+
+public:
+  void
+  opened_on(const BranchStats::Ptr &stats_)
+  {
+    stats = stats_;
+  }
+
+  void
+  writing_to(const BranchSpace::Ptr &space_,
+             const BranchStats::Ptr &stats_)
+  {
+    space  = space_;
+    stats  = stats_;
+    writer = 1;
+    stats->writer_opened();
+  }
+
+  /*
+    Called with mutex held after moveonenospc moved the file. Reads
+    don't take the mutex so stats is swapped atomically.
+  */
+  void
+  moved_to(const BranchSpace::Ptr &space_,
+           const BranchStats::Ptr &stats_)
+  {
+    stats->writer_closed();
+    stats_->writer_opened();
+    space = space_;
+    std::atomic_store(&stats,stats_);
+  }
+
 public:
   int fd;
+  int backing_id;
+  dev_t backing_dev;
+  ino_t backing_ino;
   uint32_t direct_io:1;
+  uint32_t writer:1;
+  uint32_t cached_io:1;
   std::mutex mutex;
+  BranchSpace::Ptr space;
+  BranchStats::Ptr stats;
 };
@@ -17,6 +17,7 @@
 #include "errno.h"
 #include "fs_attr.hpp"
 #include "fs_clonepath.hpp"
+#include "fs_dirpresence.hpp"
 #include "fs_lchown.hpp"
 #include "fs_lstat.hpp"
 #include "fs_lutimens.hpp"
@@ -92,12 +93,14 @@ namespace fs
     rv = fs::mkdir(topath,st.st_mode);
     if(rv == -1)
       {
-        if(errno == EEXIST)
-          return 0;
-        else
+        if(errno != EEXIST)
           return -1;
+        fs::dirpresence::set(tosrc_,relative_,true);
+        return 0;
       }
 
+    fs::dirpresence::set(tosrc_,relative_,true);
+
     // it may not support it... it's fine...
     rv = fs::attr::copy(frompath,topath);
     if(return_metadata_errors_ && (rv == -1) && !l::ignorable_error(errno))
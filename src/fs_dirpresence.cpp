@@ -0,0 +1,403 @@
+/*
+  ISC License
+
+  Copyright (c) 2024, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include "fs_dirpresence.hpp"
+
+#include "fs_exists.hpp"
+#include "fs_path.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <errno.h>
+#include <pthread.h>
+#include <time.h>
+
+#define DIRPRESENCE_SHARDS    16
+#define DIRPRESENCE_SHARD_MAX 16384
+#define DIRPRESENCE_MAX_BRANCHES 64
+
+
+namespace l
+{
+  /*
+    `known` and `present` are bitsets indexed by branch position in
+    the Branches instance identified by `id`. Entries are also created
+    for every ancestor of an indexed directory, with nothing known,
+    so a rename can tell whether it affects anything in the index by
+    looking up the old path alone.
+  */
+  struct Entry
+  {
+    uint64_t id;
+    uint64_t time;
+    uint64_t known;
+    uint64_t present;
+  };
+
+  struct Shard
+  {
+    Shard()
+    {
+      pthread_mutex_init(&lock,NULL);
+    }
+
+    pthread_mutex_t                       lock;
+    std::unordered_map<std::string,Entry> map;
+  };
+}
+
+static std::atomic<uint64_t> g_timeout(0);
+static std::atomic<uint64_t> g_id(0);
+static pthread_mutex_t       g_branches_lock = PTHREAD_MUTEX_INITIALIZER;
+static std::vector<std::string> g_branches;
+static l::Shard              g_shards[DIRPRESENCE_SHARDS];
+
+namespace l
+{
+  static
+  uint64_t
+  get_time(void)
+  {
+    uint64_t rv;
+
+    rv = ::time(NULL);
+
+    return rv;
+  }
+
+  static
+  Shard&
+  shard(const std::string &fusepath_)
+  {
+    return g_shards[std::hash<std::string>()(fusepath_) % DIRPRESENCE_SHARDS];
+  }
+
+  static
+  void
+  clear_shards(void)
+  {
+    for(auto &shard : g_shards)
+      {
+        pthread_mutex_lock(&shard.lock);
+        shard.map.clear();
+        pthread_mutex_unlock(&shard.lock);
+      }
+  }
+
+  /*
+    Bits only mean something relative to one set of branches so any
+    change to the branches starts the index over.
+  */
+  static
+  void
+  sync(const Branches::CPtr &branches_)
+  {
+    if(g_id.load(std::memory_order_acquire) == branches_->id())
+      return;
+
+    pthread_mutex_lock(&g_branches_lock);
+    if(g_id.load(std::memory_order_relaxed) != branches_->id())
+      {
+        g_branches.clear();
+        for(auto const &branch : *branches_)
+          g_branches.push_back(branch.path);
+        l::clear_shards();
+        g_id.store(branches_->id(),std::memory_order_release);
+      }
+    pthread_mutex_unlock(&g_branches_lock);
+  }
+
+  static
+  bool
+  valid(const Entry    &e_,
+        const uint64_t  id_,
+        const uint64_t  now_)
+  {
+    return ((e_.id == id_) &&
+            ((now_ - e_.time) < g_timeout.load(std::memory_order_relaxed)));
+  }
+
+  static
+  void
+  add_ancestors(const uint64_t     id_,
+                const uint64_t     now_,
+                const std::string &fusepath_)
+  {
+    std::string path;
+
+    path = fs::path::dirname(fusepath_);
+    while((path != "/") && !path.empty())
+      {
+        Shard &shard = l::shard(path);
+
+        pthread_mutex_lock(&shard.lock);
+        auto rv = shard.map.emplace(path,Entry{id_,now_,0,0});
+        pthread_mutex_unlock(&shard.lock);
+        if(rv.second == false)
+          break;
+
+        path = fs::path::dirname(path);
+      }
+  }
+
+  static
+  void
+  update(const uint64_t     id_,
+         const uint64_t     bit_,
+         const std::string &fusepath_,
+         const bool         present_,
+         const bool         insert_)
+  {
+    bool full;
+    bool inserted;
+    uint64_t now;
+    Shard &shard = l::shard(fusepath_);
+
+    now = l::get_time();
+
+    pthread_mutex_lock(&shard.lock);
+    full = (shard.map.size() >= DIRPRESENCE_SHARD_MAX);
+    pthread_mutex_unlock(&shard.lock);
+
+    // Dropping one shard could orphan ancestor entries elsewhere
+    if(full && insert_)
+      l::clear_shards();
+
+    inserted = false;
+    pthread_mutex_lock(&shard.lock);
+    auto i = shard.map.find(fusepath_);
+    if(i == shard.map.end())
+      {
+        if(insert_)
+          {
+            i = shard.map.emplace(fusepath_,Entry{id_,now,0,0}).first;
+            inserted = true;
+          }
+      }
+    else if(!l::valid(i->second,id_,now))
+      {
+        i->second = Entry{id_,now,0,0};
+      }
+
+    if(i != shard.map.end())
+      {
+        i->second.known |= bit_;
+        if(present_)
+          i->second.present |= bit_;
+        else
+          i->second.present &= ~bit_;
+      }
+    pthread_mutex_unlock(&shard.lock);
+
+    if(inserted)
+      l::add_ancestors(id_,now,fusepath_);
+  }
+
+  static
+  uint64_t
+  bit(const Branches::CPtr &branches_,
+      const Branch         &branch_)
+  {
+    uint64_t idx;
+
+    idx = (&branch_ - branches_->data());
+    if(idx >= DIRPRESENCE_MAX_BRANCHES)
+      return 0;
+
+    return (1ULL << idx);
+  }
+
+  /*
+    Probes run with the caller's credentials. Only an answer which
+    would be the same for anyone, the path being there or ENOENT /
+    ENOTDIR, can go into the shared index. Anything else, such as
+    EACCES, only answers for this caller.
+  */
+  static
+  bool
+  probe(const Branch &branch_,
+        const char   *fusepath_,
+        bool         *definite_)
+  {
+    bool rv;
+
+    errno = 0;
+    rv = fs::exists(branch_,fusepath_);
+
+    *definite_ = (rv || (errno == ENOENT) || (errno == ENOTDIR));
+
+    return rv;
+  }
+}
+
+namespace fs
+{
+  namespace dirpresence
+  {
+    uint64_t
+    timeout(void)
+    {
+      return g_timeout;
+    }
+
+    void
+    timeout(const uint64_t timeout_)
+    {
+      g_timeout = timeout_;
+      if(timeout_ == 0)
+        l::clear_shards();
+    }
+
+    bool
+    exists(const Branches::CPtr &branches_,
+           const Branch         &branch_,
+           const char           *fusepath_)
+    {
+      bool rv;
+      bool definite;
+      uint64_t id;
+      uint64_t bit;
+
+      if(g_timeout.load(std::memory_order_relaxed) == 0)
+        return fs::exists(branch_,fusepath_);
+
+      bit = l::bit(branches_,branch_);
+      if(bit == 0)
+        return fs::exists(branch_,fusepath_);
+
+      l::sync(branches_);
+
+      id = branches_->id();
+      {
+        std::string fusepath(fusepath_);
+        l::Shard &shard = l::shard(fusepath);
+
+        pthread_mutex_lock(&shard.lock);
+        auto i = shard.map.find(fusepath);
+        if((i != shard.map.end()) &&
+           (i->second.known & bit) &&
+           l::valid(i->second,id,l::get_time()))
+          {
+            rv = !!(i->second.present & bit);
+            pthread_mutex_unlock(&shard.lock);
+            return rv;
+          }
+        pthread_mutex_unlock(&shard.lock);
+
+        rv = l::probe(branch_,fusepath_,&definite);
+        if(definite)
+          l::update(id,bit,fusepath,rv,true);
+      }
+
+      return rv;
+    }
+
+    void
+    found(const Branches::CPtr &branches_,
+          const Branch         &branch_,
+          const char           *fusepath_,
+          const bool            present_)
+    {
+      uint64_t bit;
+
+      if(g_timeout.load(std::memory_order_relaxed) == 0)
+        return;
+
+      bit = l::bit(branches_,branch_);
+      if(bit == 0)
+        return;
+
+      l::sync(branches_);
+
+      l::update(branches_->id(),bit,fusepath_,present_,true);
+    }
+
+    /*
+      Used where only the branch path is at hand. Only refines
+      entries which already exist.
+    */
+    void
+    set(const std::string &branchpath_,
+        const std::string &fusepath_,
+        const bool         present_)
+    {
+      uint64_t id;
+      uint64_t bit;
+
+      if(g_timeout.load(std::memory_order_relaxed) == 0)
+        return;
+
+      bit = 0;
+      pthread_mutex_lock(&g_branches_lock);
+      id = g_id.load(std::memory_order_relaxed);
+      for(size_t i = 0; i < g_branches.size(); i++)
+        {
+          if(g_branches[i] != branchpath_)
+            continue;
+          if(i < DIRPRESENCE_MAX_BRANCHES)
+            bit = (1ULL << i);
+          break;
+        }
+      pthread_mutex_unlock(&g_branches_lock);
+
+      if(bit == 0)
+        return;
+
+      l::update(id,bit,fusepath_,present_,false);
+    }
+
+    /*
+      Moving a directory invalidates everything under both paths.
+      That's rare enough that starting over is simpler than finding
+      the affected entries.
+    */
+    void
+    rename(const std::string &oldfusepath_,
+           const std::string &newfusepath_)
+    {
+      bool indexed;
+
+      if(g_timeout.load(std::memory_order_relaxed) == 0)
+        return;
+
+      indexed = false;
+      for(auto const &path : {oldfusepath_,newfusepath_})
+        {
+          l::Shard &shard = l::shard(path);
+
+          pthread_mutex_lock(&shard.lock);
+          indexed |= (shard.map.count(path) != 0);
+          pthread_mutex_unlock(&shard.lock);
+        }
+
+      if(indexed)
+        l::clear_shards();
+    }
+
+    void
+    clear(void)
+    {
+      l::clear_shards();
+    }
+  }
+}
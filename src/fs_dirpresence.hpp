@@ -0,0 +1,60 @@
+/*
+  ISC License
+
+  Copyright (c) 2024, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#pragma once
+
+#include "branches.hpp"
+
+#include <cstdint>
+#include <string>
+
+
+/*
+  Index of which branches hold a directory, keyed by its fuse path,
+  so existing path policies needn't check every branch on every
+  create. Filled in lazily as directories are looked for or read and
+  kept current by mergerfs' own changes. Entries expire after the
+  timeout to pick up changes made directly to the branches. A
+  timeout of 0 disables the index.
+*/
+namespace fs
+{
+  namespace dirpresence
+  {
+    uint64_t timeout(void);
+    void     timeout(const uint64_t timeout);
+
+    bool exists(const Branches::CPtr &branches,
+                const Branch         &branch,
+                const char           *fusepath);
+
+    void found(const Branches::CPtr &branches,
+               const Branch         &branch,
+               const char           *fusepath,
+               const bool            present);
+
+    void set(const std::string &branchpath,
+             const std::string &fusepath,
+             const bool         present);
+
+    void rename(const std::string &oldfusepath,
+                const std::string &newfusepath);
+
+    void clear(void);
+  }
+}
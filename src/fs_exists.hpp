@@ -18,6 +18,8 @@
 
 #pragma once
 
+#include "branch.hpp"
+#include "fs_fstatat.hpp"
 #include "fs_lstat.hpp"
 #include "fs_path.hpp"
 
@@ -86,4 +88,33 @@ namespace fs
 
     return fs::exists(basepath_,relpath_,&st);
   }
+  static
+  inline
+  bool
+  exists(const Branch &branch_,
+         const char   *fusepath_,
+         struct stat  *st_)
+  {
+    int rv;
+    int dirfd;
+
+    dirfd = branch_.fd();
+    if(dirfd < 0)
+      return fs::exists(branch_.path,fusepath_,st_);
+
+    rv = fs::fstatat_nofollow(dirfd,fs::path::rel(fusepath_),st_);
+
+    return (rv == 0);
+  }
+
+  static
+  inline
+  bool
+  exists(const Branch &branch_,
+         const char   *fusepath_)
+  {
+    struct stat st;
+
+    return fs::exists(branch_,fusepath_,&st);
+  }
 }
@@ -16,6 +16,7 @@
   OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 */
 
+#include "fs_info.hpp"
 #include "fs_info_t.hpp"
 #include "fs_path.hpp"
 #include "fs_stat.hpp"
@@ -48,4 +49,11 @@ namespace fs
 
     return rv;
   }
+
+  int
+  info(const Branch &branch_,
+       fs::info_t   *info_)
+  {
+    return branch_.space->get(branch_.path,info_);
+  }
 }
@@ -18,6 +18,7 @@
 
 #pragma once
 
+#include "branch.hpp"
 #include "fs_info_t.hpp"
 
 #include <string>
@@ -28,4 +29,8 @@ namespace fs
   int
   info(const std::string &path,
        fs::info_t        *info);
+
+  int
+  info(const Branch &branch,
+       fs::info_t   *info);
 }
@@ -23,14 +23,24 @@
 
 #include <cstdint>
 #include <string>
+#include <vector>
 
+#include <limits.h>
 #include <pthread.h>
 #include <string.h>
 #include <sys/stat.h>
 
-typedef uint64_t (*inodefunc_t)(const char*,const uint64_t,const mode_t,const dev_t,const ino_t);
+// A path given whole or as a name within a directory's path hash.
+struct Path
+{
+  const char                *str;
+  uint64_t                   len;
+  const fs::inode::PathHash *parent;
+};
+
+typedef uint64_t (*inodefunc_t)(const Path&,const mode_t,const dev_t,const ino_t);
 
-static uint64_t hybrid_hash(const char*,const uint64_t,const mode_t,const dev_t,const ino_t);
+static uint64_t hybrid_hash(const Path&,const mode_t,const dev_t,const ino_t);
 
 static inodefunc_t g_func = hybrid_hash;
 
@@ -44,41 +54,40 @@ h64_to_h32(uint64_t h_)
 
 static
 uint64_t
-passthrough(const char     *fusepath_,
-            const uint64_t  fusepath_len_,
-            const mode_t    mode_,
-            const dev_t     dev_,
-            const ino_t     ino_)
+passthrough(const Path   &path_,
+            const mode_t  mode_,
+            const dev_t   dev_,
+            const ino_t   ino_)
 {
   return ino_;
 }
 
 static
 uint64_t
-path_hash(const char     *fusepath_,
-          const uint64_t  fusepath_len_,
-          const mode_t    mode_,
-          const dev_t     dev_,
-          const ino_t     ino_)
+path_hash(const Path   &path_,
+          const mode_t  mode_,
+          const dev_t   dev_,
+          const ino_t   ino_)
 {
-  return wyhash(fusepath_,
-                fusepath_len_,
+  if(path_.parent)
+    return path_.parent->hash(path_.str,path_.len);
+
+  return wyhash(path_.str,
+                path_.len,
                 fs::inode::MAGIC,
                 _wyp);
 }
 
 static
 uint64_t
-path_hash32(const char     *fusepath_,
-            const uint64_t  fusepath_len_,
-            const mode_t    mode_,
-            const dev_t     dev_,
-            const ino_t     ino_)
+path_hash32(const Path   &path_,
+            const mode_t  mode_,
+            const dev_t   dev_,
+            const ino_t   ino_)
 {
   uint64_t h;
 
-  h = path_hash(fusepath_,
-                fusepath_len_,
+  h = path_hash(path_,
                 mode_,
                 dev_,
                 ino_);
@@ -88,11 +97,10 @@ path_hash32(const char     *fusepath_,
 
 static
 uint64_t
-devino_hash(const char     *fusepath_,
-            const uint64_t  fusepath_len_,
-            const mode_t    mode_,
-            const dev_t     dev_,
-            const ino_t     ino_)
+devino_hash(const Path   &path_,
+            const mode_t  mode_,
+            const dev_t   dev_,
+            const ino_t   ino_)
 {
   uint64_t buf[2];
 
@@ -107,16 +115,14 @@ devino_hash(const char     *fusepath_,
 
 static
 uint64_t
-devino_hash32(const char     *fusepath_,
-              const uint64_t  fusepath_len_,
-              const mode_t    mode_,
-              const dev_t     dev_,
-              const ino_t     ino_)
+devino_hash32(const Path   &path_,
+              const mode_t  mode_,
+              const dev_t   dev_,
+              const ino_t   ino_)
 {
   uint64_t h;
 
-  h = devino_hash(fusepath_,
-                  fusepath_len_,
+  h = devino_hash(path_,
                   mode_,
                   dev_,
                   ino_);
@@ -126,28 +132,128 @@ devino_hash32(const char     *fusepath_,
 
 static
 uint64_t
-hybrid_hash(const char     *fusepath_,
-            const uint64_t  fusepath_len_,
-            const mode_t    mode_,
-            const dev_t     dev_,
-            const ino_t     ino_)
+hybrid_hash(const Path   &path_,
+            const mode_t  mode_,
+            const dev_t   dev_,
+            const ino_t   ino_)
 {
   return (S_ISDIR(mode_) ?
-          path_hash(fusepath_,fusepath_len_,mode_,dev_,ino_) :
-          devino_hash(fusepath_,fusepath_len_,mode_,dev_,ino_));
+          path_hash(path_,mode_,dev_,ino_) :
+          devino_hash(path_,mode_,dev_,ino_));
 }
 
 static
 uint64_t
-hybrid_hash32(const char     *fusepath_,
-              const uint64_t  fusepath_len_,
-              const mode_t    mode_,
-              const dev_t     dev_,
-              const ino_t     ino_)
+hybrid_hash32(const Path   &path_,
+              const mode_t  mode_,
+              const dev_t   dev_,
+              const ino_t   ino_)
 {
   return (S_ISDIR(mode_) ?
-          path_hash32(fusepath_,fusepath_len_,mode_,dev_,ino_) :
-          devino_hash32(fusepath_,fusepath_len_,mode_,dev_,ino_));
+          path_hash32(path_,mode_,dev_,ino_) :
+          devino_hash32(path_,mode_,dev_,ino_));
+}
+
+/*
+  wyhash consumes input in 48 byte blocks for as long as at least 48
+  bytes remain so every whole block of a directory's path is consumed
+  the same way no matter the name which follows. The state after
+  those is kept along with the rest of the path, and the 16 bytes
+  before it which the final read can reach back to, and hashing an
+  entry's path resumes from there.
+*/
+fs::inode::PathHash::PathHash(const char *dirname_)
+{
+  const uint8_t *p;
+  std::string path;
+
+  path = dirname_;
+  if(path.empty() || (path.back() != '/'))
+    path += '/';
+
+  p       = (const uint8_t*)path.data();
+  _len    = path.size();
+  _seed   = (fs::inode::MAGIC ^ _wymix(fs::inode::MAGIC ^ _wyp[0],_wyp[1]));
+  _see1   = _seed;
+  _see2   = _seed;
+  _blocks = 0;
+  for(uint64_t i = _len; i >= 48; i -= 48)
+    {
+      _seed = _wymix(_wyr8(p)^_wyp[1],_wyr8(p+8)^_seed);
+      _see1 = _wymix(_wyr8(p+16)^_wyp[2],_wyr8(p+24)^_see1);
+      _see2 = _wymix(_wyr8(p+32)^_wyp[3],_wyr8(p+40)^_see2);
+      p += 48;
+      _blocks++;
+    }
+
+  p = (const uint8_t*)path.data();
+  if(_blocks)
+    p += ((_blocks * 48) - 16);
+  _taillen = (_len - (p - (const uint8_t*)path.data()));
+  memcpy(_tail,p,_taillen);
+}
+
+uint64_t
+fs::inode::PathHash::hash(const char     *name_,
+                          const uint64_t  namelen_) const
+{
+  uint64_t a;
+  uint64_t b;
+  uint64_t i;
+  uint64_t len;
+  uint64_t seed;
+  uint64_t see1;
+  uint64_t see2;
+  uint8_t *base;
+  const uint8_t *p;
+  std::vector<uint8_t> heap;
+  uint8_t buf[sizeof(_tail) + NAME_MAX];
+
+  // Names from getdents never exceed NAME_MAX
+  base = &buf[0];
+  if(namelen_ > NAME_MAX)
+    {
+      heap.resize(_taillen + namelen_);
+      base = heap.data();
+    }
+
+  memcpy(&base[0],_tail,_taillen);
+  memcpy(&base[_taillen],name_,namelen_);
+
+  len = (_len + namelen_);
+  if(_blocks == 0)
+    return wyhash(base,len,fs::inode::MAGIC,_wyp);
+
+  p    = &base[16];
+  i    = (len - (_blocks * 48));
+  seed = _seed;
+  see1 = _see1;
+  see2 = _see2;
+  while(i >= 48)
+    {
+      seed = _wymix(_wyr8(p)^_wyp[1],_wyr8(p+8)^seed);
+      see1 = _wymix(_wyr8(p+16)^_wyp[2],_wyr8(p+24)^see1);
+      see2 = _wymix(_wyr8(p+32)^_wyp[3],_wyr8(p+40)^see2);
+      p += 48;
+      i -= 48;
+    }
+  seed ^= (see1 ^ see2);
+
+  while(i > 16)
+    {
+      seed = _wymix(_wyr8(p)^_wyp[1],_wyr8(p+8)^seed);
+      i -= 16;
+      p += 16;
+    }
+
+  a = _wyr8(p+i-16);
+  b = _wyr8(p+i-8);
+
+  a ^= _wyp[1];
+  b ^= seed;
+  _wymum(&a,&b);
+
+  return _wymix(a^_wyp[0]^len,b^_wyp[1]);
 }
 
 namespace fs
@@ -205,7 +311,9 @@ namespace fs
          const dev_t     dev_,
          const ino_t     ino_)
     {
-      return g_func(fusepath_,fusepath_len_,mode_,dev_,ino_);
+      const Path path = {fusepath_,fusepath_len_,nullptr};
+
+      return g_func(path,mode_,dev_,ino_);
     }
 
     uint64_t
@@ -246,5 +354,32 @@ namespace fs
     {
       calc(fusepath_.c_str(),fusepath_.size(),st_);
     }
+
+    uint64_t
+    calc(const PathHash &parent_,
+         const char     *name_,
+         const uint64_t  namelen_,
+         const mode_t    mode_,
+         const dev_t     dev_,
+         const ino_t     ino_)
+    {
+      const Path path = {name_,namelen_,&parent_};
+
+      return g_func(path,mode_,dev_,ino_);
+    }
+
+    void
+    calc(const PathHash &parent_,
+         const char     *name_,
+         const uint64_t  namelen_,
+         struct stat    *st_)
+    {
+      st_->st_ino = calc(parent_,
+                         name_,
+                         namelen_,
+                         st_->st_mode,
+                         st_->st_dev,
+                         st_->st_ino);
+    }
   }
 }
@@ -33,6 +33,31 @@ namespace fs
     int set_algo(const std::string &s);
     std::string get_algo(void);
 
+    /*
+      The path hash state of a directory so that the hash of each of
+      its entries' paths, as used by the path based algorithms, only
+      costs the entry's name rather than the whole path. Results are
+      identical to hashing the full path.
+    */
+    class PathHash
+    {
+    public:
+      PathHash(const char *dirname);
+
+    public:
+      uint64_t hash(const char     *name,
+                    const uint64_t  namelen) const;
+
+    private:
+      uint64_t _seed;
+      uint64_t _see1;
+      uint64_t _see2;
+      uint64_t _len;
+      uint64_t _blocks;
+      uint64_t _taillen;
+      uint8_t  _tail[64];
+    };
+
     uint64_t calc(const char     *fusepath,
                   const uint64_t  fusepath_len,
                   const mode_t    mode,
@@ -49,6 +74,16 @@ namespace fs
               struct stat *st);
     void calc(const std::string &fusepath,
               struct stat       *st);
+    uint64_t calc(const PathHash &parent,
+                  const char     *name,
+                  const uint64_t  namelen,
+                  const mode_t    mode,
+                  const dev_t     dev,
+                  const ino_t     ino);
+    void calc(const PathHash &parent,
+              const char     *name,
+              const uint64_t  namelen,
+              struct stat    *st);
 
   }
 }
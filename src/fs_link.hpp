@@ -25,13 +25,22 @@
 
 namespace fs
 {
+  static
+  inline
+  int
+  link(const char *oldpath_,
+       const char *newpath_)
+  {
+    return ::link(oldpath_,newpath_);
+  }
+
   static
   inline
   int
   link(const std::string &oldpath_,
        const std::string &newpath_)
   {
-    return ::link(oldpath_.c_str(),
-                  newpath_.c_str());
+    return fs::link(oldpath_.c_str(),
+                    newpath_.c_str());
   }
 }
@@ -27,12 +27,21 @@ namespace fs
   static
   inline
   int
-  lutimens(const std::string     &path_,
+  lutimens(const char            *path_,
            const struct timespec  ts_[2])
   {
     return fs::utimensat(AT_FDCWD,path_,ts_,AT_SYMLINK_NOFOLLOW);
   }
 
+  static
+  inline
+  int
+  lutimens(const std::string     &path_,
+           const struct timespec  ts_[2])
+  {
+    return fs::lutimens(path_.c_str(),ts_);
+  }
+
   static
   inline
   int
@@ -14,6 +14,7 @@
   OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 */
 
+#include "attr_cache.hpp"
 #include "errno.hpp"
 #include "fs_clonefile.hpp"
 #include "fs_clonepath.hpp"
@@ -29,6 +30,7 @@
 #include "fs_stat.hpp"
 #include "fs_unlink.hpp"
 #include "policy.hpp"
+#include "policy_cache.hpp"
 #include "ugid.hpp"
 
 #include <string>
@@ -66,7 +68,8 @@ namespace l
   movefile(const Policy::Create &createFunc_,
            const Branches::CPtr &branches_,
            const string         &fusepath_,
-           int                   origfd_)
+           int                   origfd_,
+           const Branch        **newbranch_)
   {
     int rv;
     int srcfd;
@@ -79,7 +82,7 @@ namespace l
     string srcfd_filepath;
     string dstfd_filepath;
     string dstfd_tmp_filepath;
-    vector<string> dstfd_branch;
+    Branch::CPtrVec dstfd_branch;
 
     srcfd = -1;
     dstfd = -1;
@@ -100,12 +103,12 @@ namespace l
     if(srcfd_size == -1)
       return -errno;
 
-    if(fs::has_space(dstfd_branch[0],srcfd_size) == false)
+    if(fs::has_space(dstfd_branch[0]->path,srcfd_size) == false)
       return -ENOSPC;
 
     fusedir = fs::path::dirname(fusepath_);
 
-    rv = fs::clonepath(srcfd_branch,dstfd_branch[0],fusedir);
+    rv = fs::clonepath(srcfd_branch,dstfd_branch[0]->path,fusedir);
     if(rv == -1)
       return -ENOSPC;
 
@@ -115,7 +118,7 @@ namespace l
     if(srcfd == -1)
       return -ENOSPC;
 
-    dstfd_filepath = dstfd_branch[0];
+    dstfd_filepath = dstfd_branch[0]->path;
     fs::path::append(dstfd_filepath,fusepath_);
     std::tie(dstfd,dstfd_tmp_filepath) = fs::mktemp(dstfd_filepath,O_WRONLY);
     if(dstfd < 0)
@@ -155,6 +158,12 @@ namespace l
 
     fs::unlink(srcfd_filepath);
 
+    g_POLICY_CACHE.erase(fusepath_.c_str());
+    g_ATTR_CACHE.erase(fusepath_.c_str());
+    g_ATTR_CACHE.notify(fusepath_.c_str());
+
+    *newbranch_ = dstfd_branch[0];
+
     return rv;
   }
 }
@@ -165,19 +174,21 @@ namespace fs
   movefile(const Policy::Create &policy_,
            const Branches::CPtr &basepaths_,
            const string         &fusepath_,
-           int                   origfd_)
+           int                   origfd_,
+           const Branch        **newbranch_)
   {
-    return l::movefile(policy_,basepaths_,fusepath_,origfd_);
+    return l::movefile(policy_,basepaths_,fusepath_,origfd_,newbranch_);
   }
 
   int
   movefile_as_root(const Policy::Create &policy_,
                    const Branches::CPtr &basepaths_,
                    const string         &fusepath_,
-                   int                   origfd_)
+                   int                   origfd_,
+                   const Branch        **newbranch_)
   {
     const ugid::Set ugid(0,0);
 
-    return fs::movefile(policy_,basepaths_,fusepath_,origfd_);
+    return fs::movefile(policy_,basepaths_,fusepath_,origfd_,newbranch_);
   }
 }
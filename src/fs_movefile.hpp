@@ -28,11 +28,13 @@ namespace fs
   movefile(const Policy::Create &policy,
            const Branches::CPtr &branches,
            const std::string    &fusepath,
-           int                   origfd);
+           int                   origfd,
+           const Branch        **newbranch);
 
   int
   movefile_as_root(const Policy::Create &policy,
                    const Branches::CPtr &branches,
                    const std::string    &fusepath,
-                   int                   origfd);
+                   int                   origfd,
+                   const Branch        **newbranch);
 }
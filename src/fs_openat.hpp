@@ -21,7 +21,6 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
-#include <errno.h>
 
 namespace fs
 {
@@ -32,10 +31,17 @@ namespace fs
          const char *pathname_,
          const int   flags_)
   {
-    int rv;
-
-    rv = ::openat(dirfd_,pathname_,flags_);
+    return ::openat(dirfd_,pathname_,flags_);
+  }
 
-    return ((rv == -1) ? -errno : rv);
+  static
+  inline
+  int
+  openat(const int     dirfd_,
+         const char   *pathname_,
+         const int     flags_,
+         const mode_t  mode_)
+  {
+    return ::openat(dirfd_,pathname_,flags_,mode_);
   }
 }
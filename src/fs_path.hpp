@@ -33,6 +33,22 @@ namespace fs
 
     std::string basename(const std::string &path);
 
+    /*
+      FUSE paths are absolute. Their form relative to a branch's
+      directory descriptor for use with the *at() calls.
+    */
+    static
+    inline
+    const
+    char*
+    rel(const char *fusepath_)
+    {
+      while(*fusepath_ == '/')
+        fusepath_++;
+
+      return ((*fusepath_ == '\0') ? "." : fusepath_);
+    }
+
     static
     inline
     void
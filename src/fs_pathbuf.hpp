@@ -0,0 +1,93 @@
+/*
+  ISC License
+
+  Copyright (c) 2024, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#pragma once
+
+#include <string>
+
+#include <limits.h>
+#include <string.h>
+
+
+namespace fs
+{
+  /*
+    A branch path joined with a FUSE path built in a PATH_MAX stack
+    buffer rather than a heap allocated std::string. Anything longer,
+    which the kernel would reject anyway, overflows to the heap so
+    callers still see the same errors. Converts to `const char*` so
+    it can be handed straight to the fs:: wrappers.
+  */
+  class PathBuf
+  {
+  public:
+    PathBuf(const char *base_,
+            const char *suffix_)
+    {
+      make(base_,strlen(base_),suffix_);
+    }
+
+    PathBuf(const std::string &base_,
+            const char        *suffix_)
+    {
+      make(base_.c_str(),base_.size(),suffix_);
+    }
+
+    PathBuf(const std::string &base_,
+            const std::string &suffix_)
+    {
+      make(base_.c_str(),base_.size(),suffix_.c_str());
+    }
+
+    PathBuf(const PathBuf&) = delete;
+    PathBuf& operator=(const PathBuf&) = delete;
+
+  public:
+    const char* c_str(void) const { return _ptr; }
+    operator const char*(void) const { return _ptr; }
+    std::string str(void) const { return std::string(_ptr); }
+
+  private:
+    void
+    make(const char   *base_,
+         const size_t  baselen_,
+         const char   *suffix_)
+    {
+      size_t suffixlen;
+
+      suffixlen = strlen(suffix_);
+      if((baselen_ + suffixlen) < sizeof(_buf))
+        {
+          memcpy(_buf,base_,baselen_);
+          memcpy(&_buf[baselen_],suffix_,suffixlen + 1);
+          _ptr = _buf;
+          return;
+        }
+
+      _overflow.reserve(baselen_ + suffixlen);
+      _overflow.append(base_,baselen_);
+      _overflow.append(suffix_,suffixlen);
+      _ptr = _overflow.c_str();
+    }
+
+  private:
+    const char  *_ptr;
+    char         _buf[PATH_MAX];
+    std::string  _overflow;
+  };
+}
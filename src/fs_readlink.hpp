@@ -25,6 +25,16 @@
 
 namespace fs
 {
+  static
+  inline
+  int
+  readlink(const char   *path_,
+           char         *buf_,
+           const size_t  bufsiz_)
+  {
+    return ::readlink(path_,buf_,bufsiz_);
+  }
+
   static
   inline
   int
@@ -32,6 +42,6 @@ namespace fs
            char              *buf_,
            const size_t       bufsiz_)
   {
-    return ::readlink(path_.c_str(),buf_,bufsiz_);
+    return fs::readlink(path_.c_str(),buf_,bufsiz_);
   }
 }
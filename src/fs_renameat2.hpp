@@ -0,0 +1,67 @@
+/*
+  ISC License
+
+  Copyright (c) 2024, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#pragma once
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#if defined __linux__
+# include <sys/syscall.h>
+#endif
+
+
+namespace fs
+{
+  static
+  inline
+  int
+  renameat2(const int           olddirfd_,
+            const char         *oldpath_,
+            const int           newdirfd_,
+            const char         *newpath_,
+            const unsigned int  flags_)
+  {
+    if(flags_ == 0)
+      return ::renameat(olddirfd_,oldpath_,newdirfd_,newpath_);
+
+#if defined SYS_renameat2
+    return ::syscall(SYS_renameat2,
+                     olddirfd_,
+                     oldpath_,
+                     newdirfd_,
+                     newpath_,
+                     flags_);
+#else
+    return (errno=EINVAL,-1);
+#endif
+  }
+
+  static
+  inline
+  int
+  renameat(const int   olddirfd_,
+           const char *oldpath_,
+           const int   newdirfd_,
+           const char *newpath_)
+  {
+    return fs::renameat2(olddirfd_,oldpath_,newdirfd_,newpath_,0);
+  }
+}
@@ -0,0 +1,80 @@
+/*
+  ISC License
+
+  Copyright (c) 2024, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#pragma once
+
+#include "fs_fstatat.hpp"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#include <sys/types.h>
+
+
+namespace fs
+{
+  /*
+    statx(2) filling a struct stat. Only the basic stats are asked
+    for which is all a stat holds and lets filesystems skip fetching
+    anything more such as birth time. Falls back to fstatat on
+    systems without statx.
+  */
+  static
+  inline
+  int
+  statx(const int    dirfd_,
+        const char  *pathname_,
+        const int    flags_,
+        struct stat *st_)
+  {
+#ifdef STATX_BASIC_STATS
+    int rv;
+    struct statx stx;
+
+    rv = ::statx(dirfd_,pathname_,flags_,STATX_BASIC_STATS,&stx);
+    if(rv == -1)
+      {
+        if(errno == ENOSYS)
+          return fs::fstatat(dirfd_,pathname_,st_,flags_);
+        return -1;
+      }
+
+    st_->st_dev          = makedev(stx.stx_dev_major,stx.stx_dev_minor);
+    st_->st_ino          = stx.stx_ino;
+    st_->st_mode         = stx.stx_mode;
+    st_->st_nlink        = stx.stx_nlink;
+    st_->st_uid          = stx.stx_uid;
+    st_->st_gid          = stx.stx_gid;
+    st_->st_rdev         = makedev(stx.stx_rdev_major,stx.stx_rdev_minor);
+    st_->st_size         = stx.stx_size;
+    st_->st_blksize      = stx.stx_blksize;
+    st_->st_blocks       = stx.stx_blocks;
+    st_->st_atim.tv_sec  = stx.stx_atime.tv_sec;
+    st_->st_atim.tv_nsec = stx.stx_atime.tv_nsec;
+    st_->st_mtim.tv_sec  = stx.stx_mtime.tv_sec;
+    st_->st_mtim.tv_nsec = stx.stx_mtime.tv_nsec;
+    st_->st_ctim.tv_sec  = stx.stx_ctime.tv_sec;
+    st_->st_ctim.tv_nsec = stx.stx_ctime.tv_nsec;
+
+    return 0;
+#else
+    return fs::fstatat(dirfd_,pathname_,st_,flags_);
+#endif
+  }
+}
@@ -51,18 +51,41 @@ Func::Base::Create::to_string(void) const
   return policy.name();
 }
 
+/*
+  POLICY[:concurrent]
+*/
 int
-Func::Base::Search::from_string(const std::string &policyname_)
+Func::Base::Search::from_string(const std::string &str_)
 {
-  policy = Policies::Search::find(policyname_);
-  if(!policy)
+  bool concurrent;
+  std::string policyname;
+  std::string::size_type pos;
+  Policy::SearchImpl *impl;
+
+  pos        = str_.find(':');
+  policyname = str_.substr(0,pos);
+  concurrent = false;
+  if(pos != std::string::npos)
+    {
+      if(str_.compare(pos + 1,std::string::npos,"concurrent") != 0)
+        return -EINVAL;
+      concurrent = true;
+    }
+
+  impl = Policies::Search::find(policyname);
+  if(impl == NULL)
     return -EINVAL;
 
+  policy            = impl;
+  policy.concurrent = concurrent;
+
   return 0;
 }
 
 std::string
 Func::Base::Search::to_string(void) const
 {
+  if(policy.concurrent)
+    return policy.name() + ":concurrent";
   return policy.name();
 }
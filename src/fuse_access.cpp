@@ -17,7 +17,7 @@
 #include "config.hpp"
 #include "errno.hpp"
 #include "fs_eaccess.hpp"
-#include "fs_path.hpp"
+#include "fs_pathbuf.hpp"
 #include "ugid.hpp"
 
 #include <string>
@@ -32,19 +32,18 @@ namespace l
   static
   int
   access(const Policy::Search &searchFunc_,
-         const Branches       &branches_,
+         const Branches::CPtr &branches_,
          const char           *fusepath_,
          const int             mask_)
   {
     int rv;
-    string fullpath;
-    StrVec basepaths;
+    Branch::CPtrVec obranches;
 
-    rv = searchFunc_(branches_,fusepath_,&basepaths);
+    rv = searchFunc_(branches_,fusepath_,&obranches);
     if(rv == -1)
       return -errno;
 
-    fullpath = fs::path::make(basepaths[0],fusepath_);
+    fs::PathBuf fullpath(obranches[0]->path,fusepath_);
 
     rv = fs::eaccess(fullpath,mask_);
 
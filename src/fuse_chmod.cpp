@@ -14,10 +14,12 @@
   OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 */
 
+#include "attr_cache.hpp"
 #include "config.hpp"
 #include "errno.hpp"
+#include "fanout.hpp"
 #include "fs_lchmod.hpp"
-#include "fs_path.hpp"
+#include "fs_pathbuf.hpp"
 #include "policy_rv.hpp"
 #include "ugid.hpp"
 
@@ -35,17 +37,17 @@ namespace l
   static
   int
   get_error(const PolicyRV &prv_,
-            const string   &basepath_)
+            const Branch   *branch_)
   {
     for(int i = 0, ei = prv_.success.size(); i < ei; i++)
       {
-        if(prv_.success[i].basepath == basepath_)
+        if(prv_.success[i].branch == branch_)
           return prv_.success[i].rv;
       }
 
     for(int i = 0, ei = prv_.error.size(); i < ei; i++)
       {
-        if(prv_.error[i].basepath == basepath_)
+        if(prv_.error[i].branch == branch_)
           return prv_.error[i].rv;
       }
 
@@ -53,63 +55,60 @@ namespace l
   }
 
   static
-  void
-  chmod_loop_core(const string &basepath_,
+  int
+  chmod_loop_core(const Branch &branch_,
                   const char   *fusepath_,
-                  const mode_t  mode_,
-                  PolicyRV     *prv_)
+                  const mode_t  mode_)
   {
-    string fullpath;
-
-    fullpath = fs::path::make(basepath_,fusepath_);
-
     errno = 0;
-    fs::lchmod(fullpath,mode_);
+    fs::lchmod(fs::PathBuf(branch_.path,fusepath_),mode_);
 
-    prv_->insert(errno,basepath_);
+    return errno;
   }
 
   static
   void
-  chmod_loop(const StrVec &basepaths_,
-             const char   *fusepath_,
-             const mode_t  mode_,
-             PolicyRV     *prv_)
+  chmod_loop(const Branch::CPtrVec &branches_,
+             const char            *fusepath_,
+             const mode_t           mode_,
+             PolicyRV              *prv_)
   {
-    for(size_t i = 0, ei = basepaths_.size(); i != ei; i++)
-      {
-        l::chmod_loop_core(basepaths_[i],fusepath_,mode_,prv_);
-      }
+    auto func = [&](const Branch &branch_)
+    {
+      return l::chmod_loop_core(branch_,fusepath_,mode_);
+    };
+
+    fanout::for_each(branches_,func,prv_);
   }
 
   static
   int
   chmod(const Policy::Action &actionFunc_,
         const Policy::Search &searchFunc_,
-        const Branches       &branches_,
+        const Branches::CPtr &branches_,
         const char           *fusepath_,
         const mode_t          mode_)
   {
     int rv;
     PolicyRV prv;
-    StrVec basepaths;
+    Branch::CPtrVec obranches;
 
-    rv = actionFunc_(branches_,fusepath_,&basepaths);
+    rv = actionFunc_(branches_,fusepath_,&obranches);
     if(rv == -1)
       return -errno;
 
-    l::chmod_loop(basepaths,fusepath_,mode_,&prv);
+    l::chmod_loop(obranches,fusepath_,mode_,&prv);
     if(prv.error.empty())
       return 0;
     if(prv.success.empty())
       return prv.error[0].rv;
 
-    basepaths.clear();
-    rv = searchFunc_(branches_,fusepath_,&basepaths);
+    obranches.clear();
+    rv = searchFunc_(branches_,fusepath_,&obranches);
     if(rv == -1)
       return -errno;
 
-    return l::get_error(prv,basepaths[0]);
+    return l::get_error(prv,obranches[0]);
   }
 }
 
@@ -119,14 +118,19 @@ namespace FUSE
   chmod(const char *fusepath_,
         mode_t      mode_)
   {
+    int rv;
     Config::Read cfg;
     const fuse_context *fc  = fuse_get_context();
     const ugid::Set     ugid(fc->uid,fc->gid);
 
-    return l::chmod(cfg->func.chmod.policy,
-                    cfg->func.getattr.policy,
-                    cfg->branches,
-                    fusepath_,
-                    mode_);
+    rv = l::chmod(cfg->func.chmod.policy,
+                  cfg->func.getattr.policy,
+                  cfg->branches,
+                  fusepath_,
+                  mode_);
+
+    g_ATTR_CACHE.erase(fusepath_);
+
+    return rv;
   }
 }
@@ -14,6 +14,7 @@
   OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 */
 
+#include "attr_cache.hpp"
 #include "errno.hpp"
 #include "fileinfo.hpp"
 #include "fs_copy_file_range.hpp"
@@ -57,14 +58,18 @@ namespace FUSE
                   size_t                  size_,
                   int                     flags_)
   {
+    ssize_t rv;
     FileInfo *fi_in  = reinterpret_cast<FileInfo*>(ffi_in_->fh);
     FileInfo *fi_out = reinterpret_cast<FileInfo*>(ffi_out_->fh);
 
-    return l::copy_file_range(fi_in->fd,
-                              offset_in_,
-                              fi_out->fd,
-                              offset_out_,
-                              size_,
-                              flags_);
+    rv = l::copy_file_range(fi_in->fd,
+                            offset_in_,
+                            fi_out->fd,
+                            offset_out_,
+                            size_,
+                            flags_);
+    g_ATTR_CACHE.erase(fi_out->fusepath.c_str());
+
+    return rv;
   }
 }
@@ -14,6 +14,7 @@
   OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 */
 
+#include "attr_cache.hpp"
 #include "config.hpp"
 #include "errno.hpp"
 #include "fileinfo.hpp"
@@ -21,6 +22,9 @@
 #include "fs_clonepath.hpp"
 #include "fs_open.hpp"
 #include "fs_path.hpp"
+#include "fs_pathbuf.hpp"
+#include "passthrough.hpp"
+#include "policy_cache.hpp"
 #include "procfs_get_name.hpp"
 #include "ugid.hpp"
 
@@ -134,10 +138,10 @@ namespace l
 
   static
   int
-  create_core(const std::string &fullpath_,
-              mode_t             mode_,
-              const mode_t       umask_,
-              const int          flags_)
+  create_core(const char   *fullpath_,
+              mode_t        mode_,
+              const mode_t  umask_,
+              const int     flags_)
   {
     if(!fs::acl::dir_has_defaults(fullpath_))
       mode_ &= ~umask_;
@@ -147,23 +151,28 @@ namespace l
 
   static
   int
-  create_core(const std::string &createpath_,
-              const char        *fusepath_,
-              fuse_file_info_t  *ffi_,
-              const mode_t       mode_,
-              const mode_t       umask_)
+  create_core(const Branch          &branch_,
+              const char            *fusepath_,
+              fuse_file_info_t      *ffi_,
+              const mode_t           mode_,
+              const mode_t           umask_,
+              const passthrough::IO  passthrough_)
   {
     int rv;
+    uint64_t start;
     FileInfo *fi;
-    std::string fullpath;
-
-    fullpath = fs::path::make(createpath_,fusepath_);
+    fs::PathBuf fullpath(branch_.path,fusepath_);
 
+    start = BranchStats::now();
     rv = l::create_core(fullpath,mode_,umask_,ffi_->flags);
+    branch_.stats->record(start,((rv == -1) && BranchStats::fault(errno)));
     if(rv == -1)
       return -errno;
 
     fi = new FileInfo(rv,fusepath_,ffi_->direct_io);
+    fi->writing_to(branch_.space,branch_.stats);
+
+    passthrough::open(fi,ffi_,passthrough_);
 
     ffi_->fh = reinterpret_cast<uint64_t>(fi);
 
@@ -172,39 +181,42 @@ namespace l
 
   static
   int
-  create(const Policy::Search &searchFunc_,
-         const Policy::Create &createFunc_,
-         const Branches       &branches_,
-         const char           *fusepath_,
-         fuse_file_info_t     *ffi_,
-         const mode_t          mode_,
-         const mode_t          umask_)
+  create(const Policy::Search  &searchFunc_,
+         const Policy::Create  &createFunc_,
+         const Branches::CPtr  &branches_,
+         const char            *fusepath_,
+         fuse_file_info_t      *ffi_,
+         const mode_t           mode_,
+         const mode_t           umask_,
+         const passthrough::IO  passthrough_)
   {
     int rv;
-    std::string fullpath;
     std::string fusedirpath;
-    StrVec createpaths;
-    StrVec existingpaths;
+    Branch::CPtrVec createbranches;
+    Branch::CPtrVec existingbranches;
 
     fusedirpath = fs::path::dirname(fusepath_);
 
-    rv = searchFunc_(branches_,fusedirpath,&existingpaths);
+    rv = searchFunc_(branches_,fusedirpath,&existingbranches);
     if(rv == -1)
       return -errno;
 
-    rv = createFunc_(branches_,fusedirpath,&createpaths);
+    rv = createFunc_(branches_,fusedirpath,&createbranches);
     if(rv == -1)
       return -errno;
 
-    rv = fs::clonepath_as_root(existingpaths[0],createpaths[0],fusedirpath);
+    rv = fs::clonepath_as_root(existingbranches[0]->path,
+                               createbranches[0]->path,
+                               fusedirpath);
     if(rv == -1)
       return -errno;
 
-    return l::create_core(createpaths[0],
+    return l::create_core(*createbranches[0],
                           fusepath_,
                           ffi_,
                           mode_,
-                          umask_);
+                          umask_,
+                          passthrough_);
   }
 }
 
@@ -216,6 +228,7 @@ namespace FUSE
          fuse_file_info_t *ffi_)
   {
     int rv;
+    passthrough::IO passthrough;
     Config::Read cfg;
     const fuse_context *fc = fuse_get_context();
     const ugid::Set     ugid(fc->uid,fc->gid);
@@ -228,13 +241,16 @@ namespace FUSE
     ffi_->noflush = !l::calculate_flush(cfg->flushonclose,
                                         ffi_->flags);
 
+    passthrough = passthrough::io(cfg,ffi_);
+
     rv = l::create(cfg->func.getattr.policy,
                    cfg->func.create.policy,
                    cfg->branches,
                    fusepath_,
                    ffi_,
                    mode_,
-                   fc->umask);
+                   fc->umask,
+                   passthrough);
     if(rv == -EROFS)
       {
         Config::Write()->branches.find_and_set_mode_ro();
@@ -244,9 +260,13 @@ namespace FUSE
                        fusepath_,
                        ffi_,
                        mode_,
-                       fc->umask);
+                       fc->umask,
+                       passthrough);
       }
 
+    g_POLICY_CACHE.erase(fusepath_);
+    g_ATTR_CACHE.erase_entry(fusepath_);
+
     return rv;
   }
 }
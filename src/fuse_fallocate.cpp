@@ -14,6 +14,7 @@
   OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 */
 
+#include "attr_cache.hpp"
 #include "errno.hpp"
 #include "fileinfo.hpp"
 #include "fs_fallocate.hpp"
@@ -46,11 +47,15 @@ namespace FUSE
             off_t                   offset_,
             off_t                   len_)
   {
+    int rv;
     FileInfo *fi = reinterpret_cast<FileInfo*>(ffi_->fh);
 
-    return l::fallocate(fi->fd,
-                        mode_,
-                        offset_,
-                        len_);
+    rv = l::fallocate(fi->fd,
+                      mode_,
+                      offset_,
+                      len_);
+    g_ATTR_CACHE.erase(fi->fusepath.c_str());
+
+    return rv;
   }
 }
@@ -14,6 +14,7 @@
   OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 */
 
+#include "attr_cache.hpp"
 #include "errno.hpp"
 #include "fileinfo.hpp"
 #include "fs_fchmod.hpp"
@@ -44,8 +45,12 @@ namespace FUSE
   fchmod(const fuse_file_info_t *ffi_,
          const mode_t            mode_)
   {
+    int rv;
     FileInfo *fi = reinterpret_cast<FileInfo*>(ffi_->fh);
 
-    return l::fchmod(fi->fd,mode_);
+    rv = l::fchmod(fi->fd,mode_);
+    g_ATTR_CACHE.erase(fi->fusepath.c_str());
+
+    return rv;
   }
 }
@@ -14,6 +14,7 @@
   OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 */
 
+#include "attr_cache.hpp"
 #include "errno.hpp"
 #include "fileinfo.hpp"
 #include "fs_fchown.hpp"
@@ -48,8 +49,12 @@ namespace FUSE
          const uid_t             uid_,
          const gid_t             gid_)
   {
+    int rv;
     FileInfo *fi = reinterpret_cast<FileInfo*>(ffi_->fh);
 
-    return l::fchown(fi->fd,uid_,gid_);
+    rv = l::fchown(fi->fd,uid_,gid_);
+    g_ATTR_CACHE.erase(fi->fusepath.c_str());
+
+    return rv;
   }
 }
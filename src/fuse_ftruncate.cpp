@@ -14,6 +14,7 @@
   OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 */
 
+#include "attr_cache.hpp"
 #include "errno.hpp"
 #include "fileinfo.hpp"
 #include "fs_ftruncate.hpp"
@@ -42,8 +43,12 @@ namespace FUSE
   ftruncate(const fuse_file_info_t *ffi_,
             off_t                   size_)
   {
+    int rv;
     FileInfo *fi = reinterpret_cast<FileInfo*>(ffi_->fh);
 
-    return l::ftruncate(fi->fd,size_);
+    rv = l::ftruncate(fi->fd,size_);
+    g_ATTR_CACHE.erase(fi->fusepath.c_str());
+
+    return rv;
   }
 }
@@ -14,6 +14,7 @@
   OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 */
 
+#include "attr_cache.hpp"
 #include "errno.hpp"
 #include "fileinfo.hpp"
 #include "fs_futimens.hpp"
@@ -46,8 +47,12 @@ namespace FUSE
   futimens(const fuse_file_info_t *ffi_,
            const struct timespec   ts_[2])
   {
+    int rv;
     FileInfo *fi = reinterpret_cast<FileInfo*>(ffi_->fh);
 
-    return l::futimens(fi->fd,ts_);
+    rv = l::futimens(fi->fd,ts_);
+    g_ATTR_CACHE.erase(fi->fusepath.c_str());
+
+    return rv;
   }
 }
@@ -14,12 +14,16 @@
   OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 */
 
+#include "attr_cache.hpp"
 #include "config.hpp"
 #include "errno.hpp"
+#include "fs_fstatat.hpp"
 #include "fs_inode.hpp"
 #include "fs_lstat.hpp"
 #include "fs_path.hpp"
+#include "fs_pathbuf.hpp"
 #include "fs_stat.hpp"
+#include "policy_cache.hpp"
 #include "symlinkify.hpp"
 #include "ugid.hpp"
 
@@ -34,8 +38,8 @@ namespace l
 {
   static
   void
-  set_stat_if_leads_to_dir(const std::string &path_,
-                           struct stat       *st_)
+  set_stat_if_leads_to_dir(const char  *path_,
+                           struct stat *st_)
   {
     int rv;
     struct stat st;
@@ -52,8 +56,8 @@ namespace l
 
   static
   void
-  set_stat_if_leads_to_reg(const std::string &path_,
-                           struct stat       *st_)
+  set_stat_if_leads_to_reg(const char  *path_,
+                           struct stat *st_)
   {
     int rv;
     struct stat st;
@@ -93,10 +97,34 @@ namespace l
     return 0;
   }
 
+  static
+  int
+  stat(const Branch &branch_,
+       const char   *fusepath_,
+       struct stat  *st_,
+       const int     flags_)
+  {
+    int rv;
+    int dirfd;
+    uint64_t start;
+
+    start = BranchStats::now();
+    dirfd = branch_.fd();
+    if(dirfd >= 0)
+      rv = fs::fstatat(dirfd,fs::path::rel(fusepath_),st_,flags_);
+    else if(flags_ & AT_SYMLINK_NOFOLLOW)
+      rv = fs::lstat(fs::PathBuf(branch_.path,fusepath_),st_);
+    else
+      rv = fs::stat(fs::PathBuf(branch_.path,fusepath_),st_);
+    branch_.stats->record(start,((rv == -1) && BranchStats::fault(errno)));
+
+    return rv;
+  }
+
   static
   int
   getattr(const Policy::Search &searchFunc_,
-          const Branches       &branches_,
+          const Branches::CPtr &branches_,
           const char           *fusepath_,
           struct stat          *st_,
           const bool            symlinkify_,
@@ -104,34 +132,34 @@ namespace l
           FollowSymlinks        followsymlinks_)
   {
     int rv;
-    string fullpath;
-    StrVec basepaths;
+    const Branch *branch;
+    Branch::CPtrVec obranches;
 
-    rv = searchFunc_(branches_,fusepath_,&basepaths);
+    rv = g_POLICY_CACHE(searchFunc_,branches_,fusepath_,&obranches);
     if(rv == -1)
       return -errno;
 
-    fullpath = fs::path::make(basepaths[0],fusepath_);
+    branch = obranches[0];
 
     switch(followsymlinks_)
       {
       case FollowSymlinks::ENUM::NEVER:
-        rv = fs::lstat(fullpath,st_);
+        rv = l::stat(*branch,fusepath_,st_,AT_SYMLINK_NOFOLLOW);
         break;
       case FollowSymlinks::ENUM::DIRECTORY:
-        rv = fs::lstat(fullpath,st_);
+        rv = l::stat(*branch,fusepath_,st_,AT_SYMLINK_NOFOLLOW);
         if(S_ISLNK(st_->st_mode))
-          l::set_stat_if_leads_to_dir(fullpath,st_);
+          l::set_stat_if_leads_to_dir(fs::PathBuf(branch->path,fusepath_),st_);
         break;
       case FollowSymlinks::ENUM::REGULAR:
-        rv = fs::lstat(fullpath,st_);
+        rv = l::stat(*branch,fusepath_,st_,AT_SYMLINK_NOFOLLOW);
         if(S_ISLNK(st_->st_mode))
-          l::set_stat_if_leads_to_reg(fullpath,st_);
+          l::set_stat_if_leads_to_reg(fs::PathBuf(branch->path,fusepath_),st_);
         break;
       case FollowSymlinks::ENUM::ALL:
-        rv = fs::stat(fullpath,st_);
+        rv = l::stat(*branch,fusepath_,st_,0);
         if(rv != 0)
-          rv = fs::lstat(fullpath,st_);
+          rv = l::stat(*branch,fusepath_,st_,AT_SYMLINK_NOFOLLOW);
         break;
       }
 
@@ -139,13 +167,42 @@ namespace l
       return -errno;
 
     if(symlinkify_ && symlinkify::can_be_symlink(*st_,symlinkify_timeout_))
-      symlinkify::convert(fullpath,st_);
+      symlinkify::convert(fs::path::make(branch->path,fusepath_),st_);
 
     fs::inode::calc(fusepath_,st_);
 
     return 0;
   }
 
+  static
+  int
+  getattr_cached(const Config::Read &cfg_,
+                 const fuse_context *fc_,
+                 const char         *fusepath_,
+                 struct stat        *st_)
+  {
+    int rv;
+    int error;
+    uint64_t gen;
+    uint64_t branches_id;
+
+    branches_id = cfg_->branches->id();
+    if(g_ATTR_CACHE.lookup(fusepath_,branches_id,fc_->uid,fc_->gid,st_,&error,&gen))
+      return -error;
+
+    rv = l::getattr(cfg_->func.getattr.policy,
+                    cfg_->branches,
+                    fusepath_,
+                    st_,
+                    cfg_->symlinkify,
+                    cfg_->symlinkify_timeout,
+                    cfg_->follow_symlinks);
+    if((rv == 0) || (rv == -ENOENT))
+      g_ATTR_CACHE.insert(fusepath_,gen,branches_id,fc_->uid,fc_->gid,-rv,st_);
+
+    return rv;
+  }
+
   int
   getattr(const char      *fusepath_,
           struct stat     *st_,
@@ -156,13 +213,16 @@ namespace l
     const fuse_context *fc = fuse_get_context();
     const ugid::Set     ugid(fc->uid,fc->gid);
 
-    rv = l::getattr(cfg->func.getattr.policy,
-                    cfg->branches,
-                    fusepath_,
-                    st_,
-                    cfg->symlinkify,
-                    cfg->symlinkify_timeout,
-                    cfg->follow_symlinks);
+    if(g_ATTR_CACHE.enabled())
+      rv = l::getattr_cached(cfg,fc,fusepath_,st_);
+    else
+      rv = l::getattr(cfg->func.getattr.policy,
+                      cfg->branches,
+                      fusepath_,
+                      st_,
+                      cfg->symlinkify,
+                      cfg->symlinkify_timeout,
+                      cfg->follow_symlinks);
 
     timeout_->entry = ((rv >= 0) ?
                        cfg->cache_entry :
@@ -139,7 +139,7 @@ namespace l
   getxattr_user_mergerfs(const string         &basepath_,
                          const char           *fusepath_,
                          const string         &fullpath_,
-                         const Branches       &branches_,
+                         const Branches::CPtr &branches_,
                          const char           *attrname_,
                          char                 *buf_,
                          const size_t          count_)
@@ -163,7 +163,7 @@ namespace l
   static
   int
   getxattr(const Policy::Search &searchFunc_,
-           const Branches       &branches_,
+           const Branches::CPtr &branches_,
            const char           *fusepath_,
            const char           *attrname_,
            char                 *buf_,
@@ -171,16 +171,16 @@ namespace l
   {
     int rv;
     string fullpath;
-    StrVec basepaths;
+    Branch::CPtrVec obranches;
 
-    rv = searchFunc_(branches_,fusepath_,&basepaths);
+    rv = searchFunc_(branches_,fusepath_,&obranches);
     if(rv == -1)
       return -errno;
 
-    fullpath = fs::path::make(basepaths[0],fusepath_);
+    fullpath = fs::path::make(obranches[0]->path,fusepath_);
 
     if(str::startswith(attrname_,"user.mergerfs."))
-      return l::getxattr_user_mergerfs(basepaths[0],
+      return l::getxattr_user_mergerfs(obranches[0]->path,
                                        fusepath_,
                                        fullpath,
                                        branches_,
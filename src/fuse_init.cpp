@@ -14,6 +14,7 @@
   OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 */
 
+#include "branch_space.hpp"
 #include "config.hpp"
 #include "ugid.hpp"
 #include "fs_readahead.hpp"
@@ -84,6 +85,54 @@ namespace l
       }
   }
 
+  /*
+    The kernel will not enable passthrough if writeback caching is
+    also requested so passthrough, being explicitly asked for, wins.
+  */
+  static
+  void
+  want_if_capable_passthrough(fuse_conn_info *conn_,
+                              Config::Write  &cfg_)
+  {
+    if(cfg_->passthrough == Passthrough::ENUM::OFF)
+      return;
+
+    if(!l::capable(conn_,FUSE_CAP_PASSTHROUGH))
+      {
+        syslog_warning("passthrough not supported by kernel - disabling");
+        cfg_->passthrough = Passthrough::ENUM::OFF;
+        return;
+      }
+
+    if(cfg_->writeback_cache)
+      {
+        syslog_warning("passthrough and cache.writeback are mutually exclusive"
+                       " - disabling cache.writeback");
+        cfg_->writeback_cache = false;
+      }
+
+    l::want(conn_,FUSE_CAP_PASSTHROUGH);
+  }
+
+  static
+  void
+  want_if_capable_io_uring(fuse_conn_info *conn_,
+                           Config::Write  &cfg_)
+  {
+    if(cfg_->fuse_loop != FuseLoop::ENUM::IO_URING)
+      return;
+
+    if(!l::capable(conn_,FUSE_CAP_OVER_IO_URING))
+      {
+        syslog_warning("fuse-loop=io_uring not supported by kernel"
+                       " - using threads");
+        cfg_->fuse_loop = FuseLoop::ENUM::THREADS;
+        return;
+      }
+
+    l::want(conn_,FUSE_CAP_OVER_IO_URING);
+  }
+
   static
   void
   readahead(const std::string path_,
@@ -151,13 +200,16 @@ namespace FUSE
     l::want_if_capable(conn_,FUSE_CAP_PARALLEL_DIROPS);
     l::want_if_capable(conn_,FUSE_CAP_POSIX_ACL,&cfg->posix_acl);
     l::want_if_capable(conn_,FUSE_CAP_READDIR_PLUS,&cfg->readdirplus);
+    l::want_if_capable_passthrough(conn_,cfg);
     l::want_if_capable(conn_,FUSE_CAP_WRITEBACK_CACHE,&cfg->writeback_cache);
     //    l::want_if_capable(conn_,FUSE_CAP_READDIR_PLUS_AUTO);
     l::want_if_capable_max_pages(conn_,cfg);
+    l::want_if_capable_io_uring(conn_,cfg);
     conn_->want &= ~FUSE_CAP_POSIX_LOCKS;
     conn_->want &= ~FUSE_CAP_FLOCK_LOCKS;
 
     l::spawn_thread_to_set_readahead();
+    BranchSpace::spawn_refresher();
 
     return NULL;
   }
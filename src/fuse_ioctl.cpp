@@ -24,6 +24,7 @@
 #include "fs_ioctl.hpp"
 #include "fs_open.hpp"
 #include "fs_path.hpp"
+#include "fs_pathbuf.hpp"
 #include "gidcache.hpp"
 #include "str.hpp"
 #include "ugid.hpp"
@@ -138,7 +139,7 @@ namespace l
   static
   int
   ioctl_dir_base(const Policy::Search &searchFunc_,
-                 const Branches       &branches_,
+                 const Branches::CPtr &branches_,
                  const char           *fusepath_,
                  const uint32_t        cmd_,
                  void                 *data_,
@@ -146,14 +147,13 @@ namespace l
   {
     int fd;
     int rv;
-    string fullpath;
-    StrVec basepaths;
+    Branch::CPtrVec obranches;
 
-    rv = searchFunc_(branches_,fusepath_,&basepaths);
+    rv = searchFunc_(branches_,fusepath_,&obranches);
     if(rv == -1)
       return -errno;
 
-    fullpath = fs::path::make(basepaths[0],fusepath_);
+    fs::PathBuf fullpath(obranches[0]->path,fusepath_);
 
     fd = fs::open(fullpath,O_RDONLY|O_NOATIME|O_NONBLOCK);
     if(fd == -1)
@@ -205,18 +205,18 @@ namespace l
   static
   int
   file_basepath(const Policy::Search &searchFunc_,
-                const Branches       &branches_,
+                const Branches::CPtr &branches_,
                 const char           *fusepath_,
                 void                 *data_)
   {
     int rv;
-    StrVec basepaths;
+    Branch::CPtrVec obranches;
 
-    rv = searchFunc_(branches_,fusepath_,&basepaths);
+    rv = searchFunc_(branches_,fusepath_,&obranches);
     if(rv == -1)
       return -errno;
 
-    return l::strcpy(basepaths[0],data_);
+    return l::strcpy(obranches[0]->path,data_);
   }
 
   static
@@ -246,19 +246,19 @@ namespace l
   static
   int
   file_fullpath(const Policy::Search &searchFunc_,
-                const Branches       &branches_,
+                const Branches::CPtr &branches_,
                 const string         &fusepath_,
                 void                 *data_)
   {
     int rv;
     string fullpath;
-    StrVec basepaths;
+    Branch::CPtrVec obranches;
 
-    rv = searchFunc_(branches_,fusepath_,&basepaths);
+    rv = searchFunc_(branches_,fusepath_,&obranches);
     if(rv == -1)
       return -errno;
 
-    fullpath = fs::path::make(basepaths[0],fusepath_);
+    fullpath = fs::path::make(obranches[0]->path,fusepath_);
 
     return l::strcpy(fullpath,data_);
   }
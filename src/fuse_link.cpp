@@ -14,15 +14,18 @@
   OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 */
 
+#include "attr_cache.hpp"
 #include "config.hpp"
 #include "errno.hpp"
 #include "fs_clonepath.hpp"
 #include "fs_link.hpp"
 #include "fs_lstat.hpp"
 #include "fs_path.hpp"
+#include "fs_pathbuf.hpp"
 #include "fuse_getattr.hpp"
 #include "fuse_symlink.hpp"
 #include "ghc/filesystem.hpp"
+#include "policy_cache.hpp"
 #include "ugid.hpp"
 
 #include "fuse.h"
@@ -58,27 +61,25 @@ namespace l
 {
   static
   int
-  link_create_path_loop(const StrVec &oldbasepaths_,
-                        const string &newbasepath_,
-                        const char   *oldfusepath_,
-                        const char   *newfusepath_,
-                        const string &newfusedirpath_)
+  link_create_path_loop(const Branch::CPtrVec &oldbranches_,
+                        const Branch          &newbranch_,
+                        const char            *oldfusepath_,
+                        const char            *newfusepath_,
+                        const string          &newfusedirpath_)
   {
     int rv;
     int error;
-    string oldfullpath;
-    string newfullpath;
 
     error = -1;
-    for(auto &oldbasepath : oldbasepaths_)
+    for(const Branch *oldbranch : oldbranches_)
       {
-        oldfullpath = fs::path::make(oldbasepath,oldfusepath_);
-        newfullpath = fs::path::make(oldbasepath,newfusepath_);
+        fs::PathBuf oldfullpath(oldbranch->path,oldfusepath_);
+        fs::PathBuf newfullpath(oldbranch->path,newfusepath_);
 
         rv = fs::link(oldfullpath,newfullpath);
         if((rv == -1) && (errno == ENOENT))
           {
-            rv = fs::clonepath_as_root(newbasepath_,oldbasepath,newfusedirpath_);
+            rv = fs::clonepath_as_root(newbranch_.path,oldbranch->path,newfusedirpath_);
             if(rv == 0)
               rv = fs::link(oldfullpath,newfullpath);
           }
@@ -93,44 +94,41 @@ namespace l
   int
   link_create_path(const Policy::Search &searchFunc_,
                    const Policy::Action &actionFunc_,
-                   const Branches       &branches_,
+                   const Branches::CPtr &branches_,
                    const char           *oldfusepath_,
                    const char           *newfusepath_)
   {
     int rv;
     string newfusedirpath;
-    StrVec oldbasepaths;
-    StrVec newbasepaths;
+    Branch::CPtrVec oldbranches;
+    Branch::CPtrVec newbranches;
 
-    rv = actionFunc_(branches_,oldfusepath_,&oldbasepaths);
+    rv = actionFunc_(branches_,oldfusepath_,&oldbranches);
     if(rv == -1)
       return -errno;
 
     newfusedirpath = fs::path::dirname(newfusepath_);
 
-    rv = searchFunc_(branches_,newfusedirpath,&newbasepaths);
+    rv = searchFunc_(branches_,newfusedirpath,&newbranches);
     if(rv == -1)
       return -errno;
 
-    return l::link_create_path_loop(oldbasepaths,newbasepaths[0],
+    return l::link_create_path_loop(oldbranches,*newbranches[0],
                                     oldfusepath_,newfusepath_,
                                     newfusedirpath);
   }
 
   static
   int
-  link_preserve_path_core(const string &oldbasepath_,
+  link_preserve_path_core(const Branch &oldbranch_,
                           const char   *oldfusepath_,
                           const char   *newfusepath_,
                           struct stat  *st_,
                           const int     error_)
   {
     int rv;
-    string oldfullpath;
-    string newfullpath;
-
-    oldfullpath = fs::path::make(oldbasepath_,oldfusepath_);
-    newfullpath = fs::path::make(oldbasepath_,newfusepath_);
+    fs::PathBuf oldfullpath(oldbranch_.path,oldfusepath_);
+    fs::PathBuf newfullpath(oldbranch_.path,newfusepath_);
 
     rv = fs::link(oldfullpath,newfullpath);
     if((rv == -1) && (errno == ENOENT))
@@ -143,17 +141,17 @@ namespace l
 
   static
   int
-  link_preserve_path_loop(const StrVec &oldbasepaths_,
-                          const char   *oldfusepath_,
-                          const char   *newfusepath_,
-                          struct stat  *st_)
+  link_preserve_path_loop(const Branch::CPtrVec &oldbranches_,
+                          const char            *oldfusepath_,
+                          const char            *newfusepath_,
+                          struct stat           *st_)
   {
     int error;
 
     error = -1;
-    for(auto &oldbasepath : oldbasepaths_)
+    for(const Branch *oldbranch : oldbranches_)
       {
-        error = l::link_preserve_path_core(oldbasepath,
+        error = l::link_preserve_path_core(*oldbranch,
                                            oldfusepath_,
                                            newfusepath_,
                                            st_,
@@ -166,19 +164,19 @@ namespace l
   static
   int
   link_preserve_path(const Policy::Action &actionFunc_,
-                     const Branches       &branches_,
+                     const Branches::CPtr &branches_,
                      const char           *oldfusepath_,
                      const char           *newfusepath_,
                      struct stat          *st_)
   {
     int rv;
-    StrVec oldbasepaths;
+    Branch::CPtrVec oldbranches;
 
-    rv = actionFunc_(branches_,oldfusepath_,&oldbasepaths);
+    rv = actionFunc_(branches_,oldfusepath_,&oldbranches);
     if(rv == -1)
       return -errno;
 
-    return l::link_preserve_path_loop(oldbasepaths,
+    return l::link_preserve_path_loop(oldbranches,
                                       oldfusepath_,
                                       newfusepath_,
                                       st_);
@@ -219,6 +217,11 @@ namespace l
     if(rv < 0)
       return rv;
 
+    // Drop cached negatives of newpath before looking it up
+    g_POLICY_CACHE.erase(newpath_);
+    g_ATTR_CACHE.erase(oldpath_);
+    g_ATTR_CACHE.erase_entry(newpath_);
+
     return FUSE::getattr(newpath_,st_,timeouts_);
   }
 
@@ -256,14 +259,14 @@ namespace l
                               fuse_timeouts_t      *timeouts_)
   {
     int rv;
-    StrVec basepaths;
+    Branch::CPtrVec obranches;
     std::string target;
 
-    rv = openPolicy_(branches_,oldpath_,&basepaths);
+    rv = openPolicy_(branches_,oldpath_,&obranches);
     if(rv == -1)
       return -errno;
 
-    target = fs::path::make(basepaths[0],oldpath_);
+    target = fs::path::make(obranches[0]->path,oldpath_);
 
     rv = FUSE::symlink(target.c_str(),newpath_);
     if(rv == 0)
@@ -354,6 +357,10 @@ namespace FUSE
     if(rv == -EXDEV)
       rv = l::link_exdev(cfg,oldpath_,newpath_,st_,timeouts_);
 
+    g_POLICY_CACHE.erase(newpath_);
+    g_ATTR_CACHE.erase(oldpath_);
+    g_ATTR_CACHE.erase_entry(newpath_);
+
     return rv;
   }
 }
@@ -18,7 +18,7 @@
 #include "config.hpp"
 #include "errno.hpp"
 #include "fs_llistxattr.hpp"
-#include "fs_path.hpp"
+#include "fs_pathbuf.hpp"
 #include "ugid.hpp"
 #include "xattr.hpp"
 
@@ -56,20 +56,19 @@ namespace l
   static
   int
   listxattr(const Policy::Search &searchFunc_,
-            const Branches       &branches_,
+            const Branches::CPtr &branches_,
             const char           *fusepath_,
             char                 *list_,
             const size_t          size_)
   {
     int rv;
-    string fullpath;
-    StrVec basepaths;
+    Branch::CPtrVec obranches;
 
-    rv = searchFunc_(branches_,fusepath_,&basepaths);
+    rv = searchFunc_(branches_,fusepath_,&obranches);
     if(rv == -1)
       return -errno;
 
-    fullpath = fs::path::make(basepaths[0],fusepath_);
+    fs::PathBuf fullpath(obranches[0]->path,fusepath_);
 
     rv = fs::llistxattr(fullpath,list_,size_);
 
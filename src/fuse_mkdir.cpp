@@ -14,13 +14,18 @@
   OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 */
 
+#include "attr_cache.hpp"
 #include "config.hpp"
 #include "errno.hpp"
 #include "fs_acl.hpp"
 #include "fs_clonepath.hpp"
+#include "fs_dirpresence.hpp"
 #include "fs_mkdir.hpp"
+#include "fs_mkdirat.hpp"
 #include "fs_path.hpp"
+#include "fs_pathbuf.hpp"
 #include "policy.hpp"
+#include "policy_cache.hpp"
 #include "ugid.hpp"
 
 #include "fuse.h"
@@ -54,54 +59,63 @@ namespace l
 {
   static
   int
-  mkdir_core(const string &fullpath_,
+  mkdir_core(const Branch &branch_,
+             const char   *fullpath_,
+             const char   *fusepath_,
              mode_t        mode_,
              const mode_t  umask_)
   {
     if(!fs::acl::dir_has_defaults(fullpath_))
       mode_ &= ~umask_;
 
+    if(branch_.fd() >= 0)
+      return fs::mkdirat(branch_.fd(),fs::path::rel(fusepath_),mode_);
+
     return fs::mkdir(fullpath_,mode_);
   }
 
   static
   int
-  mkdir_loop_core(const string &createpath_,
+  mkdir_loop_core(const Branch &branch_,
                   const char   *fusepath_,
                   const mode_t  mode_,
                   const mode_t  umask_,
                   const int     error_)
   {
     int rv;
-    string fullpath;
-
-    fullpath = fs::path::make(createpath_,fusepath_);
+    fs::PathBuf fullpath(branch_.path,fusepath_);
 
-    rv = l::mkdir_core(fullpath,mode_,umask_);
+    rv = l::mkdir_core(branch_,
+                       fullpath,
+                       fusepath_,
+                       mode_,
+                       umask_);
+    if(rv != -1)
+      fs::dirpresence::set(branch_.path,fusepath_,true);
 
     return error::calc(rv,error_,errno);
   }
 
   static
   int
-  mkdir_loop(const string &existingpath_,
-             const StrVec &createpaths_,
-             const char   *fusepath_,
-             const string &fusedirpath_,
-             const mode_t  mode_,
-             const mode_t  umask_)
+  mkdir_loop(const Branch          &existingbranch_,
+             const Branch::CPtrVec &createbranches_,
+             const char            *fusepath_,
+             const string          &fusedirpath_,
+             const mode_t           mode_,
+             const mode_t           umask_)
   {
     int rv;
     int error;
 
     error = -1;
-    for(size_t i = 0, ei = createpaths_.size(); i != ei; i++)
+    for(const Branch *createbranch : createbranches_)
       {
-        rv = fs::clonepath_as_root(existingpath_,createpaths_[i],fusedirpath_);
+        rv = fs::clonepath_as_root(existingbranch_.path,createbranch->path,fusedirpath_);
         if(rv == -1)
           error = error::calc(rv,error,errno);
         else
-          error = l::mkdir_loop_core(createpaths_[i],
+          error = l::mkdir_loop_core(*createbranch,
                                      fusepath_,
                                      mode_,
                                      umask_,
@@ -115,28 +129,28 @@ namespace l
   int
   mkdir(const Policy::Search &getattrPolicy_,
         const Policy::Create &mkdirPolicy_,
-        const Branches       &branches_,
+        const Branches::CPtr &branches_,
         const char           *fusepath_,
         const mode_t          mode_,
         const mode_t          umask_)
   {
     int rv;
     string fusedirpath;
-    StrVec createpaths;
-    StrVec existingpaths;
+    Branch::CPtrVec createbranches;
+    Branch::CPtrVec existingbranches;
 
     fusedirpath = fs::path::dirname(fusepath_);
 
-    rv = getattrPolicy_(branches_,fusedirpath.c_str(),&existingpaths);
+    rv = getattrPolicy_(branches_,fusedirpath.c_str(),&existingbranches);
     if(rv == -1)
       return -errno;
 
-    rv = mkdirPolicy_(branches_,fusedirpath.c_str(),&createpaths);
+    rv = mkdirPolicy_(branches_,fusedirpath.c_str(),&createbranches);
     if(rv == -1)
       return -errno;
 
-    return l::mkdir_loop(existingpaths[0],
-                         createpaths,
+    return l::mkdir_loop(*existingbranches[0],
+                         createbranches,
                          fusepath_,
                          fusedirpath,
                          mode_,
@@ -172,6 +186,9 @@ namespace FUSE
                       fc->umask);
       }
 
+    g_POLICY_CACHE.erase(fusepath_);
+    g_ATTR_CACHE.erase_entry(fusepath_);
+
     return rv;
   }
 }
@@ -14,12 +14,15 @@
   OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 */
 
+#include "attr_cache.hpp"
 #include "config.hpp"
 #include "errno.hpp"
 #include "fs_acl.hpp"
 #include "fs_mknod.hpp"
 #include "fs_clonepath.hpp"
 #include "fs_path.hpp"
+#include "fs_pathbuf.hpp"
+#include "policy_cache.hpp"
 #include "ugid.hpp"
 
 #include "fuse.h"
@@ -56,7 +59,7 @@ namespace l
   static
   inline
   int
-  mknod_core(const string &fullpath_,
+  mknod_core(const char   *fullpath_,
              mode_t        mode_,
              const mode_t  umask_,
              const dev_t   dev_)
@@ -69,7 +72,7 @@ namespace l
 
   static
   int
-  mknod_loop_core(const string &createpath_,
+  mknod_loop_core(const Branch &branch_,
                   const char   *fusepath_,
                   const mode_t  mode_,
                   const mode_t  umask_,
@@ -77,9 +80,7 @@ namespace l
                   const int     error_)
   {
     int rv;
-    string fullpath;
-
-    fullpath = fs::path::make(createpath_,fusepath_);
+    fs::PathBuf fullpath(branch_.path,fusepath_);
 
     rv = l::mknod_core(fullpath,mode_,umask_,dev_);
 
@@ -88,25 +89,25 @@ namespace l
 
   static
   int
-  mknod_loop(const string         &existingpath_,
-             const vector<string> &createpaths_,
-             const char           *fusepath_,
-             const string         &fusedirpath_,
-             const mode_t          mode_,
-             const mode_t          umask_,
-             const dev_t           dev_)
+  mknod_loop(const Branch          &existingbranch_,
+             const Branch::CPtrVec &createbranches_,
+             const char            *fusepath_,
+             const string          &fusedirpath_,
+             const mode_t           mode_,
+             const mode_t           umask_,
+             const dev_t            dev_)
   {
     int rv;
     int error;
 
     error = -1;
-    for(size_t i = 0, ei = createpaths_.size(); i != ei; i++)
+    for(const Branch *createbranch : createbranches_)
       {
-        rv = fs::clonepath_as_root(existingpath_,createpaths_[i],fusedirpath_);
+        rv = fs::clonepath_as_root(existingbranch_.path,createbranch->path,fusedirpath_);
         if(rv == -1)
           error = error::calc(rv,error,errno);
         else
-          error = l::mknod_loop_core(createpaths_[i],
+          error = l::mknod_loop_core(*createbranch,
                                      fusepath_,
                                      mode_,umask_,dev_,error);
       }
@@ -118,7 +119,7 @@ namespace l
   int
   mknod(const Policy::Search &searchFunc_,
         const Policy::Create &createFunc_,
-        const Branches       &branches_,
+        const Branches::CPtr &branches_,
         const char           *fusepath_,
         const mode_t          mode_,
         const mode_t          umask_,
@@ -126,20 +127,20 @@ namespace l
   {
     int rv;
     string fusedirpath;
-    vector<string> createpaths;
-    vector<string> existingpaths;
+    Branch::CPtrVec createbranches;
+    Branch::CPtrVec existingbranches;
 
     fusedirpath = fs::path::dirname(fusepath_);
 
-    rv = searchFunc_(branches_,fusedirpath,&existingpaths);
+    rv = searchFunc_(branches_,fusedirpath,&existingbranches);
     if(rv == -1)
       return -errno;
 
-    rv = createFunc_(branches_,fusedirpath,&createpaths);
+    rv = createFunc_(branches_,fusedirpath,&createbranches);
     if(rv == -1)
       return -errno;
 
-    return l::mknod_loop(existingpaths[0],createpaths,
+    return l::mknod_loop(*existingbranches[0],createbranches,
                          fusepath_,fusedirpath,
                          mode_,umask_,dev_);
   }
@@ -176,6 +177,9 @@ namespace FUSE
                       rdev_);
       }
 
+    g_POLICY_CACHE.erase(fusepath_);
+    g_ATTR_CACHE.erase_entry(fusepath_);
+
     return rv;
   }
 }
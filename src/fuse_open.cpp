@@ -14,6 +14,7 @@
   OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 */
 
+#include "attr_cache.hpp"
 #include "config.hpp"
 #include "errno.hpp"
 #include "fileinfo.hpp"
@@ -21,8 +22,11 @@
 #include "fs_fchmod.hpp"
 #include "fs_lchmod.hpp"
 #include "fs_open.hpp"
+#include "fs_openat.hpp"
 #include "fs_path.hpp"
 #include "fs_stat.hpp"
+#include "passthrough.hpp"
+#include "policy_cache.hpp"
 #include "procfs_get_name.hpp"
 #include "stat_util.hpp"
 #include "ugid.hpp"
@@ -190,28 +194,48 @@ namespace l
 
   static
   int
-  open_core(const std::string &basepath_,
-            const char        *fusepath_,
-            fuse_file_info_t  *ffi_,
-            const bool         link_cow_,
-            const NFSOpenHack  nfsopenhack_)
+  open_core(const Branch          &branch_,
+            const char            *fusepath_,
+            fuse_file_info_t      *ffi_,
+            const bool             link_cow_,
+            const NFSOpenHack      nfsopenhack_,
+            const passthrough::IO  passthrough_)
   {
     int fd;
+    int dirfd;
+    uint64_t start;
     FileInfo *fi;
     std::string fullpath;
 
-    fullpath = fs::path::make(basepath_,fusepath_);
+    dirfd = branch_.fd();
+    if(link_cow_ || (dirfd < 0))
+      fullpath = fs::path::make(branch_.path,fusepath_);
 
     if(link_cow_ && fs::cow::is_eligible(fullpath.c_str(),ffi_->flags))
       fs::cow::break_link(fullpath.c_str());
 
-    fd = fs::open(fullpath,ffi_->flags);
+    start = BranchStats::now();
+    if(dirfd >= 0)
+      fd = fs::openat(dirfd,fs::path::rel(fusepath_),ffi_->flags);
+    else
+      fd = fs::open(fullpath,ffi_->flags);
+    branch_.stats->record(start,((fd == -1) && BranchStats::fault(errno)));
     if((fd == -1) && (errno == EACCES))
-      fd = l::nfsopenhack(fullpath,ffi_->flags,nfsopenhack_);
+      {
+        if(fullpath.empty())
+          fullpath = fs::path::make(branch_.path,fusepath_);
+        fd = l::nfsopenhack(fullpath,ffi_->flags,nfsopenhack_);
+      }
     if(fd == -1)
       return -errno;
 
     fi = new FileInfo(fd,fusepath_,ffi_->direct_io);
+    if(l::rdonly(ffi_->flags))
+      fi->opened_on(branch_.stats);
+    else
+      fi->writing_to(branch_.space,branch_.stats);
+
+    passthrough::open(fi,ffi_,passthrough_);
 
     ffi_->fh = reinterpret_cast<uint64_t>(fi);
 
@@ -220,21 +244,27 @@ namespace l
 
   static
   int
-  open(const Policy::Search &searchFunc_,
-       const Branches       &branches_,
-       const char           *fusepath_,
-       fuse_file_info_t     *ffi_,
-       const bool            link_cow_,
-       const NFSOpenHack     nfsopenhack_)
+  open(const Policy::Search  &searchFunc_,
+       const Branches::CPtr  &branches_,
+       const char            *fusepath_,
+       fuse_file_info_t      *ffi_,
+       const bool             link_cow_,
+       const NFSOpenHack      nfsopenhack_,
+       const passthrough::IO  passthrough_)
   {
     int rv;
-    StrVec basepaths;
+    Branch::CPtrVec obranches;
 
-    rv = searchFunc_(branches_,fusepath_,&basepaths);
+    rv = g_POLICY_CACHE(searchFunc_,branches_,fusepath_,&obranches);
     if(rv == -1)
       return -errno;
 
-    return l::open_core(basepaths[0],fusepath_,ffi_,link_cow_,nfsopenhack_);
+    return l::open_core(*obranches[0],
+                        fusepath_,
+                        ffi_,
+                        link_cow_,
+                        nfsopenhack_,
+                        passthrough_);
   }
 }
 
@@ -262,7 +292,10 @@ namespace FUSE
                  fusepath_,
                  ffi_,
                  cfg->link_cow,
-                 cfg->nfsopenhack);
+                 cfg->nfsopenhack,
+                 passthrough::io(cfg,ffi_));
+    if(!l::rdonly(ffi_->flags))
+      g_ATTR_CACHE.erase(fusepath_);
 
     return rv;
   }
@@ -26,6 +26,13 @@
 
 namespace l
 {
+  /*
+    Spliced reads happen in libfuse after read_buf returns. The
+    matching read_buf_done runs on the same thread so the start time
+    can be carried between them here.
+  */
+  static thread_local uint64_t read_buf_start;
+
   static
   int
   read_direct_io(const int     fd_,
@@ -63,12 +70,52 @@ namespace FUSE
        size_t                  size_,
        off_t                   offset_)
   {
+    int rv;
+    uint64_t start;
     FileInfo *fi = reinterpret_cast<FileInfo*>(ffi_->fh);
 
+    start = BranchStats::now();
     if(fi->direct_io)
-      return l::read_direct_io(fi->fd,buf_,size_,offset_);
+      rv = l::read_direct_io(fi->fd,buf_,size_,offset_);
+    else
+      rv = l::read_cached(fi->fd,buf_,size_,offset_);
+    std::atomic_load(&fi->stats)->record(start,((rv < 0) && BranchStats::fault(-rv)));
+
+    return rv;
+  }
+
+  /*
+    Rather than reading the data describe where it comes from so
+    libfuse can splice it from the branch file to the kernel.
+  */
+  int
+  read_buf(const fuse_file_info_t *ffi_,
+           fuse_bufvec            *bufv_,
+           size_t                  size_,
+           off_t                   offset_)
+  {
+    FileInfo *fi = reinterpret_cast<FileInfo*>(ffi_->fh);
+
+    bufv_->buf[0].size  = size_;
+    bufv_->buf[0].flags = (fuse_buf_flags)(FUSE_BUF_IS_FD    |
+                                           FUSE_BUF_FD_SEEK  |
+                                           FUSE_BUF_FD_RETRY);
+    bufv_->buf[0].fd    = fi->fd;
+    bufv_->buf[0].pos   = offset_;
+
+    l::read_buf_start = BranchStats::now();
+
+    return 0;
+  }
+
+  void
+  read_buf_done(const fuse_file_info_t *ffi_,
+                int                     err_)
+  {
+    FileInfo *fi = reinterpret_cast<FileInfo*>(ffi_->fh);
 
-    return l::read_cached(fi->fd,buf_,size_,offset_);
+    std::atomic_load(&fi->stats)->record(l::read_buf_start,
+                                         ((err_ < 0) && BranchStats::fault(-err_)));
   }
 
   int
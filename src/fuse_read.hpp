@@ -29,6 +29,16 @@ namespace FUSE
        size_t                  size,
        off_t                   offset);
 
+  int
+  read_buf(const fuse_file_info_t *ffi,
+           fuse_bufvec            *bufv,
+           size_t                  size,
+           off_t                   offset);
+
+  void
+  read_buf_done(const fuse_file_info_t *ffi,
+                int                     err);
+
   int
   read_null(const fuse_file_info_t *ffi,
             char                   *buf,
@@ -19,7 +19,25 @@
 #include "fuse_readdir.hpp"
 
 #include "config.hpp"
+#include "dir_cache.hpp"
+#include "dirinfo.hpp"
+#include "fs_dirpresence.hpp"
+#include "fs_fstatat.hpp"
+#include "fs_path.hpp"
+#include "fs_pathbuf.hpp"
+#include "fs_stat.hpp"
 #include "fuse_readdir_factory.hpp"
+#include "ugid.hpp"
+
+#include <time.h>
+
+/*
+  Directory times may only advance every few milliseconds
+  (jiffies). A listing read while a branch directory's times are that
+  recent could miss a change which leaves them as they were so it
+  isn't cached.
+*/
+#define DIR_CACHE_MIN_AGE_SECS 1
 
 /*
   The _initialized stuff is not pretty but easiest way to deal with
@@ -27,15 +45,147 @@
   (including thread pools) before the daemonizing
  */
 
+namespace l
+{
+  static
+  int
+  stat(const Branch *branch_,
+       const char   *fusepath_,
+       struct stat  *st_)
+  {
+    int dirfd;
+
+    dirfd = branch_->fd();
+    if(dirfd >= 0)
+      return fs::fstatat(dirfd,fs::path::rel(fusepath_),st_,0);
+
+    return fs::stat(fs::PathBuf(branch_->path,fusepath_),st_);
+  }
+
+  /*
+    One stat per branch. Returns -1 if any branch couldn't be checked
+    in which case the cache isn't used.
+  */
+  static
+  int
+  stamp(const Branches::CPtr &branches_,
+        const char           *fusepath_,
+        DirCache::Stamps     *stamps_)
+  {
+    int rv;
+    struct stat st;
+    DirCache::Stamp stamp;
+
+    stamps_->reserve(branches_->size());
+    for(const auto &branch : *branches_)
+      {
+        rv = l::stat(&branch,fusepath_,&st);
+        if((rv == -1) && (errno != ENOENT) && (errno != ENOTDIR))
+          return -1;
+
+        memset(&stamp,0,sizeof(stamp));
+        stamp.present = (rv == 0);
+        if(stamp.present)
+          {
+            stamp.dev   = st.st_dev;
+            stamp.ino   = st.st_ino;
+            stamp.mtime = st.st_mtim;
+            stamp.ctime = st.st_ctim;
+          }
+
+        stamps_->push_back(stamp);
+      }
+
+    return 0;
+  }
+
+  static
+  bool
+  settled(const DirCache::Stamps &stamps_)
+  {
+    time_t limit;
+
+    limit = (::time(NULL) - DIR_CACHE_MIN_AGE_SECS);
+    for(const auto &stamp : stamps_)
+      {
+        if(!stamp.present)
+          continue;
+        if(stamp.mtime.tv_sec >= limit)
+          return false;
+        if(stamp.ctime.tv_sec >= limit)
+          return false;
+      }
+
+    return true;
+  }
+
+  static
+  int
+  readdir_cached(Config::Write          &cfg_,
+                 const fuse_file_info_t *ffi_,
+                 fuse_dirents_t         *buf_)
+  {
+    int rv;
+    uint64_t branches_id;
+    DirCache::Stamps stamps;
+    Branches::CPtr branches = cfg_->branches;
+    DirInfo *di = reinterpret_cast<DirInfo*>(ffi_->fh);
+    const char *fusepath = di->fusepath.c_str();
+    const fuse_context *fc = fuse_get_context();
+
+    {
+      const ugid::Set ugid(fc->uid,fc->gid);
+
+      rv = l::stamp(branches,fusepath,&stamps);
+    }
+
+    if(rv == -1)
+      return cfg_->readdir(ffi_,buf_);
+
+    branches_id = branches->id();
+    if(g_DIR_CACHE.get(fusepath,fc->uid,fc->gid,branches_id,stamps,buf_))
+      {
+        for(size_t i = 0; i < stamps.size(); i++)
+          fs::dirpresence::found(branches,
+                                 (*branches)[i],
+                                 fusepath,
+                                 stamps[i].present);
+        return 0;
+      }
+
+    rv = cfg_->readdir(ffi_,buf_);
+    if((rv == 0) && !buf_->more && l::settled(stamps))
+      g_DIR_CACHE.insert(fusepath,fc->uid,fc->gid,branches_id,stamps,buf_);
+
+    return rv;
+  }
+}
+
 int
 FUSE::readdir(const fuse_file_info_t *ffi_,
               fuse_dirents_t         *buf_)
 {
   Config::Write cfg;
 
+  // Continuing a streamed listing
+  if(buf_->more)
+    return cfg->readdir(ffi_,buf_);
+
+  if(g_DIR_CACHE.enabled())
+    return l::readdir_cached(cfg,ffi_,buf_);
+
   return cfg->readdir(ffi_,buf_);
 }
 
+int
+FUSE::readdir_plus(const fuse_file_info_t *ffi_,
+                   fuse_dirents_t         *buf_)
+{
+  Config::Write cfg;
+
+  return cfg->readdir.plus(ffi_,buf_);
+}
+
 FUSE::ReadDir::ReadDir(std::string const s_)
   : _initialized(false)
 {
@@ -108,3 +258,17 @@ FUSE::ReadDir::operator()(fuse_file_info_t const *ffi_,
 
   return (*readdir)(ffi_,buf_);
 }
+
+int
+FUSE::ReadDir::plus(fuse_file_info_t const *ffi_,
+                    fuse_dirents_t         *buf_)
+{
+  std::shared_ptr<FUSE::ReadDirBase> readdir;
+
+  {
+    std::lock_guard<std::mutex> lg(_mutex);
+    readdir = _readdir;
+  }
+
+  return readdir->plus(ffi_,buf_);
+}
@@ -33,6 +33,8 @@ namespace FUSE
 {
   int readdir(fuse_file_info_t const *ffi,
               fuse_dirents_t         *buf);
+  int readdir_plus(fuse_file_info_t const *ffi,
+                   fuse_dirents_t         *buf);
 
   class ReadDir : public ToFromString
   {
@@ -46,6 +48,8 @@ namespace FUSE
   public:
     int operator()(fuse_file_info_t const *ffi,
                    fuse_dirents_t         *buf);
+    int plus(fuse_file_info_t const *ffi,
+             fuse_dirents_t         *buf);
 
   public:
     void initialize();
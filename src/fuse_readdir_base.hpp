@@ -18,6 +18,8 @@
 
 #include "fuse.h"
 
+#include <errno.h>
+
 
 namespace FUSE
 {
@@ -30,5 +32,12 @@ namespace FUSE
   public:
     virtual int operator()(fuse_file_info_t const *ffi,
                            fuse_dirents_t         *buf) = 0;
+
+    // Listing with attributes for READDIRPLUS.
+    virtual int plus(fuse_file_info_t const *ffi,
+                     fuse_dirents_t         *buf)
+    {
+      return -ENOTSUP;
+    }
   };
 }
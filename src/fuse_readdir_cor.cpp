@@ -21,11 +21,13 @@
 #include "errno.hpp"
 #include "fs_close.hpp"
 #include "fs_devid.hpp"
+#include "fs_dirpresence.hpp"
 #include "fs_getdents64.hpp"
 #include "fs_inode.hpp"
 #include "fs_open.hpp"
+#include "fs_openat.hpp"
 #include "fs_path.hpp"
-#include "fs_readdir.hpp"
+#include "fs_pathbuf.hpp"
 #include "hashset.hpp"
 #include "scope_guard.hpp"
 #include "ugid.hpp"
@@ -33,6 +35,25 @@
 #include "fuse_dirents.h"
 #include "linux_dirent64.h"
 
+#include <algorithm>
+#include <memory>
+
+#include <fcntl.h>
+
+/*
+  Below this many entries in total the merge is done on the calling
+  thread. Above it deduplication is split across the thread pool.
+*/
+#define PARTITION_MIN_ENTRIES (64 * 1024)
+
+/*
+  The per branch buffers are kept per thread between calls unless
+  they grew beyond this.
+*/
+#define SCRATCH_MAX_BYTES (1024 * 1024)
+
+#define READ_SIZE (32 * 1024)
+
 
 FUSE::ReadDirCOR::ReadDirCOR(unsigned concurrency_,
                              unsigned max_queue_depth_)
@@ -74,64 +95,214 @@ namespace l
     }
   };
 
+  /*
+    A branch's raw getdents records and an index of them with the
+    hash of each name. Filled by one thread without
+    locking. Inodes are calculated once an entry is known to be kept.
+  */
+  struct BranchDirents
+  {
+    struct Entry
+    {
+      uint64_t hash;
+      uint32_t offset;
+      uint16_t namelen;
+      uint8_t  keep;
+    };
+
+    std::size_t
+    size(void) const
+    {
+      return entries.size();
+    }
+
+    void
+    reset(void)
+    {
+      len = 0;
+      entries.clear();
+    }
+
+    // Don't hold on to the memory of unusually large listings.
+    void
+    trim(void)
+    {
+      if(data.size() <= SCRATCH_MAX_BYTES)
+        return;
+
+      std::vector<char>().swap(data);
+      std::vector<Entry>().swap(entries);
+    }
+
+    dev_t              dev;
+    std::size_t        len;
+    std::vector<char>  data;
+    std::vector<Entry> entries;
+  };
+
+  static
+  int
+  open(const Branch &branch_,
+       const char   *dirname_)
+  {
+    int dirfd;
+    const int flags = (O_RDONLY|O_DIRECTORY|O_CLOEXEC);
+
+    dirfd = branch_.fd();
+    if(dirfd >= 0)
+      return fs::openat(dirfd,fs::path::rel(dirname_),flags);
+
+    return fs::open(fs::PathBuf(branch_.path,dirname_),flags);
+  }
+
   static
   inline
   int
-  readdir(std::string     basepath_,
-          HashSet        &names_,
-          fuse_dirents_t *buf_,
-          std::mutex     &mutex_)
+  readdir(const Branch  &branch_,
+          const char    *dirname_,
+          BranchDirents *out_)
   {
-    int rv;
     int dfd;
-    dev_t dev;
-    std::string filepath;
 
-    dfd = fs::open_dir_ro(basepath_);
+    dfd = l::open(branch_,dirname_);
     if(dfd == -1)
       return errno;
 
     DEFER{ fs::close(dfd); };
 
-    dev = fs::devid(dfd);
+    out_->dev = fs::devid(dfd);
 
-    rv = 0;
     for(;;)
       {
         long nread;
-        char buf[32 * 1024];
 
-        nread = fs::getdents_64(dfd,buf,sizeof(buf));
+        if((out_->data.size() - out_->len) < READ_SIZE)
+          out_->data.resize(std::max(out_->data.size() * 2,
+                                     out_->len + READ_SIZE));
+
+        nread = fs::getdents_64(dfd,&out_->data[out_->len],READ_SIZE);
         if(nread == -1)
           return errno;
         if(nread == 0)
           break;
 
         linux_dirent64_t *d;
-        std::lock_guard<std::mutex> lk(mutex_);
-        for(long pos = 0; pos < nread; pos += d->reclen)
+        for(std::size_t pos = out_->len; pos < (out_->len + nread); pos += d->reclen)
           {
-            std::uint64_t namelen;
+            BranchDirents::Entry entry;
+
+            d = (linux_dirent64_t*)&out_->data[pos];
+
+            entry.offset  = pos;
+            entry.namelen = DIRENT_NAMELEN(d);
+            entry.hash    = HashSet::hash(d->name,entry.namelen);
+            entry.keep    = 0;
+
+            out_->entries.push_back(entry);
+          }
+
+        out_->len += nread;
+      }
+
+    return 0;
+  }
+
+  /*
+    Marks which entries of each branch are kept, the first occurrence
+    of a name in branch order, and calculates their inodes. Partition
+    `part_` of `parts_` only looks at names whose hash falls in it so
+    partitions can run concurrently without sharing a set.
+  */
+  static
+  void
+  dedupe(std::vector<BranchDirents*> &branches_,
+         const char                  *dirname_,
+         const uint64_t               part_,
+         const uint64_t               parts_)
+  {
+    HashSet names;
+    fs::inode::PathHash dirhash(dirname_);
 
-            d = (linux_dirent64_t*)&buf[pos];
+    for(auto branch : branches_)
+      {
+        for(std::size_t i = 0; i < branch->size(); i++)
+          {
+            linux_dirent64_t *d;
+            BranchDirents::Entry &entry = branch->entries[i];
 
-            namelen = DIRENT_NAMELEN(d);
+            if((parts_ > 1) && (((entry.hash >> 32) % parts_) != part_))
+              continue;
 
-            rv = names_.put(d->name,namelen);
-            if(rv == 0)
+            entry.keep = !!names.put(entry.hash);
+            if(!entry.keep)
               continue;
 
-            filepath = fs::path::make(basepath_,d->name);
-            d->ino = fs::inode::calc(filepath,
+            d = (linux_dirent64_t*)&branch->data[entry.offset];
+
+            d->ino = fs::inode::calc(dirhash,
+                                     d->name,
+                                     entry.namelen,
                                      DTTOIF(d->type),
-                                     dev,
+                                     branch->dev,
                                      d->ino);
+          }
+      }
+  }
+
+  static
+  int
+  merge(ThreadPool                  &tp_,
+        std::vector<BranchDirents*> &branches_,
+        const char                  *dirname_,
+        fuse_dirents_t              *buf_)
+  {
+    int rv;
+    uint64_t parts;
+    std::size_t total;
+    std::vector<std::future<int>> futures;
+
+    total = 0;
+    for(auto branch : branches_)
+      total += branch->size();
+
+    parts = ((total >= PARTITION_MIN_ENTRIES) ? tp_.threads().size() : 1);
+    if(parts > 1)
+      {
+        futures.reserve(parts);
+        for(uint64_t part = 0; part < parts; part++)
+          {
+            auto func = [&branches_,dirname_,part,parts]()
+            {
+              l::dedupe(branches_,dirname_,part,parts);
+              return 0;
+            };
+
+            futures.emplace_back(tp_.enqueue_task(func));
+          }
+
+        for(auto &future : futures)
+          future.get();
+      }
+    else
+      {
+        l::dedupe(branches_,dirname_,0,1);
+      }
 
-            rv = fuse_dirents_add_linux(buf_,d,namelen);
-            if(rv >= 0)
+    for(auto branch : branches_)
+      {
+        for(std::size_t i = 0; i < branch->size(); i++)
+          {
+            linux_dirent64_t *d;
+            const BranchDirents::Entry &entry = branch->entries[i];
+
+            if(!entry.keep)
               continue;
 
-            return ENOMEM;
+            d = (linux_dirent64_t*)&branch->data[entry.offset];
+
+            rv = fuse_dirents_add_linux(buf_,d,entry.namelen);
+            if(rv < 0)
+              return ENOMEM;
           }
       }
 
@@ -147,48 +318,65 @@ namespace l
                      uid_t const           uid_,
                      gid_t const           gid_)
   {
-    HashSet names;
-    std::mutex mutex;
+    int rv;
+    Error error;
+    std::vector<BranchDirents*> results;
     std::vector<std::future<int>> futures;
+    static thread_local std::vector<std::unique_ptr<BranchDirents>> scratch;
+
+    while(scratch.size() < branches_->size())
+      scratch.emplace_back(new BranchDirents());
 
+    results.reserve(branches_->size());
     futures.reserve(branches_->size());
-    for(auto const &branch : *branches_)
+    for(std::size_t i = 0; i < branches_->size(); i++)
       {
-        auto func = [&,dirname_,buf_,uid_,gid_]()
+        const Branch  &branch = (*branches_)[i];
+        BranchDirents *result = scratch[i].get();
+
+        result->reset();
+        results.push_back(result);
+
+        auto func = [&branches_,&branch,result,dirname_,uid_,gid_]()
         {
-          std::string basepath;
+          int rv;
           ugid::Set const ugid(uid_,gid_);
 
-          basepath = fs::path::make(branch.path,dirname_);
+          rv = l::readdir(branch,dirname_,result);
+          if((rv == 0) || (rv == ENOENT))
+            fs::dirpresence::found(branches_,branch,dirname_,(rv == 0));
 
-          return l::readdir(basepath,names,buf_,mutex);
+          return rv;
         };
 
-        auto rv = tp_.enqueue_task(func);
-
-        futures.emplace_back(std::move(rv));
+        futures.emplace_back(tp_.enqueue_task(func));
       }
 
-    Error error;
     for(auto &future : futures)
       error = future.get();
 
+    rv = l::merge(tp_,results,dirname_,buf_);
+
+    for(auto result : results)
+      result->trim();
+
+    if(rv != 0)
+      return -ENOMEM;
+
     return -error;
   }
+}
 
-  static
-  int
-  readdir(ThreadPool           &tp_,
-          const Branches::CPtr &branches_,
-          const char           *dirname_,
-          fuse_dirents_t       *buf_,
-          uid_t const           uid_,
-          gid_t const           gid_)
-  {
-    fuse_dirents_reset(buf_);
+int
+FUSE::ReadDirCOR::readdir(const Branches::CPtr &branches_,
+                          const char           *dirname_,
+                          fuse_dirents_t       *buf_,
+                          const uid_t           uid_,
+                          const gid_t           gid_)
+{
+  fuse_dirents_reset(buf_);
 
-    return l::concurrent_readdir(tp_,branches_,dirname_,buf_,uid_,gid_);
-  }
+  return l::concurrent_readdir(_tp,branches_,dirname_,buf_,uid_,gid_);
 }
 
 int
@@ -199,10 +387,9 @@ FUSE::ReadDirCOR::operator()(fuse_file_info_t const *ffi_,
   DirInfo            *di = reinterpret_cast<DirInfo*>(ffi_->fh);
   const fuse_context *fc = fuse_get_context();
 
-  return l::readdir(_tp,
-                    cfg->branches,
-                    di->fusepath.c_str(),
-                    buf_,
-                    fc->uid,
-                    fc->gid);
+  return readdir(cfg->branches,
+                 di->fusepath.c_str(),
+                 buf_,
+                 fc->uid,
+                 fc->gid);
 }
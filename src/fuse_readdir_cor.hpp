@@ -18,6 +18,7 @@
 
 #pragma once
 
+#include "branches.hpp"
 #include "fuse_readdir_base.hpp"
 
 #include "thread_pool.hpp"
@@ -36,6 +37,12 @@ namespace FUSE
     int operator()(fuse_file_info_t const *ffi,
                    fuse_dirents_t         *buf);
 
+    int readdir(const Branches::CPtr &branches,
+                const char           *dirname,
+                fuse_dirents_t       *buf,
+                const uid_t           uid,
+                const gid_t           gid);
+
   private:
     ThreadPool _tp;
   };
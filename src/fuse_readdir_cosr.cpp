@@ -21,6 +21,7 @@
 #include "errno.hpp"
 #include "fs_closedir.hpp"
 #include "fs_devid.hpp"
+#include "fs_dirpresence.hpp"
 #include "fs_dirfd.hpp"
 #include "fs_inode.hpp"
 #include "fs_opendir.hpp"
@@ -108,7 +109,7 @@ namespace l
     futures.reserve(branches_->size());
     for(auto const &branch : *branches_)
       {
-        auto func = [&branch,dirname_,uid_,gid_]()
+        auto func = [&branches_,&branch,dirname_,uid_,gid_]()
         {
           DirRV rv;
           std::string basepath;
@@ -119,6 +120,8 @@ namespace l
           errno  = 0;
           rv.dir = fs::opendir(basepath);
           rv.err = errno;
+          if(rv.dir || (rv.err == ENOENT))
+            fs::dirpresence::found(branches_,branch,dirname_,!!rv.dir);
 
           return rv;
         };
@@ -140,7 +143,7 @@ namespace l
   {
     Error error;
     HashSet names;
-    std::string fullpath;
+    fs::inode::PathHash dirhash(dirname_);
 
     for(auto &dh_future : dh_futures_)
       {
@@ -168,8 +171,9 @@ namespace l
             if(rv == 0)
               continue;
 
-            fullpath  = fs::path::make(dirname_,de->d_name);
-            de->d_ino = fs::inode::calc(fullpath,
+            de->d_ino = fs::inode::calc(dirhash,
+                                        de->d_name,
+                                        namelen,
                                         DTTOIF(de->d_type),
                                         dev,
                                         de->d_ino);
@@ -20,7 +20,9 @@
 
 #include "fuse_readdir_cor.hpp"
 #include "fuse_readdir_cosr.hpp"
+#include "fuse_readdir_plus.hpp"
 #include "fuse_readdir_seq.hpp"
+#include "fuse_readdir_stream.hpp"
 
 #include <cassert>
 #include <cmath>
@@ -78,7 +80,7 @@ FUSE::ReadDirFactory::valid(std::string const str_)
   std::string type;
   static const std::set<std::string> types =
     {
-      "seq", "cosr", "cor"
+      "seq", "cosr", "cor", "stream", "plus"
     };
 
   l::read_cfg(str_,type,concurrency,max_queue_depth);
@@ -109,6 +111,10 @@ FUSE::ReadDirFactory::make(std::string const str_)
     return std::make_shared<FUSE::ReadDirCOSR>(concurrency,max_queue_depth);
   if(type == "cor")
     return std::make_shared<FUSE::ReadDirCOR>(concurrency,max_queue_depth);
+  if(type == "stream")
+    return std::make_shared<FUSE::ReadDirStream>();
+  if(type == "plus")
+    return std::make_shared<FUSE::ReadDirPlus>(concurrency,max_queue_depth);
 
   return {};
 }
@@ -18,12 +18,490 @@
 
 #include "fuse_readdir_plus.hpp"
 
-#include <errno.h>
+#include "attr_cache.hpp"
+#include "config.hpp"
+#include "dirinfo.hpp"
+#include "errno.hpp"
+#include "fs_close.hpp"
+#include "fs_devid.hpp"
+#include "fs_dirpresence.hpp"
+#include "fs_getdents64.hpp"
+#include "fs_inode.hpp"
+#include "fs_open.hpp"
+#include "fs_openat.hpp"
+#include "fs_path.hpp"
+#include "fs_pathbuf.hpp"
+#include "fs_statx.hpp"
+#include "hashset.hpp"
+#include "ugid.hpp"
 
+#include "fuse_dirents.h"
+#include "linux_dirent64.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <fcntl.h>
+
+/*
+  Entries are stat'ed across the thread pool in batches of this many.
+*/
+#define STAT_BATCH_SIZE 256
+
+#define READ_SIZE (32 * 1024)
+
+
+FUSE::ReadDirPlus::ReadDirPlus(unsigned concurrency_,
+                               unsigned max_queue_depth_)
+  : _tp(concurrency_,max_queue_depth_,"readdir.plus")
+{
+
+}
+
+FUSE::ReadDirPlus::~ReadDirPlus()
+{
+
+}
+
+namespace l
+{
+  struct Error
+  {
+  private:
+    int _err;
+
+  public:
+    Error()
+      : _err(ENOENT)
+    {
+    }
+
+    operator int()
+    {
+      return _err;
+    }
+
+    Error&
+    operator=(int v_)
+    {
+      if(_err != 0)
+        _err = v_;
+
+      return *this;
+    }
+  };
+
+  /*
+    A branch's raw getdents records and an index of them with the
+    hash of each name. The directory is kept open so entries can be
+    stat'ed relative to it.
+  */
+  struct BranchDirents
+  {
+    struct Entry
+    {
+      uint64_t hash;
+      uint32_t offset;
+      uint16_t namelen;
+    };
+
+    BranchDirents()
+      : fd(-1),
+        len(0)
+    {
+    }
+
+    ~BranchDirents()
+    {
+      if(fd >= 0)
+        fs::close(fd);
+    }
+
+    BranchDirents(const BranchDirents&) = delete;
+
+    int                fd;
+    dev_t              dev;
+    std::size_t        len;
+    std::vector<char>  data;
+    std::vector<Entry> entries;
+  };
+
+  // An entry to be returned and, if fetched, its attributes.
+  struct Kept
+  {
+    const BranchDirents *branch;
+    linux_dirent64_t    *d;
+    uint16_t             namelen;
+    bool                 attr;
+    struct stat          st;
+  };
+
+  static
+  int
+  open(const Branch &branch_,
+       const char   *dirname_)
+  {
+    int dirfd;
+    const int flags = (O_RDONLY|O_DIRECTORY|O_CLOEXEC);
+
+    dirfd = branch_.fd();
+    if(dirfd >= 0)
+      return fs::openat(dirfd,fs::path::rel(dirname_),flags);
+
+    return fs::open(fs::PathBuf(branch_.path,dirname_),flags);
+  }
+
+  static
+  int
+  readdir(const Branch  &branch_,
+          const char    *dirname_,
+          BranchDirents *out_)
+  {
+    out_->fd = l::open(branch_,dirname_);
+    if(out_->fd == -1)
+      return errno;
+
+    out_->dev = fs::devid(out_->fd);
+
+    for(;;)
+      {
+        long nread;
+
+        if((out_->data.size() - out_->len) < READ_SIZE)
+          out_->data.resize(std::max(out_->data.size() * 2,
+                                     out_->len + READ_SIZE));
+
+        nread = fs::getdents_64(out_->fd,&out_->data[out_->len],READ_SIZE);
+        if(nread == -1)
+          return errno;
+        if(nread == 0)
+          break;
+
+        linux_dirent64_t *d;
+        for(std::size_t pos = out_->len; pos < (out_->len + nread); pos += d->reclen)
+          {
+            BranchDirents::Entry entry;
+
+            d = (linux_dirent64_t*)&out_->data[pos];
+
+            entry.offset  = pos;
+            entry.namelen = DIRENT_NAMELEN(d);
+            entry.hash    = HashSet::hash(d->name,entry.namelen);
+
+            out_->entries.push_back(entry);
+          }
+
+        out_->len += nread;
+      }
+
+    return 0;
+  }
+
+  // The first occurrence of a name in branch order is kept.
+  static
+  void
+  dedupe(std::vector<BranchDirents> &branches_,
+         std::vector<Kept>          &kept_)
+  {
+    HashSet names;
+    std::size_t total;
+
+    total = 0;
+    for(const auto &branch : branches_)
+      total += branch.entries.size();
+    kept_.reserve(total);
+
+    for(auto &branch : branches_)
+      {
+        for(const auto &entry : branch.entries)
+          {
+            Kept kept;
+
+            if(names.put(entry.hash) == 0)
+              continue;
+
+            kept.branch  = &branch;
+            kept.d       = (linux_dirent64_t*)&branch.data[entry.offset];
+            kept.namelen = entry.namelen;
+            kept.attr    = false;
+
+            kept_.push_back(kept);
+          }
+      }
+  }
+
+  static
+  bool
+  is_dot_or_dotdot(const char *name_)
+  {
+    return ((name_[0] == '.') &&
+            ((name_[1] == '\0') ||
+             ((name_[1] == '.') && (name_[2] == '\0'))));
+  }
+
+  /*
+    The branch an entry was first found on is the one the ff search
+    policy would pick so with symlinks not being followed this is the
+    same stat getattr would return.
+  */
+  static
+  bool
+  getattr(Kept                      *kept_,
+          const std::string         &fusepath_,
+          const fs::inode::PathHash &dirhash_,
+          const uint64_t             branches_id_,
+          const uid_t                uid_,
+          const gid_t                gid_)
+  {
+    int rv;
+    int error;
+    uint64_t gen;
+
+    gen = 0;
+    if(g_ATTR_CACHE.enabled() &&
+       g_ATTR_CACHE.lookup(fusepath_.c_str(),branches_id_,uid_,gid_,&kept_->st,&error,&gen))
+      return (error == 0);
+
+    rv = fs::statx(kept_->branch->fd,
+                   kept_->d->name,
+                   AT_SYMLINK_NOFOLLOW|AT_NO_AUTOMOUNT,
+                   &kept_->st);
+    if(rv == -1)
+      return false;
+
+    fs::inode::calc(dirhash_,kept_->d->name,kept_->namelen,&kept_->st);
+
+    if(g_ATTR_CACHE.enabled())
+      g_ATTR_CACHE.insert(fusepath_.c_str(),gen,branches_id_,uid_,gid_,0,&kept_->st);
+
+    return true;
+  }
+
+  /*
+    Fetches attributes, if asked for, and sets the inode of each
+    entry. Entries whose attributes couldn't be fetched are returned
+    without them.
+  */
+  static
+  void
+  resolve(const char     *dirname_,
+          const uint64_t  branches_id_,
+          const uid_t     uid_,
+          const gid_t     gid_,
+          const bool      attrs_,
+          Kept           *begin_,
+          Kept           *end_)
+  {
+    std::size_t dirlen;
+    std::string fusepath;
+    fs::inode::PathHash dirhash(dirname_);
+
+    fusepath = dirname_;
+    if(fusepath.back() != '/')
+      fusepath += '/';
+    dirlen = fusepath.size();
+
+    for(Kept *kept = begin_; kept != end_; kept++)
+      {
+        linux_dirent64_t *d = kept->d;
+
+        if(attrs_ && !l::is_dot_or_dotdot(d->name))
+          {
+            fusepath.resize(dirlen);
+            fusepath.append(d->name,kept->namelen);
+            kept->attr = l::getattr(kept,fusepath,dirhash,branches_id_,uid_,gid_);
+          }
+
+        if(kept->attr)
+          d->ino = kept->st.st_ino;
+        else
+          d->ino = fs::inode::calc(dirhash,
+                                   d->name,
+                                   kept->namelen,
+                                   DTTOIF(d->type),
+                                   kept->branch->dev,
+                                   d->ino);
+      }
+  }
+
+  static
+  int
+  add(fuse_dirents_t          *buf_,
+      const std::vector<Kept> &kept_,
+      const bool               plus_,
+      const fuse_timeouts_t   &timeouts_)
+  {
+    int rv;
+    struct stat st;
+    fuse_entry_t entry;
+
+    for(const auto &kept : kept_)
+      {
+        if(!plus_)
+          {
+            rv = fuse_dirents_add_linux(buf_,kept.d,kept.namelen);
+            if(rv < 0)
+              return ENOMEM;
+            continue;
+          }
+
+        // Without attributes, mode 0, the entry is sent as a plain
+        // dirent which the kernel will lookup on its own.
+        memset(&entry,0,sizeof(entry));
+        if(kept.attr)
+          {
+            st = kept.st;
+            entry.entry_valid = timeouts_.entry;
+            entry.attr_valid  = timeouts_.attr;
+          }
+        else
+          {
+            memset(&st,0,sizeof(st));
+            st.st_ino = kept.d->ino;
+          }
+
+        rv = fuse_dirents_add_linux_plus(buf_,kept.d,kept.namelen,&entry,&st);
+        if(rv < 0)
+          return ENOMEM;
+      }
+
+    return 0;
+  }
+
+  static
+  int
+  readdir(ThreadPool            &tp_,
+          const Branches::CPtr  &branches_,
+          const char            *dirname_,
+          fuse_dirents_t        *buf_,
+          const uid_t            uid_,
+          const gid_t            gid_,
+          const bool             plus_,
+          const bool             attrs_,
+          const fuse_timeouts_t &timeouts_)
+  {
+    Error error;
+    std::vector<Kept> kept;
+    std::vector<std::future<int>> futures;
+    std::vector<BranchDirents> results(branches_->size());
+
+    fuse_dirents_reset(buf_);
+
+    futures.reserve(branches_->size());
+    for(std::size_t i = 0; i < branches_->size(); i++)
+      {
+        const Branch  &branch = (*branches_)[i];
+        BranchDirents *result = &results[i];
+
+        auto func = [&branches_,&branch,result,dirname_,uid_,gid_]()
+        {
+          int rv;
+          ugid::Set const ugid(uid_,gid_);
+
+          rv = l::readdir(branch,dirname_,result);
+          if((rv == 0) || (rv == ENOENT))
+            fs::dirpresence::found(branches_,branch,dirname_,(rv == 0));
+
+          return rv;
+        };
+
+        futures.emplace_back(tp_.enqueue_task(func));
+      }
+
+    for(auto &future : futures)
+      error = future.get();
+
+    l::dedupe(results,kept);
+
+    if(attrs_ && (kept.size() > STAT_BATCH_SIZE))
+      {
+        uint64_t branches_id = branches_->id();
+
+        futures.clear();
+        for(std::size_t i = 0; i < kept.size(); i += STAT_BATCH_SIZE)
+          {
+            Kept *begin = &kept[i];
+            Kept *end   = &kept[std::min(i + STAT_BATCH_SIZE,kept.size())];
+
+            auto func = [dirname_,branches_id,begin,end,uid_,gid_]()
+            {
+              ugid::Set const ugid(uid_,gid_);
+
+              l::resolve(dirname_,branches_id,uid_,gid_,true,begin,end);
+
+              return 0;
+            };
+
+            futures.emplace_back(tp_.enqueue_task(func));
+          }
+
+        for(auto &future : futures)
+          future.get();
+      }
+    else if(!kept.empty())
+      {
+        ugid::Set const ugid(uid_,gid_);
+
+        l::resolve(dirname_,
+                   branches_->id(),
+                   uid_,
+                   gid_,
+                   attrs_,
+                   &kept.front(),
+                   &kept.front() + kept.size());
+      }
+
+    if(l::add(buf_,kept,plus_,timeouts_) != 0)
+      return -ENOMEM;
+
+    return -error;
+  }
+}
 
 int
-FUSE::readdir_plus(const fuse_file_info_t *ffi_,
-                   fuse_dirents_t         *buf_)
+FUSE::ReadDirPlus::operator()(fuse_file_info_t const *ffi_,
+                              fuse_dirents_t         *buf_)
 {
-  return -ENOTSUP;
+  Config::Read        cfg;
+  fuse_timeouts_t     timeouts = {0};
+  DirInfo            *di = reinterpret_cast<DirInfo*>(ffi_->fh);
+  const fuse_context *fc = fuse_get_context();
+
+  return l::readdir(_tp,
+                    cfg->branches,
+                    di->fusepath.c_str(),
+                    buf_,
+                    fc->uid,
+                    fc->gid,
+                    false,
+                    false,
+                    timeouts);
+}
+
+int
+FUSE::ReadDirPlus::plus(fuse_file_info_t const *ffi_,
+                        fuse_dirents_t         *buf_)
+{
+  bool attrs;
+  Config::Read        cfg;
+  fuse_timeouts_t     timeouts;
+  DirInfo            *di = reinterpret_cast<DirInfo*>(ffi_->fh);
+  const fuse_context *fc = fuse_get_context();
+
+  attrs = ((cfg->func.getattr.policy.name() == "ff") &&
+           (cfg->follow_symlinks == FollowSymlinks::ENUM::NEVER) &&
+           !cfg->symlinkify);
+
+  timeouts.entry = cfg->cache_entry;
+  timeouts.attr  = cfg->cache_attr;
+
+  return l::readdir(_tp,
+                    cfg->branches,
+                    di->fusepath.c_str(),
+                    buf_,
+                    fc->uid,
+                    fc->gid,
+                    true,
+                    attrs,
+                    timeouts);
 }
@@ -16,11 +16,28 @@
 
 #pragma once
 
-#include "fuse.h"
+#include "branches.hpp"
+#include "fuse_readdir_base.hpp"
+
+#include "thread_pool.hpp"
 
 
 namespace FUSE
 {
-  int readdir_plus(fuse_file_info_t const *ffi,
+  // concurrent read with attributes fetched in batches
+  class ReadDirPlus final : public FUSE::ReadDirBase
+  {
+  public:
+    ReadDirPlus(unsigned concurrency,
+                unsigned max_queue_depth);
+    ~ReadDirPlus();
+
+    int operator()(fuse_file_info_t const *ffi,
                    fuse_dirents_t         *buf);
+    int plus(fuse_file_info_t const *ffi,
+             fuse_dirents_t         *buf);
+
+  private:
+    ThreadPool _tp;
+  };
 }
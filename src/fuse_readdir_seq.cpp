@@ -24,6 +24,7 @@
 #include "errno.hpp"
 #include "fs_closedir.hpp"
 #include "fs_devid.hpp"
+#include "fs_dirpresence.hpp"
 #include "fs_dirfd.hpp"
 #include "fs_inode.hpp"
 #include "fs_opendir.hpp"
@@ -91,7 +92,7 @@ namespace l
     Error error;
     HashSet names;
     std::string basepath;
-    std::string fullpath;
+    fs::inode::PathHash dirhash(dirname_);
 
     fuse_dirents_reset(buf_);
 
@@ -106,6 +107,8 @@ namespace l
         errno = 0;
         dh = fs::opendir(basepath);
         error = errno;
+        if(dh || (errno == ENOENT))
+          fs::dirpresence::found(branches_,branch,dirname_,!!dh);
         if(!dh)
           continue;
 
@@ -124,8 +127,9 @@ namespace l
             if(rv == 0)
               continue;
 
-            fullpath = fs::path::make(dirname_,de->d_name);
-            de->d_ino = fs::inode::calc(fullpath,
+            de->d_ino = fs::inode::calc(dirhash,
+                                        de->d_name,
+                                        namelen,
                                         DTTOIF(de->d_type),
                                         dev,
                                         de->d_ino);
@@ -0,0 +1,224 @@
+/*
+  ISC License
+
+  Copyright (c) 2024, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include "fuse_readdir_stream.hpp"
+#include "fuse_readdir_stream_state.hpp"
+
+#include "config.hpp"
+#include "dirinfo.hpp"
+#include "errno.hpp"
+#include "fs_close.hpp"
+#include "fs_devid.hpp"
+#include "fs_dirpresence.hpp"
+#include "fs_getdents64.hpp"
+#include "fs_inode.hpp"
+#include "fs_open.hpp"
+#include "fs_openat.hpp"
+#include "fs_path.hpp"
+#include "fs_pathbuf.hpp"
+#include "ugid.hpp"
+
+#include "fuse_dirents.h"
+#include "linux_dirent64.h"
+
+#include <string>
+
+#include <fcntl.h>
+
+
+FUSE::ReadDirStreamState::ReadDirStreamState(const Branches::Impl::CPtr &branches_)
+  : branches(branches_),
+    idx(0),
+    fd(-1),
+    dev(0),
+    error(ENOENT)
+{
+
+}
+
+FUSE::ReadDirStreamState::~ReadDirStreamState()
+{
+  if(fd >= 0)
+    fs::close(fd);
+}
+
+namespace l
+{
+  static
+  void
+  set_error(FUSE::ReadDirStreamState &state_,
+            const int                 err_)
+  {
+    if(state_.error != 0)
+      state_.error = err_;
+  }
+
+  static
+  int
+  open(const Branch &branch_,
+       const char   *dirname_)
+  {
+    int dirfd;
+    const int flags = (O_RDONLY|O_DIRECTORY|O_CLOEXEC);
+
+    dirfd = branch_.fd();
+    if(dirfd >= 0)
+      return fs::openat(dirfd,fs::path::rel(dirname_),flags);
+
+    return fs::open(fs::PathBuf(branch_.path,dirname_),flags);
+  }
+
+  static
+  void
+  next_branch(FUSE::ReadDirStreamState &state_)
+  {
+    if(state_.fd >= 0)
+      fs::close(state_.fd);
+    state_.fd = -1;
+    state_.idx++;
+  }
+
+  static
+  int
+  add_entries(FUSE::ReadDirStreamState &state_,
+              const char               *dirname_,
+              char                     *buf_,
+              const long                nread_,
+              fuse_dirents_t           *dirents_)
+  {
+    int rv;
+    linux_dirent64_t *d;
+    fs::inode::PathHash dirhash(dirname_);
+
+    for(long pos = 0; pos < nread_; pos += d->reclen)
+      {
+        std::uint64_t namelen;
+
+        d = (linux_dirent64_t*)&buf_[pos];
+
+        namelen = DIRENT_NAMELEN(d);
+
+        rv = state_.names.put(d->name,namelen);
+        if(rv == 0)
+          continue;
+
+        d->ino = fs::inode::calc(dirhash,
+                                 d->name,
+                                 namelen,
+                                 DTTOIF(d->type),
+                                 state_.dev,
+                                 d->ino);
+
+        rv = fuse_dirents_add_linux(dirents_,d,namelen);
+        if(rv < 0)
+          return -ENOMEM;
+      }
+
+    return 0;
+  }
+
+  /*
+    Reads branches in order until at least one new entry has been
+    added or all have been read. `more` tells libfuse whether to call
+    again when the kernel asks for entries past what's been added.
+  */
+  static
+  int
+  readdir(FUSE::ReadDirStreamState &state_,
+          const char               *dirname_,
+          fuse_dirents_t           *dirents_)
+  {
+    int rv;
+    std::size_t count;
+    const Branches::CPtr branches = state_.branches.get();
+
+    count = kv_size(dirents_->offs);
+    while(state_.idx < branches->size())
+      {
+        long nread;
+        char buf[32 * 1024];
+        const Branch &branch = (*branches)[state_.idx];
+
+        if(state_.fd == -1)
+          {
+            state_.fd = l::open(branch,dirname_);
+            if((state_.fd >= 0) || (errno == ENOENT))
+              fs::dirpresence::found(branches,branch,dirname_,(state_.fd >= 0));
+            if(state_.fd == -1)
+              {
+                l::set_error(state_,errno);
+                state_.idx++;
+                continue;
+              }
+
+            l::set_error(state_,0);
+            state_.dev = fs::devid(state_.fd);
+          }
+
+        nread = fs::getdents_64(state_.fd,buf,sizeof(buf));
+        if(nread <= 0)
+          {
+            if(nread == -1)
+              l::set_error(state_,errno);
+            l::next_branch(state_);
+            continue;
+          }
+
+        rv = l::add_entries(state_,dirname_,buf,nread,dirents_);
+        if(rv < 0)
+          return rv;
+
+        if(kv_size(dirents_->offs) > count)
+          break;
+      }
+
+    dirents_->more = (state_.idx < branches->size());
+    if(dirents_->more)
+      return 0;
+
+    if(kv_size(dirents_->offs) > 1)
+      return 0;
+
+    return -state_.error;
+  }
+}
+
+int
+FUSE::ReadDirStream::operator()(fuse_file_info_t const *ffi_,
+                                fuse_dirents_t         *buf_)
+{
+  int rv;
+  Config::Read        cfg;
+  DirInfo            *di = reinterpret_cast<DirInfo*>(ffi_->fh);
+  const fuse_context *fc = fuse_get_context();
+  const ugid::Set     ugid(fc->uid,fc->gid);
+
+  if(!buf_->more || !di->stream)
+    {
+      const Branches::CPtr branches = cfg->branches;
+
+      fuse_dirents_reset(buf_);
+      di->stream = std::make_shared<FUSE::ReadDirStreamState>(branches->shared_from_this());
+    }
+
+  rv = l::readdir(*di->stream,di->fusepath.c_str(),buf_);
+  if(!buf_->more)
+    di->stream.reset();
+
+  return rv;
+}
@@ -0,0 +1,46 @@
+/*
+  ISC License
+
+  Copyright (c) 2024, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#pragma once
+
+#include "branches.hpp"
+#include "hashset.hpp"
+
+#include <cstddef>
+
+
+namespace FUSE
+{
+  /*
+    Where a `stream` readdir left off. Held by the DirInfo between
+    requests. Only the hashes of names already returned are kept,
+    the entries themselves are in the handle's fuse_dirents_t.
+  */
+  struct ReadDirStreamState
+  {
+    ReadDirStreamState(const Branches::Impl::CPtr &branches);
+    ~ReadDirStreamState();
+
+    Branches::Impl::CPtr branches;
+    std::size_t          idx;
+    int                  fd;
+    dev_t                dev;
+    int                  error;
+    HashSet              names;
+  };
+}
@@ -17,8 +17,9 @@
 #include "config.hpp"
 #include "errno.hpp"
 #include "fs_lstat.hpp"
-#include "fs_path.hpp"
+#include "fs_pathbuf.hpp"
 #include "fs_readlink.hpp"
+#include "policy_cache.hpp"
 #include "symlinkify.hpp"
 #include "ugid.hpp"
 
@@ -33,7 +34,7 @@ namespace l
 {
   static
   int
-  readlink_core_standard(const string &fullpath_,
+  readlink_core_standard(const char   *fullpath_,
                          char         *buf_,
                          const size_t  size_)
 
@@ -51,7 +52,7 @@ namespace l
 
   static
   int
-  readlink_core_symlinkify(const string &fullpath_,
+  readlink_core_symlinkify(const char   *fullpath_,
                            char         *buf_,
                            const size_t  size_,
                            const time_t  symlinkify_timeout_)
@@ -66,23 +67,21 @@ namespace l
     if(!symlinkify::can_be_symlink(st,symlinkify_timeout_))
       return l::readlink_core_standard(fullpath_,buf_,size_);
 
-    strncpy(buf_,fullpath_.c_str(),size_);
+    strncpy(buf_,fullpath_,size_);
 
     return 0;
   }
 
   static
   int
-  readlink_core(const string &basepath_,
+  readlink_core(const Branch &branch_,
                 const char   *fusepath_,
                 char         *buf_,
                 const size_t  size_,
                 const bool    symlinkify_,
                 const time_t  symlinkify_timeout_)
   {
-    string fullpath;
-
-    fullpath = fs::path::make(basepath_,fusepath_);
+    fs::PathBuf fullpath(branch_.path,fusepath_);
 
     if(symlinkify_)
       return l::readlink_core_symlinkify(fullpath,buf_,size_,symlinkify_timeout_);
@@ -93,7 +92,7 @@ namespace l
   static
   int
   readlink(const Policy::Search &searchFunc_,
-           const Branches       &branches_,
+           const Branches::CPtr &branches_,
            const char           *fusepath_,
            char                 *buf_,
            const size_t          size_,
@@ -101,13 +100,13 @@ namespace l
            const time_t          symlinkify_timeout_)
   {
     int rv;
-    StrVec basepaths;
+    Branch::CPtrVec obranches;
 
-    rv = searchFunc_(branches_,fusepath_,&basepaths);
+    rv = g_POLICY_CACHE(searchFunc_,branches_,fusepath_,&obranches);
     if(rv == -1)
       return -errno;
 
-    return l::readlink_core(basepaths[0],fusepath_,buf_,size_,
+    return l::readlink_core(*obranches[0],fusepath_,buf_,size_,
                             symlinkify_,symlinkify_timeout_);
   }
 }
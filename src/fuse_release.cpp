@@ -14,11 +14,13 @@
   OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 */
 
+#include "attr_cache.hpp"
 #include "config.hpp"
 #include "errno.hpp"
 #include "fileinfo.hpp"
 #include "fs_close.hpp"
 #include "fs_fadvise.hpp"
+#include "passthrough.hpp"
 
 #include "fuse.h"
 
@@ -40,8 +42,13 @@ namespace l
         fs::fadvise_dontneed(fi_->fd);
       }
 
+    passthrough::close(fi_);
+
     fs::close(fi_->fd);
 
+    if(fi_->writer)
+      g_ATTR_CACHE.erase(fi_->fusepath.c_str());
+
     delete fi_;
 
     return 0;
@@ -14,10 +14,12 @@
   OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 */
 
+#include "attr_cache.hpp"
 #include "config.hpp"
 #include "errno.hpp"
+#include "fanout.hpp"
 #include "fs_lremovexattr.hpp"
-#include "fs_path.hpp"
+#include "fs_pathbuf.hpp"
 #include "policy_rv.hpp"
 #include "ugid.hpp"
 
@@ -35,17 +37,17 @@ namespace l
   static
   int
   get_error(const PolicyRV &prv_,
-            const string   &basepath_)
+            const Branch   *branch_)
   {
     for(int i = 0, ei = prv_.success.size(); i < ei; i++)
       {
-        if(prv_.success[i].basepath == basepath_)
+        if(prv_.success[i].branch == branch_)
           return prv_.success[i].rv;
       }
 
     for(int i = 0, ei = prv_.error.size(); i < ei; i++)
       {
-        if(prv_.error[i].basepath == basepath_)
+        if(prv_.error[i].branch == branch_)
           return prv_.error[i].rv;
       }
 
@@ -53,63 +55,62 @@ namespace l
   }
 
   static
-  void
-  removexattr_loop_core(const string &basepath_,
+  int
+  removexattr_loop_core(const Branch &branch_,
                         const char   *fusepath_,
-                        const char   *attrname_,
-                        PolicyRV     *prv_)
+                        const char   *attrname_)
   {
-    string fullpath;
-
-    fullpath = fs::path::make(basepath_,fusepath_);
+    fs::PathBuf fullpath(branch_.path,fusepath_);
 
     errno = 0;
     fs::lremovexattr(fullpath,attrname_);
 
-    prv_->insert(errno,basepath_);
+    return errno;
   }
 
   static
   void
-  removexattr_loop(const vector<string> &basepaths_,
-                   const char           *fusepath_,
-                   const char           *attrname_,
-                   PolicyRV             *prv_)
+  removexattr_loop(const Branch::CPtrVec &branches_,
+                   const char            *fusepath_,
+                   const char            *attrname_,
+                   PolicyRV              *prv_)
   {
-    for(size_t i = 0, ei = basepaths_.size(); i != ei; i++)
-      {
-        l::removexattr_loop_core(basepaths_[i],fusepath_,attrname_,prv_);
-      }
+    auto func = [&](const Branch &branch_)
+    {
+      return l::removexattr_loop_core(branch_,fusepath_,attrname_);
+    };
+
+    fanout::for_each(branches_,func,prv_);
   }
 
   static
   int
   removexattr(const Policy::Action &actionFunc_,
               const Policy::Search &searchFunc_,
-              const Branches       &branches_,
+              const Branches::CPtr &branches_,
               const char           *fusepath_,
               const char           *attrname_)
   {
     int rv;
     PolicyRV prv;
-    vector<string> basepaths;
+    Branch::CPtrVec obranches;
 
-    rv = actionFunc_(branches_,fusepath_,&basepaths);
+    rv = actionFunc_(branches_,fusepath_,&obranches);
     if(rv == -1)
       return -errno;
 
-    l::removexattr_loop(basepaths,fusepath_,attrname_,&prv);
+    l::removexattr_loop(obranches,fusepath_,attrname_,&prv);
     if(prv.error.empty())
       return 0;
     if(prv.success.empty())
       return prv.error[0].rv;
 
-    basepaths.clear();
-    rv = searchFunc_(branches_,fusepath_,&basepaths);
+    obranches.clear();
+    rv = searchFunc_(branches_,fusepath_,&obranches);
     if(rv == -1)
       return -errno;
 
-    return l::get_error(prv,basepaths[0]);
+    return l::get_error(prv,obranches[0]);
   }
 }
 
@@ -119,6 +120,7 @@ namespace FUSE
   removexattr(const char *fusepath_,
               const char *attrname_)
   {
+    int rv;
     Config::Read cfg;
 
     if(fusepath_ == CONTROLFILE)
@@ -130,10 +132,14 @@ namespace FUSE
     const fuse_context *fc = fuse_get_context();
     const ugid::Set     ugid(fc->uid,fc->gid);
 
-    return l::removexattr(cfg->func.removexattr.policy,
-                          cfg->func.getxattr.policy,
-                          cfg->branches,
-                          fusepath_,
-                          attrname_);
+    rv = l::removexattr(cfg->func.removexattr.policy,
+                        cfg->func.getxattr.policy,
+                        cfg->branches,
+                        fusepath_,
+                        attrname_);
+
+    g_ATTR_CACHE.erase(fusepath_);
+
+    return rv;
   }
 }
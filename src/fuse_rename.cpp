@@ -14,17 +14,24 @@
   OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 */
 
+#include "attr_cache.hpp"
 #include "config.hpp"
 #include "errno.hpp"
+#include "fanout.hpp"
 #include "fs_clonepath.hpp"
+#include "fs_dirpresence.hpp"
+#include "fs_exists.hpp"
 #include "fs_link.hpp"
 #include "fs_mkdir_as_root.hpp"
 #include "fs_path.hpp"
+#include "fs_pathbuf.hpp"
+#include "fs_renameat2.hpp"
 #include "fs_remove.hpp"
 #include "fs_rename.hpp"
 #include "fs_symlink.hpp"
 #include "fs_unlink.hpp"
 #include "fuse_symlink.hpp"
+#include "policy_cache.hpp"
 #include "ugid.hpp"
 
 #include "ghc/filesystem.hpp"
@@ -62,10 +69,10 @@ namespace l
 {
   static
   bool
-  contains(const StrVec &haystack_,
-           const char   *needle_)
+  contains(const Branch::CPtrVec &haystack_,
+           const Branch          *needle_)
   {
-    for(auto &hay : haystack_)
+    for(const Branch *hay : haystack_)
       {
         if(hay == needle_)
           return true;
@@ -74,14 +81,6 @@ namespace l
     return false;
   }
 
-  static
-  bool
-  contains(const StrVec &haystack_,
-           const string &needle_)
-  {
-    return l::contains(haystack_,needle_.c_str());
-  }
-
   static
   void
   remove(const StrVec &toremove_)
@@ -104,6 +103,23 @@ namespace l
       }
   }
 
+  static
+  int
+  rename(const Branch    &branch_,
+         const gfs::path &oldfusepath_,
+         const gfs::path &newfusepath_)
+  {
+    int dirfd;
+
+    dirfd = branch_.fd();
+    if(dirfd >= 0)
+      return fs::renameat(dirfd,fs::path::rel(oldfusepath_.c_str()),
+                          dirfd,fs::path::rel(newfusepath_.c_str()));
+
+    return fs::rename(fs::PathBuf(branch_.path,oldfusepath_.c_str()),
+                      fs::PathBuf(branch_.path,newfusepath_.c_str()));
+  }
+
   static
   int
   rename_create_path(const Policy::Search &searchPolicy_,
@@ -115,45 +131,63 @@ namespace l
     int rv;
     int error;
     StrVec toremove;
-    StrVec newbasepath;
-    StrVec oldbasepaths;
+    std::vector<int> errs;
     gfs::path oldfullpath;
     gfs::path newfullpath;
+    Branch::CPtrVec renames;
+    Branch::CPtrVec newbranches;
+    Branch::CPtrVec oldbranches;
 
-    rv = actionPolicy_(branches_,oldfusepath_,&oldbasepaths);
+    rv = actionPolicy_(branches_,oldfusepath_,&oldbranches);
     if(rv == -1)
       return -errno;
 
-    rv = searchPolicy_(branches_,newfusepath_.parent_path(),&newbasepath);
+    rv = searchPolicy_(branches_,newfusepath_.parent_path(),&newbranches);
     if(rv == -1)
       return -errno;
 
-    error = -1;
     for(auto &branch : *branches_)
       {
         newfullpath  = branch.path;
         newfullpath += newfusepath_;
 
-        if(!l::contains(oldbasepaths,branch.path))
+        if(!l::contains(oldbranches,&branch))
           {
             toremove.push_back(newfullpath);
             continue;
           }
 
-        oldfullpath  = branch.path;
-        oldfullpath += oldfusepath_;
+        renames.push_back(&branch);
+      }
+
+    auto func = [&](const Branch &branch_)
+    {
+      int rv;
+
+      rv = l::rename(branch_,oldfusepath_,newfusepath_);
+      if(rv == -1)
+        {
+          rv = fs::clonepath_as_root(newbranches[0]->path,branch_.path,newfusepath_.parent_path());
+          if(rv == 0)
+            rv = l::rename(branch_,oldfusepath_,newfusepath_);
+        }
+
+      return ((rv == -1) ? errno : 0);
+    };
 
-        rv = fs::rename(oldfullpath,newfullpath);
+    fanout::for_each(renames,func,&errs);
+
+    error = -1;
+    for(size_t i = 0, ei = renames.size(); i != ei; i++)
+      {
+        rv = (errs[i] ? -1 : 0);
+        error = error::calc(rv,error,errs[i]);
         if(rv == -1)
           {
-            rv = fs::clonepath_as_root(newbasepath[0],branch.path,newfusepath_.parent_path());
-            if(rv == 0)
-              rv = fs::rename(oldfullpath,newfullpath);
+            oldfullpath  = renames[i]->path;
+            oldfullpath += oldfusepath_;
+            toremove.push_back(oldfullpath);
           }
-
-        error = error::calc(rv,error,errno);
-        if(rv == -1)
-          toremove.push_back(oldfullpath);
       }
 
     if(error == 0)
@@ -172,37 +206,53 @@ namespace l
     int rv;
     bool success;
     StrVec toremove;
-    StrVec oldbasepaths;
+    std::vector<int> errs;
     gfs::path oldfullpath;
     gfs::path newfullpath;
+    Branch::CPtrVec renames;
+    Branch::CPtrVec oldbranches;
 
-    rv = actionPolicy_(branches_,oldfusepath_,&oldbasepaths);
+    rv = actionPolicy_(branches_,oldfusepath_,&oldbranches);
     if(rv == -1)
       return -errno;
 
-    success = false;
     for(auto &branch : *branches_)
       {
         newfullpath  = branch.path;
         newfullpath += newfusepath_;
 
-        if(!l::contains(oldbasepaths,branch.path))
+        if(!l::contains(oldbranches,&branch))
           {
             toremove.push_back(newfullpath);
             continue;
           }
 
-        oldfullpath  = branch.path;
-        oldfullpath += oldfusepath_;
+        renames.push_back(&branch);
+      }
 
-        rv = fs::rename(oldfullpath,newfullpath);
-        if(rv == -1)
+    auto func = [&](const Branch &branch_)
+    {
+      int rv;
+
+      rv = l::rename(branch_,oldfusepath_,newfusepath_);
+
+      return ((rv == -1) ? errno : 0);
+    };
+
+    fanout::for_each(renames,func,&errs);
+
+    success = false;
+    for(size_t i = 0, ei = renames.size(); i != ei; i++)
+      {
+        if(errs[i] == 0)
           {
-            toremove.push_back(oldfullpath);
+            success = true;
             continue;
           }
 
-        success = true;
+        oldfullpath  = renames[i]->path;
+        oldfullpath += oldfusepath_;
+        toremove.push_back(oldfullpath);
       }
 
     // TODO: probably should try to be nuanced here.
@@ -216,19 +266,19 @@ namespace l
 
   static
   void
-  rename_exdev_rename_back(const StrVec    &basepaths_,
-                           const gfs::path &oldfusepath_)
+  rename_exdev_rename_back(const Branch::CPtrVec &branches_,
+                           const gfs::path       &oldfusepath_)
   {
     gfs::path oldpath;
     gfs::path newpath;
 
-    for(auto &basepath : basepaths_)
+    for(const Branch *branch : branches_)
       {
-        oldpath  = basepath;
+        oldpath  = branch->path;
         oldpath /= ".mergerfs_rename_exdev";
         oldpath += oldfusepath_;
 
-        newpath  = basepath;
+        newpath  = branch->path;
         newpath += oldfusepath_;
 
         fs::rename(oldpath,newpath);
@@ -240,21 +290,21 @@ namespace l
   rename_exdev_rename_target(const Policy::Action &actionPolicy_,
                              const Branches::CPtr &branches_,
                              const gfs::path      &oldfusepath_,
-                             StrVec               *basepaths_)
+                             Branch::CPtrVec      *obranches_)
   {
     int rv;
     gfs::path clonesrc;
     gfs::path clonetgt;
 
-    rv = actionPolicy_(branches_,oldfusepath_,basepaths_);
+    rv = actionPolicy_(branches_,oldfusepath_,obranches_);
     if(rv == -1)
       return -errno;
 
     ugid::SetRootGuard ugidGuard;
-    for(auto &basepath : *basepaths_)
+    for(const Branch *branch : *obranches_)
       {
-        clonesrc  = basepath;
-        clonetgt  = basepath;
+        clonesrc  = branch->path;
+        clonetgt  = branch->path;
         clonetgt /= ".mergerfs_rename_exdev";
 
         rv = fs::clonepath(clonesrc,clonetgt,oldfusepath_.parent_path());
@@ -278,7 +328,7 @@ namespace l
     return 0;
 
   error:
-    l::rename_exdev_rename_back(*basepaths_,oldfusepath_);
+    l::rename_exdev_rename_back(*obranches_,oldfusepath_);
 
     return -EXDEV;
   }
@@ -291,11 +341,11 @@ namespace l
                            const gfs::path      &newfusepath_)
   {
     int rv;
-    StrVec basepaths;
+    Branch::CPtrVec obranches;
     gfs::path target;
     gfs::path linkpath;
 
-    rv = l::rename_exdev_rename_target(actionPolicy_,branches_,oldfusepath_,&basepaths);
+    rv = l::rename_exdev_rename_target(actionPolicy_,branches_,oldfusepath_,&obranches);
     if(rv < 0)
       return rv;
 
@@ -306,7 +356,7 @@ namespace l
 
     rv = FUSE::symlink(target.c_str(),linkpath.c_str());
     if(rv < 0)
-      l::rename_exdev_rename_back(basepaths,oldfusepath_);
+      l::rename_exdev_rename_back(obranches,oldfusepath_);
 
     return rv;
   }
@@ -320,11 +370,11 @@ namespace l
                            const gfs::path      &newfusepath_)
   {
     int rv;
-    StrVec basepaths;
+    Branch::CPtrVec obranches;
     gfs::path target;
     gfs::path linkpath;
 
-    rv = l::rename_exdev_rename_target(actionPolicy_,branches_,oldfusepath_,&basepaths);
+    rv = l::rename_exdev_rename_target(actionPolicy_,branches_,oldfusepath_,&obranches);
     if(rv < 0)
       return rv;
 
@@ -335,7 +385,7 @@ namespace l
 
     rv = FUSE::symlink(target.c_str(),linkpath.c_str());
     if(rv < 0)
-      l::rename_exdev_rename_back(basepaths,oldfusepath_);
+      l::rename_exdev_rename_back(obranches,oldfusepath_);
 
     return rv;
   }
@@ -384,6 +434,30 @@ namespace l
                                  oldpath_,
                                  newpath_);
   }
+
+  /*
+    Only a directory has cached entries beneath it so walking the
+    caches for them is skipped for anything else. When unsure, such
+    as after a rename which failed and may be partial, assume it is.
+  */
+  static
+  bool
+  maybe_dir(const Branches::CPtr &branches_,
+            const char           *fusepath_)
+  {
+    struct stat st;
+
+    for(const auto &branch : *branches_)
+      {
+        errno = 0;
+        if(fs::exists(branch,fusepath_,&st))
+          return S_ISDIR(st.st_mode);
+        if(errno != ENOENT)
+          return true;
+      }
+
+    return true;
+  }
 }
 
 namespace FUSE
@@ -393,6 +467,7 @@ namespace FUSE
          const char *newfusepath_)
   {
     int rv;
+    bool dir;
     Config::Read cfg;
     gfs::path oldfusepath(oldfusepath_);
     gfs::path newfusepath(newfusepath_);
@@ -401,7 +476,33 @@ namespace FUSE
 
     rv = l::rename(cfg,oldfusepath,newfusepath);
     if(rv == -EXDEV)
-      return l::rename_exdev(cfg,oldfusepath,newfusepath);
+      rv = l::rename_exdev(cfg,oldfusepath,newfusepath);
+
+    // Failures can leave partial changes behind so always invalidate
+    fs::dirpresence::rename(oldfusepath_,newfusepath_);
+    if(!g_POLICY_CACHE.enabled() && !g_ATTR_CACHE.enabled())
+      return rv;
+
+    dir = ((rv < 0) || l::maybe_dir(cfg->branches,newfusepath_));
+    if(dir)
+      {
+        g_POLICY_CACHE.erase_tree(oldfusepath_);
+        g_POLICY_CACHE.erase_tree(newfusepath_);
+        g_ATTR_CACHE.erase_tree(oldfusepath_);
+        g_ATTR_CACHE.erase_tree(newfusepath_);
+      }
+    else
+      {
+        g_POLICY_CACHE.erase(oldfusepath_);
+        g_POLICY_CACHE.erase(newfusepath_);
+        g_ATTR_CACHE.erase_entry(oldfusepath_);
+        g_ATTR_CACHE.erase_entry(newfusepath_);
+      }
+    if(rv < 0)
+      {
+        g_ATTR_CACHE.notify(oldfusepath_);
+        g_ATTR_CACHE.notify(newfusepath_);
+      }
 
     return rv;
   }
@@ -14,11 +14,15 @@
   OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 */
 
+#include "attr_cache.hpp"
 #include "config.hpp"
 #include "errno.hpp"
-#include "fs_path.hpp"
+#include "fanout.hpp"
+#include "fs_dirpresence.hpp"
+#include "fs_pathbuf.hpp"
 #include "fs_rmdir.hpp"
 #include "fs_unlink.hpp"
+#include "policy_cache.hpp"
 #include "ugid.hpp"
 
 #include "fuse.h"
@@ -62,36 +66,41 @@ namespace l
 
   static
   int
-  rmdir_core(const string         &basepath_,
+  rmdir_core(const Branch         &branch_,
              const char           *fusepath_,
-             const FollowSymlinks  followsymlinks_,
-             const int             error_)
+             const FollowSymlinks  followsymlinks_)
   {
     int rv;
-    string fullpath;
-
-    fullpath = fs::path::make(basepath_,fusepath_);
+    fs::PathBuf fullpath(branch_.path,fusepath_);
 
     rv = fs::rmdir(fullpath);
     if(l::should_unlink(rv,errno,followsymlinks_))
       rv = fs::unlink(fullpath);
+    if(rv != -1)
+      fs::dirpresence::set(branch_.path,fusepath_,false);
 
-    return error::calc(rv,error_,errno);
+    return ((rv == -1) ? errno : 0);
   }
 
   static
   int
-  rmdir_loop(const StrVec         &basepaths_,
-             const char           *fusepath_,
-             const FollowSymlinks  followsymlinks_)
+  rmdir_loop(const Branch::CPtrVec &branches_,
+             const char            *fusepath_,
+             const FollowSymlinks   followsymlinks_)
   {
     int error;
+    std::vector<int> errs;
+
+    auto func = [&](const Branch &branch_)
+    {
+      return l::rmdir_core(branch_,fusepath_,followsymlinks_);
+    };
+
+    fanout::for_each(branches_,func,&errs);
 
     error = 0;
-    for(size_t i = 0, ei = basepaths_.size(); i != ei; i++)
-      {
-        error = l::rmdir_core(basepaths_[i],fusepath_,followsymlinks_,error);
-      }
+    for(const auto err : errs)
+      error = error::calc((err ? -1 : 0),error,err);
 
     return -error;
   }
@@ -99,18 +108,18 @@ namespace l
   static
   int
   rmdir(const Policy::Action &actionFunc_,
-        const Branches       &branches_,
+        const Branches::CPtr &branches_,
         const FollowSymlinks  followsymlinks_,
         const char           *fusepath_)
   {
     int rv;
-    vector<string> basepaths;
+    Branch::CPtrVec obranches;
 
-    rv = actionFunc_(branches_,fusepath_,&basepaths);
+    rv = actionFunc_(branches_,fusepath_,&obranches);
     if(rv == -1)
       return -errno;
 
-    return l::rmdir_loop(basepaths,fusepath_,followsymlinks_);
+    return l::rmdir_loop(obranches,fusepath_,followsymlinks_);
   }
 }
 
@@ -119,13 +128,19 @@ namespace FUSE
   int
   rmdir(const char *fusepath_)
   {
+    int rv;
     Config::Read cfg;
     const fuse_context *fc = fuse_get_context();
     const ugid::Set     ugid(fc->uid,fc->gid);
 
-    return l::rmdir(cfg->func.rmdir.policy,
-                    cfg->branches,
-                    cfg->follow_symlinks,
-                    fusepath_);
+    rv = l::rmdir(cfg->func.rmdir.policy,
+                  cfg->branches,
+                  cfg->follow_symlinks,
+                  fusepath_);
+
+    g_POLICY_CACHE.erase(fusepath_);
+    g_ATTR_CACHE.erase_entry(fusepath_);
+
+    return rv;
   }
 }
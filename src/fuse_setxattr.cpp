@@ -14,18 +14,25 @@
   OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 */
 
+#include "attr_cache.hpp"
 #include "config.hpp"
+#include "dir_cache.hpp"
 #include "errno.hpp"
+#include "fanout.hpp"
+#include "fs_dirpresence.hpp"
 #include "fs_glob.hpp"
 #include "fs_lsetxattr.hpp"
-#include "fs_path.hpp"
+#include "fs_pathbuf.hpp"
 #include "fs_statvfs_cache.hpp"
 #include "num.hpp"
+#include "policy_cache.hpp"
+#include "policy_lat.hpp"
 #include "policy_rv.hpp"
 #include "str.hpp"
 #include "ugid.hpp"
 
 #include "fuse.h"
+#include "fuse_dirents.h"
 
 #include <string>
 #include <vector>
@@ -43,17 +50,17 @@ namespace l
   static
   int
   get_error(const PolicyRV &prv_,
-            const string   &basepath_)
+            const Branch   *branch_)
   {
     for(int i = 0, ei = prv_.success.size(); i < ei; i++)
       {
-        if(prv_.success[i].basepath == basepath_)
+        if(prv_.success[i].branch == branch_)
           return prv_.success[i].rv;
       }
 
     for(int i = 0, ei = prv_.error.size(); i < ei; i++)
       {
-        if(prv_.error[i].basepath == basepath_)
+        if(prv_.error[i].branch == branch_)
           return prv_.error[i].rv;
       }
 
@@ -93,53 +100,64 @@ namespace l
       return rv;
 
     fs::statvfs_cache_timeout(cfg->cache_statfs);
+    fanout::max(cfg->action_concurrency);
+    fs::dirpresence::timeout(cfg->cache_dir_presence);
+    Policy::LAT::hysteresis(cfg->lat_hysteresis);
+    g_POLICY_CACHE.timeout = cfg->cache_search_policy;
+    g_POLICY_CACHE.max     = cfg->cache_search_policy_max;
+    g_ATTR_CACHE.timeout   = cfg->cache_getattr;
+    g_ATTR_CACHE.max       = cfg->cache_getattr_max;
+    g_DIR_CACHE.max        = (cfg->cache_dirents * 1024 * 1024);
+    fuse_dirents_spill_size(cfg->readdir_spill * 1024 * 1024);
+    // Policy, symlink and inode options change what is returned.
+    g_ATTR_CACHE.clear();
+    g_DIR_CACHE.clear();
 
     return rv;
   }
 
   static
-  void
-  setxattr_loop_core(const string &basepath_,
+  int
+  setxattr_loop_core(const Branch &branch_,
                      const char   *fusepath_,
                      const char   *attrname_,
                      const char   *attrval_,
                      const size_t  attrvalsize_,
-                     const int     flags_,
-                     PolicyRV     *prv_)
+                     const int     flags_)
   {
-    string fullpath;
-
-    fullpath = fs::path::make(basepath_,fusepath_);
+    fs::PathBuf fullpath(branch_.path,fusepath_);
 
     errno = 0;
     fs::lsetxattr(fullpath,attrname_,attrval_,attrvalsize_,flags_);
 
-    prv_->insert(errno,basepath_);
+    return errno;
   }
 
   static
   void
-  setxattr_loop(const StrVec &basepaths_,
-                const char   *fusepath_,
-                const char   *attrname_,
-                const char   *attrval_,
-                const size_t  attrvalsize_,
-                const int     flags_,
-                PolicyRV     *prv_)
+  setxattr_loop(const Branch::CPtrVec &branches_,
+                const char            *fusepath_,
+                const char            *attrname_,
+                const char            *attrval_,
+                const size_t           attrvalsize_,
+                const int              flags_,
+                PolicyRV              *prv_)
   {
-    for(size_t i = 0, ei = basepaths_.size(); i != ei; i++)
-      {
-        l::setxattr_loop_core(basepaths_[i],fusepath_,
-                              attrname_,attrval_,attrvalsize_,
-                              flags_,prv_);
-      }
+    auto func = [&](const Branch &branch_)
+    {
+      return l::setxattr_loop_core(branch_,fusepath_,
+                                   attrname_,attrval_,attrvalsize_,
+                                   flags_);
+    };
+
+    fanout::for_each(branches_,func,prv_);
   }
 
   static
   int
   setxattr(const Policy::Action &setxattrPolicy_,
            const Policy::Search &getxattrPolicy_,
-           const Branches       &branches_,
+           const Branches::CPtr &branches_,
            const char           *fusepath_,
            const char           *attrname_,
            const char           *attrval_,
@@ -148,24 +166,24 @@ namespace l
   {
     int rv;
     PolicyRV prv;
-    StrVec basepaths;
+    Branch::CPtrVec obranches;
 
-    rv = setxattrPolicy_(branches_,fusepath_,&basepaths);
+    rv = setxattrPolicy_(branches_,fusepath_,&obranches);
     if(rv == -1)
       return -errno;
 
-    l::setxattr_loop(basepaths,fusepath_,attrname_,attrval_,attrvalsize_,flags_,&prv);
+    l::setxattr_loop(obranches,fusepath_,attrname_,attrval_,attrvalsize_,flags_,&prv);
     if(prv.error.empty())
       return 0;
     if(prv.success.empty())
       return prv.error[0].rv;
 
-    basepaths.clear();
-    rv = getxattrPolicy_(branches_,fusepath_,&basepaths);
+    obranches.clear();
+    rv = getxattrPolicy_(branches_,fusepath_,&obranches);
     if(rv == -1)
       return -errno;
 
-    return l::get_error(prv,basepaths[0]);
+    return l::get_error(prv,obranches[0]);
   }
 
   int
@@ -207,11 +225,16 @@ namespace FUSE
            size_t      attrvalsize_,
            int         flags_)
   {
+    int rv;
+
     if(fusepath_ == CONTROLFILE)
       return l::setxattr_controlfile(attrname_,
                                      string(attrval_,attrvalsize_),
                                      flags_);
 
-    return l::setxattr(fusepath_,attrname_,attrval_,attrvalsize_,flags_);
+    rv = l::setxattr(fusepath_,attrname_,attrval_,attrvalsize_,flags_);
+    g_ATTR_CACHE.erase(fusepath_);
+
+    return rv;
   }
 }
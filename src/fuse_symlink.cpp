@@ -14,14 +14,17 @@
   OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 */
 
+#include "attr_cache.hpp"
 #include "config.hpp"
 #include "errno.hpp"
 #include "fs_clonepath.hpp"
 #include "fs_lstat.hpp"
 #include "fs_path.hpp"
+#include "fs_pathbuf.hpp"
 #include "fs_inode.hpp"
 #include "fs_symlink.hpp"
 #include "fuse_getattr.hpp"
+#include "policy_cache.hpp"
 #include "ugid.hpp"
 
 #include "fuse.h"
@@ -58,16 +61,14 @@ namespace l
 {
   static
   int
-  symlink_loop_core(const string &newbasepath_,
+  symlink_loop_core(const Branch &newbranch_,
                     const char   *target_,
                     const char   *linkpath_,
                     struct stat  *st_,
                     const int     error_)
   {
     int rv;
-    string fullnewpath;
-
-    fullnewpath = fs::path::make(newbasepath_,linkpath_);
+    fs::PathBuf fullnewpath(newbranch_.path,linkpath_);
 
     rv = fs::symlink(target_,fullnewpath);
     if((rv != -1) && (st_ != NULL) && (st_->st_ino == 0))
@@ -82,24 +83,24 @@ namespace l
 
   static
   int
-  symlink_loop(const string &existingpath_,
-               const StrVec &newbasepaths_,
-               const char   *target_,
-               const char   *linkpath_,
-               const string &newdirpath_,
-               struct stat  *st_)
+  symlink_loop(const Branch          &existingbranch_,
+               const Branch::CPtrVec &newbranches_,
+               const char            *target_,
+               const char            *linkpath_,
+               const string          &newdirpath_,
+               struct stat           *st_)
   {
     int rv;
     int error;
 
     error = -1;
-    for(size_t i = 0, ei = newbasepaths_.size(); i != ei; i++)
+    for(const Branch *newbranch : newbranches_)
       {
-        rv = fs::clonepath_as_root(existingpath_,newbasepaths_[i],newdirpath_);
+        rv = fs::clonepath_as_root(existingbranch_.path,newbranch->path,newdirpath_);
         if(rv == -1)
           error = error::calc(rv,error,errno);
         else
-          error = l::symlink_loop_core(newbasepaths_[i],
+          error = l::symlink_loop_core(*newbranch,
                                        target_,
                                        linkpath_,
                                        st_,
@@ -113,27 +114,27 @@ namespace l
   int
   symlink(const Policy::Search &searchFunc_,
           const Policy::Create &createFunc_,
-          const Branches       &branches_,
+          const Branches::CPtr &branches_,
           const char           *target_,
           const char           *linkpath_,
           struct stat          *st_)
   {
     int rv;
     string newdirpath;
-    StrVec newbasepaths;
-    StrVec existingpaths;
+    Branch::CPtrVec newbranches;
+    Branch::CPtrVec existingbranches;
 
     newdirpath = fs::path::dirname(linkpath_);
 
-    rv = searchFunc_(branches_,newdirpath,&existingpaths);
+    rv = searchFunc_(branches_,newdirpath,&existingbranches);
     if(rv == -1)
       return -errno;
 
-    rv = createFunc_(branches_,newdirpath,&newbasepaths);
+    rv = createFunc_(branches_,newdirpath,&newbranches);
     if(rv == -1)
       return -errno;
 
-    return l::symlink_loop(existingpaths[0],newbasepaths,
+    return l::symlink_loop(*existingbranches[0],newbranches,
                            target_,linkpath_,newdirpath,st_);
   }
 }
@@ -168,6 +169,9 @@ namespace FUSE
                         st_);
       }
 
+    g_POLICY_CACHE.erase(linkpath_);
+    g_ATTR_CACHE.erase_entry(linkpath_);
+
     if(timeouts_ != NULL)
       {
         switch(cfg->follow_symlinks)
@@ -14,9 +14,11 @@
   OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 */
 
+#include "attr_cache.hpp"
 #include "config.hpp"
 #include "errno.hpp"
-#include "fs_path.hpp"
+#include "fanout.hpp"
+#include "fs_pathbuf.hpp"
 #include "fs_truncate.hpp"
 #include "policy_rv.hpp"
 #include "ugid.hpp"
@@ -36,17 +38,17 @@ namespace l
   static
   int
   get_error(const PolicyRV &prv_,
-            const string   &basepath_)
+            const Branch   *branch_)
   {
     for(int i = 0, ei = prv_.success.size(); i < ei; i++)
       {
-        if(prv_.success[i].basepath == basepath_)
+        if(prv_.success[i].branch == branch_)
           return prv_.success[i].rv;
       }
 
     for(int i = 0, ei = prv_.error.size(); i < ei; i++)
       {
-        if(prv_.error[i].basepath == basepath_)
+        if(prv_.error[i].branch == branch_)
           return prv_.error[i].rv;
       }
 
@@ -54,63 +56,62 @@ namespace l
   }
 
   static
-  void
-  truncate_loop_core(const string &basepath_,
+  int
+  truncate_loop_core(const Branch &branch_,
                      const char   *fusepath_,
-                     const off_t   size_,
-                     PolicyRV     *prv_)
+                     const off_t   size_)
   {
-    string fullpath;
-
-    fullpath = fs::path::make(basepath_,fusepath_);
+    fs::PathBuf fullpath(branch_.path,fusepath_);
 
     errno = 0;
     fs::truncate(fullpath,size_);
 
-    prv_->insert(errno,basepath_);
+    return errno;
   }
 
   static
   void
-  truncate_loop(const StrVec &basepaths_,
-                const char   *fusepath_,
-                const off_t   size_,
-                PolicyRV     *prv_)
+  truncate_loop(const Branch::CPtrVec &branches_,
+                const char            *fusepath_,
+                const off_t            size_,
+                PolicyRV              *prv_)
   {
-    for(size_t i = 0, ei = basepaths_.size(); i != ei; i++)
-      {
-        l::truncate_loop_core(basepaths_[i],fusepath_,size_,prv_);
-      }
+    auto func = [&](const Branch &branch_)
+    {
+      return l::truncate_loop_core(branch_,fusepath_,size_);
+    };
+
+    fanout::for_each(branches_,func,prv_);
   }
 
   static
   int
   truncate(const Policy::Action &actionFunc_,
            const Policy::Search &searchFunc_,
-           const Branches       &branches_,
+           const Branches::CPtr &branches_,
            const char           *fusepath_,
            const off_t           size_)
   {
     int rv;
     PolicyRV prv;
-    StrVec basepaths;
+    Branch::CPtrVec obranches;
 
-    rv = actionFunc_(branches_,fusepath_,&basepaths);
+    rv = actionFunc_(branches_,fusepath_,&obranches);
     if(rv == -1)
       return -errno;
 
-    l::truncate_loop(basepaths,fusepath_,size_,&prv);
+    l::truncate_loop(obranches,fusepath_,size_,&prv);
     if(prv.error.empty())
       return 0;
     if(prv.success.empty())
       return prv.error[0].rv;
 
-    basepaths.clear();
-    rv = searchFunc_(branches_,fusepath_,&basepaths);
+    obranches.clear();
+    rv = searchFunc_(branches_,fusepath_,&obranches);
     if(rv == -1)
       return -errno;
 
-    return l::get_error(prv,basepaths[0]);
+    return l::get_error(prv,obranches[0]);
   }
 }
 
@@ -120,14 +121,19 @@ namespace FUSE
   truncate(const char *fusepath_,
            off_t       size_)
   {
+    int rv;
     Config::Read cfg;
     const fuse_context *fc = fuse_get_context();
     const ugid::Set     ugid(fc->uid,fc->gid);
 
-    return l::truncate(cfg->func.truncate.policy,
-                       cfg->func.getattr.policy,
-                       cfg->branches,
-                       fusepath_,
-                       size_);
+    rv = l::truncate(cfg->func.truncate.policy,
+                     cfg->func.getattr.policy,
+                     cfg->branches,
+                     fusepath_,
+                     size_);
+
+    g_ATTR_CACHE.erase(fusepath_);
+
+    return rv;
   }
 }
@@ -14,10 +14,15 @@
   OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 */
 
+#include "attr_cache.hpp"
 #include "config.hpp"
 #include "errno.hpp"
+#include "fanout.hpp"
 #include "fs_path.hpp"
+#include "fs_pathbuf.hpp"
 #include "fs_unlink.hpp"
+#include "fs_unlinkat.hpp"
+#include "policy_cache.hpp"
 #include "ugid.hpp"
 
 #include "fuse.h"
@@ -52,32 +57,37 @@ namespace l
 {
   static
   int
-  unlink_loop_core(const string &basepath_,
-                   const char   *fusepath_,
-                   const int     error_)
+  unlink_loop_core(const Branch &branch_,
+                   const char   *fusepath_)
   {
     int rv;
-    string fullpath;
 
-    fullpath = fs::path::make(basepath_,fusepath_);
+    if(branch_.fd() >= 0)
+      rv = fs::unlinkat(branch_.fd(),fs::path::rel(fusepath_),0);
+    else
+      rv = fs::unlink(fs::PathBuf(branch_.path,fusepath_));
 
-    rv = fs::unlink(fullpath);
-
-    return error::calc(rv,error_,errno);
+    return ((rv == -1) ? errno : 0);
   }
 
   static
   int
-  unlink_loop(const vector<string> &basepaths_,
-              const char           *fusepath_)
+  unlink_loop(const Branch::CPtrVec &branches_,
+              const char            *fusepath_)
   {
     int error;
+    std::vector<int> errs;
+
+    auto func = [&](const Branch &branch_)
+    {
+      return l::unlink_loop_core(branch_,fusepath_);
+    };
+
+    fanout::for_each(branches_,func,&errs);
 
     error = 0;
-    for(size_t i = 0, ei = basepaths_.size(); i != ei; i++)
-      {
-        error = l::unlink_loop_core(basepaths_[i],fusepath_,error);
-      }
+    for(const auto err : errs)
+      error = error::calc((err ? -1 : 0),error,err);
 
     return -error;
   }
@@ -85,17 +95,17 @@ namespace l
   static
   int
   unlink(const Policy::Action &unlinkPolicy_,
-         const Branches       &branches_,
+         const Branches::CPtr &branches_,
          const char           *fusepath_)
   {
     int rv;
-    vector<string> basepaths;
+    Branch::CPtrVec obranches;
 
-    rv = unlinkPolicy_(branches_,fusepath_,&basepaths);
+    rv = unlinkPolicy_(branches_,fusepath_,&obranches);
     if(rv == -1)
       return -errno;
 
-    return l::unlink_loop(basepaths,fusepath_);
+    return l::unlink_loop(obranches,fusepath_);
   }
 }
 
@@ -104,12 +114,18 @@ namespace FUSE
   int
   unlink(const char *fusepath_)
   {
+    int rv;
     Config::Read cfg;
     const fuse_context *fc = fuse_get_context();
     const ugid::Set     ugid(fc->uid,fc->gid);
 
-    return l::unlink(cfg->func.unlink.policy,
-                     cfg->branches,
-                     fusepath_);
+    rv = l::unlink(cfg->func.unlink.policy,
+                   cfg->branches,
+                   fusepath_);
+
+    g_POLICY_CACHE.erase(fusepath_);
+    g_ATTR_CACHE.erase_entry(fusepath_);
+
+    return rv;
   }
 }
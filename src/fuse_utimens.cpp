@@ -14,10 +14,12 @@
   OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 */
 
+#include "attr_cache.hpp"
 #include "config.hpp"
 #include "errno.hpp"
+#include "fanout.hpp"
 #include "fs_lutimens.hpp"
-#include "fs_path.hpp"
+#include "fs_pathbuf.hpp"
 #include "policy_rv.hpp"
 #include "ugid.hpp"
 
@@ -35,17 +37,17 @@ namespace l
   static
   int
   get_error(const PolicyRV &prv_,
-            const string   &basepath_)
+            const Branch   *branch_)
   {
     for(int i = 0, ei = prv_.success.size(); i < ei; i++)
       {
-        if(prv_.success[i].basepath == basepath_)
+        if(prv_.success[i].branch == branch_)
           return prv_.success[i].rv;
       }
 
     for(int i = 0, ei = prv_.error.size(); i < ei; i++)
       {
-        if(prv_.error[i].basepath == basepath_)
+        if(prv_.error[i].branch == branch_)
           return prv_.error[i].rv;
       }
 
@@ -53,63 +55,62 @@ namespace l
   }
 
   static
-  void
-  utimens_loop_core(const string   &basepath_,
+  int
+  utimens_loop_core(const Branch   &branch_,
                     const char     *fusepath_,
-                    const timespec  ts_[2],
-                    PolicyRV       *prv_)
+                    const timespec  ts_[2])
   {
-    string fullpath;
-
-    fullpath = fs::path::make(basepath_,fusepath_);
+    fs::PathBuf fullpath(branch_.path,fusepath_);
 
     errno = 0;
     fs::lutimens(fullpath,ts_);
 
-    prv_->insert(errno,basepath_);
+    return errno;
   }
 
   static
   void
-  utimens_loop(const StrVec   &basepaths_,
-               const char     *fusepath_,
-               const timespec  ts_[2],
-               PolicyRV       *prv_)
+  utimens_loop(const Branch::CPtrVec &branches_,
+               const char            *fusepath_,
+               const timespec         ts_[2],
+               PolicyRV              *prv_)
   {
-    for(size_t i = 0, ei = basepaths_.size(); i != ei; i++)
-      {
-        l::utimens_loop_core(basepaths_[i],fusepath_,ts_,prv_);
-      }
+    auto func = [&](const Branch &branch_)
+    {
+      return l::utimens_loop_core(branch_,fusepath_,ts_);
+    };
+
+    fanout::for_each(branches_,func,prv_);
   }
 
   static
   int
   utimens(const Policy::Action &utimensPolicy_,
           const Policy::Search &getattrPolicy_,
-          const Branches       &branches_,
+          const Branches::CPtr &branches_,
           const char           *fusepath_,
           const timespec        ts_[2])
   {
     int rv;
     PolicyRV prv;
-    StrVec basepaths;
+    Branch::CPtrVec obranches;
 
-    rv = utimensPolicy_(branches_,fusepath_,&basepaths);
+    rv = utimensPolicy_(branches_,fusepath_,&obranches);
     if(rv == -1)
       return -errno;
 
-    l::utimens_loop(basepaths,fusepath_,ts_,&prv);
+    l::utimens_loop(obranches,fusepath_,ts_,&prv);
     if(prv.error.empty())
       return 0;
     if(prv.success.empty())
       return prv.error[0].rv;
 
-    basepaths.clear();
-    rv = getattrPolicy_(branches_,fusepath_,&basepaths);
+    obranches.clear();
+    rv = getattrPolicy_(branches_,fusepath_,&obranches);
     if(rv == -1)
       return -errno;
 
-    return l::get_error(prv,basepaths[0]);
+    return l::get_error(prv,obranches[0]);
   }
 }
 
@@ -119,14 +120,19 @@ namespace FUSE
   utimens(const char     *fusepath_,
           const timespec  ts_[2])
   {
+    int rv;
     Config::Read cfg;
     const fuse_context *fc = fuse_get_context();
     const ugid::Set     ugid(fc->uid,fc->gid);
 
-    return l::utimens(cfg->func.utimens.policy,
-                      cfg->func.getattr.policy,
-                      cfg->branches,
-                      fusepath_,
-                      ts_);
+    rv = l::utimens(cfg->func.utimens.policy,
+                    cfg->func.getattr.policy,
+                    cfg->branches,
+                    fusepath_,
+                    ts_);
+
+    g_ATTR_CACHE.erase(fusepath_);
+
+    return rv;
   }
 }
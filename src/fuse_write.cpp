@@ -14,6 +14,7 @@
   OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 */
 
+#include "attr_cache.hpp"
 #include "config.hpp"
 #include "errno.hpp"
 #include "fileinfo.hpp"
@@ -36,31 +37,52 @@ namespace l
             (error_ == -EDQUOT));
   }
 
+  /*
+    Moves the file to a branch picked by moveonenospc's policy and
+    points the handle's fd, space and stats at the new copy.
+  */
   static
   int
-  move_and_pwrite(const char   *buf_,
-                  const size_t  count_,
-                  const off_t   offset_,
-                  FileInfo     *fi_,
-                  int           err_)
+  movefile(FileInfo *fi_)
   {
+    int rv;
     int err;
-    ssize_t rv;
+    const Branch *branch;
     Config::Read cfg;
 
     if(cfg->moveonenospc.enabled == false)
-      return err_;
+      return -ENOSPC;
 
     rv = fs::movefile_as_root(cfg->moveonenospc.policy,
                               cfg->branches,
                               fi_->fusepath,
-                              fi_->fd);
+                              fi_->fd,
+                              &branch);
     if(rv < 0)
-      return err_;
+      return rv;
 
     err = fs::dup2(rv,fi_->fd);
     fs::close(rv);
     if(err < 0)
+      return err;
+
+    fi_->moved_to(branch->space,branch->stats);
+
+    return 0;
+  }
+
+  static
+  int
+  move_and_pwrite(const char   *buf_,
+                  const size_t  count_,
+                  const off_t   offset_,
+                  FileInfo     *fi_,
+                  int           err_)
+  {
+    ssize_t rv;
+
+    rv = l::movefile(fi_);
+    if(rv < 0)
       return err_;
 
     return fs::pwrite(fi_->fd,buf_,count_,offset_);
@@ -77,23 +99,11 @@ namespace l
   {
     int err;
     ssize_t rv;
-    Config::Read cfg;
-
-    if(cfg->moveonenospc.enabled == false)
-      return err_;
 
-    rv = fs::movefile_as_root(cfg->moveonenospc.policy,
-                              cfg->branches,
-                              fi_->fusepath,
-                              fi_->fd);
+    rv = l::movefile(fi_);
     if(rv < 0)
       return err_;
 
-    err = fs::dup2(rv,fi_->fd);
-    fs::close(rv);
-    if(err < 0)
-      return err_;
-
     rv = fs::pwriten(fi_->fd,
                      buf_ + written_,
                      count_ - written_,
@@ -153,6 +163,111 @@ namespace l
     return rv;
   }
 
+  static
+  ssize_t
+  splicen(const int           fd_,
+          fuse_bufvec        *src_,
+          const size_t        count_,
+          const off_t         offset_,
+          int                *err_)
+  {
+    ssize_t rv;
+    size_t written;
+
+    *err_   = 0;
+    written = 0;
+    while(written < count_)
+      {
+        fuse_bufvec dst = FUSE_BUFVEC_INIT(count_ - written);
+
+        dst.buf[0].flags = (fuse_buf_flags)(FUSE_BUF_IS_FD    |
+                                            FUSE_BUF_FD_SEEK  |
+                                            FUSE_BUF_FD_RETRY);
+        dst.buf[0].fd    = fd_;
+        dst.buf[0].pos   = (offset_ + written);
+
+        rv = fuse_buf_copy(&dst,src_,FUSE_BUF_SPLICE_MOVE);
+        if(rv == 0)
+          break;
+        if(rv < 0)
+          {
+            *err_ = rv;
+            break;
+          }
+
+        written += rv;
+      }
+
+    return written;
+  }
+
+  static
+  int
+  move_and_splicen(fuse_bufvec   *src_,
+                   size_t const   count_,
+                   off_t const    offset_,
+                   FileInfo      *fi_,
+                   ssize_t const  err_,
+                   ssize_t const  written_)
+  {
+    int err;
+    ssize_t rv;
+
+    rv = l::movefile(fi_);
+    if(rv < 0)
+      return err_;
+
+    rv = l::splicen(fi_->fd,
+                    src_,
+                    count_ - written_,
+                    offset_ + written_,
+                    &err);
+    if(err < 0)
+      return err;
+
+    return (written_ + rv);
+  }
+
+  // Same return value semantics as write_direct_io and write_cached
+  // but the data is spliced from the request's pipe. Whatever has
+  // been written is no longer in the pipe so a retry after moving
+  // the file continues from where the failure occurred.
+  static
+  int
+  write_buf(fuse_bufvec  *src_,
+            const off_t   offset_,
+            FileInfo     *fi_)
+  {
+    int err;
+    ssize_t rv;
+    size_t count;
+
+    count = fuse_buf_size(src_);
+
+    rv = l::splicen(fi_->fd,src_,count,offset_,&err);
+    if(err == 0)
+      return rv;
+    if(fi_->direct_io && (rv > 0))
+      return rv;
+    if(!l::out_of_space(err))
+      return err;
+
+    return l::move_and_splicen(src_,count,offset_,fi_,err,rv);
+  }
+
+  static
+  void
+  consume_space(FileInfo       *fi_,
+                const uint64_t  start_,
+                const int       rv_)
+  {
+    fi_->stats->record(start_,((rv_ < 0) && BranchStats::fault(-rv_)));
+    if(rv_ <= 0)
+      return;
+    fi_->space->consume(rv_);
+    fi_->stats->written(rv_);
+  }
+
   static
   int
   write(const fuse_file_info_t *ffi_,
@@ -160,6 +275,8 @@ namespace l
         const size_t            count_,
         const off_t             offset_)
   {
+    int rv;
+    uint64_t start;
     FileInfo *fi;
 
     fi = reinterpret_cast<FileInfo*>(ffi_->fh);
@@ -175,10 +292,16 @@ namespace l
     // transfer to complete before retrying.
     std::lock_guard<std::mutex> guard(fi->mutex);
 
+    start = BranchStats::now();
     if(fi->direct_io)
-      return l::write_direct_io(buf_,count_,offset_,fi);
+      rv = l::write_direct_io(buf_,count_,offset_,fi);
+    else
+      rv = l::write_cached(buf_,count_,offset_,fi);
 
-    return l::write_cached(buf_,count_,offset_,fi);
+    l::consume_space(fi,start,rv);
+    g_ATTR_CACHE.erase(fi->fusepath.c_str());
+
+    return rv;
   }
 }
 
@@ -193,6 +316,28 @@ namespace FUSE
     return l::write(ffi_,buf_,count_,offset_);
   }
 
+  int
+  write_buf(const fuse_file_info_t *ffi_,
+            fuse_bufvec            *src_,
+            off_t                   offset_)
+  {
+    int rv;
+    uint64_t start;
+    FileInfo *fi;
+
+    fi = reinterpret_cast<FileInfo*>(ffi_->fh);
+
+    std::lock_guard<std::mutex> guard(fi->mutex);
+
+    start = BranchStats::now();
+    rv = l::write_buf(src_,offset_,fi);
+
+    l::consume_space(fi,start,rv);
+    g_ATTR_CACHE.erase(fi->fusepath.c_str());
+
+    return rv;
+  }
+
   int
   write_null(const fuse_file_info_t *ffi_,
              const char             *buf_,
@@ -27,6 +27,11 @@ namespace FUSE
         size_t                  count,
         off_t                   offset);
 
+  int
+  write_buf(const fuse_file_info_t *ffi,
+            fuse_bufvec            *src,
+            off_t                   offset);
+
   int
   write_null(const fuse_file_info_t *ffi,
              const char             *buf,
@@ -36,26 +36,39 @@ public:
     kh_destroy(hashset,_set);
   }
 
+  static
+  inline
+  uint64_t
+  hash(const char     *str_,
+       const uint64_t  len_)
+  {
+    return wyhash(str_,len_,0x7472617065786974,_wyp);
+  }
+
   inline
   int
-  put(const char     *str_,
-      const uint64_t  len_)
+  put(const uint64_t h_)
   {
     int rv;
-    uint64_t h;
     khint_t key;
 
-    h = wyhash(str_,len_,0x7472617065786974,_wyp);
-
-    key = kh_put(hashset,_set,h,&rv);
+    key = kh_put(hashset,_set,h_,&rv);
     if(rv == 0)
       return 0;
 
-    kh_key(_set,key) = h;
+    kh_key(_set,key) = h_;
 
     return rv;
   }
 
+  inline
+  int
+  put(const char     *str_,
+      const uint64_t  len_)
+  {
+    return put(HashSet::hash(str_,len_));
+  }
+
   inline
   int
   put(const char *str_)
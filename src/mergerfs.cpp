@@ -60,7 +60,6 @@
 #include "fuse_prepare_hide.hpp"
 #include "fuse_read.hpp"
 #include "fuse_readdir.hpp"
-#include "fuse_readdir_plus.hpp"
 #include "fuse_readlink.hpp"
 #include "fuse_release.hpp"
 #include "fuse_releasedir.hpp"
@@ -93,7 +92,9 @@ namespace l
   static
   void
   get_fuse_operations(struct fuse_operations &ops_,
-                      const bool              nullrw_)
+                      const bool              nullrw_,
+                      const bool              read_splice_,
+                      const bool              write_splice_)
   {
     ops_.access          = FUSE::access;
     ops_.bmap            = FUSE::bmap;
@@ -127,6 +128,8 @@ namespace l
     ops_.poll            = FUSE::poll;;
     ops_.prepare_hide    = FUSE::prepare_hide;
     ops_.read            = (nullrw_ ? FUSE::read_null : FUSE::read);
+    ops_.read_buf        = ((read_splice_ && !nullrw_) ? FUSE::read_buf : NULL);
+    ops_.read_buf_done   = ((read_splice_ && !nullrw_) ? FUSE::read_buf_done : NULL);
     ops_.readdir         = FUSE::readdir;
     ops_.readdir_plus    = FUSE::readdir_plus;
     ops_.readlink        = FUSE::readlink;
@@ -146,6 +149,7 @@ namespace l
     ops_.unlink          = FUSE::unlink;
     ops_.utimens         = FUSE::utimens;
     ops_.write           = (nullrw_ ? FUSE::write_null : FUSE::write);
+    ops_.write_buf       = ((write_splice_ && !nullrw_) ? FUSE::write_buf : NULL);
 
     return;
   }
@@ -250,7 +254,6 @@ namespace l
        char      **argv_)
   {
     int rv;
-    Config::Read    cfg;
     Config::ErrVec  errs;
     fuse_args       args;
     fuse_operations ops;
@@ -272,17 +275,26 @@ namespace l
         return 1;
       }
 
-    if(cfg->branches_mount_timeout > 0)
-      l::wait_for_mount(cfg);
+    // Scoped so the main thread isn't holding an epoch guard, and
+    // keeping replaced branch lists alive, while in fuse_main.
+    {
+      Config::Read cfg;
 
-    l::setup_resources(cfg->scheduling_priority);
-    l::setup_signal_handlers();
-    l::get_fuse_operations(ops,cfg->nullrw);
+      if(cfg->branches_mount_timeout > 0)
+        l::wait_for_mount(cfg);
 
-    if(cfg->lazy_umount_mountpoint)
-      l::lazy_umount(cfg->mountpoint);
+      l::setup_resources(cfg->scheduling_priority);
+      l::setup_signal_handlers();
+      l::get_fuse_operations(ops,
+                             cfg->nullrw,
+                             cfg->read_splice,
+                             cfg->write_splice);
 
-    procfs::init();
+      if(cfg->lazy_umount_mountpoint)
+        l::lazy_umount(cfg->mountpoint);
+
+      procfs::init();
+    }
 
     rv = fuse_main(args.argc,
                    args.argv,
@@ -16,21 +16,28 @@
 
 #define FMT_HEADER_ONLY
 
+#include "attr_cache.hpp"
 #include "config.hpp"
+#include "dir_cache.hpp"
 #include "ef.hpp"
 #include "errno.hpp"
+#include "fanout.hpp"
 #include "fmt/core.h"
+#include "fs_dirpresence.hpp"
 #include "fs_glob.hpp"
 #include "fs_statvfs_cache.hpp"
 #include "hw_cpu.hpp"
 #include "num.hpp"
 #include "policy.hpp"
+#include "policy_cache.hpp"
+#include "policy_lat.hpp"
 #include "str.hpp"
 #include "syslog.hpp"
 #include "version.hpp"
 
 #include "fuse.h"
 #include "fuse_config.hpp"
+#include "fuse_dirents.h"
 
 #include <fstream>
 #include <iomanip>
@@ -331,6 +338,19 @@ usage(void)
     "                           where there are issues with creating files for\n"
     "                           write while setting the mode to read-only.\n"
     "                           default = off\n"
+    "    -o passthrough=off|ro|wo|rw\n"
+    "                           Have the kernel perform reads and writes\n"
+    "                           directly against the branch file for files\n"
+    "                           opened read-only, for write, or both.\n"
+    "                           Requires Linux 6.9+. default = off\n"
+    "    -o read-splice=BOOL    Splice read data from branch files to the\n"
+    "                           kernel rather than copying. default = false\n"
+    "    -o write-splice=BOOL   Splice write data from the kernel to branch\n"
+    "                           files rather than copying. default = false\n"
+    "    -o fuse-loop=threads|io_uring\n"
+    "                           How FUSE requests are received. 'io_uring'\n"
+    "                           requires Linux 6.14+ with fuse module param\n"
+    "                           enable_uring=1. default = threads\n"
     "    -o security_capability=BOOL\n"
     "                           When disabled return ENOATTR when the xattr\n"
     "                           security.capability is queried. default = true\n"
@@ -469,6 +489,16 @@ namespace options
     set_subtype(args_);
     set_fuse_threads(cfg);
 
+    fanout::max(cfg->action_concurrency);
+    fs::dirpresence::timeout(cfg->cache_dir_presence);
+    Policy::LAT::hysteresis(cfg->lat_hysteresis);
+    g_POLICY_CACHE.timeout = cfg->cache_search_policy;
+    g_POLICY_CACHE.max     = cfg->cache_search_policy_max;
+    g_ATTR_CACHE.timeout   = cfg->cache_getattr;
+    g_ATTR_CACHE.max       = cfg->cache_getattr_max;
+    g_DIR_CACHE.max        = (cfg->cache_dirents * 1024 * 1024);
+    fuse_dirents_spill_size(cfg->readdir_spill * 1024 * 1024);
+
     cfg->finish_initializing();
   }
 }
@@ -0,0 +1,215 @@
+/*
+  ISC License
+
+  Copyright (c) 2024, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include "passthrough.hpp"
+
+#include "fs_fstat.hpp"
+#include "ugid.hpp"
+
+#include <fcntl.h>
+
+#include <map>
+#include <mutex>
+#include <utility>
+
+
+/*
+  The kernel allows a single backing file per inode, refuses cached
+  handles while it is passed through and expects every later open of
+  it to be passed through as well. Handles are tracked by the backing
+  file's dev/ino, which is what a fuse node resolves to, so all opens
+  share one refcounted backing id. The first open decides the mode:
+  an inode with cached handles isn't passed through and regular
+  handles on a passed through inode are made direct_io, which keeps
+  their IO going through mergerfs.
+*/
+namespace l
+{
+  typedef std::pair<dev_t,ino_t> Key;
+
+  struct Backing
+  {
+    int      id          = 0;
+    uint64_t passthrough = 0;
+    uint64_t cached      = 0;
+  };
+
+  static std::mutex           g_mutex;
+  static std::map<Key,Backing> g_backings;
+
+  static
+  bool
+  rdonly(const int flags_)
+  {
+    return ((flags_ & O_ACCMODE) == O_RDONLY);
+  }
+
+  static
+  int
+  register_backing(const int fd_)
+  {
+    const ugid::SetRootGuard ugidGuard;
+
+    return fuse_passthrough_open(fd_);
+  }
+
+  static
+  void
+  unregister_backing(const int backing_id_)
+  {
+    const ugid::SetRootGuard ugidGuard;
+
+    fuse_passthrough_close(backing_id_);
+  }
+}
+
+/*
+  Passthrough hands read/write/mmap of the backing file to the
+  kernel. Handles using direct_io (cache.files=off or a process not
+  in cache.files.process-names) aren't passed through. Neither are
+  writable handles when moveonenospc is enabled given the ENOSPC
+  would never make it back to mergerfs.
+*/
+passthrough::IO
+passthrough::io(Config::Read           &cfg_,
+                const fuse_file_info_t *ffi_)
+{
+  if(cfg_->passthrough == Passthrough::ENUM::OFF)
+    return IO::NONE;
+  if(ffi_->direct_io)
+    return IO::REGULAR;
+
+  switch(cfg_->passthrough)
+    {
+    case Passthrough::ENUM::OFF:
+      return IO::NONE;
+    case Passthrough::ENUM::RO:
+      if(l::rdonly(ffi_->flags))
+        return IO::PASSTHROUGH;
+      return IO::REGULAR;
+    case Passthrough::ENUM::WO:
+      if(l::rdonly(ffi_->flags))
+        return IO::REGULAR;
+      if(cfg_->moveonenospc.enabled)
+        return IO::REGULAR;
+      return IO::PASSTHROUGH;
+    case Passthrough::ENUM::RW:
+      if(l::rdonly(ffi_->flags))
+        return IO::PASSTHROUGH;
+      if(cfg_->moveonenospc.enabled)
+        return IO::REGULAR;
+      return IO::PASSTHROUGH;
+    }
+
+  return IO::NONE;
+}
+
+/*
+  Registering a backing file requires CAP_SYS_ADMIN so it is done as
+  root rather than as the caller. If the kernel or the branch's
+  filesystem refuse the backing file the handle simply continues on
+  as a regular one.
+*/
+void
+passthrough::open(FileInfo         *fi_,
+                  fuse_file_info_t *ffi_,
+                  const IO          io_)
+{
+  int rv;
+  struct stat st;
+
+  if(io_ == IO::NONE)
+    return;
+
+  rv = fs::fstat(fi_->fd,&st);
+  if(rv == -1)
+    return;
+
+  std::lock_guard<std::mutex> guard(l::g_mutex);
+  l::Key key(st.st_dev,st.st_ino);
+  l::Backing &b = l::g_backings[key];
+
+  if((io_ == IO::PASSTHROUGH) && (b.cached == 0) && (b.id <= 0))
+    b.id = l::register_backing(fi_->fd);
+
+  if(b.id > 0)
+    {
+      b.passthrough++;
+      fi_->backing_id   = b.id;
+      fi_->backing_dev  = st.st_dev;
+      fi_->backing_ino  = st.st_ino;
+      ffi_->passthrough = 1;
+      ffi_->backing_id  = b.id;
+      ffi_->keep_cache  = 0;
+      ffi_->auto_cache  = 0;
+      if(io_ != IO::PASSTHROUGH)
+        {
+          fi_->direct_io  = 1;
+          ffi_->direct_io = 1;
+        }
+      return;
+    }
+
+  b.id = 0;
+  if(ffi_->direct_io)
+    {
+      if(b.cached == 0)
+        l::g_backings.erase(key);
+      return;
+    }
+
+  b.cached++;
+  fi_->cached_io   = 1;
+  fi_->backing_dev = st.st_dev;
+  fi_->backing_ino = st.st_ino;
+}
+
+void
+passthrough::close(FileInfo *fi_)
+{
+  int backing_id;
+  std::map<l::Key,l::Backing>::iterator i;
+
+  if((fi_->backing_id <= 0) && !fi_->cached_io)
+    return;
+
+  backing_id = 0;
+  {
+    std::lock_guard<std::mutex> guard(l::g_mutex);
+
+    i = l::g_backings.find(l::Key(fi_->backing_dev,fi_->backing_ino));
+    if(i != l::g_backings.end())
+      {
+        l::Backing &b = i->second;
+
+        if(fi_->cached_io)
+          b.cached--;
+        else if(--b.passthrough == 0)
+          backing_id = b.id;
+
+        if((b.cached == 0) && (b.passthrough == 0))
+          l::g_backings.erase(i);
+      }
+  }
+
+  if(backing_id > 0)
+    l::unregister_backing(backing_id);
+
+  fi_->backing_id = 0;
+  fi_->cached_io  = 0;
+}
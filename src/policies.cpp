@@ -26,6 +26,7 @@
   FUNC(all)                                     \
   FUNC(epall)                                   \
   FUNC(epff)                                    \
+  FUNC(eplat)                                   \
   FUNC(eplfs)                                   \
   FUNC(eplus)                                   \
   FUNC(epmfs)                                   \
@@ -33,6 +34,7 @@
   FUNC(eprand)                                  \
   FUNC(erofs)                                   \
   FUNC(ff)                                      \
+  FUNC(lat)                                     \
   FUNC(lfs)                                     \
   FUNC(lus)                                     \
   FUNC(mfs)                                     \
@@ -41,6 +43,7 @@
   FUNC(mspmfs)                                  \
   FUNC(msppfrd)                                 \
   FUNC(newest)                                  \
+  FUNC(pflb)                                    \
   FUNC(pfrd)                                    \
   FUNC(rand)
 
@@ -71,6 +74,7 @@ Policies::Search::find(const std::string &name_)
 Policy::All::Action     Policies::Action::all;
 Policy::EPAll::Action   Policies::Action::epall;
 Policy::EPFF::Action    Policies::Action::epff;
+Policy::EPLAT::Action   Policies::Action::eplat;
 Policy::EPLFS::Action   Policies::Action::eplfs;
 Policy::EPLUS::Action   Policies::Action::eplus;
 Policy::EPMFS::Action   Policies::Action::epmfs;
@@ -78,6 +82,7 @@ Policy::EPPFRD::Action  Policies::Action::eppfrd;
 Policy::EPRand::Action  Policies::Action::eprand;
 Policy::ERoFS::Action   Policies::Action::erofs;
 Policy::FF::Action      Policies::Action::ff;
+Policy::LAT::Action     Policies::Action::lat;
 Policy::LFS::Action     Policies::Action::lfs;
 Policy::LUS::Action     Policies::Action::lus;
 Policy::MFS::Action     Policies::Action::mfs;
@@ -86,12 +91,14 @@ Policy::MSPLUS::Action  Policies::Action::msplus;
 Policy::MSPMFS::Action  Policies::Action::mspmfs;
 Policy::MSPPFRD::Action Policies::Action::msppfrd;
 Policy::Newest::Action  Policies::Action::newest;
+Policy::PFLB::Action    Policies::Action::pflb;
 Policy::PFRD::Action    Policies::Action::pfrd;
 Policy::Rand::Action    Policies::Action::rand;
 
 Policy::All::Create     Policies::Create::all;
 Policy::EPAll::Create   Policies::Create::epall;
 Policy::EPFF::Create    Policies::Create::epff;
+Policy::EPLAT::Create   Policies::Create::eplat;
 Policy::EPLFS::Create   Policies::Create::eplfs;
 Policy::EPLUS::Create   Policies::Create::eplus;
 Policy::EPMFS::Create   Policies::Create::epmfs;
@@ -99,6 +106,7 @@ Policy::EPPFRD::Create  Policies::Create::eppfrd;
 Policy::EPRand::Create  Policies::Create::eprand;
 Policy::ERoFS::Create   Policies::Create::erofs;
 Policy::FF::Create      Policies::Create::ff;
+Policy::LAT::Create     Policies::Create::lat;
 Policy::LFS::Create     Policies::Create::lfs;
 Policy::LUS::Create     Policies::Create::lus;
 Policy::MFS::Create     Policies::Create::mfs;
@@ -107,12 +115,14 @@ Policy::MSPLUS::Create  Policies::Create::msplus;
 Policy::MSPMFS::Create  Policies::Create::mspmfs;
 Policy::MSPPFRD::Create Policies::Create::msppfrd;
 Policy::Newest::Create  Policies::Create::newest;
+Policy::PFLB::Create    Policies::Create::pflb;
 Policy::PFRD::Create    Policies::Create::pfrd;
 Policy::Rand::Create    Policies::Create::rand;
 
 Policy::All::Search     Policies::Search::all;
 Policy::EPAll::Search   Policies::Search::epall;
 Policy::EPFF::Search    Policies::Search::epff;
+Policy::EPLAT::Search   Policies::Search::eplat;
 Policy::EPLFS::Search   Policies::Search::eplfs;
 Policy::EPLUS::Search   Policies::Search::eplus;
 Policy::EPMFS::Search   Policies::Search::epmfs;
@@ -120,6 +130,7 @@ Policy::EPPFRD::Search  Policies::Search::eppfrd;
 Policy::EPRand::Search  Policies::Search::eprand;
 Policy::ERoFS::Search   Policies::Search::erofs;
 Policy::FF::Search      Policies::Search::ff;
+Policy::LAT::Search     Policies::Search::lat;
 Policy::LFS::Search     Policies::Search::lfs;
 Policy::LUS::Search     Policies::Search::lus;
 Policy::MFS::Search     Policies::Search::mfs;
@@ -128,5 +139,6 @@ Policy::MSPLUS::Search  Policies::Search::msplus;
 Policy::MSPMFS::Search  Policies::Search::mspmfs;
 Policy::MSPPFRD::Search Policies::Search::msppfrd;
 Policy::Newest::Search  Policies::Search::newest;
+Policy::PFLB::Search    Policies::Search::pflb;
 Policy::PFRD::Search    Policies::Search::pfrd;
 Policy::Rand::Search    Policies::Search::rand;
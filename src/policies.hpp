@@ -21,6 +21,7 @@
 #include "policy_all.hpp"
 #include "policy_epall.hpp"
 #include "policy_epff.hpp"
+#include "policy_eplat.hpp"
 #include "policy_eplfs.hpp"
 #include "policy_eplus.hpp"
 #include "policy_epmfs.hpp"
@@ -28,6 +29,7 @@
 #include "policy_eprand.hpp"
 #include "policy_erofs.hpp"
 #include "policy_ff.hpp"
+#include "policy_lat.hpp"
 #include "policy_lfs.hpp"
 #include "policy_lus.hpp"
 #include "policy_mfs.hpp"
@@ -36,6 +38,7 @@
 #include "policy_mspmfs.hpp"
 #include "policy_msppfrd.hpp"
 #include "policy_newest.hpp"
+#include "policy_pflb.hpp"
 #include "policy_pfrd.hpp"
 #include "policy_rand.hpp"
 
@@ -48,6 +51,7 @@ struct Policies
     static Policy::All::Action     all;
     static Policy::EPAll::Action   epall;
     static Policy::EPFF::Action    epff;
+    static Policy::EPLAT::Action   eplat;
     static Policy::EPLFS::Action   eplfs;
     static Policy::EPLUS::Action   eplus;
     static Policy::EPMFS::Action   epmfs;
@@ -55,6 +59,7 @@ struct Policies
     static Policy::EPRand::Action  eprand;
     static Policy::ERoFS::Action   erofs;
     static Policy::FF::Action      ff;
+    static Policy::LAT::Action     lat;
     static Policy::LFS::Action     lfs;
     static Policy::LUS::Action     lus;
     static Policy::MFS::Action     mfs;
@@ -63,6 +68,7 @@ struct Policies
     static Policy::MSPMFS::Action  mspmfs;
     static Policy::MSPPFRD::Action msppfrd;
     static Policy::Newest::Action  newest;
+    static Policy::PFLB::Action    pflb;
     static Policy::PFRD::Action    pfrd;
     static Policy::Rand::Action    rand;
   };
@@ -74,6 +80,7 @@ struct Policies
     static Policy::All::Create     all;
     static Policy::EPAll::Create   epall;
     static Policy::EPFF::Create    epff;
+    static Policy::EPLAT::Create   eplat;
     static Policy::EPLFS::Create   eplfs;
     static Policy::EPLUS::Create   eplus;
     static Policy::EPMFS::Create   epmfs;
@@ -81,6 +88,7 @@ struct Policies
     static Policy::EPRand::Create  eprand;
     static Policy::ERoFS::Create   erofs;
     static Policy::FF::Create      ff;
+    static Policy::LAT::Create     lat;
     static Policy::LFS::Create     lfs;
     static Policy::LUS::Create     lus;
     static Policy::MFS::Create     mfs;
@@ -89,6 +97,7 @@ struct Policies
     static Policy::MSPMFS::Create  mspmfs;
     static Policy::MSPPFRD::Create msppfrd;
     static Policy::Newest::Create  newest;
+    static Policy::PFLB::Create    pflb;
     static Policy::PFRD::Create    pfrd;
     static Policy::Rand::Create    rand;
   };
@@ -100,6 +109,7 @@ struct Policies
     static Policy::All::Search     all;
     static Policy::EPAll::Search   epall;
     static Policy::EPFF::Search    epff;
+    static Policy::EPLAT::Search   eplat;
     static Policy::EPLFS::Search   eplfs;
     static Policy::EPLUS::Search   eplus;
     static Policy::EPMFS::Search   epmfs;
@@ -107,6 +117,7 @@ struct Policies
     static Policy::EPRand::Search  eprand;
     static Policy::ERoFS::Search   erofs;
     static Policy::FF::Search      ff;
+    static Policy::LAT::Search     lat;
     static Policy::LFS::Search     lfs;
     static Policy::LUS::Search     lus;
     static Policy::MFS::Search     mfs;
@@ -115,6 +126,7 @@ struct Policies
     static Policy::MSPMFS::Search  mspmfs;
     static Policy::MSPPFRD::Search msppfrd;
     static Policy::Newest::Search  newest;
+    static Policy::PFLB::Search    pflb;
     static Policy::PFRD::Search    pfrd;
     static Policy::Rand::Search    rand;
   };
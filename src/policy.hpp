@@ -16,8 +16,8 @@
 
 #pragma once
 
+#include "branch.hpp"
 #include "branches.hpp"
-#include "strvec.hpp"
 
 #include <string>
 
@@ -33,7 +33,7 @@ namespace Policy
 
   public:
     std::string name;
-    virtual int operator()(const Branches::CPtr&,const char*,StrVec*) const = 0;
+    virtual int operator()(const Branches::CPtr&,const char*,Branch::CPtrVec*) const = 0;
   };
 
   class Action
@@ -60,7 +60,7 @@ namespace Policy
     int
     operator()(const Branches::CPtr &branches_,
                const char           *fusepath_,
-               StrVec               *paths_) const
+               Branch::CPtrVec      *paths_) const
     {
       return (*impl)(branches_,fusepath_,paths_);
     }
@@ -68,7 +68,7 @@ namespace Policy
     int
     operator()(const Branches::CPtr &branches_,
                const std::string    &fusepath_,
-               StrVec               *paths_) const
+               Branch::CPtrVec      *paths_) const
     {
       return (*impl)(branches_,fusepath_.c_str(),paths_);
     }
@@ -92,7 +92,7 @@ namespace Policy
 
   public:
     std::string name;
-    virtual int operator()(const Branches::CPtr&,const char*,StrVec*) const = 0;
+    virtual int operator()(const Branches::CPtr&,const char*,Branch::CPtrVec*) const = 0;
     virtual bool path_preserving(void) const = 0;
   };
 
@@ -126,7 +126,7 @@ namespace Policy
     int
     operator()(const Branches::CPtr &branches_,
                const char           *fusepath_,
-               StrVec               *paths_) const
+               Branch::CPtrVec      *paths_) const
     {
       return (*impl)(branches_,fusepath_,paths_);
     }
@@ -134,7 +134,7 @@ namespace Policy
     int
     operator()(const Branches::CPtr &branches_,
                const std::string    &fusepath_,
-               StrVec               *paths_) const
+               Branch::CPtrVec      *paths_) const
     {
       return (*impl)(branches_,fusepath_.c_str(),paths_);
     }
@@ -158,14 +158,25 @@ namespace Policy
 
   public:
     std::string name;
-    virtual int operator()(const Branches::CPtr&,const char*,StrVec*) const = 0;
+    virtual int operator()(const Branches::CPtr&,const char*,Branch::CPtrVec*) const = 0;
+
+    // Policies which can probe branches in parallel override this
+    virtual
+    int
+    concurrent(const Branches::CPtr &branches_,
+               const char           *fusepath_,
+               Branch::CPtrVec      *paths_) const
+    {
+      return (*this)(branches_,fusepath_,paths_);
+    }
   };
 
   class Search
   {
   public:
     Search(SearchImpl *impl_)
-      : impl(impl_)
+      : concurrent(false),
+        impl(impl_)
     {}
 
     Search&
@@ -185,17 +196,26 @@ namespace Policy
     int
     operator()(const Branches::CPtr &branches_,
                const char           *fusepath_,
-               StrVec               *paths_) const
+               Branch::CPtrVec      *paths_) const
     {
+      if(concurrent)
+        return impl->concurrent(branches_,fusepath_,paths_);
       return (*impl)(branches_,fusepath_,paths_);
     }
 
     int
     operator()(const Branches::CPtr &branches_,
                const std::string    &fusepath_,
-               StrVec               *paths_) const
+               Branch::CPtrVec      *paths_) const
     {
-      return (*impl)(branches_,fusepath_.c_str(),paths_);
+      return (*this)(branches_,fusepath_.c_str(),paths_);
+    }
+
+    const
+    SearchImpl*
+    get(void) const
+    {
+      return impl;
     }
 
     operator bool() const
@@ -203,6 +223,9 @@ namespace Policy
       return (bool)impl;
     }
 
+  public:
+    bool concurrent;
+
   private:
     SearchImpl *impl;
   };
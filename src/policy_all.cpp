@@ -20,6 +20,7 @@
 #include "fs_path.hpp"
 #include "policy.hpp"
 #include "policies.hpp"
+#include "policy_concurrent.hpp"
 #include "policy_error.hpp"
 #include "strvec.hpp"
 
@@ -32,7 +33,7 @@ namespace all
   static
   int
   create(const Branches::CPtr &branches_,
-         StrVec               *paths_)
+         Branch::CPtrVec      *paths_)
   {
     int rv;
     int error;
@@ -43,7 +44,7 @@ namespace all
       {
         if(branch.ro_or_nc())
           error_and_continue(error,EROFS);
-        rv = fs::info(branch.path,&info);
+        rv = fs::info(branch,&info);
         if(rv == -1)
           error_and_continue(error,ENOENT);
         if(info.readonly)
@@ -51,7 +52,7 @@ namespace all
         if(info.spaceavail < branch.minfreespace())
           error_and_continue(error,ENOSPC);
 
-        paths_->push_back(branch.path);
+        paths_->push_back(&branch);
       }
 
     if(paths_->empty())
@@ -64,7 +65,7 @@ namespace all
 int
 Policy::All::Action::operator()(const Branches::CPtr &branches_,
                                 const char           *fusepath_,
-                                StrVec               *paths_) const
+                                Branch::CPtrVec      *paths_) const
 {
   return Policies::Action::epall(branches_,fusepath_,paths_);
 }
@@ -72,7 +73,7 @@ Policy::All::Action::operator()(const Branches::CPtr &branches_,
 int
 Policy::All::Create::operator()(const Branches::CPtr &branches_,
                                 const char           *fusepath_,
-                                StrVec               *paths_) const
+                                Branch::CPtrVec      *paths_) const
 {
   return ::all::create(branches_,paths_);
 }
@@ -80,7 +81,15 @@ Policy::All::Create::operator()(const Branches::CPtr &branches_,
 int
 Policy::All::Search::operator()(const Branches::CPtr &branches_,
                                 const char           *fusepath_,
-                                StrVec               *paths_) const
+                                Branch::CPtrVec      *paths_) const
 {
   return Policies::Search::epall(branches_,fusepath_,paths_);
 }
+
+int
+Policy::All::Search::concurrent(const Branches::CPtr &branches_,
+                                const char           *fusepath_,
+                                Branch::CPtrVec      *paths_) const
+{
+  return Policy::Concurrent::epall(branches_,fusepath_,paths_);
+}
@@ -32,7 +32,7 @@ namespace Policy
       {}
 
     public:
-      int operator()(const Branches::CPtr&,const char*,StrVec*) const final;
+      int operator()(const Branches::CPtr&,const char*,Branch::CPtrVec*) const final;
     };
 
     class Create final : public Policy::CreateImpl
@@ -43,7 +43,7 @@ namespace Policy
       {}
 
     public:
-      int operator()(const Branches::CPtr&,const char*,StrVec*) const final;
+      int operator()(const Branches::CPtr&,const char*,Branch::CPtrVec*) const final;
       bool path_preserving(void) const final { return false; }
     };
 
@@ -55,7 +55,8 @@ namespace Policy
       {}
 
     public:
-      int operator()(const Branches::CPtr&,const char*,StrVec*) const final;
+      int operator()(const Branches::CPtr&,const char*,Branch::CPtrVec*) const final;
+      int concurrent(const Branches::CPtr&,const char*,Branch::CPtrVec*) const final;
     };
   }
 }
@@ -1,42 +1,55 @@
 #include "policy_cache.hpp"
 
-#include <cstdlib>
-#include <map>
+#include "fs_exists.hpp"
+
 #include <string>
 
-#include <time.h>
+#include <errno.h>
 
-using std::map;
 using std::string;
 
 static const uint64_t DEFAULT_TIMEOUT = 0;
+static const uint64_t DEFAULT_MAX     = 65536;
+
+PolicyCache g_POLICY_CACHE;
 
 namespace l
 {
+  /*
+    Policies run with the caller's credentials and report failures
+    such as EACCES as ENOENT. A negative is only shared between
+    callers once every branch agrees the path isn't there.
+  */
   static
-  uint64_t
-  get_time(void)
+  bool
+  absent(const Branches::CPtr &branches_,
+         const char           *fusepath_)
   {
-    uint64_t rv;
-
-    rv = ::time(NULL);
-
-    return rv;
+    for(const auto &branch : *branches_)
+      {
+        errno = 0;
+        if(fs::exists(branch,fusepath_))
+          return false;
+        if((errno != ENOENT) && (errno != ENOTDIR))
+          return false;
+      }
+
+    return true;
   }
 }
 
 
-PolicyCache::Value::Value()
-  : time(0),
-    paths()
+PolicyCache::PolicyCache(void)
+  : timeout(DEFAULT_TIMEOUT),
+    max(DEFAULT_MAX)
 {
 
 }
 
-PolicyCache::PolicyCache(void)
-  : timeout(DEFAULT_TIMEOUT)
+bool
+PolicyCache::enabled(void) const
 {
-  pthread_mutex_init(&_lock,NULL);
+  return (timeout != 0);
 }
 
 void
@@ -45,87 +58,102 @@ PolicyCache::erase(const char *fusepath_)
   if(timeout == 0)
     return;
 
-  pthread_mutex_lock(&_lock);
-
-  _cache.erase(fusepath_);
-
-  pthread_mutex_unlock(&_lock);
+  _lru.erase(fusepath_);
 }
 
+/*
+  Erases the path and everything under it. Used when a directory may
+  have moved so walks every entry.
+*/
 void
-PolicyCache::cleanup(const int prob_)
+PolicyCache::erase_tree(const char *fusepath_)
 {
-  uint64_t now;
-  map<string,Value>::iterator i;
-
   if(timeout == 0)
     return;
 
-  if(rand() % prob_)
-    return;
-
-  now = l::get_time();
-
-  pthread_mutex_lock(&_lock);
-
-  i = _cache.begin();
-  while(i != _cache.end())
-    {
-      if((now - i->second.time) >= timeout)
-        _cache.erase(i++);
-      else
-        ++i;
-    }
-
-  pthread_mutex_unlock(&_lock);
+  _lru.erase(fusepath_);
+  _lru.erase_children(fusepath_);
 }
 
 void
 PolicyCache::clear(void)
 {
-  pthread_mutex_lock(&_lock);
+  _lru.clear();
+}
 
-  _cache.clear();
+uint64_t
+PolicyCache::hits(void) const
+{
+  return _lru.hits();
+}
 
-  pthread_mutex_unlock(&_lock);
+uint64_t
+PolicyCache::misses(void) const
+{
+  return _lru.misses();
+}
+
+uint64_t
+PolicyCache::evictions(void) const
+{
+  return _lru.evictions();
 }
 
 int
 PolicyCache::operator()(const Policy::Search &policy_,
-                        const Branches       &branches_,
+                        const Branches::CPtr &branches_,
                         const char           *fusepath_,
-                        StrVec               *paths_)
+                        Branch::CPtrVec      *paths_)
 {
   int rv;
-  Value *v;
+  int error;
+  uint64_t gen;
   uint64_t now;
+  string fusepath;
+  Value value;
 
   if(timeout == 0)
     return policy_(branches_,fusepath_,paths_);
 
-  now = l::get_time();
+  now      = ShardedLRU<Value,POLICY_CACHE_SHARDS>::now();
+  fusepath = fusepath_;
 
-  pthread_mutex_lock(&_lock);
-  v = &_cache[fusepath_];
+  auto hit = [&](const Value &v_)
+  {
+    if((v_.branches_id != branches_->id()) ||
+       (v_.policy != policy_.get()))
+      return false;
 
-  if((now - v->time) >= timeout)
-    {
-      pthread_mutex_unlock(&_lock);
+    error = v_.error;
+    for(const auto idx : v_.idxs)
+      paths_->push_back(&(*branches_)[idx]);
 
-      rv = policy_(branches_,fusepath_,paths_);
-      if(rv == -1)
-        return -1;
+    return true;
+  };
 
-      pthread_mutex_lock(&_lock);
-      v->time  = now;
-      v->paths = *paths_;
-    }
-  else
+  if(_lru.lookup(fusepath,now,timeout,&gen,hit))
     {
-      *paths_ = v->paths;
+      if(error)
+        return (errno=error,-1);
+      return 0;
     }
 
-  pthread_mutex_unlock(&_lock);
+  rv = policy_(branches_,fusepath_,paths_);
+  if((rv == -1) && (errno != ENOENT))
+    return -1;
+  if((rv == -1) && !l::absent(branches_,fusepath_))
+    return (errno=ENOENT,-1);
+
+  value.branches_id = branches_->id();
+  value.policy      = policy_.get();
+  value.error       = ((rv == -1) ? ENOENT : 0);
+  for(const auto branch : *paths_)
+    value.idxs.push_back(branch - branches_->data());
+
+  _lru.insert(fusepath,gen,now,value,max);
+
+  if(rv == -1)
+    return (errno=ENOENT,-1);
 
   return 0;
 }
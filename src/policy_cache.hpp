@@ -18,45 +18,70 @@
 
 #pragma once
 
+#include "branches.hpp"
 #include "policy.hpp"
+#include "sharded_lru.hpp"
 #include "strvec.hpp"
 
+#include <atomic>
 #include <cstdint>
-#include <string>
-#include <map>
+#include <vector>
 
-#include <pthread.h>
+#define POLICY_CACHE_SHARDS 16
 
 
+/*
+  Caches the results of search policies keyed by fuse path. Entries
+  hold the indexes of the branches found rather than the paths and
+  are tied to the Branches instance and policy which produced them so
+  changing either makes them misses. ENOENT is cached as well, once
+  confirmed on every branch, so repeated lookups of missing paths
+  don't hit every branch.
+
+  Entries expire after `timeout` milliseconds. Each shard keeps its
+  entries on an LRU list and evicts the oldest once past its share
+  of `max`. Callers modifying the namespace must erase the paths
+  they touch.
+*/
 class PolicyCache
 {
 public:
   struct Value
   {
-    Value();
-
-    uint64_t time;
-    StrVec   paths;
+    uint64_t                     branches_id;
+    const Policy::SearchImpl    *policy;
+    int                          error;
+    std::vector<uint16_t>        idxs;
   };
 
 public:
   PolicyCache(void);
 
+public:
+  bool enabled(void) const;
+
 public:
   void erase(const char *fusepath);
-  void cleanup(const int prob = 1);
+  void erase_tree(const char *fusepath);
   void clear(void);
 
 public:
   int operator()(const Policy::Search &policy,
-                 const Branches       &branches,
+                 const Branches::CPtr &branches,
                  const char           *fusepath,
-                 StrVec               *paths);
+                 Branch::CPtrVec      *paths);
+
+public:
+  uint64_t hits(void) const;
+  uint64_t misses(void) const;
+  uint64_t evictions(void) const;
 
 public:
-  uint64_t timeout;
+  std::atomic<uint64_t> timeout;
+  std::atomic<uint64_t> max;
 
 private:
-  pthread_mutex_t             _lock;
-  std::map<std::string,Value> _cache;
+  ShardedLRU<Value,POLICY_CACHE_SHARDS> _lru;
 };
+
+extern PolicyCache g_POLICY_CACHE;
@@ -0,0 +1,313 @@
+/*
+  ISC License
+
+  Copyright (c) 2024, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include "policy_concurrent.hpp"
+
+#include "errno.hpp"
+#include "fs_exists.hpp"
+#include "ugid.hpp"
+
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#define PROBE_PENDING -1
+#define PROBE_ABSENT   0
+#define PROBE_PRESENT  1
+
+
+namespace l
+{
+  /*
+    Shared with the probes so the caller can return while some are
+    still queued or blocked on a slow branch. Which is also why it
+    holds its own reference to the branch list rather than relying on
+    the caller's epoch guard.
+  */
+  struct Probes
+  {
+    Probes(const Branches::CPtr &branches_,
+           const char           *fusepath_)
+      : branches(branches_->shared_from_this()),
+        fusepath(fusepath_),
+        done(false),
+        found(branches_->size(),PROBE_PENDING),
+        mtimes(branches_->size(),0),
+        deferred(branches_->size(),false)
+    {
+    }
+
+    std::mutex              mutex;
+    std::condition_variable cv;
+    Branches::Impl::CPtr    branches;
+    std::string             fusepath;
+    bool                    done;
+    std::vector<int>        found;
+    std::vector<time_t>     mtimes;
+    // Only touched by the caller
+    std::vector<bool>       deferred;
+  };
+
+  typedef std::shared_ptr<Probes> ProbesPtr;
+
+  static
+  unsigned
+  threads(void)
+  {
+    return std::max(4U,std::thread::hardware_concurrency());
+  }
+
+  static
+  ThreadPool&
+  pool(void)
+  {
+    static ThreadPool tp(l::threads(),
+                         1024,
+                         "policy.search");
+
+    return tp;
+  }
+
+  /*
+    Probes stuck on a hung branch would otherwise fill the pool and
+    queue up probes of healthy branches behind them. Past this many
+    outstanding on a branch the caller probes it itself, and only if
+    the answer comes down to that branch.
+  */
+  static
+  uint64_t
+  per_branch_max(void)
+  {
+    return std::max(1U,(l::threads() / 4));
+  }
+
+  static
+  void
+  probe(const ProbesPtr &probes_,
+        const size_t     idx_)
+  {
+    bool rv;
+    uint64_t start;
+    struct stat st;
+    const Branch &branch = (*probes_->branches)[idx_];
+
+    {
+      std::lock_guard<std::mutex> lg(probes_->mutex);
+      if(probes_->done)
+        return;
+    }
+
+    start = BranchStats::now();
+    rv = fs::exists(branch,probes_->fusepath.c_str(),&st);
+    branch.stats->record(start,
+                         (!rv && (errno != ENOENT) && (errno != ENOTDIR)));
+
+    {
+      std::lock_guard<std::mutex> lg(probes_->mutex);
+      probes_->found[idx_]  = (rv ? PROBE_PRESENT : PROBE_ABSENT);
+      probes_->mtimes[idx_] = (rv ? st.st_mtime : 0);
+    }
+
+    probes_->cv.notify_all();
+  }
+
+  /*
+    Branch 0 is probed by the caller since it'd otherwise be waiting
+    anyway.
+  */
+  static
+  ProbesPtr
+  start(const Branches::CPtr &branches_,
+        const char           *fusepath_)
+  {
+    uid_t uid;
+    gid_t gid;
+    ProbesPtr probes;
+
+    uid    = ::geteuid();
+    gid    = ::getegid();
+    probes = std::make_shared<Probes>(branches_,fusepath_);
+
+    for(size_t i = 1, ei = branches_->size(); i < ei; i++)
+      {
+        const BranchStats::Ptr &stats = (*branches_)[i].stats;
+
+        if(!stats->probe_begin(l::per_branch_max()))
+          {
+            probes->deferred[i] = true;
+            continue;
+          }
+
+        auto func = [probes,i,uid,gid]()
+        {
+          const ugid::Set ugid(uid,gid);
+
+          l::probe(probes,i);
+          (*probes->branches)[i].stats->probe_end();
+        };
+
+        l::pool().enqueue_work(func);
+      }
+
+    l::probe(probes,0);
+
+    return probes;
+  }
+
+  static
+  int
+  result(const ProbesPtr &probes_,
+         const size_t     idx_)
+  {
+    if(probes_->deferred[idx_])
+      l::probe(probes_,idx_);
+
+    std::unique_lock<std::mutex> lk(probes_->mutex);
+    probes_->cv.wait(lk,[&probes_,idx_]() { return (probes_->found[idx_] != PROBE_PENDING); });
+
+    return probes_->found[idx_];
+  }
+
+  static
+  void
+  wait_all(const ProbesPtr &probes_)
+  {
+    for(size_t i = 0, ei = probes_->found.size(); i < ei; i++)
+      l::result(probes_,i);
+  }
+
+  static
+  void
+  finish(const ProbesPtr &probes_)
+  {
+    std::lock_guard<std::mutex> lg(probes_->mutex);
+
+    probes_->done = true;
+  }
+}
+
+namespace Policy
+{
+  namespace Concurrent
+  {
+    int
+    epff(const Branches::CPtr &branches_,
+         const char           *fusepath_,
+         Branch::CPtrVec      *paths_)
+    {
+      ssize_t idx;
+      l::ProbesPtr probes;
+
+      if(branches_->size() == 0)
+        return (errno=ENOENT,-1);
+
+      probes = l::start(branches_,fusepath_);
+
+      idx = -1;
+      for(size_t i = 0, ei = branches_->size(); i < ei; i++)
+        {
+          if(l::result(probes,i) != PROBE_PRESENT)
+            continue;
+
+          idx = i;
+          break;
+        }
+
+      l::finish(probes);
+
+      if(idx == -1)
+        return (errno=ENOENT,-1);
+
+      paths_->push_back(&(*branches_)[idx]);
+
+      return 0;
+    }
+
+    int
+    epall(const Branches::CPtr &branches_,
+          const char           *fusepath_,
+          Branch::CPtrVec      *paths_)
+    {
+      l::ProbesPtr probes;
+
+      if(branches_->size() == 0)
+        return (errno=ENOENT,-1);
+
+      probes = l::start(branches_,fusepath_);
+
+      l::wait_all(probes);
+
+      for(size_t i = 0, ei = probes->found.size(); i < ei; i++)
+        {
+          if(probes->found[i] == PROBE_PRESENT)
+            paths_->push_back(&(*branches_)[i]);
+        }
+
+      if(paths_->empty())
+        return (errno=ENOENT,-1);
+
+      return 0;
+    }
+
+    int
+    newest(const Branches::CPtr &branches_,
+           const char           *fusepath_,
+           Branch::CPtrVec      *paths_)
+    {
+      ssize_t idx;
+      time_t newest;
+      l::ProbesPtr probes;
+
+      if(branches_->size() == 0)
+        return (errno=ENOENT,-1);
+
+      probes = l::start(branches_,fusepath_);
+
+      l::wait_all(probes);
+
+      idx    = -1;
+      newest = std::numeric_limits<time_t>::min();
+      for(size_t i = 0, ei = probes->found.size(); i < ei; i++)
+        {
+          if(probes->found[i] != PROBE_PRESENT)
+            continue;
+          if(probes->mtimes[i] < newest)
+            continue;
+
+          newest = probes->mtimes[i];
+          idx    = i;
+        }
+
+      if(idx == -1)
+        return (errno=ENOENT,-1);
+
+      paths_->push_back(&(*branches_)[idx]);
+
+      return 0;
+    }
+  }
+}
@@ -0,0 +1,50 @@
+/*
+  ISC License
+
+  Copyright (c) 2024, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#pragma once
+
+#include "branches.hpp"
+#include "strvec.hpp"
+
+
+/*
+  Concurrent versions of the search policies which only need to know
+  which branches hold a path. Every branch is probed at once on a
+  dedicated thread pool so a slow branch only delays lookups whose
+  answer depends on it. Results are still considered in branch order
+  so they match the sequential policies. Probes not yet started when
+  the answer is known are skipped. The number of probes outstanding
+  on any one branch is capped so a hung branch can't tie up the pool.
+*/
+namespace Policy
+{
+  namespace Concurrent
+  {
+    int epff(const Branches::CPtr &branches,
+             const char           *fusepath,
+             Branch::CPtrVec      *paths);
+
+    int epall(const Branches::CPtr &branches,
+              const char           *fusepath,
+              Branch::CPtrVec      *paths);
+
+    int newest(const Branches::CPtr &branches,
+               const char           *fusepath,
+               Branch::CPtrVec      *paths);
+  }
+}
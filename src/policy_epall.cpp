@@ -15,11 +15,12 @@
 */
 
 #include "errno.hpp"
+#include "fs_dirpresence.hpp"
 #include "fs_exists.hpp"
 #include "fs_info.hpp"
 #include "fs_path.hpp"
-#include "fs_statvfs_cache.hpp"
 #include "policy.hpp"
+#include "policy_concurrent.hpp"
 #include "policy_epall.hpp"
 #include "policy_error.hpp"
 #include "strvec.hpp"
@@ -35,7 +36,7 @@ namespace epall
   int
   create(const Branches::CPtr &branches_,
          const char           *fusepath_,
-         StrVec               *paths_)
+         Branch::CPtrVec      *paths_)
   {
     int rv;
     int error;
@@ -46,9 +47,9 @@ namespace epall
       {
         if(branch.ro_or_nc())
           error_and_continue(error,EROFS);
-        if(!fs::exists(branch.path,fusepath_))
+        if(!fs::dirpresence::exists(branches_,branch,fusepath_))
           error_and_continue(error,ENOENT);
-        rv = fs::info(branch.path,&info);
+        rv = fs::info(branch,&info);
         if(rv == -1)
           error_and_continue(error,ENOENT);
         if(info.readonly)
@@ -56,7 +57,7 @@ namespace epall
         if(info.spaceavail < branch.minfreespace())
           error_and_continue(error,ENOSPC);
 
-        paths_->push_back(branch.path);
+        paths_->push_back(&branch);
       }
 
     if(paths_->empty())
@@ -69,26 +70,26 @@ namespace epall
   int
   action(const Branches::CPtr &branches_,
          const char           *fusepath_,
-         StrVec               *paths_)
+         Branch::CPtrVec      *paths_)
   {
     int rv;
     int error;
-    bool readonly;
+    fs::info_t info;
 
     error = ENOENT;
     for(auto &branch : *branches_)
       {
         if(branch.ro())
           error_and_continue(error,EROFS);
-        if(!fs::exists(branch.path,fusepath_))
+        if(!fs::exists(branch,fusepath_))
           error_and_continue(error,ENOENT);
-        rv = fs::statvfs_cache_readonly(branch.path,&readonly);
+        rv = fs::info(branch,&info);
         if(rv == -1)
           error_and_continue(error,ENOENT);
-        if(readonly)
+        if(info.readonly)
           error_and_continue(error,EROFS);
 
-        paths_->push_back(branch.path);
+        paths_->push_back(&branch);
       }
 
     if(paths_->empty())
@@ -101,14 +102,14 @@ namespace epall
   int
   search(const Branches::CPtr &branches_,
          const char           *fusepath_,
-         StrVec               *paths_)
+         Branch::CPtrVec      *paths_)
   {
     for(auto &branch : *branches_)
       {
-        if(!fs::exists(branch.path,fusepath_))
+        if(!fs::exists(branch,fusepath_))
           continue;
 
-        paths_->push_back(branch.path);
+        paths_->push_back(&branch);
       }
 
     if(paths_->empty())
@@ -121,7 +122,7 @@ namespace epall
 int
 Policy::EPAll::Action::operator()(const Branches::CPtr &branches_,
                                   const char           *fusepath_,
-                                  StrVec               *paths_) const
+                                  Branch::CPtrVec      *paths_) const
 {
   return ::epall::action(branches_,fusepath_,paths_);
 }
@@ -129,7 +130,7 @@ Policy::EPAll::Action::operator()(const Branches::CPtr &branches_,
 int
 Policy::EPAll::Create::operator()(const Branches::CPtr &branches_,
                                   const char           *fusepath_,
-                                  StrVec               *paths_) const
+                                  Branch::CPtrVec      *paths_) const
 {
   return ::epall::create(branches_,fusepath_,paths_);
 }
@@ -137,7 +138,15 @@ Policy::EPAll::Create::operator()(const Branches::CPtr &branches_,
 int
 Policy::EPAll::Search::operator()(const Branches::CPtr &branches_,
                                   const char     *fusepath_,
-                                  StrVec         *paths_) const
+                                  Branch::CPtrVec *paths_) const
 {
   return ::epall::search(branches_,fusepath_,paths_);
 }
+
+int
+Policy::EPAll::Search::concurrent(const Branches::CPtr &branches_,
+                                  const char           *fusepath_,
+                                  Branch::CPtrVec      *paths_) const
+{
+  return Policy::Concurrent::epall(branches_,fusepath_,paths_);
+}
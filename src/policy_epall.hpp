@@ -33,7 +33,7 @@ namespace Policy
       }
 
     public:
-      int operator()(const Branches::CPtr&,const char*,StrVec*) const final;
+      int operator()(const Branches::CPtr&,const char*,Branch::CPtrVec*) const final;
     };
 
     class Create final : public Policy::CreateImpl
@@ -45,7 +45,7 @@ namespace Policy
       }
 
     public:
-      int operator()(const Branches::CPtr&,const char*,StrVec*) const final;
+      int operator()(const Branches::CPtr&,const char*,Branch::CPtrVec*) const final;
       bool path_preserving(void) const final { return true; }
     };
 
@@ -58,7 +58,8 @@ namespace Policy
       }
 
     public:
-      int operator()(const Branches::CPtr&,const char*,StrVec*) const final;
+      int operator()(const Branches::CPtr&,const char*,Branch::CPtrVec*) const final;
+      int concurrent(const Branches::CPtr&,const char*,Branch::CPtrVec*) const final;
     };
   }
 }
@@ -16,11 +16,12 @@
 
 #include "branches.hpp"
 #include "errno.hpp"
+#include "fs_dirpresence.hpp"
 #include "fs_exists.hpp"
 #include "fs_info.hpp"
 #include "fs_path.hpp"
-#include "fs_statvfs_cache.hpp"
 #include "policy.hpp"
+#include "policy_concurrent.hpp"
 #include "policy_epff.hpp"
 #include "policy_error.hpp"
 #include "rwlock.hpp"
@@ -37,7 +38,7 @@ namespace epff
   int
   create(const Branches::CPtr &branches_,
          const char           *fusepath_,
-         StrVec               *paths_)
+         Branch::CPtrVec      *paths_)
   {
     int rv;
     int error;
@@ -48,9 +49,9 @@ namespace epff
       {
         if(branch.ro_or_nc())
           error_and_continue(error,EROFS);
-        if(!fs::exists(branch.path,fusepath_))
+        if(!fs::dirpresence::exists(branches_,branch,fusepath_))
           error_and_continue(error,ENOENT);
-        rv = fs::info(branch.path,&info);
+        rv = fs::info(branch,&info);
         if(rv == -1)
           error_and_continue(error,ENOENT);
         if(info.readonly)
@@ -58,7 +59,7 @@ namespace epff
         if(info.spaceavail < branch.minfreespace())
           error_and_continue(error,ENOSPC);
 
-        paths_->push_back(branch.path);
+        paths_->push_back(&branch);
 
         return 0;
       }
@@ -70,26 +71,26 @@ namespace epff
   int
   action(const Branches::CPtr &branches_,
          const char           *fusepath_,
-         StrVec               *paths_)
+         Branch::CPtrVec      *paths_)
   {
     int rv;
     int error;
-    bool readonly;
+    fs::info_t info;
 
     error = ENOENT;
     for(auto &branch : *branches_)
       {
         if(branch.ro())
           error_and_continue(error,EROFS);
-        if(!fs::exists(branch.path,fusepath_))
+        if(!fs::exists(branch,fusepath_))
           error_and_continue(error,ENOENT);
-        rv = fs::statvfs_cache_readonly(branch.path,&readonly);
+        rv = fs::info(branch,&info);
         if(rv == -1)
           error_and_continue(error,ENOENT);
-        if(readonly)
+        if(info.readonly)
           error_and_continue(error,EROFS);
 
-        paths_->push_back(branch.path);
+        paths_->push_back(&branch);
 
         return 0;
       }
@@ -101,14 +102,14 @@ namespace epff
   int
   search(const Branches::CPtr &branches_,
          const char           *fusepath_,
-         StrVec               *paths_)
+         Branch::CPtrVec      *paths_)
   {
     for(auto &branch : *branches_)
       {
-        if(!fs::exists(branch.path,fusepath_))
+        if(!fs::exists(branch,fusepath_))
           continue;
 
-        paths_->push_back(branch.path);
+        paths_->push_back(&branch);
 
         return 0;
       }
@@ -120,7 +121,7 @@ namespace epff
 int
 Policy::EPFF::Action::operator()(const Branches::CPtr &branches_,
                                  const char          *fusepath_,
-                                 StrVec              *paths_) const
+                                 Branch::CPtrVec     *paths_) const
 {
   return ::epff::action(branches_,fusepath_,paths_);
 }
@@ -128,7 +129,7 @@ Policy::EPFF::Action::operator()(const Branches::CPtr &branches_,
 int
 Policy::EPFF::Create::operator()(const Branches::CPtr &branches_,
                                  const char           *fusepath_,
-                                 StrVec               *paths_) const
+                                 Branch::CPtrVec      *paths_) const
 {
   return ::epff::create(branches_,fusepath_,paths_);
 }
@@ -136,7 +137,15 @@ Policy::EPFF::Create::operator()(const Branches::CPtr &branches_,
 int
 Policy::EPFF::Search::operator()(const Branches::CPtr &branches_,
                                  const char           *fusepath_,
-                                 StrVec               *paths_) const
+                                 Branch::CPtrVec      *paths_) const
 {
   return ::epff::search(branches_,fusepath_,paths_);
 }
+
+int
+Policy::EPFF::Search::concurrent(const Branches::CPtr &branches_,
+                                 const char           *fusepath_,
+                                 Branch::CPtrVec      *paths_) const
+{
+  return Policy::Concurrent::epff(branches_,fusepath_,paths_);
+}
@@ -0,0 +1,161 @@
+/*
+  ISC License
+
+  Copyright (c) 2024, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include "errno.hpp"
+#include "fs_dirpresence.hpp"
+#include "fs_info.hpp"
+#include "policy.hpp"
+#include "policy_eplat.hpp"
+#include "policy_error.hpp"
+#include "policy_lat.hpp"
+
+#include <string>
+
+using std::string;
+
+
+namespace eplat
+{
+  static std::atomic<const BranchStats*> g_prev(NULL);
+
+  static
+  int
+  create(const Branches::CPtr &branches_,
+         const char           *fusepath_,
+         Branch::CPtrVec      *paths_)
+  {
+    int rv;
+    int error;
+    fs::info_t info;
+    const Branch *branch;
+    std::vector<const Branch*> candidates;
+
+    error = ENOENT;
+    for(const auto &branch : *branches_)
+      {
+        if(branch.ro_or_nc())
+          error_and_continue(error,EROFS);
+        if(!fs::dirpresence::exists(branches_,branch,fusepath_))
+          error_and_continue(error,ENOENT);
+        rv = fs::info(branch,&info);
+        if(rv == -1)
+          error_and_continue(error,ENOENT);
+        if(info.readonly)
+          error_and_continue(error,EROFS);
+        if(info.spaceavail < branch.minfreespace())
+          error_and_continue(error,ENOSPC);
+
+        candidates.push_back(&branch);
+      }
+
+    branch = Policy::LAT::fastest(candidates,&g_prev);
+    if(branch == NULL)
+      return (errno=error,-1);
+
+    paths_->push_back(branch);
+
+    return 0;
+  }
+
+  static
+  int
+  action(const Branches::CPtr &branches_,
+         const char           *fusepath_,
+         Branch::CPtrVec      *paths_)
+  {
+    int rv;
+    int error;
+    fs::info_t info;
+    const Branch *branch;
+    std::vector<const Branch*> candidates;
+
+    error = ENOENT;
+    for(const auto &branch : *branches_)
+      {
+        if(branch.ro())
+          error_and_continue(error,EROFS);
+        if(!Policy::LAT::exists(branch,fusepath_))
+          error_and_continue(error,ENOENT);
+        rv = fs::info(branch,&info);
+        if(rv == -1)
+          error_and_continue(error,ENOENT);
+        if(info.readonly)
+          error_and_continue(error,EROFS);
+
+        candidates.push_back(&branch);
+      }
+
+    branch = Policy::LAT::fastest(candidates);
+    if(branch == NULL)
+      return (errno=error,-1);
+
+    paths_->push_back(branch);
+
+    return 0;
+  }
+
+  static
+  int
+  search(const Branches::CPtr &branches_,
+         const char           *fusepath_,
+         Branch::CPtrVec      *paths_)
+  {
+    const Branch *branch;
+    std::vector<const Branch*> candidates;
+
+    for(const auto &branch : *branches_)
+      {
+        if(!Policy::LAT::exists(branch,fusepath_))
+          continue;
+
+        candidates.push_back(&branch);
+      }
+
+    branch = Policy::LAT::fastest(candidates);
+    if(branch == NULL)
+      return (errno=ENOENT,-1);
+
+    paths_->push_back(branch);
+
+    return 0;
+  }
+}
+
+int
+Policy::EPLAT::Action::operator()(const Branches::CPtr &branches_,
+                                  const char           *fusepath_,
+                                  Branch::CPtrVec      *paths_) const
+{
+  return ::eplat::action(branches_,fusepath_,paths_);
+}
+
+int
+Policy::EPLAT::Create::operator()(const Branches::CPtr &branches_,
+                                  const char           *fusepath_,
+                                  Branch::CPtrVec      *paths_) const
+{
+  return ::eplat::create(branches_,fusepath_,paths_);
+}
+
+int
+Policy::EPLAT::Search::operator()(const Branches::CPtr &branches_,
+                                  const char           *fusepath_,
+                                  Branch::CPtrVec      *paths_) const
+{
+  return ::eplat::search(branches_,fusepath_,paths_);
+}
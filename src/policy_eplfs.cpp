@@ -15,10 +15,10 @@
 */
 
 #include "errno.hpp"
+#include "fs_dirpresence.hpp"
 #include "fs_exists.hpp"
 #include "fs_info.hpp"
 #include "fs_path.hpp"
-#include "fs_statvfs_cache.hpp"
 #include "policies.hpp"
 #include "policy.hpp"
 #include "policy_eplfs.hpp"
@@ -37,24 +37,24 @@ namespace eplfs
   int
   create(const Branches::CPtr &branches_,
          const char           *fusepath_,
-         StrVec               *paths_)
+         Branch::CPtrVec      *paths_)
   {
     int rv;
     int error;
     uint64_t eplfs;
     fs::info_t info;
-    const string *basepath;
+    const Branch *obranch;
 
     error = ENOENT;
     eplfs = std::numeric_limits<uint64_t>::max();
-    basepath = NULL;
+    obranch = NULL;
     for(const auto &branch : *branches_)
       {
         if(branch.ro_or_nc())
           error_and_continue(error,EROFS);
-        if(!fs::exists(branch.path,fusepath_))
+        if(!fs::dirpresence::exists(branches_,branch,fusepath_))
           error_and_continue(error,ENOENT);
-        rv = fs::info(branch.path,&info);
+        rv = fs::info(branch,&info);
         if(rv == -1)
           error_and_continue(error,ENOENT);
         if(info.readonly)
@@ -65,13 +65,13 @@ namespace eplfs
           continue;
 
         eplfs = info.spaceavail;
-        basepath = &branch.path;
+        obranch = &branch;
       }
 
-    if(basepath == NULL)
+    if(obranch == NULL)
       return (errno=error,-1);
 
-    paths_->push_back(*basepath);
+    paths_->push_back(obranch);
 
     return 0;
   }
@@ -80,24 +80,24 @@ namespace eplfs
   int
   action(const Branches::CPtr &branches_,
          const char           *fusepath_,
-         StrVec               *paths_)
+         Branch::CPtrVec      *paths_)
   {
     int rv;
     int error;
     uint64_t eplfs;
     fs::info_t info;
-    const string *basepath;
+    const Branch *obranch;
 
     error = ENOENT;
     eplfs = std::numeric_limits<uint64_t>::max();
-    basepath = NULL;
+    obranch = NULL;
     for(const auto &branch : *branches_)
       {
         if(branch.ro())
           error_and_continue(error,EROFS);
-        if(!fs::exists(branch.path,fusepath_))
+        if(!fs::exists(branch,fusepath_))
           error_and_continue(error,ENOENT);
-        rv = fs::info(branch.path,&info);
+        rv = fs::info(branch,&info);
         if(rv == -1)
           error_and_continue(error,ENOENT);
         if(info.readonly)
@@ -106,13 +106,13 @@ namespace eplfs
           continue;
 
         eplfs = info.spaceavail;
-        basepath = &branch.path;
+        obranch = &branch;
       }
 
-    if(basepath == NULL)
+    if(obranch == NULL)
       return (errno=error,-1);
 
-    paths_->push_back(*basepath);
+    paths_->push_back(obranch);
 
     return 0;
   }
@@ -121,33 +121,33 @@ namespace eplfs
   int
   search(const Branches::CPtr &branches_,
          const char           *fusepath_,
-         StrVec               *paths_)
+         Branch::CPtrVec      *paths_)
   {
     int rv;
     uint64_t eplfs;
-    uint64_t spaceavail;
-    const string *basepath;
+    fs::info_t info;
+    const Branch *obranch;
 
     eplfs = std::numeric_limits<uint64_t>::max();
-    basepath = NULL;
+    obranch = NULL;
     for(const auto &branch : *branches_)
       {
-        if(!fs::exists(branch.path,fusepath_))
+        if(!fs::exists(branch,fusepath_))
           continue;
-        rv = fs::statvfs_cache_spaceavail(branch.path,&spaceavail);
+        rv = fs::info(branch,&info);
         if(rv == -1)
           continue;
-        if(spaceavail > eplfs)
+        if(info.spaceavail > eplfs)
           continue;
 
-        eplfs = spaceavail;
-        basepath = &branch.path;
+        eplfs = info.spaceavail;
+        obranch = &branch;
       }
 
-    if(basepath == NULL)
+    if(obranch == NULL)
       return (errno=ENOENT,-1);
 
-    paths_->push_back(*basepath);
+    paths_->push_back(obranch);
 
     return 0;
   }
@@ -156,7 +156,7 @@ namespace eplfs
 int
 Policy::EPLFS::Action::operator()(const Branches::CPtr &branches_,
                                   const char           *fusepath_,
-                                  StrVec               *paths_) const
+                                  Branch::CPtrVec      *paths_) const
 {
   return ::eplfs::action(branches_,fusepath_,paths_);
 }
@@ -164,7 +164,7 @@ Policy::EPLFS::Action::operator()(const Branches::CPtr &branches_,
 int
 Policy::EPLFS::Create::operator()(const Branches::CPtr &branches_,
                                   const char           *fusepath_,
-                                  StrVec               *paths_) const
+                                  Branch::CPtrVec      *paths_) const
 {
   return ::eplfs::create(branches_,fusepath_,paths_);
 }
@@ -172,7 +172,7 @@ Policy::EPLFS::Create::operator()(const Branches::CPtr &branches_,
 int
 Policy::EPLFS::Search::operator()(const Branches::CPtr &branches_,
                                   const char           *fusepath_,
-                                  StrVec               *paths_) const
+                                  Branch::CPtrVec      *paths_) const
 {
   return ::eplfs::search(branches_,fusepath_,paths_);
 }
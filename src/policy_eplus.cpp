@@ -15,10 +15,10 @@
 */
 
 #include "errno.hpp"
+#include "fs_dirpresence.hpp"
 #include "fs_exists.hpp"
 #include "fs_info.hpp"
 #include "fs_path.hpp"
-#include "fs_statvfs_cache.hpp"
 #include "policy.hpp"
 #include "policy_eplus.hpp"
 #include "policy_error.hpp"
@@ -35,24 +35,24 @@ namespace eplus
   int
   create(const Branches::CPtr &branches_,
          const char           *fusepath_,
-         StrVec               *paths_)
+         Branch::CPtrVec      *paths_)
   {
     int rv;
     int error;
     uint64_t eplus;
     fs::info_t info;
-    const string *basepath;
+    const Branch *obranch;
 
     error = ENOENT;
     eplus = std::numeric_limits<uint64_t>::max();
-    basepath = NULL;
+    obranch = NULL;
     for(auto &branch : *branches_)
       {
         if(branch.ro_or_nc())
           error_and_continue(error,EROFS);
-        if(!fs::exists(branch.path,fusepath_))
+        if(!fs::dirpresence::exists(branches_,branch,fusepath_))
           error_and_continue(error,ENOENT);
-        rv = fs::info(branch.path,&info);
+        rv = fs::info(branch,&info);
         if(rv == -1)
           error_and_continue(error,ENOENT);
         if(info.readonly)
@@ -63,13 +63,13 @@ namespace eplus
           continue;
 
         eplus = info.spaceused;
-        basepath = &branch.path;
+        obranch = &branch;
       }
 
-    if(basepath == NULL)
+    if(obranch == NULL)
       return (errno=error,-1);
 
-    paths_->push_back(*basepath);
+    paths_->push_back(obranch);
 
     return 0;
   }
@@ -78,24 +78,24 @@ namespace eplus
   int
   action(const Branches::CPtr &branches_,
          const char           *fusepath_,
-         StrVec               *paths_)
+         Branch::CPtrVec      *paths_)
   {
     int rv;
     int error;
     uint64_t eplus;
     fs::info_t info;
-    const string *basepath;
+    const Branch *obranch;
 
     error = ENOENT;
     eplus = std::numeric_limits<uint64_t>::max();
-    basepath = NULL;
+    obranch = NULL;
     for(auto &branch : *branches_)
       {
         if(branch.ro())
           error_and_continue(error,EROFS);
-        if(!fs::exists(branch.path,fusepath_))
+        if(!fs::exists(branch,fusepath_))
           error_and_continue(error,ENOENT);
-        rv = fs::info(branch.path,&info);
+        rv = fs::info(branch,&info);
         if(rv == -1)
           error_and_continue(error,ENOENT);
         if(info.readonly)
@@ -104,13 +104,13 @@ namespace eplus
           continue;
 
         eplus = info.spaceused;
-        basepath = &branch.path;
+        obranch = &branch;
       }
 
-    if(basepath == NULL)
+    if(obranch == NULL)
       return (errno=error,-1);
 
-    paths_->push_back(*basepath);
+    paths_->push_back(obranch);
 
     return 0;
   }
@@ -119,33 +119,33 @@ namespace eplus
   int
   search(const Branches::CPtr &branches_,
          const char           *fusepath_,
-         StrVec               *paths_)
+         Branch::CPtrVec      *paths_)
   {
     int rv;
     uint64_t eplus;
-    uint64_t spaceused;
-    const string *basepath;
+    fs::info_t info;
+    const Branch *obranch;
 
     eplus = 0;
-    basepath = NULL;
+    obranch = NULL;
     for(auto &branch : *branches_)
       {
-        if(!fs::exists(branch.path,fusepath_))
+        if(!fs::exists(branch,fusepath_))
           continue;
-        rv = fs::statvfs_cache_spaceused(branch.path,&spaceused);
+        rv = fs::info(branch,&info);
         if(rv == -1)
           continue;
-        if(spaceused >= eplus)
+        if(info.spaceused >= eplus)
           continue;
 
-        eplus = spaceused;
-        basepath = &branch.path;
+        eplus = info.spaceused;
+        obranch = &branch;
       }
 
-    if(basepath == NULL)
+    if(obranch == NULL)
       return (errno=ENOENT,-1);
 
-    paths_->push_back(*basepath);
+    paths_->push_back(obranch);
 
     return 0;
   }
@@ -154,7 +154,7 @@ namespace eplus
 int
 Policy::EPLUS::Action::operator()(const Branches::CPtr &branches_,
                                   const char          *fusepath_,
-                                  StrVec              *paths_) const
+                                  Branch::CPtrVec     *paths_) const
 {
   return ::eplus::action(branches_,fusepath_,paths_);
 }
@@ -162,7 +162,7 @@ Policy::EPLUS::Action::operator()(const Branches::CPtr &branches_,
 int
 Policy::EPLUS::Create::operator()(const Branches::CPtr &branches_,
                                   const char           *fusepath_,
-                                  StrVec               *paths_) const
+                                  Branch::CPtrVec      *paths_) const
 {
   return ::eplus::create(branches_,fusepath_,paths_);
 }
@@ -170,7 +170,7 @@ Policy::EPLUS::Create::operator()(const Branches::CPtr &branches_,
 int
 Policy::EPLUS::Search::operator()(const Branches::CPtr &branches_,
                                   const char           *fusepath_,
-                                  StrVec               *paths_) const
+                                  Branch::CPtrVec      *paths_) const
 {
   return ::eplus::search(branches_,fusepath_,paths_);
 }
@@ -15,10 +15,10 @@
 */
 
 #include "errno.hpp"
+#include "fs_dirpresence.hpp"
 #include "fs_exists.hpp"
 #include "fs_info.hpp"
 #include "fs_path.hpp"
-#include "fs_statvfs_cache.hpp"
 #include "policy.hpp"
 #include "policy_epmfs.hpp"
 #include "policy_error.hpp"
@@ -36,24 +36,24 @@ namespace epmfs
   int
   create(const Branches::CPtr &branches_,
          const char           *fusepath_,
-         StrVec               *paths_)
+         Branch::CPtrVec      *paths_)
   {
     int rv;
     int error;
     uint64_t epmfs;
     fs::info_t info;
-    const string *basepath;
+    const Branch *obranch;
 
     error = ENOENT;
     epmfs = std::numeric_limits<uint64_t>::min();
-    basepath = NULL;
+    obranch = NULL;
     for(const auto &branch : *branches_)
       {
         if(branch.ro_or_nc())
           error_and_continue(error,EROFS);
-        if(!fs::exists(branch.path,fusepath_))
+        if(!fs::dirpresence::exists(branches_,branch,fusepath_))
           error_and_continue(error,ENOENT);
-        rv = fs::info(branch.path,&info);
+        rv = fs::info(branch,&info);
         if(rv == -1)
           error_and_continue(error,ENOENT);
         if(info.readonly)
@@ -64,13 +64,13 @@ namespace epmfs
           continue;
 
         epmfs = info.spaceavail;
-        basepath = &branch.path;
+        obranch = &branch;
       }
 
-    if(basepath == NULL)
+    if(obranch == NULL)
       return (errno=error,-1);
 
-    paths_->push_back(*basepath);
+    paths_->push_back(obranch);
 
     return 0;
   }
@@ -79,24 +79,24 @@ namespace epmfs
   int
   action(const Branches::CPtr &branches_,
          const char           *fusepath_,
-         StrVec               *paths_)
+         Branch::CPtrVec      *paths_)
   {
     int rv;
     int error;
     uint64_t epmfs;
     fs::info_t info;
-    const string *basepath;
+    const Branch *obranch;
 
     error = ENOENT;
     epmfs = std::numeric_limits<uint64_t>::min();
-    basepath = NULL;
+    obranch = NULL;
     for(const auto &branch : *branches_)
       {
         if(branch.ro())
           error_and_continue(error,EROFS);
-        if(!fs::exists(branch.path,fusepath_))
+        if(!fs::exists(branch,fusepath_))
           error_and_continue(error,ENOENT);
-        rv = fs::info(branch.path,&info);
+        rv = fs::info(branch,&info);
         if(rv == -1)
           error_and_continue(error,ENOENT);
         if(info.readonly)
@@ -105,13 +105,13 @@ namespace epmfs
           continue;
 
         epmfs = info.spaceavail;
-        basepath = &branch.path;
+        obranch = &branch;
       }
 
-    if(basepath == NULL)
+    if(obranch == NULL)
       return (errno=error,-1);
 
-    paths_->push_back(*basepath);
+    paths_->push_back(obranch);
 
     return 0;
   }
@@ -120,33 +120,33 @@ namespace epmfs
   int
   search(const Branches::CPtr &branches_,
          const char           *fusepath_,
-         StrVec               *paths_)
+         Branch::CPtrVec      *paths_)
   {
     int rv;
     uint64_t epmfs;
-    uint64_t spaceavail;
-    const string *basepath;
+    fs::info_t info;
+    const Branch *obranch;
 
     epmfs = 0;
-    basepath = NULL;
+    obranch = NULL;
     for(const auto &branch : *branches_)
       {
-        if(!fs::exists(branch.path,fusepath_))
+        if(!fs::exists(branch,fusepath_))
           continue;
-        rv = fs::statvfs_cache_spaceavail(branch.path,&spaceavail);
+        rv = fs::info(branch,&info);
         if(rv == -1)
           continue;
-        if(spaceavail < epmfs)
+        if(info.spaceavail < epmfs)
           continue;
 
-        epmfs = spaceavail;
-        basepath = &branch.path;
+        epmfs = info.spaceavail;
+        obranch = &branch;
       }
 
-    if(basepath == NULL)
+    if(obranch == NULL)
       return (errno=ENOENT,-1);
 
-    paths_->push_back(*basepath);
+    paths_->push_back(obranch);
 
     return 0;
   }
@@ -155,7 +155,7 @@ namespace epmfs
 int
 Policy::EPMFS::Action::operator()(const Branches::CPtr &branches_,
                                   const char           *fusepath_,
-                                  StrVec               *paths_) const
+                                  Branch::CPtrVec      *paths_) const
 {
   return ::epmfs::action(branches_,fusepath_,paths_);
 }
@@ -163,7 +163,7 @@ Policy::EPMFS::Action::operator()(const Branches::CPtr &branches_,
 int
 Policy::EPMFS::Create::operator()(const Branches::CPtr &branches_,
                                   const char           *fusepath_,
-                                  StrVec               *paths_) const
+                                  Branch::CPtrVec      *paths_) const
 {
   return ::epmfs::create(branches_,fusepath_,paths_);
 }
@@ -171,7 +171,7 @@ Policy::EPMFS::Create::operator()(const Branches::CPtr &branches_,
 int
 Policy::EPMFS::Search::operator()(const Branches::CPtr &branches_,
                                   const char           *fusepath_,
-                                  StrVec               *paths_) const
+                                  Branch::CPtrVec      *paths_) const
 {
   return ::epmfs::search(branches_,fusepath_,paths_);
 }
@@ -15,10 +15,10 @@
 */
 
 #include "errno.hpp"
+#include "fs_dirpresence.hpp"
 #include "fs_exists.hpp"
 #include "fs_info.hpp"
 #include "fs_path.hpp"
-#include "fs_statvfs_cache.hpp"
 #include "policy.hpp"
 #include "policy_eppfrd.hpp"
 #include "policy_error.hpp"
@@ -35,7 +35,7 @@ using std::vector;
 struct BranchInfo
 {
   uint64_t      spaceavail;
-  const string *basepath;
+  const Branch *branch;
 };
 
 typedef vector<BranchInfo> BranchInfoVec;
@@ -60,9 +60,9 @@ namespace eppfrd
       {
         if(branch.ro_or_nc())
           error_and_continue(error,EROFS);
-        if(!fs::exists(branch.path,fusepath_))
+        if(!fs::dirpresence::exists(branches_,branch,fusepath_))
           error_and_continue(error,ENOENT);
-        rv = fs::info(branch.path,&info);
+        rv = fs::info(branch,&info);
         if(rv == -1)
           error_and_continue(error,ENOENT);
         if(info.readonly)
@@ -73,7 +73,7 @@ namespace eppfrd
         *sum_ += info.spaceavail;
 
         bi.spaceavail = info.spaceavail;
-        bi.basepath   = &branch.path;
+        bi.branch     = &branch;
         branchinfo_->push_back(bi);
       }
 
@@ -98,9 +98,9 @@ namespace eppfrd
       {
         if(branch.ro())
           error_and_continue(error,EROFS);
-        if(!fs::exists(branch.path,fusepath_))
+        if(!fs::exists(branch,fusepath_))
           error_and_continue(error,ENOENT);
-        rv = fs::info(branch.path,&info);
+        rv = fs::info(branch,&info);
         if(rv == -1)
           error_and_continue(error,ENOENT);
         if(info.readonly)
@@ -109,7 +109,7 @@ namespace eppfrd
         *sum_ += info.spaceavail;
 
         bi.spaceavail = info.spaceavail;
-        bi.basepath   = &branch.path;
+        bi.branch     = &branch;
         branchinfo_->push_back(bi);
       }
 
@@ -125,21 +125,21 @@ namespace eppfrd
   {
     int rv;
     BranchInfo bi;
-    uint64_t spaceavail;
+    fs::info_t info;
 
     *sum_ = 0;
     for(auto &branch : *branches_)
       {
-        if(!fs::exists(branch.path,fusepath_))
+        if(!fs::exists(branch,fusepath_))
           continue;
-        rv = fs::statvfs_cache_spaceavail(branch.path,&spaceavail);
+        rv = fs::info(branch,&info);
         if(rv == -1)
           continue;
 
-        *sum_ += spaceavail;
+        *sum_ += info.spaceavail;
 
-        bi.spaceavail = spaceavail;
-        bi.basepath   = &branch.path;
+        bi.spaceavail = info.spaceavail;
+        bi.branch     = &branch;
         branchinfo_->push_back(bi);
       }
 
@@ -148,7 +148,7 @@ namespace eppfrd
 
   static
   const
-  string*
+  Branch*
   get_branch(const BranchInfoVec &branchinfo_,
              const uint64_t       sum_)
   {
@@ -167,7 +167,7 @@ namespace eppfrd
         if(idx < threshold)
           continue;
 
-        return branchinfo_[i].basepath;
+        return branchinfo_[i].branch;
       }
 
     return NULL;
@@ -177,19 +177,19 @@ namespace eppfrd
   int
   create(const Branches::CPtr &branches_,
          const char           *fusepath_,
-         StrVec               *paths_)
+         Branch::CPtrVec      *paths_)
   {
     int error;
     uint64_t sum;
-    const string *basepath;
+    const Branch *obranch;
     BranchInfoVec branchinfo;
 
     error    = eppfrd::get_branchinfo_create(branches_,fusepath_,&branchinfo,&sum);
-    basepath = eppfrd::get_branch(branchinfo,sum);
-    if(basepath == NULL)
+    obranch  = eppfrd::get_branch(branchinfo,sum);
+    if(obranch == NULL)
       return (errno=error,-1);
 
-    paths_->push_back(*basepath);
+    paths_->push_back(obranch);
 
     return 0;
   }
@@ -198,19 +198,19 @@ namespace eppfrd
   int
   action(const Branches::CPtr &branches_,
          const char           *fusepath_,
-         StrVec               *paths_)
+         Branch::CPtrVec      *paths_)
   {
     int error;
     uint64_t sum;
-    const string *basepath;
+    const Branch *obranch;
     BranchInfoVec branchinfo;
 
     error    = eppfrd::get_branchinfo_action(branches_,fusepath_,&branchinfo,&sum);
-    basepath = eppfrd::get_branch(branchinfo,sum);
-    if(basepath == NULL)
+    obranch  = eppfrd::get_branch(branchinfo,sum);
+    if(obranch == NULL)
       return (errno=error,-1);
 
-    paths_->push_back(*basepath);
+    paths_->push_back(obranch);
 
     return 0;
   }
@@ -219,19 +219,19 @@ namespace eppfrd
   int
   search(const Branches::CPtr &branches_,
          const char           *fusepath_,
-         StrVec               *paths_)
+         Branch::CPtrVec      *paths_)
   {
     int error;
     uint64_t sum;
-    const string *basepath;
+    const Branch *obranch;
     BranchInfoVec branchinfo;
 
     error    = eppfrd::get_branchinfo_search(branches_,fusepath_,&branchinfo,&sum);
-    basepath = eppfrd::get_branch(branchinfo,sum);
-    if(basepath == NULL)
+    obranch  = eppfrd::get_branch(branchinfo,sum);
+    if(obranch == NULL)
       return (errno=error,-1);
 
-    paths_->push_back(*basepath);
+    paths_->push_back(obranch);
 
     return 0;
   }
@@ -240,7 +240,7 @@ namespace eppfrd
 int
 Policy::EPPFRD::Action::operator()(const Branches::CPtr &branches_,
                                    const char           *fusepath_,
-                                   StrVec               *paths_) const
+                                   Branch::CPtrVec      *paths_) const
 {
   return ::eppfrd::action(branches_,fusepath_,paths_);
 }
@@ -248,7 +248,7 @@ Policy::EPPFRD::Action::operator()(const Branches::CPtr &branches_,
 int
 Policy::EPPFRD::Create::operator()(const Branches::CPtr &branches_,
                                    const char           *fusepath_,
-                                   StrVec               *paths_) const
+                                   Branch::CPtrVec      *paths_) const
 {
   return ::eppfrd::create(branches_,fusepath_,paths_);
 }
@@ -256,7 +256,7 @@ Policy::EPPFRD::Create::operator()(const Branches::CPtr &branches_,
 int
 Policy::EPPFRD::Search::operator()(const Branches::CPtr &branches_,
                                    const char           *fusepath_,
-                                   StrVec               *paths_) const
+                                   Branch::CPtrVec      *paths_) const
 {
   return ::eppfrd::search(branches_,fusepath_,paths_);
 }
@@ -24,7 +24,7 @@
 int
 Policy::EPRand::Action::operator()(const Branches::CPtr &branches_,
                                    const char           *fusepath_,
-                                   StrVec               *paths_) const
+                                   Branch::CPtrVec      *paths_) const
 {
   int rv;
 
@@ -41,7 +41,7 @@ Policy::EPRand::Action::operator()(const Branches::CPtr &branches_,
 int
 Policy::EPRand::Create::operator()(const Branches::CPtr &branches_,
                                    const char           *fusepath_,
-                                   StrVec               *paths_) const
+                                   Branch::CPtrVec      *paths_) const
 {
   int rv;
 
@@ -58,7 +58,7 @@ Policy::EPRand::Create::operator()(const Branches::CPtr &branches_,
 int
 Policy::EPRand::Search::operator()(const Branches::CPtr &branches_,
                                    const char           *fusepath_,
-                                   StrVec               *paths_) const
+                                   Branch::CPtrVec      *paths_) const
 {
   int rv;
 
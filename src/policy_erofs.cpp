@@ -26,7 +26,7 @@ using std::string;
 int
 Policy::ERoFS::Action::operator()(const Branches::CPtr &branches_,
                                   const char           *fusepath_,
-                                  StrVec               *paths_) const
+                                  Branch::CPtrVec      *paths_) const
 {
   return (errno=EROFS,-1);
 }
@@ -34,7 +34,7 @@ Policy::ERoFS::Action::operator()(const Branches::CPtr &branches_,
 int
 Policy::ERoFS::Create::operator()(const Branches::CPtr &branches_,
                                   const char           *fusepath_,
-                                  StrVec               *paths_) const
+                                  Branch::CPtrVec      *paths_) const
 {
   return (errno=EROFS,-1);
 }
@@ -42,7 +42,7 @@ Policy::ERoFS::Create::operator()(const Branches::CPtr &branches_,
 int
 Policy::ERoFS::Search::operator()(const Branches::CPtr &branches_,
                                   const char           *fusepath_,
-                                  StrVec               *paths_) const
+                                  Branch::CPtrVec      *paths_) const
 {
   return (errno=EROFS,-1);
 }
@@ -20,6 +20,7 @@
 #include "fs_path.hpp"
 #include "policies.hpp"
 #include "policy.hpp"
+#include "policy_concurrent.hpp"
 #include "policy_error.hpp"
 #include "policy_ff.hpp"
 
@@ -32,7 +33,7 @@ namespace ff
   static
   int
   create(const Branches::CPtr &branches_,
-         StrVec               *paths_)
+         Branch::CPtrVec      *paths_)
   {
     int rv;
     int error;
@@ -43,7 +44,7 @@ namespace ff
       {
         if(branch.ro_or_nc())
           error_and_continue(error,EROFS);
-        rv = fs::info(branch.path,&info);
+        rv = fs::info(branch,&info);
         if(rv == -1)
           error_and_continue(error,ENOENT);
         if(info.readonly)
@@ -51,7 +52,7 @@ namespace ff
         if(info.spaceavail < branch.minfreespace())
           error_and_continue(error,ENOSPC);
 
-        paths_->push_back(branch.path);
+        paths_->push_back(&branch);
 
         return 0;
       }
@@ -63,7 +64,7 @@ namespace ff
 int
 Policy::FF::Action::operator()(const Branches::CPtr &branches_,
                                const char           *fusepath_,
-                               StrVec               *paths_) const
+                               Branch::CPtrVec      *paths_) const
 {
   return Policies::Action::epff(branches_,fusepath_,paths_);
 }
@@ -71,7 +72,7 @@ Policy::FF::Action::operator()(const Branches::CPtr &branches_,
 int
 Policy::FF::Create::operator()(const Branches::CPtr &branches_,
                                const char           *fusepath_,
-                               StrVec               *paths_) const
+                               Branch::CPtrVec      *paths_) const
 {
   return ::ff::create(branches_,paths_);
 }
@@ -79,7 +80,15 @@ Policy::FF::Create::operator()(const Branches::CPtr &branches_,
 int
 Policy::FF::Search::operator()(const Branches::CPtr &branches_,
                                const char           *fusepath_,
-                               StrVec               *paths_) const
+                               Branch::CPtrVec      *paths_) const
 {
   return Policies::Search::epff(branches_,fusepath_,paths_);
 }
+
+int
+Policy::FF::Search::concurrent(const Branches::CPtr &branches_,
+                               const char           *fusepath_,
+                               Branch::CPtrVec      *paths_) const
+{
+  return Policy::Concurrent::epff(branches_,fusepath_,paths_);
+}
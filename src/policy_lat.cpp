@@ -0,0 +1,179 @@
+/*
+  ISC License
+
+  Copyright (c) 2024, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include "errno.hpp"
+#include "fs_exists.hpp"
+#include "fs_info.hpp"
+#include "policies.hpp"
+#include "policy.hpp"
+#include "policy_error.hpp"
+#include "policy_lat.hpp"
+
+#include <string>
+
+using std::string;
+
+static std::atomic<uint64_t> g_hysteresis(20);
+
+namespace lat
+{
+  static std::atomic<const BranchStats*> g_prev(NULL);
+
+  static
+  int
+  create(const Branches::CPtr &branches_,
+         Branch::CPtrVec      *paths_)
+  {
+    int rv;
+    int error;
+    fs::info_t info;
+    const Branch *branch;
+    std::vector<const Branch*> candidates;
+
+    error = ENOENT;
+    for(const auto &branch : *branches_)
+      {
+        if(branch.ro_or_nc())
+          error_and_continue(error,EROFS);
+        rv = fs::info(branch,&info);
+        if(rv == -1)
+          error_and_continue(error,ENOENT);
+        if(info.readonly)
+          error_and_continue(error,EROFS);
+        if(info.spaceavail < branch.minfreespace())
+          error_and_continue(error,ENOSPC);
+
+        candidates.push_back(&branch);
+      }
+
+    branch = Policy::LAT::fastest(candidates,&g_prev);
+    if(branch == NULL)
+      return (errno=error,-1);
+
+    paths_->push_back(branch);
+
+    return 0;
+  }
+}
+
+namespace Policy
+{
+  namespace LAT
+  {
+    uint64_t
+    hysteresis(void)
+    {
+      return g_hysteresis;
+    }
+
+    void
+    hysteresis(const uint64_t percent_)
+    {
+      g_hysteresis = percent_;
+    }
+
+    bool
+    exists(const Branch &branch_,
+           const char   *fusepath_)
+    {
+      bool rv;
+      uint64_t start;
+
+      start = BranchStats::now();
+      rv = fs::exists(branch_,fusepath_);
+      branch_.stats->record(start,
+                            (!rv && (errno != ENOENT) && (errno != ENOTDIR)));
+
+      return rv;
+    }
+
+    const
+    Branch*
+    fastest(const std::vector<const Branch*> &candidates_)
+    {
+      const Branch *rv;
+
+      rv = NULL;
+      for(const auto branch : candidates_)
+        {
+          if((rv == NULL) || (branch->stats->score() < rv->stats->score()))
+            rv = branch;
+        }
+
+      return rv;
+    }
+
+    /*
+      Sticks with the previous choice unless another candidate is
+      faster by more than the hysteresis percentage so placement
+      doesn't flip between branches of similar speed on noise.
+    */
+    const
+    Branch*
+    fastest(const std::vector<const Branch*> &candidates_,
+            std::atomic<const BranchStats*>  *prev_)
+    {
+      uint64_t best;
+      const Branch *rv;
+      const BranchStats *prev;
+
+      rv = LAT::fastest(candidates_);
+      if(rv == NULL)
+        return NULL;
+
+      best = rv->stats->score();
+      prev = prev_->load(std::memory_order_relaxed);
+      for(const auto branch : candidates_)
+        {
+          if(branch->stats.get() != prev)
+            continue;
+          if(branch->stats->score() <= (best + ((best * g_hysteresis) / 100)))
+            return branch;
+          break;
+        }
+
+      prev_->store(rv->stats.get(),std::memory_order_relaxed);
+
+      return rv;
+    }
+  }
+}
+
+int
+Policy::LAT::Action::operator()(const Branches::CPtr &branches_,
+                                const char           *fusepath_,
+                                Branch::CPtrVec      *paths_) const
+{
+  return Policies::Action::eplat(branches_,fusepath_,paths_);
+}
+
+int
+Policy::LAT::Create::operator()(const Branches::CPtr &branches_,
+                                const char           *fusepath_,
+                                Branch::CPtrVec      *paths_) const
+{
+  return ::lat::create(branches_,paths_);
+}
+
+int
+Policy::LAT::Search::operator()(const Branches::CPtr &branches_,
+                                const char           *fusepath_,
+                                Branch::CPtrVec      *paths_) const
+{
+  return Policies::Search::eplat(branches_,fusepath_,paths_);
+}
@@ -31,22 +31,22 @@ namespace mfs
   static
   int
   create(const Branches::CPtr &branches_,
-         StrVec               *paths_)
+         Branch::CPtrVec      *paths_)
   {
     int rv;
     int error;
     uint64_t mfs;
     fs::info_t info;
-    const string *basepath;
+    const Branch *obranch;
 
     error = ENOENT;
     mfs = 0;
-    basepath = NULL;
+    obranch = NULL;
     for(const auto &branch : *branches_)
       {
         if(branch.ro_or_nc())
           error_and_continue(error,EROFS);
-        rv = fs::info(branch.path,&info);
+        rv = fs::info(branch,&info);
         if(rv == -1)
           error_and_continue(error,ENOENT);
         if(info.readonly)
@@ -57,13 +57,13 @@ namespace mfs
           continue;
 
         mfs = info.spaceavail;
-        basepath = &branch.path;
+        obranch = &branch;
       }
 
-    if(basepath == NULL)
+    if(obranch == NULL)
       return (errno=error,-1);
 
-    paths_->push_back(*basepath);
+    paths_->push_back(obranch);
 
     return 0;
   }
@@ -72,7 +72,7 @@ namespace mfs
 int
 Policy::MFS::Action::operator()(const Branches::CPtr &branches_,
                                 const char           *fusepath_,
-                                StrVec               *paths_) const
+                                Branch::CPtrVec      *paths_) const
 {
   return Policies::Action::epmfs(branches_,fusepath_,paths_);
 }
@@ -80,7 +80,7 @@ Policy::MFS::Action::operator()(const Branches::CPtr &branches_,
 int
 Policy::MFS::Create::operator()(const Branches::CPtr &branches_,
                                 const char           *fusepath_,
-                                StrVec               *paths_) const
+                                Branch::CPtrVec      *paths_) const
 {
   return ::mfs::create(branches_,paths_);
 }
@@ -88,7 +88,7 @@ Policy::MFS::Create::operator()(const Branches::CPtr &branches_,
 int
 Policy::MFS::Search::operator()(const Branches::CPtr &branches_,
                                 const char           *fusepath_,
-                                StrVec               *paths_) const
+                                Branch::CPtrVec      *paths_) const
 {
   return Policies::Search::epmfs(branches_,fusepath_,paths_);
 }
@@ -15,7 +15,7 @@
 */
 
 #include "errno.hpp"
-#include "fs_exists.hpp"
+#include "fs_dirpresence.hpp"
 #include "fs_info.hpp"
 #include "fs_path.hpp"
 #include "fs_statvfs_cache.hpp"
@@ -35,7 +35,7 @@ namespace msplfs
 {
   static
   const
-  string*
+  Branch*
   create_1(const Branches::CPtr &branches_,
            const string         &fusepath_,
            int                  *err_)
@@ -43,17 +43,17 @@ namespace msplfs
     int rv;
     uint64_t lfs;
     fs::info_t info;
-    const string *basepath;
+    const Branch *obranch;
 
-    basepath = NULL;
+    obranch = NULL;
     lfs = std::numeric_limits<uint64_t>::max();
     for(const auto &branch : *branches_)
       {
         if(branch.ro_or_nc())
           error_and_continue(*err_,EROFS);
-        if(!fs::exists(branch.path,fusepath_))
+        if(!fs::dirpresence::exists(branches_,branch,fusepath_.c_str()))
           error_and_continue(*err_,ENOENT);
-        rv = fs::info(branch.path,&info);
+        rv = fs::info(branch,&info);
         if(rv == -1)
           error_and_continue(*err_,ENOENT);
         if(info.readonly)
@@ -64,38 +64,38 @@ namespace msplfs
           continue;
 
         lfs = info.spaceavail;
-        basepath = &branch.path;
+        obranch = &branch;
       }
 
-    return basepath;
+    return obranch;
   }
 
   static
   int
   create(const Branches::CPtr &branches_,
          const char           *fusepath_,
-         StrVec               *paths_)
+         Branch::CPtrVec      *paths_)
   {
     int error;
     string fusepath;
-    const string *basepath;
+    const Branch *obranch;
 
     error = ENOENT;
     fusepath = fusepath_;
     for(;;)
       {
-        basepath = msplfs::create_1(branches_,fusepath,&error);
-        if(basepath)
+        obranch = msplfs::create_1(branches_,fusepath,&error);
+        if(obranch)
           break;
         if(fusepath == "/")
           break;
         fusepath = fs::path::dirname(fusepath);
       }
 
-    if(basepath == NULL)
+    if(obranch == NULL)
       return (errno=error,-1);
 
-    paths_->push_back(*basepath);
+    paths_->push_back(obranch);
 
     return 0;
   }
@@ -104,7 +104,7 @@ namespace msplfs
 int
 Policy::MSPLFS::Action::operator()(const Branches::CPtr &branches_,
                                    const char           *fusepath_,
-                                   StrVec               *paths_) const
+                                   Branch::CPtrVec      *paths_) const
 {
   return Policies::Action::eplfs(branches_,fusepath_,paths_);
 }
@@ -112,7 +112,7 @@ Policy::MSPLFS::Action::operator()(const Branches::CPtr &branches_,
 int
 Policy::MSPLFS::Create::operator()(const Branches::CPtr &branches_,
                                    const char           *fusepath_,
-                                   StrVec               *paths_) const
+                                   Branch::CPtrVec      *paths_) const
 {
   return ::msplfs::create(branches_,fusepath_,paths_);
 }
@@ -120,7 +120,7 @@ Policy::MSPLFS::Create::operator()(const Branches::CPtr &branches_,
 int
 Policy::MSPLFS::Search::operator()(const Branches::CPtr &branches_,
                                    const char           *fusepath_,
-                                   StrVec               *paths_) const
+                                   Branch::CPtrVec      *paths_) const
 {
   return Policies::Search::eplfs(branches_,fusepath_,paths_);
 }
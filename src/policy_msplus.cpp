@@ -15,7 +15,7 @@
 */
 
 #include "errno.hpp"
-#include "fs_exists.hpp"
+#include "fs_dirpresence.hpp"
 #include "fs_info.hpp"
 #include "fs_path.hpp"
 #include "fs_statvfs_cache.hpp"
@@ -33,7 +33,7 @@ namespace msplus
 {
   static
   const
-  string*
+  Branch*
   create_1(const Branches::CPtr &branches_,
            const string         &fusepath_,
            int                  *err_)
@@ -41,17 +41,17 @@ namespace msplus
     int rv;
     uint64_t lus;
     fs::info_t info;
-    const string *basepath;
+    const Branch *obranch;
 
-    basepath = NULL;
+    obranch = NULL;
     lus = std::numeric_limits<uint64_t>::max();
     for(auto &branch : *branches_)
       {
         if(branch.ro_or_nc())
           error_and_continue(*err_,EROFS);
-        if(!fs::exists(branch.path,fusepath_))
+        if(!fs::dirpresence::exists(branches_,branch,fusepath_.c_str()))
           error_and_continue(*err_,ENOENT);
-        rv = fs::info(branch.path,&info);
+        rv = fs::info(branch,&info);
         if(rv == -1)
           error_and_continue(*err_,ENOENT);
         if(info.readonly)
@@ -62,38 +62,38 @@ namespace msplus
           continue;
 
         lus = info.spaceused;;
-        basepath = &branch.path;
+        obranch = &branch;
       }
 
-    return basepath;
+    return obranch;
   }
 
   static
   int
   create(const Branches::CPtr &branches_,
          const char           *fusepath_,
-         StrVec               *paths_)
+         Branch::CPtrVec      *paths_)
   {
     int error;
     string fusepath;
-    const string *basepath;
+    const Branch *obranch;
 
     error = ENOENT;
     fusepath = fusepath_;
     for(;;)
       {
-        basepath = msplus::create_1(branches_,fusepath,&error);
-        if(basepath)
+        obranch = msplus::create_1(branches_,fusepath,&error);
+        if(obranch)
           break;
         if(fusepath == "/")
           break;
         fusepath = fs::path::dirname(fusepath);
       }
 
-    if(basepath == NULL)
+    if(obranch == NULL)
       return (errno=error,-1);
 
-    paths_->push_back(*basepath);
+    paths_->push_back(obranch);
 
     return 0;
   }
@@ -102,7 +102,7 @@ namespace msplus
 int
 Policy::MSPLUS::Action::operator()(const Branches::CPtr &branches_,
                                    const char           *fusepath_,
-                                   StrVec               *paths_) const
+                                   Branch::CPtrVec      *paths_) const
 {
   return Policies::Action::eplus(branches_,fusepath_,paths_);
 }
@@ -110,7 +110,7 @@ Policy::MSPLUS::Action::operator()(const Branches::CPtr &branches_,
 int
 Policy::MSPLUS::Create::operator()(const Branches::CPtr &branches_,
                                    const char           *fusepath_,
-                                   StrVec               *paths_) const
+                                   Branch::CPtrVec      *paths_) const
 {
   return ::msplus::create(branches_,fusepath_,paths_);
 }
@@ -118,7 +118,7 @@ Policy::MSPLUS::Create::operator()(const Branches::CPtr &branches_,
 int
 Policy::MSPLUS::Search::operator()(const Branches::CPtr &branches_,
                                    const char           *fusepath_,
-                                   StrVec               *paths_) const
+                                   Branch::CPtrVec      *paths_) const
 {
   return Policies::Search::eplus(branches_,fusepath_,paths_);
 }
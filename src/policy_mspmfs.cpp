@@ -15,7 +15,7 @@
 */
 
 #include "errno.hpp"
-#include "fs_exists.hpp"
+#include "fs_dirpresence.hpp"
 #include "fs_info.hpp"
 #include "fs_path.hpp"
 #include "fs_statvfs_cache.hpp"
@@ -36,7 +36,7 @@ namespace mspmfs
 {
   static
   const
-  string*
+  Branch*
   create_1(const Branches::CPtr &branches_,
            const string         &fusepath_,
            int                  *err_)
@@ -44,17 +44,17 @@ namespace mspmfs
     int rv;
     uint64_t mfs;
     fs::info_t info;
-    const string *basepath;
+    const Branch *obranch;
 
-    basepath = NULL;
+    obranch = NULL;
     mfs = std::numeric_limits<uint64_t>::min();
     for(const auto &branch : *branches_)
       {
         if(branch.ro_or_nc())
           error_and_continue(*err_,EROFS);
-        if(!fs::exists(branch.path,fusepath_))
+        if(!fs::dirpresence::exists(branches_,branch,fusepath_.c_str()))
           error_and_continue(*err_,ENOENT);
-        rv = fs::info(branch.path,&info);
+        rv = fs::info(branch,&info);
         if(rv == -1)
           error_and_continue(*err_,ENOENT);
         if(info.readonly)
@@ -65,38 +65,38 @@ namespace mspmfs
           continue;
 
         mfs = info.spaceavail;
-        basepath = &branch.path;
+        obranch = &branch;
       }
 
-    return basepath;
+    return obranch;
   }
 
   static
   int
   create(const Branches::CPtr &branches_,
          const char           *fusepath_,
-         StrVec               *paths_)
+         Branch::CPtrVec      *paths_)
   {
     int error;
     string fusepath;
-    const string *basepath;
+    const Branch *obranch;
 
     error = ENOENT;
     fusepath = fusepath_;
     for(;;)
       {
-        basepath = mspmfs::create_1(branches_,fusepath,&error);
-        if(basepath)
+        obranch = mspmfs::create_1(branches_,fusepath,&error);
+        if(obranch)
           break;
         if(fusepath == "/")
           break;
         fusepath = fs::path::dirname(fusepath);
       }
 
-    if(basepath == NULL)
+    if(obranch == NULL)
       return (errno=error,-1);
 
-    paths_->push_back(*basepath);
+    paths_->push_back(obranch);
 
     return 0;
   }
@@ -105,7 +105,7 @@ namespace mspmfs
 int
 Policy::MSPMFS::Action::operator()(const Branches::CPtr &branches_,
                                    const char           *fusepath_,
-                                   StrVec               *paths_) const
+                                   Branch::CPtrVec      *paths_) const
 {
   return Policies::Action::epmfs(branches_,fusepath_,paths_);
 }
@@ -113,7 +113,7 @@ Policy::MSPMFS::Action::operator()(const Branches::CPtr &branches_,
 int
 Policy::MSPMFS::Create::operator()(const Branches::CPtr &branches_,
                                    const char           *fusepath_,
-                                   StrVec               *paths_) const
+                                   Branch::CPtrVec      *paths_) const
 {
   return ::mspmfs::create(branches_,fusepath_,paths_);
 }
@@ -121,7 +121,7 @@ Policy::MSPMFS::Create::operator()(const Branches::CPtr &branches_,
 int
 Policy::MSPMFS::Search::operator()(const Branches::CPtr &branches_,
                                    const char           *fusepath_,
-                                   StrVec               *paths_) const
+                                   Branch::CPtrVec      *paths_) const
 {
   return Policies::Search::epmfs(branches_,fusepath_,paths_);
 }
@@ -17,7 +17,7 @@
 */
 
 #include "errno.hpp"
-#include "fs_exists.hpp"
+#include "fs_dirpresence.hpp"
 #include "fs_info.hpp"
 #include "fs_path.hpp"
 #include "fs_statvfs_cache.hpp"
@@ -36,7 +36,7 @@ using std::vector;
 struct BranchInfo
 {
   uint64_t      spaceavail;
-  const string *basepath;
+  const Branch *branch;
 };
 
 typedef vector<BranchInfo> BranchInfoVec;
@@ -61,9 +61,9 @@ namespace msppfrd
       {
         if(branch.ro_or_nc())
           error_and_continue(error,EROFS);
-        if(!fs::exists(branch.path,fusepath_))
+        if(!fs::dirpresence::exists(branches_,branch,fusepath_.c_str()))
           error_and_continue(error,ENOENT);
-        rv = fs::info(branch.path,&info);
+        rv = fs::info(branch,&info);
         if(rv == -1)
           error_and_continue(error,ENOENT);
         if(info.readonly)
@@ -74,7 +74,7 @@ namespace msppfrd
         *sum_ += info.spaceavail;
 
         bi.spaceavail = info.spaceavail;
-        bi.basepath   = &branch.path;
+        bi.branch     = &branch;
         branchinfo_->push_back(bi);
       }
 
@@ -107,7 +107,7 @@ namespace msppfrd
 
   static
   const
-  string*
+  Branch*
   get_branch(const BranchInfoVec &branchinfo_,
              const uint64_t       sum_)
   {
@@ -126,7 +126,7 @@ namespace msppfrd
         if(idx < threshold)
           continue;
 
-        return branchinfo_[i].basepath;
+        return branchinfo_[i].branch;
       }
 
     return NULL;
@@ -136,19 +136,19 @@ namespace msppfrd
   int
   create(const Branches::CPtr &branches_,
          const char           *fusepath_,
-         StrVec               *paths_)
+         Branch::CPtrVec      *paths_)
   {
     int error;
     uint64_t sum;
-    const string *basepath;
+    const Branch *obranch;
     BranchInfoVec branchinfo;
 
     error    = msppfrd::get_branchinfo(branches_,fusepath_,&branchinfo,&sum);
-    basepath = msppfrd::get_branch(branchinfo,sum);
-    if(basepath == NULL)
+    obranch  = msppfrd::get_branch(branchinfo,sum);
+    if(obranch == NULL)
       return (errno=error,-1);
 
-    paths_->push_back(*basepath);
+    paths_->push_back(obranch);
 
     return 0;
   }
@@ -157,7 +157,7 @@ namespace msppfrd
 int
 Policy::MSPPFRD::Action::operator()(const Branches::CPtr &branches_,
                                     const char           *fusepath_,
-                                    StrVec               *paths_) const
+                                    Branch::CPtrVec      *paths_) const
 {
   return Policies::Action::eppfrd(branches_,fusepath_,paths_);
 }
@@ -165,7 +165,7 @@ Policy::MSPPFRD::Action::operator()(const Branches::CPtr &branches_,
 int
 Policy::MSPPFRD::Create::operator()(const Branches::CPtr &branches_,
                                     const char           *fusepath_,
-                                    StrVec               *paths_) const
+                                    Branch::CPtrVec      *paths_) const
 {
   return ::msppfrd::create(branches_,fusepath_,paths_);
 }
@@ -173,7 +173,7 @@ Policy::MSPPFRD::Create::operator()(const Branches::CPtr &branches_,
 int
 Policy::MSPPFRD::Search::operator()(const Branches::CPtr &branches_,
                                     const char           *fusepath_,
-                                    StrVec               *paths_) const
+                                    Branch::CPtrVec      *paths_) const
 {
   return Policies::Search::eppfrd(branches_,fusepath_,paths_);
 }
@@ -18,8 +18,8 @@
 #include "fs_exists.hpp"
 #include "fs_info.hpp"
 #include "fs_path.hpp"
-#include "fs_statvfs_cache.hpp"
 #include "policy.hpp"
+#include "policy_concurrent.hpp"
 #include "policy_error.hpp"
 #include "policy_newest.hpp"
 #include "rwlock.hpp"
@@ -37,27 +37,27 @@ namespace newest
   int
   create(const Branches::CPtr &branches_,
          const char           *fusepath_,
-         StrVec               *paths_)
+         Branch::CPtrVec      *paths_)
   {
     int rv;
     int error;
     time_t newest;
     struct stat st;
     fs::info_t info;
-    const string *basepath;
+    const Branch *obranch;
 
     error = ENOENT;
     newest = std::numeric_limits<time_t>::min();
-    basepath = NULL;
+    obranch = NULL;
     for(auto &branch : *branches_)
       {
         if(branch.ro_or_nc())
           error_and_continue(error,EROFS);
-        if(!fs::exists(branch.path,fusepath_,&st))
+        if(!fs::exists(branch,fusepath_,&st))
           error_and_continue(error,ENOENT);
         if(st.st_mtime < newest)
           continue;
-        rv = fs::info(branch.path,&info);
+        rv = fs::info(branch,&info);
         if(rv == -1)
           error_and_continue(error,ENOENT);
         if(info.readonly)
@@ -66,13 +66,13 @@ namespace newest
           error_and_continue(error,ENOSPC);
 
         newest = st.st_mtime;
-        basepath = &branch.path;
+        obranch = &branch;
       }
 
-    if(basepath == NULL)
+    if(obranch == NULL)
       return (errno=error,-1);
 
-    paths_->push_back(*basepath);
+    paths_->push_back(obranch);
 
     return 0;
   }
@@ -81,40 +81,40 @@ namespace newest
   int
   action(const Branches::CPtr &branches_,
          const char           *fusepath_,
-         StrVec               *paths_)
+         Branch::CPtrVec      *paths_)
   {
     int rv;
     int error;
-    bool readonly;
+    fs::info_t info;
     time_t newest;
     struct stat st;
-    const string *basepath;
+    const Branch *obranch;
 
     error = ENOENT;
     newest = std::numeric_limits<time_t>::min();
-    basepath = NULL;
+    obranch = NULL;
     for(auto &branch : *branches_)
       {
         if(branch.ro())
           error_and_continue(error,EROFS);
-        if(!fs::exists(branch.path,fusepath_,&st))
+        if(!fs::exists(branch,fusepath_,&st))
           error_and_continue(error,ENOENT);
         if(st.st_mtime < newest)
           continue;
-        rv = fs::statvfs_cache_readonly(branch.path,&readonly);
+        rv = fs::info(branch,&info);
         if(rv == -1)
           error_and_continue(error,ENOENT);
-        if(readonly)
+        if(info.readonly)
           error_and_continue(error,EROFS);
 
         newest = st.st_mtime;
-        basepath = &branch.path;
+        obranch = &branch;
       }
 
-    if(basepath == NULL)
+    if(obranch == NULL)
       return (errno=error,-1);
 
-    paths_->push_back(*basepath);
+    paths_->push_back(obranch);
 
     return 0;
   }
@@ -123,29 +123,29 @@ namespace newest
   int
   search(const Branches::CPtr &branches_,
          const char           *fusepath_,
-         StrVec               *paths_)
+         Branch::CPtrVec      *paths_)
   {
     time_t newest;
     struct stat st;
-    const string *basepath;
+    const Branch *obranch;
 
     newest = std::numeric_limits<time_t>::min();
-    basepath = NULL;
+    obranch = NULL;
     for(auto &branch : *branches_)
       {
-        if(!fs::exists(branch.path,fusepath_,&st))
+        if(!fs::exists(branch,fusepath_,&st))
           continue;
         if(st.st_mtime < newest)
           continue;
 
         newest = st.st_mtime;
-        basepath = &branch.path;
+        obranch = &branch;
       }
 
-    if(basepath == NULL)
+    if(obranch == NULL)
       return (errno=ENOENT,-1);
 
-    paths_->push_back(*basepath);
+    paths_->push_back(obranch);
 
     return 0;
   }
@@ -154,7 +154,7 @@ namespace newest
 int
 Policy::Newest::Action::operator()(const Branches::CPtr &branches_,
                                    const char           *fusepath_,
-                                   StrVec               *paths_) const
+                                   Branch::CPtrVec      *paths_) const
 {
   return ::newest::action(branches_,fusepath_,paths_);
 }
@@ -162,7 +162,7 @@ Policy::Newest::Action::operator()(const Branches::CPtr &branches_,
 int
 Policy::Newest::Create::operator()(const Branches::CPtr &branches_,
                                    const char           *fusepath_,
-                                   StrVec               *paths_) const
+                                   Branch::CPtrVec      *paths_) const
 {
   return ::newest::create(branches_,fusepath_,paths_);
 }
@@ -170,7 +170,15 @@ Policy::Newest::Create::operator()(const Branches::CPtr &branches_,
 int
 Policy::Newest::Search::operator()(const Branches::CPtr &branches_,
                                    const char           *fusepath_,
-                                   StrVec               *paths_) const
+                                   Branch::CPtrVec      *paths_) const
 {
   return ::newest::search(branches_,fusepath_,paths_);
 }
+
+int
+Policy::Newest::Search::concurrent(const Branches::CPtr &branches_,
+                                   const char           *fusepath_,
+                                   Branch::CPtrVec      *paths_) const
+{
+  return Policy::Concurrent::newest(branches_,fusepath_,paths_);
+}
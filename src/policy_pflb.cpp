@@ -0,0 +1,123 @@
+/*
+  ISC License
+
+  Copyright (c) 2024, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include "errno.hpp"
+#include "fs_info.hpp"
+#include "policies.hpp"
+#include "policy.hpp"
+#include "policy_error.hpp"
+#include "policy_pflb.hpp"
+#include "policy_pfrd.hpp"
+#include "strvec.hpp"
+
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+using Policy::PFRD::BranchInfo;
+using Policy::PFRD::BranchInfoVec;
+
+namespace pflb
+{
+  /*
+    Like pfrd a branch's weight is its available space but divided by
+    1 + its current write load. A branch already taking writes is
+    less likely to be picked than an idle one with similar space.
+  */
+  static
+  int
+  get_branchinfo(const Branches::CPtr &branches_,
+                 BranchInfoVec        *branchinfo_,
+                 uint64_t             *sum_)
+  {
+    int rv;
+    int error;
+    BranchInfo bi;
+    fs::info_t info;
+
+    *sum_ = 0;
+    error = ENOENT;
+    for(auto &branch : *branches_)
+      {
+        if(branch.ro_or_nc())
+          error_and_continue(error,EROFS);
+        rv = fs::info(branch,&info);
+        if(rv == -1)
+          error_and_continue(error,ENOENT);
+        if(info.readonly)
+          error_and_continue(error,EROFS);
+        if(info.spaceavail < branch.minfreespace())
+          error_and_continue(error,ENOSPC);
+
+        bi.weight   = (info.spaceavail / (1 + branch.stats->load()));
+        bi.branch   = &branch;
+        branchinfo_->push_back(bi);
+
+        *sum_ += bi.weight;
+      }
+
+    return error;
+  }
+
+  static
+  int
+  create(const Branches::CPtr &branches_,
+         const char           *fusepath_,
+         Branch::CPtrVec      *paths_)
+  {
+    int error;
+    uint64_t sum;
+    const Branch *obranch;
+    BranchInfoVec branchinfo;
+
+    error    = pflb::get_branchinfo(branches_,&branchinfo,&sum);
+    obranch  = Policy::PFRD::get_branch(branchinfo,sum);
+    if(obranch == NULL)
+      return (errno=error,-1);
+
+    paths_->push_back(obranch);
+
+    return 0;
+  }
+}
+
+int
+Policy::PFLB::Action::operator()(const Branches::CPtr &branches_,
+                                 const char           *fusepath_,
+                                 Branch::CPtrVec      *paths_) const
+{
+  return Policies::Action::eppfrd(branches_,fusepath_,paths_);
+}
+
+int
+Policy::PFLB::Create::operator()(const Branches::CPtr &branches_,
+                                 const char           *fusepath_,
+                                 Branch::CPtrVec      *paths_) const
+{
+  return ::pflb::create(branches_,fusepath_,paths_);
+}
+
+int
+Policy::PFLB::Search::operator()(const Branches::CPtr &branches_,
+                                 const char           *fusepath_,
+                                 Branch::CPtrVec      *paths_) const
+{
+  return Policies::Search::eppfrd(branches_,fusepath_,paths_);
+}
@@ -30,13 +30,8 @@
 using std::string;
 using std::vector;
 
-struct BranchInfo
-{
-  uint64_t      spaceavail;
-  const string *basepath;
-};
-
-typedef vector<BranchInfo> BranchInfoVec;
+using Policy::PFRD::BranchInfo;
+using Policy::PFRD::BranchInfoVec;
 
 namespace pfrd
 {
@@ -57,7 +52,7 @@ namespace pfrd
       {
         if(branch.ro_or_nc())
           error_and_continue(error,EROFS);
-        rv = fs::info(branch.path,&info);
+        rv = fs::info(branch,&info);
         if(rv == -1)
           error_and_continue(error,ENOENT);
         if(info.readonly)
@@ -67,67 +62,66 @@ namespace pfrd
 
         *sum_ += info.spaceavail;
 
-        bi.spaceavail = info.spaceavail;
-        bi.basepath   = &branch.path;
+        bi.weight = info.spaceavail;
+        bi.branch = &branch;
         branchinfo_->push_back(bi);
       }
 
     return error;
   }
 
-  static
-  const
-  string*
-  get_branch(const BranchInfoVec &branchinfo_,
-             const uint64_t       sum_)
-  {
-    uint64_t idx;
-    uint64_t threshold;
-
-    if(sum_ == 0)
-      return NULL;
-
-    idx = 0;
-    threshold = RND::rand64(sum_);
-    for(size_t i = 0; i < branchinfo_.size(); i++)
-      {
-        idx += branchinfo_[i].spaceavail;
-
-        if(idx < threshold)
-          continue;
-
-        return branchinfo_[i].basepath;
-      }
-
-    return NULL;
-  }
-
   static
   int
   create(const Branches::CPtr &branches_,
          const char           *fusepath_,
-         StrVec               *paths_)
+         Branch::CPtrVec      *paths_)
   {
     int error;
     uint64_t sum;
-    const string *basepath;
+    const Branch *obranch;
     BranchInfoVec branchinfo;
 
     error    = pfrd::get_branchinfo(branches_,&branchinfo,&sum);
-    basepath = pfrd::get_branch(branchinfo,sum);
-    if(basepath == NULL)
+    obranch  = Policy::PFRD::get_branch(branchinfo,sum);
+    if(obranch == NULL)
       return (errno=error,-1);
 
-    paths_->push_back(*basepath);
+    paths_->push_back(obranch);
 
     return 0;
   }
 }
 
+const
+Branch*
+Policy::PFRD::get_branch(const BranchInfoVec &branchinfo_,
+                         const uint64_t       sum_)
+{
+  uint64_t idx;
+  uint64_t threshold;
+
+  if(sum_ == 0)
+    return NULL;
+
+  idx = 0;
+  threshold = RND::rand64(sum_);
+  for(size_t i = 0; i < branchinfo_.size(); i++)
+    {
+      idx += branchinfo_[i].weight;
+
+      if(idx < threshold)
+        continue;
+
+      return branchinfo_[i].branch;
+    }
+
+  return NULL;
+}
+
 int
 Policy::PFRD::Action::operator()(const Branches::CPtr &branches_,
                                  const char           *fusepath_,
-                                 StrVec               *paths_) const
+                                 Branch::CPtrVec      *paths_) const
 {
   return Policies::Action::eppfrd(branches_,fusepath_,paths_);
 }
@@ -135,7 +129,7 @@ Policy::PFRD::Action::operator()(const Branches::CPtr &branches_,
 int
 Policy::PFRD::Create::operator()(const Branches::CPtr &branches_,
                                  const char           *fusepath_,
-                                 StrVec               *paths_) const
+                                 Branch::CPtrVec      *paths_) const
 {
   return ::pfrd::create(branches_,fusepath_,paths_);
 }
@@ -143,7 +137,7 @@ Policy::PFRD::Create::operator()(const Branches::CPtr &branches_,
 int
 Policy::PFRD::Search::operator()(const Branches::CPtr &branches_,
                                  const char           *fusepath_,
-                                 StrVec               *paths_) const
+                                 Branch::CPtrVec      *paths_) const
 {
   return Policies::Search::eppfrd(branches_,fusepath_,paths_);
 }
@@ -20,10 +20,25 @@
 
 #include "policy.hpp"
 
+#include <cstdint>
+#include <vector>
+
 namespace Policy
 {
   namespace PFRD
   {
+    struct BranchInfo
+    {
+      uint64_t      weight;
+      const Branch *branch;
+    };
+
+    typedef std::vector<BranchInfo> BranchInfoVec;
+
+    // Picks a branch at random with probability weight / sum
+    const Branch* get_branch(const BranchInfoVec &branchinfo,
+                             const uint64_t       sum);
+
     class Action final : public Policy::ActionImpl
     {
     public:
@@ -32,7 +47,7 @@ namespace Policy
       {}
 
     public:
-      int operator()(const Branches::CPtr&,const char*,StrVec*) const final;
+      int operator()(const Branches::CPtr&,const char*,Branch::CPtrVec*) const final;
     };
 
     class Create final : public Policy::CreateImpl
@@ -43,7 +58,7 @@ namespace Policy
       {}
 
     public:
-      int operator()(const Branches::CPtr&,const char*,StrVec*) const final;
+      int operator()(const Branches::CPtr&,const char*,Branch::CPtrVec*) const final;
       bool path_preserving() const final { return false; }
     };
 
@@ -55,7 +70,7 @@ namespace Policy
       {}
 
     public:
-      int operator()(const Branches::CPtr&,const char*,StrVec*) const final;
+      int operator()(const Branches::CPtr&,const char*,Branch::CPtrVec*) const final;
     };
   }
 }
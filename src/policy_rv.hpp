@@ -18,34 +18,35 @@
 
 #pragma once
 
-#include <string>
+#include "branch.hpp"
+
 #include <vector>
 
 struct PolicyRV
 {
   struct RV
   {
-    RV(const int          rv_,
-       const std::string &basepath_)
+    RV(const int     rv_,
+       const Branch *branch_)
       : rv(rv_),
-        basepath(basepath_)
+        branch(branch_)
     {
     }
 
-    int         rv;
-    std::string basepath;
+    int           rv;
+    const Branch *branch;
   };
 
   std::vector<RV> success;
   std::vector<RV> error;
 
   void
-  insert(const int          err_,
-         const std::string &basepath_)
+  insert(const int     err_,
+         const Branch *branch_)
   {
     if(err_ == 0)
-      success.push_back(RV(err_,basepath_));
+      success.push_back(RV(err_,branch_));
     else
-      error.push_back(RV(-err_,basepath_));
+      error.push_back(RV(-err_,branch_));
   }
 };
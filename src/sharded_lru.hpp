@@ -0,0 +1,277 @@
+/*
+  ISC License
+
+  Copyright (c) 2024, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <string>
+#include <unordered_map>
+
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+
+
+/*
+  The storage shared by the path keyed caches. Entries are spread
+  over N shards by hash of the path, each with its own lock and LRU
+  list. Every erase bumps its shard's generation. A caller which
+  missed is handed the generation and passes it back to `insert`, so
+  a result computed while the path was being changed is dropped
+  rather than stored. What makes an entry a hit beyond its age is up
+  to the caller.
+*/
+template<typename V, std::size_t N>
+class ShardedLRU
+{
+private:
+  typedef std::list<const std::string*> LRU;
+
+  struct Entry
+  {
+    uint64_t      time;
+    V             value;
+    LRU::iterator lru;
+  };
+
+  typedef std::unordered_map<std::string,Entry> Map;
+
+  struct Shard
+  {
+    Shard()
+      : gen(0)
+    {
+      pthread_mutex_init(&lock,NULL);
+    }
+
+    pthread_mutex_t lock;
+    uint64_t        gen;
+    Map             cache;
+    LRU             lru;
+  };
+
+public:
+  ShardedLRU()
+    : _hits(0),
+      _misses(0),
+      _evictions(0)
+  {
+  }
+
+public:
+  // milliseconds
+  static
+  uint64_t
+  now(void)
+  {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+
+    return ((ts.tv_sec * 1000) + (ts.tv_nsec / 1000000));
+  }
+
+public:
+  /*
+    Calls `hit_` with the value of an entry younger than `timeout_`.
+    If it returns true the entry is marked most recently used and
+    true is returned. Otherwise `gen_` is set for `insert`.
+  */
+  template<typename F>
+  bool
+  lookup(const std::string &key_,
+         const uint64_t     now_,
+         const uint64_t     timeout_,
+         uint64_t          *gen_,
+         F                  hit_)
+  {
+    Shard &shard = _shard(key_);
+
+    pthread_mutex_lock(&shard.lock);
+
+    auto i = shard.cache.find(key_);
+    if((i != shard.cache.end()) &&
+       ((now_ - i->second.time) < timeout_) &&
+       hit_(i->second.value))
+      {
+        shard.lru.splice(shard.lru.begin(),shard.lru,i->second.lru);
+
+        pthread_mutex_unlock(&shard.lock);
+
+        _hits++;
+        return true;
+      }
+
+    *gen_ = shard.gen;
+
+    pthread_mutex_unlock(&shard.lock);
+
+    _misses++;
+
+    return false;
+  }
+
+  /*
+    Stores the value unless the shard was erased from since `gen_`
+    was handed out then evicts the least recently used entries past
+    the shard's share of `max_`.
+  */
+  void
+  insert(const std::string &key_,
+         const uint64_t     gen_,
+         const uint64_t     time_,
+         const V           &value_,
+         const uint64_t     max_)
+  {
+    uint64_t max;
+    Shard &shard = _shard(key_);
+
+    max = ((max_ / N) + 1);
+
+    pthread_mutex_lock(&shard.lock);
+
+    if(shard.gen != gen_)
+      {
+        pthread_mutex_unlock(&shard.lock);
+        return;
+      }
+
+    auto rv = shard.cache.emplace(key_,Entry());
+    if(rv.second)
+      {
+        shard.lru.push_front(&rv.first->first);
+        rv.first->second.lru = shard.lru.begin();
+      }
+    else
+      {
+        shard.lru.splice(shard.lru.begin(),shard.lru,rv.first->second.lru);
+      }
+    rv.first->second.time  = time_;
+    rv.first->second.value = value_;
+
+    while(shard.cache.size() > max)
+      {
+        _erase(shard,shard.cache.find(*shard.lru.back()));
+        _evictions++;
+      }
+
+    pthread_mutex_unlock(&shard.lock);
+  }
+
+  void
+  erase(const std::string &key_)
+  {
+    Shard &shard = _shard(key_);
+
+    pthread_mutex_lock(&shard.lock);
+
+    shard.gen++;
+    auto i = shard.cache.find(key_);
+    if(i != shard.cache.end())
+      _erase(shard,i);
+
+    pthread_mutex_unlock(&shard.lock);
+  }
+
+  /*
+    Erases everything under `path_` but not `path_` itself. Walks
+    every entry.
+  */
+  void
+  erase_children(const char *path_)
+  {
+    size_t len;
+
+    len = strlen(path_);
+    for(auto &shard : _shards)
+      {
+        pthread_mutex_lock(&shard.lock);
+
+        shard.gen++;
+        auto i = shard.cache.begin();
+        while(i != shard.cache.end())
+          {
+            auto next = std::next(i);
+
+            if(ShardedLRU::is_child(i->first,path_,len))
+              _erase(shard,i);
+
+            i = next;
+          }
+
+        pthread_mutex_unlock(&shard.lock);
+      }
+  }
+
+  void
+  clear(void)
+  {
+    for(auto &shard : _shards)
+      {
+        pthread_mutex_lock(&shard.lock);
+
+        shard.gen++;
+        shard.cache.clear();
+        shard.lru.clear();
+
+        pthread_mutex_unlock(&shard.lock);
+      }
+  }
+
+public:
+  uint64_t hits(void) const      { return _hits; }
+  uint64_t misses(void) const    { return _misses; }
+  uint64_t evictions(void) const { return _evictions; }
+
+private:
+  static
+  bool
+  is_child(const std::string &path_,
+           const char        *parent_,
+           const size_t       parentlen_)
+  {
+    return ((path_.size() > parentlen_) &&
+            (path_[parentlen_] == '/') &&
+            (memcmp(path_.data(),parent_,parentlen_) == 0));
+  }
+
+  Shard&
+  _shard(const std::string &key_)
+  {
+    return _shards[std::hash<std::string>()(key_) % N];
+  }
+
+  static
+  void
+  _erase(Shard                   &shard_,
+         typename Map::iterator   i_)
+  {
+    shard_.lru.erase(i_->second.lru);
+    shard_.cache.erase(i_);
+  }
+
+private:
+  Shard                 _shards[N];
+  std::atomic<uint64_t> _hits;
+  std::atomic<uint64_t> _misses;
+  std::atomic<uint64_t> _evictions;
+};
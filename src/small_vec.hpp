@@ -0,0 +1,111 @@
+/*
+  ISC License
+
+  Copyright (c) 2024, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+
+/*
+  A vector which keeps its first N elements inline and only moves
+  them to the heap when it grows beyond that. For short lists built
+  on every request, such as a policy's branches, so they don't cost
+  an allocation. Only the parts of std::vector's interface that are
+  needed. T must be trivially copyable.
+*/
+template<typename T, std::size_t N>
+class SmallVec
+{
+public:
+  typedef T*       iterator;
+  typedef const T* const_iterator;
+
+public:
+  SmallVec()
+    : _size(0)
+  {
+  }
+
+public:
+  std::size_t size(void) const { return _size; }
+  bool        empty(void) const { return (_size == 0); }
+
+  T*       data(void)       { return ((_size > N) ? _heap.data() : _inline); }
+  const T* data(void) const { return ((_size > N) ? _heap.data() : _inline); }
+
+  iterator       begin(void)       { return data(); }
+  iterator       end(void)         { return (data() + _size); }
+  const_iterator begin(void) const { return data(); }
+  const_iterator end(void)   const { return (data() + _size); }
+
+  T&       operator[](const std::size_t i_)       { return data()[i_]; }
+  const T& operator[](const std::size_t i_) const { return data()[i_]; }
+
+public:
+  void
+  push_back(const T &v_)
+  {
+    if(_size < N)
+      {
+        _inline[_size++] = v_;
+        return;
+      }
+
+    if(_size == N)
+      _heap.assign(_inline,_inline + N);
+    _heap.push_back(v_);
+    _size++;
+  }
+
+  void
+  resize(const std::size_t size_)
+  {
+    if(size_ <= N)
+      {
+        if(_size > N)
+          {
+            for(std::size_t i = 0; i < size_; i++)
+              _inline[i] = _heap[i];
+            _heap.clear();
+          }
+        for(std::size_t i = _size; i < size_; i++)
+          _inline[i] = T();
+      }
+    else
+      {
+        if(_size <= N)
+          _heap.assign(_inline,_inline + _size);
+        _heap.resize(size_);
+      }
+
+    _size = size_;
+  }
+
+  void
+  clear(void)
+  {
+    _heap.clear();
+    _size = 0;
+  }
+
+private:
+  std::size_t    _size;
+  T              _inline[N];
+  std::vector<T> _heap;
+};
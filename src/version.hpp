@@ -0,0 +1,2 @@
+#pragma once
+static const char MERGERFS_VERSION[] = "58c3c4a-dirty";
@@ -1,6 +1,19 @@
 #include "acutest.h"
 
+#include "attr_cache.hpp"
 #include "config.hpp"
+#include "epoch.hpp"
+#include "fs_inode.hpp"
+#include "fs_pathbuf.hpp"
+#include "fuse_dirents.h"
+#include "policy_cache.hpp"
+#include "small_vec.hpp"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include <unistd.h>
 
 void
 test_nop()
@@ -93,7 +106,7 @@ test_config_branches()
   TEST_CHECK(b.from_string("/foo/bar") == 0);
   TEST_CHECK(b.to_string() == "/foo/bar=RW");
   bcp1 = b;
-  TEST_CHECK(bcp0.get() != bcp1.get());
+  TEST_CHECK(bcp0 != bcp1);
 
   TEST_CHECK(b.from_string("/foo/bar=RW,1234") == 0);
   TEST_CHECK(b.to_string() == "/foo/bar=RW,1234");
@@ -136,6 +149,43 @@ test_config_cachefiles()
   TEST_CHECK(cf.from_string("foobar") == -EINVAL);
 }
 
+void
+test_config_fuse_loop()
+{
+  FuseLoop l;
+
+  TEST_CHECK(l.from_string("threads") == 0);
+  TEST_CHECK(l.to_string() == "threads");
+  TEST_CHECK(l == FuseLoop::ENUM::THREADS);
+
+  TEST_CHECK(l.from_string("io_uring") == 0);
+  TEST_CHECK(l.to_string() == "io_uring");
+  TEST_CHECK(l == FuseLoop::ENUM::IO_URING);
+
+  TEST_CHECK(l.from_string("blah") == -EINVAL);
+}
+
+void
+test_config_func_search()
+{
+  Func::GetAttr f;
+
+  TEST_CHECK(f.to_string() == "ff");
+  TEST_CHECK(f.policy.concurrent == false);
+
+  TEST_CHECK(f.from_string("newest:concurrent") == 0);
+  TEST_CHECK(f.to_string() == "newest:concurrent");
+  TEST_CHECK(f.policy.concurrent == true);
+
+  TEST_CHECK(f.from_string("epff") == 0);
+  TEST_CHECK(f.to_string() == "epff");
+  TEST_CHECK(f.policy.concurrent == false);
+
+  TEST_CHECK(f.from_string("ff:blah") == -EINVAL);
+  TEST_CHECK(f.from_string("blah:concurrent") == -EINVAL);
+  TEST_CHECK(f.to_string() == "epff");
+}
+
 void
 test_config_inodecalc()
 {
@@ -191,18 +241,49 @@ test_config_nfsopenhack()
   TEST_CHECK(n == NFSOpenHack::ENUM::ALL);
 }
 
+void
+test_config_passthrough()
+{
+  Passthrough p;
+
+  TEST_CHECK(p.from_string("off") == 0);
+  TEST_CHECK(p.to_string() == "off");
+  TEST_CHECK(p == Passthrough::ENUM::OFF);
+
+  TEST_CHECK(p.from_string("ro") == 0);
+  TEST_CHECK(p.to_string() == "ro");
+  TEST_CHECK(p == Passthrough::ENUM::RO);
+
+  TEST_CHECK(p.from_string("wo") == 0);
+  TEST_CHECK(p.to_string() == "wo");
+  TEST_CHECK(p == Passthrough::ENUM::WO);
+
+  TEST_CHECK(p.from_string("rw") == 0);
+  TEST_CHECK(p.to_string() == "rw");
+  TEST_CHECK(p == Passthrough::ENUM::RW);
+
+  TEST_CHECK(p.from_string("blah") == -EINVAL);
+}
+
 void
 test_config_readdir()
 {
-  ReadDir r;
+  FUSE::ReadDir r("seq");
+
+  TEST_CHECK(r.to_string() == "seq");
+
+  TEST_CHECK(r.from_string("cosr") == 0);
+  TEST_CHECK(r.to_string() == "cosr");
 
-  TEST_CHECK(r.from_string("linux") == 0);
-  TEST_CHECK(r.to_string() == "linux");
-  TEST_CHECK(r == ReadDir::ENUM::LINUX);
+  TEST_CHECK(r.from_string("cor:4:2") == 0);
+  TEST_CHECK(r.to_string() == "cor:4:2");
 
-  TEST_CHECK(r.from_string("posix") == 0);
-  TEST_CHECK(r.to_string() == "posix");
-  TEST_CHECK(r == ReadDir::ENUM::POSIX);
+  TEST_CHECK(r.from_string("stream") == 0);
+  TEST_CHECK(r.from_string("plus:4") == 0);
+
+  TEST_CHECK(r.from_string("linux") == -EINVAL);
+  TEST_CHECK(r.from_string("posix") == -EINVAL);
+  TEST_CHECK(r.to_string() == "plus:4");
 }
 
 void
@@ -261,12 +342,498 @@ test_config_xattr()
   TEST_CHECK(x.from_string("asdf") == -EINVAL);
 }
 
+class TestSearch : public Policy::SearchImpl
+{
+public:
+  TestSearch()
+    : Policy::SearchImpl("test"),
+      error(0),
+      calls(0),
+      cache(NULL)
+  {
+  }
+
+public:
+  int
+  operator()(const Branches::CPtr &branches_,
+             const char           *fusepath_,
+             Branch::CPtrVec      *paths_) const
+  {
+    calls++;
+    if(cache)
+      cache->erase(fusepath_);
+    if(error)
+      return (errno=error,-1);
+
+    paths_->push_back(&(*branches_)[0]);
+
+    return 0;
+  }
+
+public:
+  int                  error;
+  mutable int          calls;
+  PolicyCache         *cache;
+};
+
+void
+test_policy_cache()
+{
+  int rv;
+  uint64_t minfreespace;
+  Branches branches(minfreespace);
+  Branches::CPtr bcp;
+  TestSearch impl;
+  Policy::Search search(&impl);
+  Branch::CPtrVec paths;
+  PolicyCache cache;
+
+  minfreespace = 0;
+  TEST_CHECK(branches.from_string("/tmp") == 0);
+  bcp = branches;
+  cache.timeout = 60000;
+
+  // hits skip the policy and return the same branches
+  TEST_CHECK(cache(search,bcp,"/a",&paths) == 0);
+  TEST_CHECK(cache(search,bcp,"/a",&paths) == 0);
+  TEST_CHECK(impl.calls == 1);
+  TEST_CHECK(paths.size() == 2);
+  TEST_CHECK((paths[0] == &(*bcp)[0]) && (paths[1] == &(*bcp)[0]));
+  TEST_CHECK(cache.hits() == 1);
+
+  cache.erase("/a");
+  paths.clear();
+  TEST_CHECK(cache(search,bcp,"/a",&paths) == 0);
+  TEST_CHECK(impl.calls == 2);
+
+  // erase_tree drops children but not siblings sharing a prefix
+  TEST_CHECK(cache(search,bcp,"/a/b",&paths) == 0);
+  TEST_CHECK(cache(search,bcp,"/ab",&paths) == 0);
+  impl.calls = 0;
+  cache.erase_tree("/a");
+  TEST_CHECK(cache(search,bcp,"/a/b",&paths) == 0);
+  TEST_CHECK(cache(search,bcp,"/ab",&paths) == 0);
+  TEST_CHECK(impl.calls == 1);
+
+  // ENOENT confirmed on every branch is cached
+  impl.calls = 0;
+  impl.error = ENOENT;
+  rv = cache(search,bcp,"/mergerfs-tests-does-not-exist",&paths);
+  TEST_CHECK((rv == -1) && (errno == ENOENT));
+  rv = cache(search,bcp,"/mergerfs-tests-does-not-exist",&paths);
+  TEST_CHECK((rv == -1) && (errno == ENOENT));
+  TEST_CHECK(impl.calls == 1);
+
+  // but not when the path is there, as with EACCES reported as ENOENT
+  impl.calls = 0;
+  TEST_CHECK(cache(search,bcp,"/",&paths) == -1);
+  TEST_CHECK(cache(search,bcp,"/",&paths) == -1);
+  TEST_CHECK(impl.calls == 2);
+
+  // other errors are never cached
+  impl.calls = 0;
+  impl.error = EIO;
+  TEST_CHECK(cache(search,bcp,"/eio",&paths) == -1);
+  TEST_CHECK(cache(search,bcp,"/eio",&paths) == -1);
+  TEST_CHECK(impl.calls == 2);
+  impl.error = 0;
+
+  // a result raced by an erase of its shard isn't inserted
+  impl.calls = 0;
+  impl.cache = &cache;
+  TEST_CHECK(cache(search,bcp,"/raced",&paths) == 0);
+  impl.cache = NULL;
+  TEST_CHECK(cache(search,bcp,"/raced",&paths) == 0);
+  TEST_CHECK(impl.calls == 2);
+
+  // a different Branches instance misses
+  impl.calls = 0;
+  TEST_CHECK(branches.from_string("/tmp") == 0);
+  TEST_CHECK(cache(search,branches,"/raced",&paths) == 0);
+  TEST_CHECK(impl.calls == 1);
+  bcp = branches;
+
+  // shards evict the least recently used once past their share
+  cache.clear();
+  cache.max = POLICY_CACHE_SHARDS;
+  for(int i = 0; i < 256; i++)
+    TEST_CHECK(cache(search,bcp,("/lru" + std::to_string(i)).c_str(),&paths) == 0);
+  TEST_CHECK(cache.evictions() >= (256 - (2 * POLICY_CACHE_SHARDS)));
+  impl.calls = 0;
+  TEST_CHECK(cache(search,bcp,"/lru255",&paths) == 0);
+  TEST_CHECK(impl.calls == 0);
+  TEST_CHECK(cache(search,bcp,"/lru0",&paths) == 0);
+  TEST_CHECK(impl.calls == 1);
+
+  // a timeout of 0 bypasses the cache
+  cache.timeout = 0;
+  impl.calls = 0;
+  TEST_CHECK(cache(search,bcp,"/lru255",&paths) == 0);
+  TEST_CHECK(impl.calls == 1);
+}
+
+void
+test_attr_cache()
+{
+  int error;
+  uint64_t gen;
+  struct stat st = {};
+  struct stat out;
+  AttrCache cache;
+
+  cache.timeout = 60000;
+  st.st_mode  = S_IFREG;
+  st.st_nlink = 1;
+  st.st_size  = 42;
+
+  // misses hand out the generation for insert
+  TEST_CHECK(!cache.lookup("/d/f",1,0,0,&out,&error,&gen));
+  cache.insert("/d/f",gen,1,0,0,0,&st);
+  TEST_CHECK(cache.lookup("/d/f",1,0,0,&out,&error,&gen));
+  TEST_CHECK((error == 0) && (out.st_size == 42));
+  TEST_CHECK(cache.hits() == 1);
+
+  // entries from another Branches instance or caller miss
+  TEST_CHECK(!cache.lookup("/d/f",2,0,0,&out,&error,&gen));
+  TEST_CHECK(!cache.lookup("/d/f",1,1000,0,&out,&error,&gen));
+  TEST_CHECK(!cache.lookup("/d/f",1,0,1000,&out,&error,&gen));
+
+  // negatives are cached
+  TEST_CHECK(!cache.lookup("/d/missing",1,0,0,&out,&error,&gen));
+  cache.insert("/d/missing",gen,1,0,0,ENOENT,NULL);
+  TEST_CHECK(cache.lookup("/d/missing",1,0,0,&out,&error,&gen));
+  TEST_CHECK(error == ENOENT);
+
+  // an erase while the branches were checked drops the insert
+  TEST_CHECK(!cache.lookup("/d/g",1,0,0,&out,&error,&gen));
+  cache.erase("/d/g");
+  cache.insert("/d/g",gen,1,0,0,0,&st);
+  TEST_CHECK(!cache.lookup("/d/g",1,0,0,&out,&error,&gen));
+
+  // erase_entry takes the parent with it
+  TEST_CHECK(!cache.lookup("/d",1,0,0,&out,&error,&gen));
+  st.st_mode = S_IFDIR;
+  st.st_nlink = 2;
+  cache.insert("/d",gen,1,0,0,0,&st);
+  TEST_CHECK(cache.lookup("/d",1,0,0,&out,&error,&gen));
+  cache.erase_entry("/d/missing");
+  TEST_CHECK(!cache.lookup("/d/missing",1,0,0,&out,&error,&gen));
+  TEST_CHECK(!cache.lookup("/d",1,0,0,&out,&error,&gen));
+
+  // erase_tree takes children but not siblings sharing a prefix
+  cache.insert("/d",gen,1,0,0,0,&st);
+  TEST_CHECK(!cache.lookup("/dd",1,0,0,&out,&error,&gen));
+  cache.insert("/dd",gen,1,0,0,0,&st);
+  cache.erase_tree("/d");
+  TEST_CHECK(!cache.lookup("/d/f",1,0,0,&out,&error,&gen));
+  TEST_CHECK(cache.lookup("/dd",1,0,0,&out,&error,&gen));
+
+  // files with other links aren't cached, directories are
+  st.st_mode  = S_IFREG;
+  st.st_nlink = 2;
+  TEST_CHECK(!cache.lookup("/linked",1,0,0,&out,&error,&gen));
+  cache.insert("/linked",gen,1,0,0,0,&st);
+  TEST_CHECK(!cache.lookup("/linked",1,0,0,&out,&error,&gen));
+
+  // shards evict the least recently used once past their share
+  cache.clear();
+  cache.max   = ATTR_CACHE_SHARDS;
+  st.st_nlink = 1;
+  for(int i = 0; i < 256; i++)
+    {
+      std::string path("/lru" + std::to_string(i));
+
+      TEST_CHECK(!cache.lookup(path.c_str(),1,0,0,&out,&error,&gen));
+      cache.insert(path.c_str(),gen,1,0,0,0,&st);
+    }
+  TEST_CHECK(cache.evictions() >= (256 - (2 * ATTR_CACHE_SHARDS)));
+  TEST_CHECK(cache.lookup("/lru255",1,0,0,&out,&error,&gen));
+  TEST_CHECK(!cache.lookup("/lru0",1,0,0,&out,&error,&gen));
+
+  // expired entries miss
+  cache.timeout = 1;
+  usleep(5000);
+  TEST_CHECK(!cache.lookup("/lru255",1,0,0,&out,&error,&gen));
+}
+
+void
+test_epoch()
+{
+  std::weak_ptr<int> w;
+
+  // nothing to wait for outside of a Guard
+  {
+    auto p = std::make_shared<int>(1);
+    w = p;
+    epoch::retire(std::move(p));
+    TEST_CHECK(w.expired());
+  }
+
+  // held until the outermost Guard it was retired in is left
+  {
+    epoch::Guard g0;
+    {
+      epoch::Guard g1;
+      auto p = std::make_shared<int>(2);
+      w = p;
+      epoch::retire(std::move(p));
+    }
+    epoch::reclaim();
+    TEST_CHECK(!w.expired());
+  }
+  epoch::reclaim();
+  TEST_CHECK(w.expired());
+
+  // held for a Guard on another thread entered before the retire
+  // but not one entered after
+  bool entered = false;
+  bool release = false;
+  std::mutex m;
+  std::condition_variable cv;
+  std::thread t([&]()
+  {
+    epoch::Guard g;
+    std::unique_lock<std::mutex> lk(m);
+    entered = true;
+    cv.notify_all();
+    cv.wait(lk,[&]{ return release; });
+  });
+
+  {
+    std::unique_lock<std::mutex> lk(m);
+    cv.wait(lk,[&]{ return entered; });
+  }
+
+  auto p = std::make_shared<int>(3);
+  w = p;
+  epoch::retire(std::move(p));
+  epoch::reclaim();
+  TEST_CHECK(!w.expired());
+
+  {
+    std::lock_guard<std::mutex> lk(m);
+    release = true;
+  }
+  cv.notify_all();
+  t.join();
+
+  epoch::Guard g;
+  epoch::reclaim();
+  TEST_CHECK(w.expired());
+}
+
+void
+test_small_vec()
+{
+  SmallVec<int,2> v;
+
+  TEST_CHECK(v.empty());
+
+  // stays inline up to N
+  v.push_back(1);
+  v.push_back(2);
+  TEST_CHECK(v.size() == 2);
+  TEST_CHECK((v[0] == 1) && (v[1] == 2));
+  TEST_CHECK(v.data() == &v[0]);
+
+  // moves to the heap past N keeping what was inline
+  v.push_back(3);
+  v.push_back(4);
+  TEST_CHECK(v.size() == 4);
+  TEST_CHECK((v[0] == 1) && (v[1] == 2) && (v[2] == 3) && (v[3] == 4));
+  TEST_CHECK((v.end() - v.begin()) == 4);
+
+  // shrinking back to N moves to inline storage
+  v.resize(1);
+  TEST_CHECK((v.size() == 1) && (v[0] == 1));
+  v.push_back(5);
+  TEST_CHECK((v[0] == 1) && (v[1] == 5));
+
+  // growing by resize keeps elements and value initializes the rest
+  v.resize(3);
+  TEST_CHECK((v[0] == 1) && (v[1] == 5) && (v[2] == 0));
+  v.resize(2);
+  v.resize(2);
+  TEST_CHECK((v[0] == 1) && (v[1] == 5));
+
+  v.clear();
+  TEST_CHECK(v.empty() && (v.begin() == v.end()));
+  for(int i = 0; i < 10; i++)
+    v.push_back(i);
+  for(int i = 0; i < 10; i++)
+    TEST_CHECK(v[i] == i);
+}
+
+void
+test_pathbuf()
+{
+  const std::string base("/mnt/branch");
+
+  // joins without adding a separator like fs::path::make(string,string)
+  TEST_CHECK(strcmp(fs::PathBuf("/mnt/branch","/a/b"),"/mnt/branch/a/b") == 0);
+  TEST_CHECK(fs::PathBuf(base,"/a").str() == "/mnt/branch/a");
+  TEST_CHECK(fs::PathBuf(base,std::string("/a")).str() == "/mnt/branch/a");
+  TEST_CHECK(fs::PathBuf(base,"").str() == base);
+
+  // exactly fills the stack buffer
+  std::string fits(PATH_MAX - base.size() - 1,'f');
+  fs::PathBuf pbfits(base,fits);
+  TEST_CHECK(pbfits.str() == (base + fits));
+  TEST_CHECK(strlen(pbfits.c_str()) == (PATH_MAX - 1));
+
+  // one more byte and longer overflow to the heap intact
+  std::string over(PATH_MAX - base.size(),'o');
+  TEST_CHECK(fs::PathBuf(base,over).str() == (base + over));
+  std::string huge(PATH_MAX * 3,'h');
+  TEST_CHECK(fs::PathBuf(base,huge).str() == (base + huge));
+}
+
+static
+void
+dirents_fill(fuse_dirents_t *d_,
+             const int       count_)
+{
+  struct dirent de = {};
+
+  for(int i = 0; i < count_; i++)
+    {
+      de.d_ino  = (i + 1);
+      de.d_type = DT_REG;
+      snprintf(de.d_name,sizeof(de.d_name),"entry-%d",i);
+      TEST_CHECK(fuse_dirents_add(d_,&de,strlen(de.d_name)) == 0);
+    }
+}
+
+static
+bool
+dirents_check(fuse_dirents_t *d_,
+              const int       count_)
+{
+  char name[64];
+  fuse_dirent_t *de;
+
+  if(kv_size(d_->offs) != (size_t)(count_ + 1))
+    return false;
+
+  for(int i = 0; i < count_; i++)
+    {
+      de = (fuse_dirent_t*)fuse_dirents_find(d_,i + 1);
+      snprintf(name,sizeof(name),"entry-%d",i);
+      if((de == NULL) ||
+         (de->namelen != strlen(name)) ||
+         (memcmp(de->name,name,de->namelen) != 0))
+        return false;
+    }
+
+  return true;
+}
+
+void
+test_dirents()
+{
+  const int count = 20000;
+
+  // grows on the heap without a spill size
+  {
+    fuse_dirents_t d;
+
+    fuse_dirents_spill_size(0);
+    TEST_CHECK(fuse_dirents_init(&d) == 0);
+    dirents_fill(&d,count);
+    TEST_CHECK(!d.spilled);
+    TEST_CHECK(dirents_check(&d,count));
+    fuse_dirents_free(&d);
+  }
+
+  // moves to a temp file once past it and keeps growing there
+  {
+    fuse_dirents_t d;
+    fuse_dirents_t copy = {};
+
+    fuse_dirents_spill_size(64 * 1024);
+    TEST_CHECK(fuse_dirents_init(&d) == 0);
+    dirents_fill(&d,100);
+    TEST_CHECK(!d.spilled);
+    fuse_dirents_reset(&d);
+    dirents_fill(&d,count);
+    TEST_CHECK(d.spilled && (d.spill_fd >= 0));
+    TEST_CHECK(kv_max(d.data) > (64 * 1024));
+    TEST_CHECK(dirents_check(&d,count));
+
+    // a zeroed copy is sized to fit and spills as well
+    TEST_CHECK(fuse_dirents_copy(&copy,&d) == 0);
+    TEST_CHECK(copy.spilled);
+    TEST_CHECK(dirents_check(&copy,count));
+
+    // reset keeps the mapping for reuse
+    fuse_dirents_reset(&d);
+    dirents_fill(&d,10);
+    TEST_CHECK(d.spilled);
+    TEST_CHECK(dirents_check(&d,10));
+    TEST_CHECK(dirents_check(&copy,count));
+
+    fuse_dirents_free(&copy);
+    fuse_dirents_free(&d);
+    fuse_dirents_spill_size(0);
+  }
+}
+
+void
+test_inode_path_hash()
+{
+  const char *algos[] =
+    {"passthrough","path-hash","path-hash32","devino-hash",
+     "devino-hash32","hybrid-hash","hybrid-hash32"};
+  const mode_t modes[] = {S_IFREG,S_IFDIR};
+
+  for(const char *algo : algos)
+    {
+      TEST_CHECK(fs::inode::set_algo(algo) == 0);
+      for(uint64_t dirlen = 0; dirlen < 150; dirlen++)
+        {
+          std::string dirname("/");
+          dirname.append(dirlen,'d');
+          fs::inode::PathHash ph(dirname.c_str());
+
+          for(uint64_t namelen = 1; namelen <= 255; namelen += 7)
+            {
+              std::string name(namelen,'n');
+              std::string fullpath(dirname);
+
+              if(fullpath.back() != '/')
+                fullpath += '/';
+              fullpath += name;
+
+              for(mode_t mode : modes)
+                TEST_CHECK(fs::inode::calc(ph,name.c_str(),name.size(),mode,1,2) ==
+                           fs::inode::calc(fullpath,mode,1,2));
+            }
+        }
+    }
+
+  TEST_CHECK(fs::inode::set_algo("hybrid-hash") == 0);
+}
+
 void
 test_config()
 {
   Config cfg;
 
   TEST_CHECK(cfg.set_raw("async_read","true") == 0);
+  TEST_CHECK(cfg.set_raw("lat.hysteresis","50") == 0);
+  TEST_CHECK(cfg.set("branches-latency","") == -EROFS);
+  TEST_CHECK(cfg.set("branches-load","") == -EROFS);
+  TEST_CHECK(cfg.set_raw("category.create","pflb") == 0);
+  TEST_CHECK(cfg.set_raw("category.create","eplat") == 0);
+  TEST_CHECK(cfg.set_raw("func.getattr","lat") == 0);
+  TEST_CHECK(cfg.set_raw("cache.getattr","1000") == 0);
+  TEST_CHECK(cfg.set("cache.getattr-stats","") == -EROFS);
+  TEST_CHECK(cfg.set_raw("cache.dirents","64") == 0);
+  TEST_CHECK(cfg.set("cache.dirents-stats","") == -EROFS);
+  TEST_CHECK(cfg.set_raw("func.readdir","stream") == 0);
+  TEST_CHECK(cfg.set_raw("readdir-spill","64") == 0);
+  TEST_CHECK(cfg.set_raw("func.readdir","plus:4") == 0);
+  TEST_CHECK(cfg.set_raw("func.readdir","plush") == -EINVAL);
 }
 
 TEST_LIST =
@@ -278,13 +845,23 @@ TEST_LIST =
    {"config_str",test_config_str},
    {"config_branches",test_config_branches},
    {"config_cachefiles",test_config_cachefiles},
+   {"config_fuse_loop",test_config_fuse_loop},
+   {"config_func_search",test_config_func_search},
    {"config_inodecalc",test_config_inodecalc},
    {"config_moveonenospc",test_config_moveonenospc},
    {"config_nfsopenhack",test_config_nfsopenhack},
+   {"config_passthrough",test_config_passthrough},
    {"config_readdir",test_config_readdir},
    {"config_statfs",test_config_statfs},
    {"config_statfsignore",test_config_statfs_ignore},
    {"config_xattr",test_config_xattr},
    {"config",test_config},
+   {"inode_path_hash",test_inode_path_hash},
+   {"policy_cache",test_policy_cache},
+   {"attr_cache",test_attr_cache},
+   {"epoch",test_epoch},
+   {"small_vec",test_small_vec},
+   {"pathbuf",test_pathbuf},
+   {"dirents",test_dirents},
    {NULL,NULL}
   };
@@ -0,0 +1,186 @@
+/*
+  ISC License
+
+  Copyright (c) 2024, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+/*
+  Times each inodecalc algorithm over a directory's worth of entry
+  names the way readdir computes them: building each entry's full
+  path and hashing it versus hashing only the name from the parent's
+  precomputed PathHash. Also checks both give the same inodes.
+
+  usage: inodecalc-bench [entries] [dirname...]
+         (default: 100000 entries, "/", a 3 level and a 12 level path)
+*/
+
+#include "fs_inode.hpp"
+#include "fs_path.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+
+#define RUNS 5
+
+namespace l
+{
+  static
+  double
+  now(void)
+  {
+    using namespace std::chrono;
+
+    return duration<double>(steady_clock::now().time_since_epoch()).count();
+  }
+
+  static
+  uint64_t
+  fullpath(const std::string              &dirname_,
+           const std::vector<std::string> &names_)
+  {
+    uint64_t sum;
+    std::string fullpath;
+
+    sum = 0;
+    for(uint64_t i = 0; i < names_.size(); i++)
+      {
+        fullpath = fs::path::make(dirname_.c_str(),names_[i].c_str());
+        sum += fs::inode::calc(fullpath,
+                               ((i & 1) ? S_IFDIR : S_IFREG),
+                               1,
+                               i);
+      }
+
+    return sum;
+  }
+
+  static
+  uint64_t
+  incremental(const std::string              &dirname_,
+              const std::vector<std::string> &names_)
+  {
+    uint64_t sum;
+    fs::inode::PathHash dirhash(dirname_.c_str());
+
+    sum = 0;
+    for(uint64_t i = 0; i < names_.size(); i++)
+      sum += fs::inode::calc(dirhash,
+                             names_[i].c_str(),
+                             names_[i].size(),
+                             ((i & 1) ? S_IFDIR : S_IFREG),
+                             1,
+                             i);
+
+    return sum;
+  }
+
+  template<typename Func>
+  static
+  double
+  time(Func      func_,
+       uint64_t *sum_)
+  {
+    double best;
+
+    best = 0;
+    for(int i = 0; i < RUNS; i++)
+      {
+        double start;
+        double secs;
+
+        start = l::now();
+        *sum_ = func_();
+        secs  = l::now() - start;
+        if((i == 0) || (secs < best))
+          best = secs;
+      }
+
+    return best;
+  }
+
+  static
+  void
+  bench(const std::string              &dirname_,
+        const std::vector<std::string> &names_)
+  {
+    const char *algos[] =
+      {"passthrough","path-hash","path-hash32","devino-hash",
+       "devino-hash32","hybrid-hash","hybrid-hash32"};
+
+    printf("%s (%lu bytes)\n",dirname_.c_str(),dirname_.size());
+    for(const char *algo : algos)
+      {
+        double full_secs;
+        double incr_secs;
+        uint64_t full_sum;
+        uint64_t incr_sum;
+
+        fs::inode::set_algo(algo);
+
+        full_secs = l::time([&](){ return l::fullpath(dirname_,names_); },&full_sum);
+        incr_secs = l::time([&](){ return l::incremental(dirname_,names_); },&incr_sum);
+
+        printf("  %-14s %12.2f %12.2f %8.2fx%s\n",
+               algo,
+               full_secs * 1000,
+               incr_secs * 1000,
+               full_secs / incr_secs,
+               ((full_sum == incr_sum) ? "" : "  (output differs)"));
+      }
+  }
+}
+
+int
+main(int    argc_,
+     char **argv_)
+{
+  int i;
+  uint64_t entries;
+  std::vector<std::string> names;
+  std::vector<std::string> dirnames;
+
+  i = 1;
+  entries = 100000;
+  if(i < argc_)
+    entries = ::strtoull(argv_[i++],NULL,10);
+  for(; i < argc_; i++)
+    dirnames.push_back(argv_[i]);
+  if(dirnames.empty())
+    dirnames = {"/",
+                "/media/tv/Some Show",
+                "/media/music/a/b/c/d/e/f/g/Some Artist/Some Album (Deluxe Edition)"};
+
+  names.reserve(entries);
+  for(uint64_t n = 0; n < entries; n++)
+    {
+      char name[64];
+
+      snprintf(name,sizeof(name),"entry-%08lu.%s",n,((n & 1) ? "d" : "mkv"));
+      names.push_back(name);
+    }
+
+  printf("entries: %lu; best of %d\n\n",entries,RUNS);
+  printf("  %-14s %12s %12s %9s\n",
+         "inodecalc","path (ms)","parent (ms)","speedup");
+  for(const auto &dirname : dirnames)
+    l::bench(dirname,names);
+
+  return 0;
+}
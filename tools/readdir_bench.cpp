@@ -0,0 +1,365 @@
+/*
+  ISC License
+
+  Copyright (c) 2024, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+/*
+  Compares the cor readdir merge against the one it replaced where
+  every branch's thread took a shared lock around deduplication and
+  insertion of each chunk it read. Each run lists one directory
+  spread over N branches where each branch overlaps the next by 3/4
+  of its entries.
+
+  usage: readdir-bench [-t threads] [entries] [branches...]
+         (default: hardware threads, 20000 entries, 8 16 32 branches)
+
+  The directories are created under $TMPDIR (or /tmp) and removed
+  when done. Listings are done warm so it is the merge being timed
+  rather than the underlying filesystem.
+*/
+
+#include "branches.hpp"
+#include "fs_close.hpp"
+#include "fs_devid.hpp"
+#include "fs_dirpresence.hpp"
+#include "fs_getdents64.hpp"
+#include "fs_inode.hpp"
+#include "fs_open.hpp"
+#include "fs_path.hpp"
+#include "fuse_readdir_cor.hpp"
+#include "hashset.hpp"
+#include "scope_guard.hpp"
+
+#include "fuse_dirents.h"
+#include "linux_dirent64.h"
+#include "thread_pool.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <ftw.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define RUNS    10
+#define DIRNAME "/dir"
+
+
+namespace old
+{
+  static
+  int
+  readdir(std::string     basepath_,
+          HashSet        &names_,
+          fuse_dirents_t *buf_,
+          std::mutex     &mutex_)
+  {
+    int rv;
+    int dfd;
+    dev_t dev;
+    std::string filepath;
+
+    dfd = fs::open_dir_ro(basepath_);
+    if(dfd == -1)
+      return errno;
+
+    DEFER{ fs::close(dfd); };
+
+    dev = fs::devid(dfd);
+
+    for(;;)
+      {
+        long nread;
+        char buf[32 * 1024];
+
+        nread = fs::getdents_64(dfd,buf,sizeof(buf));
+        if(nread == -1)
+          return errno;
+        if(nread == 0)
+          break;
+
+        linux_dirent64_t *d;
+        std::lock_guard<std::mutex> lk(mutex_);
+        for(long pos = 0; pos < nread; pos += d->reclen)
+          {
+            std::uint64_t namelen;
+
+            d = (linux_dirent64_t*)&buf[pos];
+
+            namelen = DIRENT_NAMELEN(d);
+
+            rv = names_.put(d->name,namelen);
+            if(rv == 0)
+              continue;
+
+            filepath = fs::path::make(basepath_,d->name);
+            d->ino = fs::inode::calc(filepath,
+                                     DTTOIF(d->type),
+                                     dev,
+                                     d->ino);
+
+            rv = fuse_dirents_add_linux(buf_,d,namelen);
+            if(rv < 0)
+              return ENOMEM;
+          }
+      }
+
+    return 0;
+  }
+
+  static
+  int
+  readdir(ThreadPool           &tp_,
+          const Branches::CPtr &branches_,
+          const char           *dirname_,
+          fuse_dirents_t       *buf_)
+  {
+    HashSet names;
+    std::mutex mutex;
+    std::vector<std::future<int>> futures;
+
+    fuse_dirents_reset(buf_);
+
+    futures.reserve(branches_->size());
+    for(auto const &branch : *branches_)
+      {
+        auto func = [&]()
+        {
+          int rv;
+          std::string basepath;
+
+          basepath = fs::path::make(branch.path,dirname_);
+
+          rv = old::readdir(basepath,names,buf_,mutex);
+          if((rv == 0) || (rv == ENOENT))
+            fs::dirpresence::found(branches_,branch,dirname_,(rv == 0));
+
+          return rv;
+        };
+
+        futures.emplace_back(tp_.enqueue_task(func));
+      }
+
+    for(auto &future : futures)
+      future.get();
+
+    return 0;
+  }
+}
+
+namespace l
+{
+  static
+  double
+  now(void)
+  {
+    using namespace std::chrono;
+
+    return duration<double>(steady_clock::now().time_since_epoch()).count();
+  }
+
+  static
+  int
+  rm(const char        *fpath_,
+     const struct stat *st_,
+     int                typeflag_,
+     struct FTW        *ftw_)
+  {
+    return ::remove(fpath_);
+  }
+
+  static
+  std::string
+  populate(const std::string &root_,
+           const uint64_t     branches_,
+           const uint64_t     entries_)
+  {
+    std::string branchesstr;
+
+    for(uint64_t b = 0; b < branches_; b++)
+      {
+        char name[64];
+        std::string path;
+
+        snprintf(name,sizeof(name),"/%02lu",b);
+        path = root_ + name;
+        ::mkdir(path.c_str(),0755);
+        ::mkdir((path + DIRNAME).c_str(),0755);
+
+        for(uint64_t i = 0; i < entries_; i++)
+          {
+            int fd;
+
+            snprintf(name,sizeof(name),
+                     DIRNAME "/file_%08lu",
+                     (b * entries_ / 4) + i);
+            fd = ::open((path + name).c_str(),O_CREAT|O_WRONLY,0644);
+            if(fd >= 0)
+              ::close(fd);
+          }
+
+        if(!branchesstr.empty())
+          branchesstr += ':';
+        branchesstr += path;
+      }
+
+    return branchesstr;
+  }
+
+  template<typename F>
+  static
+  double
+  time(F          func_,
+       uint64_t  *count_)
+  {
+    double t;
+    double best;
+
+    best = 1e9;
+    for(int i = 0; i < RUNS; i++)
+      {
+        t = l::now();
+        *count_ = func_();
+        t = l::now() - t;
+        if(t < best)
+          best = t;
+      }
+
+    return best;
+  }
+
+  static
+  void
+  bench(const std::string &root_,
+        const unsigned     threads_,
+        const uint64_t     branches_,
+        const uint64_t     entries_)
+  {
+    int rv;
+    double old_secs;
+    double new_secs;
+    uint64_t old_count;
+    uint64_t new_count;
+    uint64_t minfreespace;
+    std::string path;
+    fuse_dirents_t buf;
+    Branches::CPtr branches;
+
+    char name[64];
+    snprintf(name,sizeof(name),"/%lu",branches_);
+    path = root_ + name;
+    ::mkdir(path.c_str(),0755);
+
+    minfreespace = 0;
+    Branches b(minfreespace);
+    rv = b.from_string(l::populate(path,branches_,entries_));
+    if(rv != 0)
+      {
+        fprintf(stderr,"error: failed to parse branches\n");
+        return;
+      }
+    branches = b;
+
+    fuse_dirents_init(&buf);
+
+    {
+      ThreadPool tp(threads_,0,"bench.old");
+      auto func = [&]()
+      {
+        old::readdir(tp,branches,DIRNAME,&buf);
+        return kv_size(buf.data);
+      };
+
+      old_secs = l::time(func,&old_count);
+    }
+
+    {
+      FUSE::ReadDirCOR cor(threads_,0);
+      auto func = [&]()
+      {
+        cor.readdir(branches,DIRNAME,&buf,getuid(),getgid());
+        return kv_size(buf.data);
+      };
+
+      new_secs = l::time(func,&new_count);
+    }
+
+    fuse_dirents_free(&buf);
+
+    printf("%8lu %10lu %12.2f %12.2f %8.2fx%s\n",
+           branches_,
+           (entries_ * (branches_ + 3) / 4),
+           old_secs * 1000,
+           new_secs * 1000,
+           old_secs / new_secs,
+           ((old_count == new_count) ? "" : "  (output differs)"));
+  }
+}
+
+int
+main(int    argc_,
+     char **argv_)
+{
+  int i;
+  unsigned threads;
+  uint64_t entries;
+  const char *tmpdir;
+  std::string root;
+  std::vector<uint64_t> branches;
+
+  i = 1;
+  threads = std::thread::hardware_concurrency();
+  if((argc_ > 2) && (std::string(argv_[1]) == "-t"))
+    {
+      threads = ::strtoul(argv_[2],NULL,10);
+      i = 3;
+    }
+
+  entries = 20000;
+  if(i < argc_)
+    entries = ::strtoull(argv_[i++],NULL,10);
+  for(; i < argc_; i++)
+    branches.push_back(::strtoull(argv_[i],NULL,10));
+  if(branches.empty())
+    branches = {8,16,32};
+
+  tmpdir = ::getenv("TMPDIR");
+  root  = ((tmpdir && *tmpdir) ? tmpdir : "/tmp");
+  root += "/readdir-bench.XXXXXX";
+  if(::mkdtemp(&root[0]) == NULL)
+    {
+      perror("mkdtemp");
+      return 1;
+    }
+
+  printf("threads: %u; entries per branch: %lu; best of %d\n\n",
+         threads,
+         entries,
+         RUNS);
+  printf("%8s %10s %12s %12s %9s\n",
+         "branches","merged","locked (ms)","cor (ms)","speedup");
+  for(auto n : branches)
+    l::bench(root,threads,n,entries);
+
+  ::nftw(root.c_str(),l::rm,64,FTW_DEPTH|FTW_PHYS);
+
+  return 0;
+}